@@ -31,4 +31,277 @@
 
 BEGIN_MIDI_NAMESPACE
 
+#define MIDI_STATUS_DATA    0
+#define MIDI_STATUS_CH2     (2 | StatusInfo::ChannelMessage | StatusInfo::RunningStatus)
+#define MIDI_STATUS_CH3     (3 | StatusInfo::ChannelMessage | StatusInfo::RunningStatus)
+#define MIDI_STATUS_RT      (1 | StatusInfo::RealTime)
+#define MIDI_STATUS_ROW(x)  x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x
+
+const byte StatusInfoTable[256] MIDI_PROGMEM =
+{
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x00 - 0x0f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x10 - 0x1f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x20 - 0x2f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x30 - 0x3f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x40 - 0x4f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x50 - 0x5f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x60 - 0x6f
+    MIDI_STATUS_ROW(MIDI_STATUS_DATA),  // 0x70 - 0x7f
+    MIDI_STATUS_ROW(MIDI_STATUS_CH3),   // NoteOff
+    MIDI_STATUS_ROW(MIDI_STATUS_CH3),   // NoteOn
+    MIDI_STATUS_ROW(MIDI_STATUS_CH3),   // AfterTouchPoly
+    MIDI_STATUS_ROW(MIDI_STATUS_CH3),   // ControlChange
+    MIDI_STATUS_ROW(MIDI_STATUS_CH2),   // ProgramChange
+    MIDI_STATUS_ROW(MIDI_STATUS_CH2),   // AfterTouchChannel
+    MIDI_STATUS_ROW(MIDI_STATUS_CH3),   // PitchBend
+
+    0,                      // SystemExclusive
+    2,                      // TimeCodeQuarterFrame
+    3,                      // SongPosition
+    2,                      // SongSelect
+    0,                      // Undefined_F4
+    0,                      // Undefined_F5
+    1,                      // TuneRequest
+    0,                      // SystemExclusiveEnd
+    MIDI_STATUS_RT,         // Clock
+    MIDI_STATUS_RT,         // Tick
+    MIDI_STATUS_RT,         // Start
+    MIDI_STATUS_RT,         // Continue
+    MIDI_STATUS_RT,         // Stop
+    StatusInfo::Ignored,    // Undefined_FD
+    MIDI_STATUS_RT,         // ActiveSensing
+    MIDI_STATUS_RT,         // SystemReset
+};
+
+#undef MIDI_STATUS_ROW
+#undef MIDI_STATUS_RT
+#undef MIDI_STATUS_CH3
+#undef MIDI_STATUS_CH2
+#undef MIDI_STATUS_DATA
+
+// -----------------------------------------------------------------------------
+//                                SysEx codec
+// -----------------------------------------------------------------------------
+
+#if MIDI_SYSEX_WORD_CODEC
+
+namespace
+{
+    // inSize bytes (up to 4), first one in the most significant byte.
+    inline uint32_t loadWord(const byte* inData, unsigned inSize)
+    {
+        uint32_t word = 0;
+        for (unsigned i = 0; i < 4; ++i)
+            word = (word << 8) | (i < inSize ? inData[i] : 0);
+        return word;
+    }
+
+    inline void storeWord(byte* outData, uint32_t inWord, unsigned inSize)
+    {
+        for (unsigned i = 0; i < inSize; ++i)
+            outData[i] = byte(inWord >> (24 - 8 * i));
+    }
+
+    inline uint32_t swapWord(uint32_t inWord)
+    {
+        return (inWord >> 24)
+             | ((inWord >> 8) & 0x0000ff00)
+             | ((inWord << 8) & 0x00ff0000)
+             | (inWord << 24);
+    }
+
+    // Top bit of each byte, most significant byte's one in bit 3.
+    // The multiply shifts each bit by a distinct amount, into bits 24 to 21.
+    inline byte gatherMsbs(uint32_t inWord)
+    {
+        return byte(((((inWord & 0x80808080) >> 7) * 0x00204081) >> 21) & 0x0f);
+    }
+
+    // Inverse of gatherMsbs: bit 3 to the top bit of the most significant byte.
+    inline uint32_t spreadMsbs(byte inBits)
+    {
+        return (uint32_t(inBits) * 0x10204081) & 0x80808080;
+    }
+}
+
+#endif
+
+SysExEncoder::SysExEncoder(bool inFlipHeaderBits)
+    : mCount(0)
+    , mFlipHeaderBits(inFlipHeaderBits)
+{
+}
+
+unsigned SysExEncoder::encode(const byte* inData, unsigned inLength, byte* outSysEx)
+{
+    unsigned count = 0;
+
+    // Complete the group left by the previous call
+    while (mCount != 0 && inLength != 0)
+    {
+        mGroup[mCount++] = *inData++;
+        inLength--;
+
+        if (mCount == sizeof(mGroup))
+        {
+            count += encodeGroup(mGroup, mCount, outSysEx + count);
+            mCount = 0;
+        }
+    }
+
+    // Then encode straight from the input
+    const unsigned groupSize = unsigned(sizeof(mGroup));
+    while (inLength >= groupSize)
+    {
+        count    += encodeGroup(inData, groupSize, outSysEx + count);
+        inData   += groupSize;
+        inLength -= groupSize;
+    }
+
+    // Keep the remainder for later
+    while (inLength != 0)
+    {
+        mGroup[mCount++] = *inData++;
+        inLength--;
+    }
+    return count;
+}
+
+unsigned SysExEncoder::finish(byte* outSysEx)
+{
+    if (mCount == 0)
+        return 0;
+
+    const unsigned count = encodeGroup(mGroup, mCount, outSysEx);
+    mCount = 0;
+    return count;
+}
+
+unsigned SysExEncoder::encodeGroup(const byte* inGroup, byte inSize, byte* outSysEx) const
+{
+#if MIDI_SYSEX_WORD_CODEC
+    if (inSize == sizeof(mGroup))
+    {
+        const uint32_t high = loadWord(inGroup, 4);
+        const uint32_t low  = loadWord(inGroup + 4, 3);
+
+        outSysEx[0] = mFlipHeaderBits
+            ? byte(gatherMsbs(swapWord(high)) | gatherMsbs(swapWord(low)) << 4)
+            : byte(gatherMsbs(high) << 3 | gatherMsbs(low) >> 1);
+        storeWord(outSysEx + 1, high & 0x7f7f7f7f, 4);
+        storeWord(outSysEx + 5, low  & 0x7f7f7f7f, 3);
+        return sizeof(mGroup) + 1;
+    }
+#endif
+
+    byte header = 0;
+    for (byte i = 0; i < inSize; ++i)
+    {
+        const byte shift = mFlipHeaderBits ? i : byte(6 - i);
+        header |= byte((inGroup[i] >> 7) << shift);
+        outSysEx[i + 1] = inGroup[i] & 0x7f;
+    }
+    outSysEx[0] = header;
+    return inSize + 1u;
+}
+
+// -----------------------------------------------------------------------------
+
+SysExDecoder::SysExDecoder(bool inFlipHeaderBits)
+    : mHeader(0)
+    , mIndex(0)
+    , mFlipHeaderBits(inFlipHeaderBits)
+{
+}
+
+unsigned SysExDecoder::decode(const byte* inSysEx, unsigned inLength, byte* outData)
+{
+    unsigned count = 0;
+
+    while (inLength != 0)
+    {
+#if MIDI_SYSEX_WORD_CODEC
+        if (mIndex == 0 && inLength >= 8)
+        {
+            // Whole group available: header and 7 data bytes
+            const byte header = inSysEx[0];
+            const uint32_t high = mFlipHeaderBits
+                                ? swapWord(spreadMsbs(header & 0x0f))
+                                : spreadMsbs(header >> 3);
+            const uint32_t low  = mFlipHeaderBits
+                                ? swapWord(spreadMsbs((header >> 4) & 0x07))
+                                : spreadMsbs(byte((header & 0x07) << 1));
+
+            storeWord(outData + count,     loadWord(inSysEx + 1, 4) | high, 4);
+            storeWord(outData + count + 4, loadWord(inSysEx + 5, 3) | low,  3);
+            count    += 7;
+            inSysEx  += 8;
+            inLength -= 8;
+            continue;
+        }
+#endif
+
+        const byte value = *inSysEx++;
+        inLength--;
+
+        if (mIndex == 0)
+        {
+            mHeader = value;
+            mIndex  = 1;
+        }
+        else
+        {
+            const byte shift = mFlipHeaderBits ? byte(mIndex - 1) : byte(7 - mIndex);
+            outData[count++] = byte(value | ((mHeader >> shift) & 1) << 7);
+            mIndex = mIndex == 7 ? 0 : mIndex + 1;
+        }
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Encode System Exclusive messages.
+ SysEx messages are encoded to guarantee transmission of data bytes higher than
+ 127 without breaking the MIDI protocol. Use this static method to convert the
+ data you want to send.
+ \param inData The data to encode.
+ \param outSysEx The output buffer where to store the encoded message.
+ \param inLength The length of the input buffer.
+ \param inFlipHeaderBits True for Korg and other who store MSB in reverse order
+ \return The length of the encoded output buffer.
+ @see decodeSysEx
+ @see SysExEncoder to encode data one slice at a time.
+ */
+unsigned encodeSysEx(const byte* inData,
+                     byte* outSysEx,
+                     unsigned inLength,
+                     bool inFlipHeaderBits)
+{
+    SysExEncoder encoder(inFlipHeaderBits);
+    const unsigned count = encoder.encode(inData, inLength, outSysEx);
+    return count + encoder.finish(outSysEx + count);
+}
+
+/*! \brief Decode System Exclusive messages.
+ SysEx messages are encoded to guarantee transmission of data bytes higher than
+ 127 without breaking the MIDI protocol. Use this static method to reassemble
+ your received message.
+ \param inSysEx The SysEx data received from MIDI in.
+ \param outData    The output buffer where to store the decrypted message.
+ \param inLength The length of the input buffer.
+ \param inFlipHeaderBits True for Korg and other who store MSB in reverse order
+ \return The length of the output buffer.
+ @see encodeSysEx @see getSysExArrayLength
+ @see SysExDecoder to decode data one slice at a time.
+ */
+unsigned decodeSysEx(const byte* inSysEx,
+                     byte* outData,
+                     unsigned inLength,
+                     bool inFlipHeaderBits)
+{
+    SysExDecoder decoder(inFlipHeaderBits);
+    return decoder.decode(inSysEx, inLength, outData);
+}
+
 END_MIDI_NAMESPACE
@@ -30,31 +30,28 @@
 BEGIN_MIDI_NAMESPACE
 
 /// \brief Constructor for MidiInterface.
-template<class Transport, class Settings, class Platform>
-inline MidiInterface<Transport, Settings, Platform>::MidiInterface(Transport& inTransport)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline MidiInterface<Transport, Settings, Platform, Handlers>::MidiInterface(Transport& inTransport)
     : mTransport(inTransport)
     , mInputChannel(0)
     , mRunningStatus_RX(InvalidType)
-    , mRunningStatus_TX(InvalidType)
     , mPendingMessageExpectedLength(0)
     , mPendingMessageIndex(0)
-    , mCurrentRpnNumber(0xffff)
-    , mCurrentNrpnNumber(0xffff)
-    , mLastMessageSentTime(0)
-    , mLastMessageReceivedTime(0)
-    , mSenderActiveSensingPeriodicity(0)
-    , mReceiverActiveSensingActivated(false)
     , mLastError(0)
+    , mPendingMessageRejected(false)
+    , mThruFilterMode(Thru::Full)
+    , mThruChannelMask(0xffff)
+    , mInputChannelMask(0xffff)
+    , mInputTypeMask(0xffffffff)
 {
-    mSenderActiveSensingPeriodicity = Settings::SenderActiveSensingPeriodicity;
 }
 
 /*! \brief Destructor for MidiInterface.
 
  This is not really useful for the Arduino, as it is never called...
  */
-template<class Transport, class Settings, class Platform>
-inline MidiInterface<Transport, Settings, Platform>::~MidiInterface()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline MidiInterface<Transport, Settings, Platform, Handlers>::~MidiInterface()
 {
 }
 
@@ -66,23 +63,33 @@ inline MidiInterface<Transport, Settings, Platform>::~MidiInterface()
  - Input channel set to 1 if no value is specified
  - Full thru mirroring
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::begin(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::begin(Channel inChannel)
 {
     // Initialise the Transport layer
     mTransport.begin();
 
     mInputChannel = inChannel;
-    mRunningStatus_TX = InvalidType;
+    this->runningStatusTx().cancel();
     mRunningStatus_RX = InvalidType;
 
     mPendingMessageIndex = 0;
     mPendingMessageExpectedLength = 0;
 
-    mCurrentRpnNumber  = 0xffff;
-    mCurrentNrpnNumber = 0xffff;
+    this->parameterNumbers().reset();
 
-    mLastMessageSentTime = Platform::now();
+    sampleTime();
+    this->senderActiveSensing().schedule(this->getTime());
+    this->txQueue().clear();
+    this->coalescer().clear();
+    this->sysExInput().reset();
+    this->parameterDecoder().reset();
+    this->controllerPairing().reset();
+    this->clockFollower().reset();
+    this->timeCodeDecoder().reset();
+
+    mThruFilterMode = Thru::Full;
+    updateThruChannelMask();
 
     mMessage.valid   = false;
     mMessage.type    = InvalidType;
@@ -90,6 +97,8 @@ void MidiInterface<Transport, Settings, Platform>::begin(Channel inChannel)
     mMessage.data1   = 0;
     mMessage.data2   = 0;
     mMessage.length  = 0;
+    mMessage.timestamp = 0;
+    this->timestampLatch().set(0);
 }
 
 // -----------------------------------------------------------------------------
@@ -109,22 +118,34 @@ void MidiInterface<Transport, Settings, Platform>::begin(Channel inChannel)
  Typically this function is use by MIDI Bridges taking MIDI messages and passing
  them thru.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::send(const MidiMessage& inMessage)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::send(const MidiMessage& inMessage)
+{
+    send(PackedMessage(inMessage));
+}
+
+/*! \brief Send a message in its packed (wire) form.
+ Same as send(const MidiMessage&), without unpacking the status byte.
+ SysEx chunks are ignored, their content is not in the packed form
+ (@see sendSysEx).
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::send(const PackedMessage& inMessage)
 {
-    if (!inMessage.valid)
+    if (!inMessage.isValid() || inMessage.status == SystemExclusive)
         return;
 
-    if (mTransport.beginTransmission(inMessage.type))
-    {
-        const StatusByte status = getStatus(inMessage.type, inMessage.channel);
-        mTransport.write(status);
+    const StatusByte status = inMessage.status;
 
-        if (inMessage.length > 1) mTransport.write(inMessage.data1);
-        if (inMessage.length > 2) mTransport.write(inMessage.data2);
-    }
-    mTransport.endTransmission();
-    updateLastSentTime();
+    if ((getStatusInfo(status) & StatusInfo::ChannelMessage)
+        && coalesce(status, inMessage.data1, inMessage.data2))
+        return;
+
+    if (enqueue(status, inMessage.data1, inMessage.data2))
+        return;
+
+    const byte message[3] = { status, inMessage.data1, inMessage.data2 };
+    writeMessage(message);
 }
 
 
@@ -139,11 +160,11 @@ void MidiInterface<Transport, Settings, Platform>::send(const MidiMessage& inMes
  This is an internal method, use it only if you need to send raw data
  from your code, at your own risks.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::send(MidiType inType,
-                                               DataByte inData1,
-                                               DataByte inData2,
-                                               Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::send(MidiType inType,
+                                                         DataByte inData1,
+                                                         DataByte inData2,
+                                                         Channel inChannel)
 {
     if (inType <= PitchBend)  // Channel messages
     {
@@ -160,33 +181,13 @@ void MidiInterface<Transport, Settings, Platform>::send(MidiType inType,
 
         const StatusByte status = getStatus(inType, inChannel);
 
-        if (mTransport.beginTransmission(inType))
-        {
-            if (Settings::UseRunningStatus)
-            {
-                if (mRunningStatus_TX != status)
-                {
-                    // New message, memorise and send header
-                    mRunningStatus_TX = status;
-                    mTransport.write(mRunningStatus_TX);
-                }
-            }
-            else
-            {
-                // Don't care about running status, send the status byte.
-                mTransport.write(status);
-            }
+        if (coalesce(status, inData1, inData2))
+            return; // Written when the transport has room.
 
-            // Then send data
-            mTransport.write(inData1);
-            if (inType != ProgramChange && inType != AfterTouchChannel)
-            {
-                mTransport.write(inData2);
-            }
+        if (enqueue(status, inData1, inData2))
+            return; // Running status is applied when flushing the queue.
 
-            mTransport.endTransmission();
-            updateLastSentTime();
-        }
+        writeChannelMessage(status, inData1, inData2);
     }
     else if (inType >= Clock && inType <= SystemReset)
     {
@@ -205,10 +206,10 @@ void MidiInterface<Transport, Settings, Platform>::send(MidiType inType,
  Take a look at the values, names and frequencies of notes here:
  http://www.phys.unsw.edu.au/jw/notes.html
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendNoteOn(DataByte inNoteNumber,
-                                                     DataByte inVelocity,
-                                                     Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendNoteOn(DataByte inNoteNumber,
+                                                               DataByte inVelocity,
+                                                               Channel inChannel)
 {
     send(NoteOn, inNoteNumber, inVelocity, inChannel);
 }
@@ -220,25 +221,29 @@ void MidiInterface<Transport, Settings, Platform>::sendNoteOn(DataByte inNoteNum
 
  Note: you can send NoteOn with zero velocity to make a NoteOff, this is based
  on the Running Status principle, to avoid sending status messages and thus
- sending only NoteOn data. sendNoteOff will always send a real NoteOff message.
+ sending only NoteOn data. sendNoteOff sends a real NoteOff message, unless
+ Settings::SendNoteOffAsNullVelocityNoteOn is set (inVelocity is then ignored).
  Take a look at the values, names and frequencies of notes here:
  http://www.phys.unsw.edu.au/jw/notes.html
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendNoteOff(DataByte inNoteNumber,
-                                                      DataByte inVelocity,
-                                                      Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendNoteOff(DataByte inNoteNumber,
+                                                                DataByte inVelocity,
+                                                                Channel inChannel)
 {
-    send(NoteOff, inNoteNumber, inVelocity, inChannel);
+    if (Settings::SendNoteOffAsNullVelocityNoteOn)
+        send(NoteOn, inNoteNumber, 0, inChannel);
+    else
+        send(NoteOff, inNoteNumber, inVelocity, inChannel);
 }
 
 /*! \brief Send a Program Change message
  \param inProgramNumber The Program to select (0 to 127).
  \param inChannel       The channel on which the message will be sent (1 to 16).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendProgramChange(DataByte inProgramNumber,
-                                                            Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendProgramChange(DataByte inProgramNumber,
+                                                                      Channel inChannel)
 {
     send(ProgramChange, inProgramNumber, 0, inChannel);
 }
@@ -249,14 +254,29 @@ void MidiInterface<Transport, Settings, Platform>::sendProgramChange(DataByte in
  \param inChannel       The channel on which the message will be sent (1 to 16).
  @see MidiControlChangeNumber
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendControlChange(DataByte inControlNumber,
-                                                            DataByte inControlValue,
-                                                            Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendControlChange(DataByte inControlNumber,
+                                                                      DataByte inControlValue,
+                                                                      Channel inChannel)
 {
     send(ControlChange, inControlNumber, inControlValue, inChannel);
 }
 
+/*! \brief Send a high resolution Control Change, as an MSB / LSB pair.
+ \param inControlNumber The MSB controller number (0 to 31), the LSB goes to +32.
+ \param inControlValue  The 14-bit value (0 to 16383).
+ \param inChannel       The channel on which the message will be sent (1 to 16).
+ With UseRunningStatus, the LSB is sent without status byte (5 bytes in total).
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendControlChange14(DataByte inControlNumber,
+                                                                                        uint16_t inControlValue,
+                                                                                        Channel inChannel)
+{
+    send(ControlChange, inControlNumber,      0x7f & (inControlValue >> 7), inChannel);
+    send(ControlChange, inControlNumber + 32, 0x7f & inControlValue,        inChannel);
+}
+
 /*! \brief Send a Polyphonic AfterTouch message (applies to a specified note)
  \param inNoteNumber  The note to apply AfterTouch to (0 to 127).
  \param inPressure    The amount of AfterTouch to apply (0 to 127).
@@ -264,10 +284,10 @@ void MidiInterface<Transport, Settings, Platform>::sendControlChange(DataByte in
  Note: this method is deprecated and will be removed in a future revision of the
  library, @see sendAfterTouch to send polyphonic and monophonic AfterTouch messages.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendPolyPressure(DataByte inNoteNumber,
-                                                           DataByte inPressure,
-                                                           Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendPolyPressure(DataByte inNoteNumber,
+                                                                     DataByte inPressure,
+                                                                     Channel inChannel)
 {
     send(AfterTouchPoly, inNoteNumber, inPressure, inChannel);
 }
@@ -276,9 +296,9 @@ void MidiInterface<Transport, Settings, Platform>::sendPolyPressure(DataByte inN
  \param inPressure    The amount of AfterTouch to apply to all notes.
  \param inChannel     The channel on which the message will be sent (1 to 16).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendAfterTouch(DataByte inPressure,
-                                                         Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendAfterTouch(DataByte inPressure,
+                                                                   Channel inChannel)
 {
     send(AfterTouchChannel, inPressure, 0, inChannel);
 }
@@ -289,10 +309,10 @@ void MidiInterface<Transport, Settings, Platform>::sendAfterTouch(DataByte inPre
  \param inChannel     The channel on which the message will be sent (1 to 16).
  @see Replaces sendPolyPressure (which is now deprecated).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendAfterTouch(DataByte inNoteNumber,
-                                                         DataByte inPressure,
-                                                         Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendAfterTouch(DataByte inNoteNumber,
+                                                                   DataByte inPressure,
+                                                                   Channel inChannel)
 {
     send(AfterTouchPoly, inNoteNumber, inPressure, inChannel);
 }
@@ -303,9 +323,9 @@ void MidiInterface<Transport, Settings, Platform>::sendAfterTouch(DataByte inNot
  center value is 0.
  \param inChannel     The channel on which the message will be sent (1 to 16).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendPitchBend(int inPitchValue,
-                                                        Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendPitchBend(int inPitchValue,
+                                                                  Channel inChannel)
 {
     const unsigned bend = unsigned(inPitchValue - int(MIDI_PITCHBEND_MIN));
     send(PitchBend, (bend & 0x7f), (bend >> 7) & 0x7f, inChannel);
@@ -318,9 +338,9 @@ void MidiInterface<Transport, Settings, Platform>::sendPitchBend(int inPitchValu
  and +1.0f (max upwards bend), center value is 0.0f.
  \param inChannel     The channel on which the message will be sent (1 to 16).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendPitchBend(double inPitchValue,
-                                                        Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendPitchBend(double inPitchValue,
+                                                                  Channel inChannel)
 {
     const int scale = inPitchValue > 0.0 ? MIDI_PITCHBEND_MAX : - MIDI_PITCHBEND_MIN;
     const int value = int(inPitchValue * double(scale));
@@ -332,21 +352,60 @@ void MidiInterface<Transport, Settings, Platform>::sendPitchBend(double inPitchV
  When a MIDI unit receives this message,
  it should tune its oscillators (if equipped with any).
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendTuneRequest()
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendTuneRequest()
 {
     sendCommon(TuneRequest);
 }
 
+/*! \brief Generate and send a System Exclusive frame.
+ \param inLength  The size of the array to send
+ \param inArray   The byte array containing the data to send
+ \param inArrayContainsBoundaries When set to 'true', 0xF0 & 0xF7 bytes
+ (start & stop SysEx) will NOT be sent (and therefore must be included in
+ the array). This also allows sending a large frame in several calls: the
+ first slice starting with 0xF0, the last one ending with 0xF7.
+ default value for ArrayContainsBoundaries is set to 'false' for compatibility
+ with previous versions of the library.
+ @see SysExEncoder to encode 8-bit data on the fly.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendSysEx(unsigned inLength,
+                                                                       const byte* inArray,
+                                                                       bool inArrayContainsBoundaries)
+{
+    // Queued messages were sent first.
+    flush();
+
+    if (mTransport.beginTransmission(SystemExclusive))
+    {
+        static const byte start = SystemExclusiveStart;
+        static const byte end   = SystemExclusiveEnd;
+
+        if (!inArrayContainsBoundaries)
+            writeBytes(&start, 1);
+
+        writeBytes(inArray, inLength);
+
+        if (!inArrayContainsBoundaries)
+            writeBytes(&end, 1);
+
+        mTransport.endTransmission();
+        updateLastSentTime();
+    }
+
+    this->runningStatusTx().cancel();
+}
+
 /*! \brief Send a MIDI Time Code Quarter Frame.
 
  \param inTypeNibble      MTC type
  \param inValuesNibble    MTC data
  See MIDI Specification for more information.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendTimeCodeQuarterFrame(DataByte inTypeNibble,
-                                                                            DataByte inValuesNibble)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendTimeCodeQuarterFrame(DataByte inTypeNibble,
+                                                                                      DataByte inValuesNibble)
 {
     const byte data = byte((((inTypeNibble & 0x07) << 4) | (inValuesNibble & 0x0f)));
     sendTimeCodeQuarterFrame(data);
@@ -358,8 +417,8 @@ void MidiInterface<Transport, Settings, Platform>::sendTimeCodeQuarterFrame(Data
  \param inData  if you want to encode directly the nibbles in your program,
                 you can send the byte here.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendTimeCodeQuarterFrame(DataByte inData)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendTimeCodeQuarterFrame(DataByte inData)
 {
     sendCommon(TimeCodeQuarterFrame, inData);
 }
@@ -367,15 +426,15 @@ void MidiInterface<Transport, Settings, Platform>::sendTimeCodeQuarterFrame(Data
 /*! \brief Send a Song Position Pointer message.
  \param inBeats    The number of beats since the start of the song.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendSongPosition(unsigned inBeats)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendSongPosition(unsigned inBeats)
 {
     sendCommon(SongPosition, inBeats);
 }
 
 /*! \brief Send a Song Select message */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendSongSelect(DataByte inSongNumber)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendSongSelect(DataByte inSongNumber)
 {
     sendCommon(SongSelect, inSongNumber);
 }
@@ -387,8 +446,8 @@ void MidiInterface<Transport, Settings, Platform>::sendSongSelect(DataByte inSon
  @see MidiType
  \param inData1   The byte that goes with the common message.
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendCommon(MidiType inType, unsigned inData1)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendCommon(MidiType inType, unsigned inData1)
 {
     switch (inType)
     {
@@ -402,20 +461,26 @@ void MidiInterface<Transport, Settings, Platform>::sendCommon(MidiType inType, u
             return;
     }
 
+    if (enqueue(inType, byte(inData1 & 0x7f), byte((inData1 >> 7) & 0x7f)))
+        return;
+
     if (mTransport.beginTransmission(inType))
     {
-            mTransport.write((byte)inType);
-            switch (inType)
-            {
+        byte message[3];
+        size_t size = 0;
+        message[size++] = (byte)inType;
+
+        switch (inType)
+        {
             case TimeCodeQuarterFrame:
-                mTransport.write(inData1);
+                message[size++] = byte(inData1);
                 break;
             case SongPosition:
-                mTransport.write(inData1 & 0x7f);
-                mTransport.write((inData1 >> 7) & 0x7f);
+                message[size++] = byte(inData1 & 0x7f);
+                message[size++] = byte((inData1 >> 7) & 0x7f);
                 break;
             case SongSelect:
-                mTransport.write(inData1 & 0x7f);
+                message[size++] = byte(inData1 & 0x7f);
                 break;
             case TuneRequest:
                 break;
@@ -424,12 +489,12 @@ void MidiInterface<Transport, Settings, Platform>::sendCommon(MidiType inType, u
                 break;
             // LCOV_EXCL_STOP
         }
+        writeBytes(message, size);
         mTransport.endTransmission();
         updateLastSentTime();
     }
 
-    if (Settings::UseRunningStatus)
-        mRunningStatus_TX = InvalidType;
+    this->runningStatusTx().cancel();
 }
 
 /*! \brief Send a Real Time (one byte) message.
@@ -438,8 +503,8 @@ void MidiInterface<Transport, Settings, Platform>::sendCommon(MidiType inType, u
  Start, Stop, Continue, Clock, ActiveSensing and SystemReset.
  @see MidiType
  */
-template<class Transport, class Settings, class Platform>
-void MidiInterface<Transport, Settings, Platform>::sendRealTime(MidiType inType)
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::sendRealTime(MidiType inType)
 {
     // Do not invalidate Running Status for real-time messages
     // as they can be interleaved within any message.
@@ -452,9 +517,15 @@ void MidiInterface<Transport, Settings, Platform>::sendRealTime(MidiType inType)
         case Continue:
         case ActiveSensing:
         case SystemReset:
+            if (enqueue(inType))
+                break;
+
             if (mTransport.beginTransmission(inType))
             {
+                const unsigned long start = sampleSendTime(BoolTag<Settings::UseStatistics>());
                 mTransport.write((byte)inType);
+                this->countSendTime(sampleSendTime(BoolTag<Settings::UseStatistics>()) - start);
+                occupyLine(1);
                 mTransport.endTransmission();
                 updateLastSentTime();
             }
@@ -469,17 +540,16 @@ void MidiInterface<Transport, Settings, Platform>::sendRealTime(MidiType inType)
  \param inNumber The 14-bit number of the RPN you want to select.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::beginRpn(unsigned inNumber,
-                                                          Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::beginRpn(unsigned inNumber,
+                                                                    Channel inChannel)
 {
-    if (mCurrentRpnNumber != inNumber)
+    if (this->parameterNumbers().selectRpn(inNumber))
     {
         const byte numMsb = 0x7f & (inNumber >> 7);
         const byte numLsb = 0x7f & inNumber;
         sendControlChange(RPNLSB, numLsb, inChannel);
         sendControlChange(RPNMSB, numMsb, inChannel);
-        mCurrentRpnNumber = inNumber;
     }
 }
 
@@ -487,9 +557,9 @@ inline void MidiInterface<Transport, Settings, Platform>::beginRpn(unsigned inNu
  \param inValue  The 14-bit value of the selected RPN.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendRpnValue(unsigned inValue,
-                                                              Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendRpnValue(unsigned inValue,
+                                                                        Channel inChannel)
 {;
     const byte valMsb = 0x7f & (inValue >> 7);
     const byte valLsb = 0x7f & inValue;
@@ -502,10 +572,10 @@ inline void MidiInterface<Transport, Settings, Platform>::sendRpnValue(unsigned
  \param inLsb The LSB part of the value to send. Meaning depends on RPN number.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendRpnValue(byte inMsb,
-                                                              byte inLsb,
-                                                              Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendRpnValue(byte inMsb,
+                                                                        byte inLsb,
+                                                                        Channel inChannel)
 {
     sendControlChange(DataEntryMSB, inMsb, inChannel);
     sendControlChange(DataEntryLSB, inLsb, inChannel);
@@ -514,9 +584,9 @@ inline void MidiInterface<Transport, Settings, Platform>::sendRpnValue(byte inMs
 /* \brief Increment the value of the currently selected RPN number by the specified amount.
  \param inAmount The amount to add to the currently selected RPN value.
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendRpnIncrement(byte inAmount,
-                                                                  Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendRpnIncrement(byte inAmount,
+                                                                            Channel inChannel)
 {
     sendControlChange(DataIncrement, inAmount, inChannel);
 }
@@ -524,9 +594,9 @@ inline void MidiInterface<Transport, Settings, Platform>::sendRpnIncrement(byte
 /* \brief Decrement the value of the currently selected RPN number by the specified amount.
  \param inAmount The amount to subtract to the currently selected RPN value.
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendRpnDecrement(byte inAmount,
-                                                                  Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendRpnDecrement(byte inAmount,
+                                                                            Channel inChannel)
 {
     sendControlChange(DataDecrement, inAmount, inChannel);
 }
@@ -535,12 +605,12 @@ inline void MidiInterface<Transport, Settings, Platform>::sendRpnDecrement(byte
 This will send a Null Function to deselect the currently selected RPN.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::endRpn(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::endRpn(Channel inChannel)
 {
     sendControlChange(RPNLSB, 0x7f, inChannel);
     sendControlChange(RPNMSB, 0x7f, inChannel);
-    mCurrentRpnNumber = 0xffff;
+    this->parameterNumbers().deselectRpn();
 }
 
 
@@ -549,17 +619,16 @@ inline void MidiInterface<Transport, Settings, Platform>::endRpn(Channel inChann
  \param inNumber The 14-bit number of the NRPN you want to select.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::beginNrpn(unsigned inNumber,
-                                                           Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::beginNrpn(unsigned inNumber,
+                                                                     Channel inChannel)
 {
-    if (mCurrentNrpnNumber != inNumber)
+    if (this->parameterNumbers().selectNrpn(inNumber))
     {
         const byte numMsb = 0x7f & (inNumber >> 7);
         const byte numLsb = 0x7f & inNumber;
         sendControlChange(NRPNLSB, numLsb, inChannel);
         sendControlChange(NRPNMSB, numMsb, inChannel);
-        mCurrentNrpnNumber = inNumber;
     }
 }
 
@@ -567,9 +636,9 @@ inline void MidiInterface<Transport, Settings, Platform>::beginNrpn(unsigned inN
  \param inValue  The 14-bit value of the selected NRPN.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendNrpnValue(unsigned inValue,
-                                                               Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendNrpnValue(unsigned inValue,
+                                                                         Channel inChannel)
 {;
     const byte valMsb = 0x7f & (inValue >> 7);
     const byte valLsb = 0x7f & inValue;
@@ -582,10 +651,10 @@ inline void MidiInterface<Transport, Settings, Platform>::sendNrpnValue(unsigned
  \param inLsb The LSB part of the value to send. Meaning depends on NRPN number.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendNrpnValue(byte inMsb,
-                                                               byte inLsb,
-                                                               Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendNrpnValue(byte inMsb,
+                                                                         byte inLsb,
+                                                                         Channel inChannel)
 {
     sendControlChange(DataEntryMSB, inMsb, inChannel);
     sendControlChange(DataEntryLSB, inLsb, inChannel);
@@ -594,9 +663,9 @@ inline void MidiInterface<Transport, Settings, Platform>::sendNrpnValue(byte inM
 /* \brief Increment the value of the currently selected NRPN number by the specified amount.
  \param inAmount The amount to add to the currently selected NRPN value.
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendNrpnIncrement(byte inAmount,
-                                                                   Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendNrpnIncrement(byte inAmount,
+                                                                             Channel inChannel)
 {
     sendControlChange(DataIncrement, inAmount, inChannel);
 }
@@ -604,9 +673,9 @@ inline void MidiInterface<Transport, Settings, Platform>::sendNrpnIncrement(byte
 /* \brief Decrement the value of the currently selected NRPN number by the specified amount.
  \param inAmount The amount to subtract to the currently selected NRPN value.
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::sendNrpnDecrement(byte inAmount,
-                                                                   Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sendNrpnDecrement(byte inAmount,
+                                                                             Channel inChannel)
 {
     sendControlChange(DataDecrement, inAmount, inChannel);
 }
@@ -615,349 +684,1295 @@ inline void MidiInterface<Transport, Settings, Platform>::sendNrpnDecrement(byte
 This will send a Null Function to deselect the currently selected NRPN.
  \param inChannel The channel on which the message will be sent (1 to 16).
 */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::endNrpn(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::endNrpn(Channel inChannel)
 {
     sendControlChange(NRPNLSB, 0x7f, inChannel);
     sendControlChange(NRPNMSB, 0x7f, inChannel);
-    mCurrentNrpnNumber = 0xffff;
+    this->parameterNumbers().deselectNrpn();
 }
 
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::updateLastSentTime()
+/*! \brief Write all queued messages to the transport.
+
+ Only relevant when Settings::TxQueueSize or Settings::CoalescedMessages is
+ not zero, read() also calls it.
+ The queue is written in order within a single transmission (one
+ beginTransmission/endTransmission pair, and bulk writes when the transport
+ supports them). With running status enabled, consecutive channel messages
+ sharing the same status only send it once. If the transport refuses the
+ transmission, the queue is kept as is for the next flush(): messages sent
+ meanwhile are dropped once it is full (ErrorTxQueueOverflow).
+ Pending controller values are written next, as far as the transport has
+ room for them (all of them if it can't tell), then the scheduled messages
+ that are due (unless Settings::UseExternalTime is set, @see service).
+ Last, transports that hold messages until a deadline (@see UsbMIDI,
+ RtpMIDI) send them if it has passed: a loop that only sends must call
+ flush() (or read()) regularly.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::flush()
 {
-    if (Settings::UseSenderActiveSensing && mSenderActiveSensingPeriodicity)
-        mLastMessageSentTime = Platform::now();
-}
+    flushTxQueue();
+    drainCoalesced(getWriteRoom(BoolTag<HasAvailableForWrite<Transport>::value>()));
 
-/*! @} */ // End of doc group MIDI Output
+    if (Settings::ScheduledMessages != 0 && !Settings::UseExternalTime)
+        service(sampleLineTime(BoolTag<Settings::ScheduledMessages != 0>()));
 
-// -----------------------------------------------------------------------------
+    serviceTransport(BoolTag<HasService<Transport>::value>());
+}
 
-template<class Transport, class Settings, class Platform>
-StatusByte MidiInterface<Transport, Settings, Platform>::getStatus(MidiType inType,
-                                                          Channel inChannel) const
+// Private method: write the TX queue in a single transmission.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::flushTxQueue()
 {
-    return StatusByte(((byte)inType | ((inChannel - 1) & 0x0f)));
+    if (Settings::TxQueueSize == 0 || this->txQueue().isEmpty())
+        return;
+
+    // Kept for the next flush if the transport is not ready.
+    const MidiType firstType = getTypeFromStatusByte(this->txQueue().front()[0]);
+    if (!mTransport.beginTransmission(firstType))
+        return;
+
+    byte buffer[16];
+    size_t size = 0;
+
+    while (!this->txQueue().isEmpty())
+    {
+        const byte* message     = this->txQueue().front();
+        const StatusByte status = message[0];
+        const byte info         = getStatusInfo(status);
+        const byte length       = info & StatusInfo::LengthMask;
+
+        if (size + 3 > sizeof(buffer))
+        {
+            writeBytes(buffer, size);
+            size = 0;
+        }
+
+        if (!Settings::UseRunningStatus)
+        {
+            buffer[size++] = status;
+        }
+        else if (info & StatusInfo::RunningStatus)
+        {
+            if (!omitStatus(status))
+                buffer[size++] = status;
+        }
+        else
+        {
+            buffer[size++] = status;
+
+            // Common messages reset the running status,
+            // real-time messages can be interleaved anywhere.
+            if (!(info & StatusInfo::RealTime))
+                this->runningStatusTx().cancel();
+        }
+
+        if (length > 1) buffer[size++] = message[1];
+        if (length > 2) buffer[size++] = message[2];
+
+        this->txQueue().pop();
+    }
+
+    writeBytes(buffer, size);
+    mTransport.endTransmission();
+    updateLastSentTime();
 }
 
-// -----------------------------------------------------------------------------
-//                                  Input
-// -----------------------------------------------------------------------------
+// Private method: tell whether the status byte of an outgoing channel message
+// can be left out (running status), remember it as the new one otherwise.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::omitStatus(StatusByte inStatus)
+{
+    if (!Settings::UseRunningStatus)
+        return false;
 
-/*! \addtogroup input
- @{
-*/
+    if (!this->runningStatusTx().omit(inStatus, this->getTime()))
+        return false;
 
-/*! \brief Read messages from the serial port using the main input channel.
+    this->countRunningStatusSent();
+    return true;
+}
 
- \return True if a valid message has been stored in the structure, false if not.
- A valid message is a message that matches the input channel. \n\n
- If the Thru is enabled and the message matches the filter,
- it is sent back on the MIDI output.
- @see see setInputChannel()
+/*! \brief Number of channel message status bytes sent with running status.
+ Always 0 without Settings::UseRunningStatus.
  */
-template<class Transport, class Settings, class Platform>
-inline bool MidiInterface<Transport, Settings, Platform>::read()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::getStatusBytesSent() const
 {
-    return read(mInputChannel);
+    return this->runningStatusTx().getStatusBytesSent();
 }
 
-/*! \brief Read messages on a specified channel.
+/*! \brief Number of channel message status bytes left out by running status.
+ Always 0 without Settings::UseRunningStatus.
  */
-template<class Transport, class Settings, class Platform>
-inline bool MidiInterface<Transport, Settings, Platform>::read(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::getStatusBytesSaved() const
 {
-    #ifndef RegionActiveSending
-    // Active Sensing. This message is intended to be sent
-    // repeatedly to tell the receiver that a connection is alive. Use
-    // of this message is optional. When initially received, the
-    // receiver will expect to receive another Active Sensing
-    // message each 300ms (max), and if it does not then it will
-    // assume that the connection has been terminated. At
-    // termination, the receiver will turn off all voices and return to
-    // normal (non- active sensing) operation.
-    if (Settings::UseSenderActiveSensing && (mSenderActiveSensingPeriodicity > 0) && (Platform::now() - mLastMessageSentTime) > mSenderActiveSensingPeriodicity)
+    return this->runningStatusTx().getStatusBytesSaved();
+}
+
+// Private method: store a message into the TX queue.
+// Returns false if queueing is disabled, and the message must be sent now.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::enqueue(StatusByte inStatus,
+                                                                            DataByte inData1,
+                                                                            DataByte inData2)
+{
+    if (Settings::TxQueueSize == 0)
+        return false;
+
+    if (!this->txQueue().push(inStatus, inData1, inData2))
     {
-        sendActiveSensing();
-        mLastMessageSentTime = Platform::now();
+        mLastError |= 1UL << ErrorTxQueueOverflow; // set the ErrorTxQueueOverflow bit
+        launchErrorCallback();
     }
 
-    if (Settings::UseReceiverActiveSensing && mReceiverActiveSensingActivated && (mLastMessageReceivedTime + ActiveSensingTimeout < Platform::now()))
+    return true;
+}
+
+// Private method: write a channel message now, with running status if enabled.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::writeChannelMessage(StatusByte inStatus,
+                                                                                        DataByte inData1,
+                                                                                        DataByte inData2)
+{
+    const MidiType type = MidiType(inStatus & 0xf0);
+
+    if (mTransport.beginTransmission(type))
     {
-        mReceiverActiveSensingActivated = false;
+        byte message[3];
+        size_t size = 0;
 
-        mLastError |= 1UL << ErrorActiveSensingTimeout; // set the ErrorActiveSensingTimeout bit
-    }
-    #endif
+        if (!omitStatus(inStatus))
+            message[size++] = inStatus;
 
-    if (inChannel >= MIDI_CHANNEL_OFF)
-        return false; // MIDI Input disabled.
+        // Then send data
+        message[size++] = inData1;
+        if (type != ProgramChange && type != AfterTouchChannel)
+        {
+            message[size++] = inData2;
+        }
 
-    if (!parse())
-        return false;
+        writeBytes(message, size);
+        mTransport.endTransmission();
+        updateLastSentTime();
+    }
+}
 
-    #ifndef RegionActiveSending
+// Private method: keep a controller value pending, replacing an older one.
+// Returns false if the message must be sent now (pending values on its
+// channel are released first, to keep their order).
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::coalesce(StatusByte inStatus,
+                                                                             DataByte inData1,
+                                                                             DataByte inData2)
+{
+    if (Settings::CoalescedMessages == 0)
+        return false;
 
-    if (Settings::UseReceiverActiveSensing && mMessage.type == ActiveSensing)
+    if (!this->coalescer().isCoalescable(inStatus, inData1))
     {
-        // When an ActiveSensing message is received, the time keeping is activated.
-        // When a timeout occurs, an error message is send and time keeping ends.
-        mReceiverActiveSensingActivated = true;
-
-        // is ErrorActiveSensingTimeout bit in mLastError on
-        if (mLastError & (1 << (ErrorActiveSensingTimeout - 1)))
+        byte message[3];
+        while (this->coalescer().take(inStatus & 0x0f, message))
         {
-            mLastError &= ~(1UL << ErrorActiveSensingTimeout); // clear the ErrorActiveSensingTimeout bit
+            if (!enqueue(message[0], message[1], message[2]))
+                writeChannelMessage(message[0], message[1], message[2]);
         }
+        return false;
     }
 
-    // Keep the time of the last received message, so we can check for the timeout
-    if (Settings::UseReceiverActiveSensing && mReceiverActiveSensingActivated)
-        mLastMessageReceivedTime = Platform::now();
+    if (!this->coalescer().store(inStatus, inData1, inData2))
+    {
+        // Full: the oldest value can't wait any longer.
+        const byte* oldest = this->coalescer().front();
+        if (!enqueue(oldest[0], oldest[1], oldest[2]))
+            writeChannelMessage(oldest[0], oldest[1], oldest[2]);
+        this->coalescer().pop();
+        this->coalescer().store(inStatus, inData1, inData2);
+    }
 
-    #endif
+    // Queued messages must go first, flush() will drain the values.
+    if (Settings::TxQueueSize == 0)
+    {
+        const int room = getWriteRoom(BoolTag<HasAvailableForWrite<Transport>::value>());
+        if (room >= 0)
+            drainCoalesced(room);
+    }
+    return true;
+}
 
-    handleNullVelocityNoteOnAsNoteOff();
+// Private method: write pending values while the transport has room for
+// them, inRoom is in bytes (negative: unknown, write them all).
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::drainCoalesced(int inRoom)
+{
+    while (!this->coalescer().isEmpty() && (inRoom < 0 || inRoom >= 3))
+    {
+        const byte* message = this->coalescer().front();
+        writeChannelMessage(message[0], message[1], message[2]);
+        this->coalescer().pop();
 
-    const bool channelMatch = inputFilter(inChannel);
-    return channelMatch;
+        if (inRoom > 0)
+            inRoom -= 3;
+    }
 }
 
-// -----------------------------------------------------------------------------
+template<class Transport, class Settings, class Platform, class Handlers>
+inline int MidiInterface<Transport, Settings, Platform, Handlers>::getWriteRoom(BoolTag<true>)
+{
+    return int(mTransport.availableForWrite());
+}
 
-// Private method: MIDI parser
-template<class Transport, class Settings, class Platform>
-bool MidiInterface<Transport, Settings, Platform>::parse()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline int MidiInterface<Transport, Settings, Platform, Handlers>::getWriteRoom(BoolTag<false>)
 {
-    if (mTransport.available() == 0)
-        return false; // No data available.
+    return -1;
+}
 
-    // clear the ErrorParse bit
-    mLastError &= ~(1UL << ErrorParse);
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::serviceTransport(BoolTag<true>)
+{
+    mTransport.service();
+}
 
-    // Parsing algorithm:
-    // Get a byte from the serial buffer.
-    // If there is no pending message to be recomposed, start a new one.
-    //  - Find type and channel (if pertinent)
-    //  - Look for other bytes in buffer, call parser recursively,
-    //    until the message is assembled or the buffer is empty.
-    // Else, add the extracted byte to the pending message, and check validity.
-    // When the message is done, store it.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::serviceTransport(BoolTag<false>)
+{
+}
 
-    const byte extracted = mTransport.read();
+/*! \brief Send a message at a given time.
+ \param inTime    When the message should be on the line, in us, on the
+ clock of Platform::nowMicros().
+ \param inMessage Any message but SysEx.
+ \return false if the message can't be scheduled (ErrorScheduleOverflow is
+ set if all the slots are used).
+
+ The message is kept (see Settings::ScheduledMessages) until service() finds
+ it due, it then bypasses the TX queue and the coalesced controllers.
+ Without Settings::ScheduledMessages, it is sent right away.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::sendAt(unsigned long inTime,
+                                                                           const MidiMessage& inMessage)
+{
+    return sendAt(inTime, PackedMessage(inMessage));
+}
 
-    // Ignore Undefined
-    if (extracted == Undefined_FD)
-        return (Settings::Use1ByteParsing) ? false : parse();
+/*! \brief Send a message in its packed form at a given time.
+ @see sendAt(unsigned long, const MidiMessage&)
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+bool MidiInterface<Transport, Settings, Platform, Handlers>::sendAt(unsigned long inTime,
+                                                                    const PackedMessage& inMessage)
+{
+    const byte info = getStatusInfo(inMessage.status);
+    if (!inMessage.isValid() || (info & StatusInfo::LengthMask) == 0 || (info & StatusInfo::Ignored))
+        return false;
 
-    if (mPendingMessageIndex == 0)
+    if (Settings::ScheduledMessages == 0)
     {
-        // Start a new pending message
-        mPendingMessage[0] = extracted;
+        send(inMessage);
+        return true;
+    }
 
-        // Check for running status first
-        if (isChannelMessage(getTypeFromStatusByte(mRunningStatus_RX)))
-        {
-            // Only these types allow Running Status
+    if (!this->scheduler().push(inTime, inMessage.status, inMessage.data1 & 0x7f, inMessage.data2 & 0x7f))
+    {
+        mLastError |= 1UL << ErrorScheduleOverflow; // set the ErrorScheduleOverflow bit
+        launchErrorCallback();
+        return false;
+    }
+    return true;
+}
 
-            // If the status byte is not received, prepend it
-            // to the pending message
-            if (extracted < 0x80)
-            {
-                mPendingMessage[0]   = mRunningStatus_RX;
-                mPendingMessage[1]   = extracted;
-                mPendingMessageIndex = 1;
-            }
-            // Else: well, we received another status byte,
-            // so the running status does not apply here.
-            // It will be updated upon completion of this message.
-        }
+/*! \brief Write the scheduled messages that are due.
+ \param inNow The current time, on the clock of Platform::nowMicros().
+
+ A message is written once its time has come, or as soon as the bytes
+ already written to the transport keep the line busy until its time (it
+ then reaches the line right on time). Due Real Time messages are written
+ first, and a message that would still be on the line when the next Real
+ Time message is due waits until it has been written: Clock keeps its
+ period whatever the traffic.\n
+ Messages are late by at most the time between two calls: call it from
+ loop() (flush() and read() do), or from a timer interrupt, in which case
+ the other send methods and sendAt must not be called while it runs.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::service(unsigned long inNow)
+{
+    typedef typename MidiInterface::MidiScheduler Scheduler;
 
-        const MidiType pendingType = getTypeFromStatusByte(mPendingMessage[0]);
+    while (!this->scheduler().isEmpty())
+    {
+        // When a byte written now gets on the line
+        const unsigned long start = this->scheduler().getLineFree(inNow);
 
-        switch (pendingType)
+        const typename Scheduler::Entry* realTime = this->scheduler().top(true);
+        if (realTime != nullptr && Scheduler::isDue(*realTime, start))
         {
-            // 1 byte messages
-            case Start:
-            case Continue:
-            case Stop:
-            case Clock:
-            case Tick:
-            case ActiveSensing:
-            case SystemReset:
-            case TuneRequest:
-                // Handle the message type directly here.
-                mMessage.type    = pendingType;
-                mMessage.channel = 0;
-                mMessage.data1   = 0;
-                mMessage.data2   = 0;
-                mMessage.valid   = true;
-
-                // Do not reset all input attributes, Running Status must remain unchanged.
-                // We still need to reset these
-                mPendingMessageIndex = 0;
-                mPendingMessageExpectedLength = 0;
-
-                return true;
-                break;
-
-            // 2 bytes messages
-            case ProgramChange:
-            case AfterTouchChannel:
-            case TimeCodeQuarterFrame:
-            case SongSelect:
-                mPendingMessageExpectedLength = 2;
-                break;
-
-            // 3 bytes messages
-            case NoteOn:
-            case NoteOff:
-            case ControlChange:
-            case PitchBend:
-            case AfterTouchPoly:
-            case SongPosition:
-                mPendingMessageExpectedLength = 3;
-                break;
-
-            case InvalidType:
-            default:
-                // This is obviously wrong. Let's get the hell out'a here.
-                mLastError |= 1UL << ErrorParse; // set the ErrorParse bit
-
-                resetInput();
-                return false;
-                break;
+            writeMessage(realTime->message);
+            this->scheduler().pop(true);
+            continue;
         }
 
-        if (mPendingMessageIndex >= (mPendingMessageExpectedLength - 1))
-        {
-            // Reception complete
-            mMessage.type    = pendingType;
-            mMessage.channel = getChannelFromStatusByte(mPendingMessage[0]);
-            mMessage.data1   = mPendingMessage[1];
-            mMessage.data2   = 0; // Completed new message has 1 data byte
-            mMessage.length  = 1;
-
-            mPendingMessageIndex = 0;
-            mPendingMessageExpectedLength = 0;
-            mMessage.valid = true;
+        const typename Scheduler::Entry* other = this->scheduler().top(false);
+        if (other == nullptr || !Scheduler::isDue(*other, start))
+            return;
 
-            return true;
-        }
-        else
+        if (realTime != nullptr)
         {
-            // Waiting for more data
-            mPendingMessageIndex++;
+            const byte length = getStatusInfo(other->message[0]) & StatusInfo::LengthMask;
+            if (Scheduler::isDue(*realTime, start + length * Scheduler::ByteTime))
+                return; // Would still be on the line, let the Real Time message go first.
         }
 
-        return (Settings::Use1ByteParsing) ? false : parse();
+        writeMessage(other->message);
+        this->scheduler().pop(false);
     }
-    else
-    {
-        // First, test if this is a status byte
-        if (extracted >= 0x80)
-        {
-            // Reception of status bytes in the middle of an uncompleted message
-            // are allowed only for interleaved Real Time message or EOX
-            switch (extracted)
-            {
-                case Clock:
-                case Start:
-                case Tick:
-                case Continue:
-                case Stop:
-                case ActiveSensing:
-                case SystemReset:
-
-                    // Here we will have to extract the one-byte message,
-                    // pass it to the structure for being read outside
-                    // the MIDI class, and recompose the message it was
-                    // interleaved into. Oh, and without killing the running status..
-                    // This is done by leaving the pending message as is,
-                    // it will be completed on next calls.
-
-                    mMessage.type    = (MidiType)extracted;
-                    mMessage.data1   = 0;
-                    mMessage.data2   = 0;
-                    mMessage.channel = 0;
-                    mMessage.length  = 1;
-                    mMessage.valid   = true;
+}
 
-                    return true;
+/*! \brief Write the scheduled messages that are due, now being Platform::nowMicros().
+ @see service(unsigned long)
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::service()
+{
+    service(Platform::nowMicros());
+}
 
-                    // Exclusive
-                case SystemExclusiveStart:
-                case SystemExclusiveEnd:
-                    // Well well well.. error.
-                    mLastError |= 1UL << ErrorParse; // set the error bits
-
-                    resetInput();
-                    return false;
-                // LCOV_EXCL_START - Coverage blind spot
-                default:
-                    break;
-                // LCOV_EXCL_STOP
-            }
-        }
+/*! \brief Drop all the scheduled messages (eg: when the sequencer stops). */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::clearSchedule()
+{
+    this->scheduler().clear();
+}
 
-        // Add extracted data byte to pending message
-        mPendingMessage[mPendingMessageIndex] = extracted;
+// Private method: write a message now (as status + 2 data bytes), with
+// running status for channel messages.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::writeMessage(const byte* inMessage)
+{
+    const StatusByte status = inMessage[0];
+    const byte info = getStatusInfo(status);
 
-        // Now we are going to check if we have reached the end of the message
-        if (mPendingMessageIndex >= (mPendingMessageExpectedLength - 1))
-        {
-            mMessage.type = getTypeFromStatusByte(mPendingMessage[0]);
+    if (info & StatusInfo::ChannelMessage)
+    {
+        writeChannelMessage(status, inMessage[1], inMessage[2]);
+        return;
+    }
 
-            if (isChannelMessage(mMessage.type))
-                mMessage.channel = getChannelFromStatusByte(mPendingMessage[0]);
-            else
-                mMessage.channel = 0;
+    if (mTransport.beginTransmission(MidiType(status)))
+    {
+        writeBytes(inMessage, info & StatusInfo::LengthMask);
+        mTransport.endTransmission();
+        updateLastSentTime();
+    }
+
+    // Common messages reset the running status,
+    // real-time messages can be interleaved anywhere.
+    if (!(info & StatusInfo::RealTime))
+        this->runningStatusTx().cancel();
+}
+
+// Private method: push back the next Active Sensing.
+// Uses the time sampled by the last read(), which can only make it come early.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::updateLastSentTime()
+{
+    this->senderActiveSensing().schedule(this->getTime());
+}
+
+/*! @} */ // End of doc group MIDI Output
+
+// -----------------------------------------------------------------------------
+
+template<class Transport, class Settings, class Platform, class Handlers>
+StatusByte MidiInterface<Transport, Settings, Platform, Handlers>::getStatus(MidiType inType,
+                                                                    Channel inChannel) const
+{
+    return StatusByte(((byte)inType | ((inChannel - 1) & 0x0f)));
+}
+
+// Private method: write an assembled message in a single call if the
+// Transport implements write(const byte*, size_t), byte by byte otherwise.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::writeBytes(const byte* inData,
+                                                                               size_t inSize)
+{
+    const unsigned long start = sampleSendTime(BoolTag<Settings::UseStatistics>());
+
+    writeBytes(inData, inSize, BoolTag<HasBulkWrite<Transport>::value>());
+
+    this->countSendTime(sampleSendTime(BoolTag<Settings::UseStatistics>()) - start);
+    occupyLine(inSize);
+}
+
+// Private method: scheduled messages are timed from the end of the bytes written.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::occupyLine(size_t inSize)
+{
+    if (Settings::ScheduledMessages != 0 && this->scheduler().ByteTime != 0)
+        this->scheduler().occupyLine(sampleLineTime(BoolTag<Settings::ScheduledMessages != 0>()), inSize);
+}
+
+// Private method: the scheduler is the only user of the clock on output,
+// platforms without nowMicros() are fine without it.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleLineTime(BoolTag<true>)
+{
+    return Platform::nowMicros();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleLineTime(BoolTag<false>)
+{
+    return 0;
+}
+
+// Private method: time spent sending is only measured for the statistics
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleSendTime(BoolTag<true>)
+{
+    return Platform::nowMicros();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleSendTime(BoolTag<false>)
+{
+    return 0;
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::writeBytes(const byte* inData,
+                                                                               size_t inSize,
+                                                                               BoolTag<true>)
+{
+    mTransport.write(inData, inSize);
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::writeBytes(const byte* inData,
+                                                                               size_t inSize,
+                                                                               BoolTag<false>)
+{
+    for (size_t i = 0; i < inSize; ++i)
+        mTransport.write(inData[i]);
+}
+
+// -----------------------------------------------------------------------------
+//                                  Input
+// -----------------------------------------------------------------------------
+
+/*! \addtogroup input
+ @{
+*/
+
+/*! \brief Read messages from the serial port using the main input channel.
+
+ \return True if a valid message has been stored in the structure, false if not.
+ A valid message is a message that matches the input channel. \n\n
+ If the Thru is enabled and the message matches the filter,
+ it is sent back on the MIDI output (whatever the channel given to read).
+ Queued output messages (see DefaultSettings::TxQueueSize) are flushed.
+ @see see setInputChannel()
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::read()
+{
+    return read(mInputChannel);
+}
+
+/*! \brief Read messages on a specified channel.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::read(Channel inChannel)
+{
+    updateActiveSensing();
+    flush();
+
+    if (inChannel >= MIDI_CHANNEL_OFF)
+        return false; // MIDI Input disabled.
+
+    if (!expireHeldController())
+    {
+        if (!takeDeferredMessage())
+        {
+            if (!parse())
+                return false;
+
+            thruFilter();
+            processReceivedMessage();
+        }
+
+        if (!releaseHeldController() && (!decodeParameter() || !pairController()))
+            return false;
+    }
+
+    const bool channelMatch = inputFilter(inChannel);
+    if (channelMatch)
+        launchCallback();
+
+    return channelMatch;
+}
+
+/*! \brief Drain the transport into a caller-owned array of messages,
+ using the main input channel.
+ @see readBatch(MidiMessage*, unsigned, Channel)
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned MidiInterface<Transport, Settings, Platform, Handlers>::readBatch(MidiMessage* outMessages,
+                                                                                  unsigned inMaxMessages)
+{
+    return readBatch(outMessages, inMaxMessages, mInputChannel);
+}
+
+/*! \brief Drain the transport into a caller-owned array of messages.
+ \param outMessages    Where to append the received messages.
+ \param inMaxMessages  Capacity of outMessages.
+ \param inChannel      The channel to listen to (same as read(Channel)).
+ \return The number of messages written to outMessages.
+
+ Parses every byte the transport currently holds (or until outMessages is
+ full) in a single call, and stores each completed message that passes the
+ channel filter. Active Sensing is checked once per batch rather than once per
+ message, which makes this cheaper than calling read() in a loop under dense
+ traffic. A partial message left at the end of the batch is kept pending and
+ will be completed by the next call.
+ To fill a ring buffer, call it once per contiguous free region.
+ The batch stops after a SysEx chunk or a parameter event (see
+ isParameterEvent), as the next one would overwrite it.
+ The last message written is also available through getType(), getData1()...
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+unsigned MidiInterface<Transport, Settings, Platform, Handlers>::readBatch(MidiMessage* outMessages,
+                                                                           unsigned inMaxMessages,
+                                                                           Channel inChannel)
+{
+    return readEvents(outMessages, inMaxMessages, inChannel);
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned MidiInterface<Transport, Settings, Platform, Handlers>::readBatch(PackedMessage* outMessages,
+                                                                                  unsigned inMaxMessages)
+{
+    return readBatch(outMessages, inMaxMessages, mInputChannel);
+}
+
+/*! \brief Drain the transport into an array of packed messages.
+ Same as readBatch(MidiMessage*, unsigned, Channel), in 4 bytes per message
+ (without timestamps).
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+unsigned MidiInterface<Transport, Settings, Platform, Handlers>::readBatch(PackedMessage* outMessages,
+                                                                           unsigned inMaxMessages,
+                                                                           Channel inChannel)
+{
+    return readEvents(outMessages, inMaxMessages, inChannel);
+}
+
+// Private method: readBatch for both message forms.
+template<class Transport, class Settings, class Platform, class Handlers>
+template<class Event>
+inline unsigned MidiInterface<Transport, Settings, Platform, Handlers>::readEvents(Event* outMessages,
+                                                                                   unsigned inMaxMessages,
+                                                                                   Channel inChannel)
+{
+    updateActiveSensing();
+    flush();
+
+    if (inChannel >= MIDI_CHANNEL_OFF)
+        return 0; // MIDI Input disabled.
+
+    unsigned count = 0;
+    if (inMaxMessages > 0 && expireHeldController() && inputFilter(inChannel))
+    {
+        launchCallback();
+        outMessages[count++] = Event(mMessage);
+    }
+
+    while (count < inMaxMessages)
+    {
+        if (!takeDeferredMessage())
+        {
+            if (mTransport.available() == 0)
+                break;
+            if (!parse())
+                continue;
+
+            thruFilter();
+            processReceivedMessage();
+        }
+
+        if (!releaseHeldController() && (!decodeParameter() || !pairController()))
+            continue;
+
+        if (inputFilter(inChannel))
+        {
+            launchCallback();
+            outMessages[count++] = Event(mMessage);
+
+            // Let the caller consume the chunk / event before it gets overwritten.
+            if (mMessage.type == SystemExclusive || this->parameterDecoder().isEventReady())
+                break;
+        }
+    }
+    return count;
+}
+
+/*! \brief Parse at most inMaxBytes bytes, on the main input channel.
+ \return True if the transport still holds bytes after the call.
+
+ Each message completed is dispatched to the callbacks (or Handlers), as
+ read() would. The parser resumes where it stopped on the next call, even
+ in the middle of a message. Unlike Use1ByteParsing, the amount of work
+ per call is chosen at run time: a loop can give MIDI more bytes when the
+ return value tells there is a backlog, and less when it is busy.
+ The getters (getType()...) give the last message completed.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+bool MidiInterface<Transport, Settings, Platform, Handlers>::poll(unsigned inMaxBytes)
+{
+    beginPoll();
+    pollBytes(inMaxBytes);
+    return mTransport.available() > 0;
+}
+
+/*! \brief Parse for about inMicros us, on the main input channel.
+ \return True if the transport still holds bytes after the call.
+
+ Same as poll(unsigned), the clock (Platform::nowMicros) is checked each
+ time a channel message worth of bytes (3) has been parsed, the call can
+ then last a little longer than inMicros if a callback is slow.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+bool MidiInterface<Transport, Settings, Platform, Handlers>::pollFor(unsigned long inMicros)
+{
+    const unsigned long start = Platform::nowMicros();
+    beginPoll();
+    while (mTransport.available() > 0)
+    {
+        pollBytes(3);
+        if (Platform::nowMicros() - start >= inMicros)
+            break;
+    }
+    return mTransport.available() > 0;
+}
+
+// Private method: once per poll, like read() does for each call
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::beginPoll()
+{
+    updateActiveSensing();
+    flush();
+
+    if (mInputChannel < MIDI_CHANNEL_OFF && expireHeldController() && inputFilter(mInputChannel))
+        launchCallback();
+}
+
+// Private method: parse and dispatch up to inMaxBytes bytes
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::pollBytes(unsigned inMaxBytes)
+{
+    if (mInputChannel >= MIDI_CHANNEL_OFF)
+        return; // MIDI Input disabled.
+
+    for (;;)
+    {
+        if (!takeDeferredMessage())
+        {
+            if (inMaxBytes == 0 || mTransport.available() == 0)
+                break;
+            if (!parse<true>(inMaxBytes))
+                continue;
+
+            thruFilter();
+            processReceivedMessage();
+        }
+
+        if (!releaseHeldController() && (!decodeParameter() || !pairController()))
+            continue;
+
+        if (inputFilter(mInputChannel))
+            launchCallback();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// Private method: send and check Active Sensing before reading new input
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::updateActiveSensing()
+{
+    #ifndef RegionActiveSending
+    // Active Sensing. This message is intended to be sent
+    // repeatedly to tell the receiver that a connection is alive. Use
+    // of this message is optional. When initially received, the
+    // receiver will expect to receive another Active Sensing
+    // message each 300ms (max), and if it does not then it will
+    // assume that the connection has been terminated. At
+    // termination, the receiver will turn off all voices and return to
+    // normal (non- active sensing) operation.
+    //
+    // The clock is sampled once, and compared to deadlines computed when
+    // messages are sent / received (wrap-around safe).
+    sampleTime();
+
+    if (this->senderActiveSensing().isDue(this->getTime()))
+    {
+        sendActiveSensing();
+        this->senderActiveSensing().schedule(this->getTime());
+    }
+
+    if (this->receiverActiveSensing().expire(this->getTime()))
+    {
+        mLastError |= 1UL << ErrorActiveSensingTimeout; // set the ErrorActiveSensingTimeout bit
+        launchErrorCallback();
+
+        // The sender is gone, its notes would hang.
+        if (Settings::UseStateTracker)
+            panic();
+    }
+    #endif
+}
+
+// Private method: sample the clock for the current read, unless the
+// application provides the time (see setCurrentTime) or nothing needs it.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::sampleTime()
+{
+    if (this->UseClock && !Settings::UseExternalTime)
+        this->setTime(Platform::now());
+}
+
+/*! \brief Give the current time to the library, in milliseconds.
+
+ With Settings::UseExternalTime, the library never reads the clock itself:
+ call this before read() (eg: from a timer tick) to drive Active Sensing.
+ It has no effect otherwise.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setCurrentTime(unsigned long inTime)
+{
+    if (Settings::UseExternalTime)
+        this->setTime(inTime);
+}
+
+// Private method: push back the Active Sensing timeout on reception,
+// using the time sampled at the start of read()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::refreshReceiverTimeout()
+{
+    this->receiverActiveSensing().refresh(this->getTime());
+}
+
+// Private method: bookkeeping for a freshly parsed message in mMessage
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::processReceivedMessage()
+{
+    this->countMessageReceived(mMessage.type);
+
+    #ifndef RegionActiveSending
+
+    if (Settings::UseReceiverActiveSensing && mMessage.type == ActiveSensing)
+    {
+        // When an ActiveSensing message is received, the time keeping is activated.
+        // When a timeout occurs, an error message is send and time keeping ends.
+        this->receiverActiveSensing().activate();
+
+        // is ErrorActiveSensingTimeout bit in mLastError on
+        if (mLastError & (1 << (ErrorActiveSensingTimeout - 1)))
+        {
+            mLastError &= ~(1UL << ErrorActiveSensingTimeout); // clear the ErrorActiveSensingTimeout bit
+            launchErrorCallback();
+        }
+    }
+
+    refreshReceiverTimeout();
+
+    #endif
+
+    this->stateTracker().process(mMessage.type, mMessage.channel, mMessage.data1, mMessage.data2);
+
+    if (Settings::UseClockFollower || Settings::UseTimeCodeDecoder)
+    {
+        const unsigned long time = sampleArrivalTime(BoolTag<MidiInterface::UseArrivalTime>());
+        this->clockFollower().process(mMessage.type, mMessage.data1, mMessage.data2, time);
+        this->timeCodeDecoder().process(mMessage.type, mMessage.data1, time);
+
+        if (Settings::UseTimeCodeDecoder && mMessage.type == SystemExclusive)
+            this->timeCodeDecoder().processFullFrame(getSysExArray(), getSysExArrayLength(), time);
+    }
+
+    handleNullVelocityNoteOnAsNoteOff();
+}
+
+// -----------------------------------------------------------------------------
+
+// Private method: feed Control Changes to the RPN / NRPN decoder.
+// Returns false if the message is swallowed.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::decodeParameter()
+{
+    this->parameterDecoder().clearEvent();
+
+    if (!Settings::UseParameterDecoder)
+        return true;
+
+    if (mMessage.type == SystemReset)
+    {
+        this->parameterDecoder().reset();
+        return true;
+    }
+    if (mMessage.type != ControlChange)
+        return true;
+
+    typedef typename MidiInterface::MidiParameterDecoder Decoder;
+    switch (this->parameterDecoder().process(mMessage.channel, mMessage.data1, mMessage.data2))
+    {
+        case Decoder::Event:
+            return true;
+        case Decoder::Selection:
+            return !Settings::SwallowParameterControllers;
+        default:
+            return true;
+    }
+}
+
+// Private method: pair MSB / LSB Control Changes (0-31 / 32-63).
+// Returns false if the message is held (MSB waiting for its LSB).
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::pairController()
+{
+    this->controllerPairing().clearEvent();
+
+    if (!Settings::UseControllerPairing)
+        return true;
+
+    if (mMessage.type == SystemReset)
+    {
+        this->controllerPairing().reset();
+        return true;
+    }
+    if (mMessage.type != ControlChange)
+        return true;
+
+    typedef typename MidiInterface::MidiControllerPairing Pairing;
+    switch (this->controllerPairing().process(mMessage.channel,
+                                       mMessage.data1,
+                                       mMessage.data2,
+                                       this->getTime(),
+                                       Settings::ControllerPairingTimeout))
+    {
+        case Pairing::Event:
+            storeControlChange14();
+            return true;
+        case Pairing::Held:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Private method: read the MSB held on the channel of the message received,
+// if the message would overtake it. The message is read next.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::releaseHeldController()
+{
+    if (!Settings::UseControllerPairing || !this->controllerPairing().defer(mMessage))
+        return false;
+
+    this->parameterDecoder().clearEvent();
+    storeControlChange14();
+    return true;
+}
+
+// Private method: restore the message deferred by releaseHeldController.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::takeDeferredMessage()
+{
+    return Settings::UseControllerPairing && this->controllerPairing().takeDeferred(mMessage);
+}
+
+// Private method: read an MSB whose LSB did not come in time.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::expireHeldController()
+{
+    if (!Settings::UseControllerPairing || Settings::ControllerPairingTimeout == 0)
+        return false;
+
+    if (!this->controllerPairing().expire(this->getTime()))
+        return false;
+
+    storeControlChange14();
+    return true;
+}
+
+// Private method: expose a paired value as a Control Change on the MSB.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::storeControlChange14()
+{
+    const ControlChange14& event = this->controllerPairing().getEvent();
+
+    mMessage.type    = ControlChange;
+    mMessage.channel = event.channel;
+    mMessage.data1   = event.number;
+    mMessage.data2   = byte(event.value >> 7);
+    mMessage.length  = 3;
+    mMessage.valid   = true;
+}
+
+// Private method: parse up to the next message, or a single byte with
+// Use1ByteParsing
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::parse()
+{
+    unsigned unused = 0;
+    return parse<false>(unused);
+}
+
+// Private method: MIDI parser, returns true as soon as a message is complete.
+// Bounded reads at most ioMaxBytes bytes (counted down) whatever
+// Use1ByteParsing, for poll(). Unbounded keeps the count out of the loop.
+template<class Transport, class Settings, class Platform, class Handlers>
+template<bool Bounded>
+bool MidiInterface<Transport, Settings, Platform, Handlers>::parse(unsigned& ioMaxBytes)
+{
+    // Parsing algorithm:
+    // Get a byte from the serial buffer.
+    // If there is no pending message to be recomposed, start a new one.
+    //  - Find type and channel (if pertinent)
+    //  - Look for other bytes in buffer, looping (Use1ByteParsing disabled,
+    //    or up to ioMaxBytes when Bounded) until the message is assembled or
+    //    the buffer is empty.
+    // Else, add the extracted byte to the pending message, and check validity.
+    // When the message is done, store it.
+    // Byte properties (expected length, channel & running status eligibility)
+    // come from StatusInfoTable rather than from the type helpers.
+
+    unsigned available = mTransport.available();
+
+    while (available != 0)
+    {
+        // clear the ErrorParse bit
+        mLastError &= ~(1UL << ErrorParse);
+
+        const byte extracted = mTransport.read();
+        const byte info      = getStatusInfo(extracted);
+        this->countByteReceived();
+        if (Bounded)
+            ioMaxBytes--;
+
+        if (mPendingMessageIndex != 0
+            && extracted >= 0x80
+            && !(info & (StatusInfo::RealTime | StatusInfo::Ignored))
+            && !(extracted == SystemExclusiveEnd && mPendingMessage[0] == SystemExclusiveStart))
+        {
+            // A status byte ends the message or SysEx frame being received
+            // (which is dropped), and starts a new message (MIDI 1.0).
+            mLastError |= 1UL << ErrorParse; // set the ErrorParse bit
+            this->countParseError();
+            launchErrorCallback();
+
+            if (mPendingMessage[0] == SystemExclusiveStart)
+                this->sysExInput().reset();
+            mPendingMessageIndex = 0;
+            mPendingMessageExpectedLength = 0;
+        }
+
+        if (info & StatusInfo::Ignored)
+        {
+            // Ignore Undefined
+            this->countUndefinedByte();
+        }
+        else if (Settings::UseSysExInput
+              && mPendingMessageIndex != 0
+              && mPendingMessage[0] == SystemExclusiveStart
+              && !(info & StatusInfo::RealTime))
+        {
+            // Receiving a SysEx frame: bytes go straight to the user buffer.
+            // (only data bytes and F7 here, other status bytes ended it above)
+            if (mPendingMessageRejected)
+            {
+                if (extracted == SystemExclusiveEnd)
+                    skipPendingMessage();
+            }
+            else if (this->sysExInput().write(extracted))
+            {
+                completeSysExChunk(extracted == SystemExclusiveEnd);
+                return true;
+            }
+        }
+        else if (mPendingMessageIndex == 0)
+        {
+            // Start a new pending message
+            this->timestampLatch().set(latchTimestamp(BoolTag<Settings::UseTimestamps>()));
+            mPendingMessage[0] = extracted;
+            byte pendingInfo   = info;
+
+            // Check for running status first (only channel messages allow it).
+            // If the status byte is not received, prepend it
+            // to the pending message. If we received another status byte,
+            // the running status does not apply here, it will be updated
+            // upon completion of this message.
+            if (extracted < 0x80)
+            {
+                const byte runningInfo = getStatusInfo(mRunningStatus_RX);
+                if (runningInfo & StatusInfo::RunningStatus)
+                {
+                    mPendingMessage[0]   = mRunningStatus_RX;
+                    mPendingMessage[1]   = extracted;
+                    mPendingMessageIndex = 1;
+                    pendingInfo          = runningInfo;
+                    this->countRunningStatusReceived();
+                }
+            }
+
+            mPendingMessageExpectedLength = pendingInfo & StatusInfo::LengthMask;
+
+            // Messages nobody wants are skimmed without being stored.
+            mPendingMessageRejected = !acceptStatus(mPendingMessage[0], pendingInfo);
+
+            if (Settings::UseSysExInput
+                && extracted == SystemExclusiveStart
+                && (this->sysExInput().isReady() || mPendingMessageRejected))
+            {
+                // System Exclusive cancels running status.
+                mRunningStatus_RX    = InvalidType;
+                mPendingMessageIndex = 1;
+
+                if (!mPendingMessageRejected && this->sysExInput().write(extracted))
+                {
+                    completeSysExChunk(false);
+                    return true;
+                }
+            }
+            else if (mPendingMessageExpectedLength == 0)
+            {
+                // Data byte without running status, SysEx or undefined status.
+                // This is obviously wrong. Let's get the hell out'a here.
+                mLastError |= 1UL << ErrorParse; // set the ErrorParse bit
+                this->countParseError();
+                launchErrorCallback();
 
-            mMessage.data1 = mPendingMessage[1];
-            // Save data2 only if applicable
-            mMessage.data2 = mPendingMessageExpectedLength == 3 ? mPendingMessage[2] : 0;
+                resetInput();
+                return false;
+            }
 
-            // Reset local variables
-            mPendingMessageIndex = 0;
-            mPendingMessageExpectedLength = 0;
+            else if (mPendingMessageIndex + 1 >= mPendingMessageExpectedLength)
+            {
+                // Reception complete: one byte messages, or two bytes messages
+                // using running status. Running Status must remain unchanged,
+                // but for Tune Request (System Common messages cancel it).
+                if (extracted >= 0x80 && !(pendingInfo & StatusInfo::RealTime))
+                    mRunningStatus_RX = InvalidType;
 
-            mMessage.valid = true;
+                if (mPendingMessageRejected)
+                {
+                    skipPendingMessage();
+                }
+                else
+                {
+                    completePendingMessage(pendingInfo);
+                    return true;
+                }
+            }
 
-            // Activate running status (if enabled for the received type)
-            switch (mMessage.type)
+            else
             {
-                case NoteOff:
-                case NoteOn:
-                case AfterTouchPoly:
-                case ControlChange:
-                case ProgramChange:
-                case AfterTouchChannel:
-                case PitchBend:
-                    // Running status enabled: store it from received message
-                    mRunningStatus_RX = mPendingMessage[0];
-                    break;
-
-                default:
-                    // No running status
-                    mRunningStatus_RX = InvalidType;
-                    break;
+                // Waiting for more data
+                mPendingMessageIndex++;
             }
-            return true;
+        }
+        else if (info & StatusInfo::RealTime)
+        {
+            // Reception of status bytes in the middle of an uncompleted message
+            // are allowed only for interleaved Real Time message or EOX.
+            // Here we will have to extract the one-byte message,
+            // pass it to the structure for being read outside
+            // the MIDI class, and recompose the message it was
+            // interleaved into. Oh, and without killing the running status..
+            // This is done by leaving the pending message as is,
+            // it will be completed on next calls.
+            if (acceptStatus(extracted, info))
+            {
+                mMessage.type    = MidiType(extracted);
+                mMessage.channel = 0;
+                mMessage.data1   = 0;
+                mMessage.data2   = 0;
+                mMessage.length  = 1;
+                mMessage.valid   = true;
+                mMessage.timestamp = latchTimestamp(BoolTag<Settings::UseTimestamps>());
+
+                return true;
+            }
+            this->countFilteredMessage();
+            refreshReceiverTimeout();
         }
         else
         {
-            // Then update the index of the pending message.
-            mPendingMessageIndex++;
+            // Add extracted data byte to pending message
+            // (other status bytes ended the pending message above)
+            mPendingMessage[mPendingMessageIndex] = extracted;
+
+            // Now we are going to check if we have reached the end of the message
+            if (mPendingMessageIndex + 1 >= mPendingMessageExpectedLength)
+            {
+                const byte pendingInfo = getStatusInfo(mPendingMessage[0]);
+
+                // Activate running status (if enabled for the received type)
+                mRunningStatus_RX = (pendingInfo & StatusInfo::RunningStatus)
+                                  ? mPendingMessage[0]
+                                  : StatusByte(InvalidType);
 
-            return (Settings::Use1ByteParsing) ? false : parse();
+                if (!mPendingMessageRejected)
+                {
+                    completePendingMessage(pendingInfo);
+                    return true;
+                }
+                skipPendingMessage();
+            }
+            else
+            {
+                // Then update the index of the pending message.
+                mPendingMessageIndex++;
+            }
         }
+
+        if (Bounded ? ioMaxBytes == 0 : Settings::Use1ByteParsing)
+            return false;
+
+        if (--available == 0)
+            available = mTransport.available();
+    }
+
+    return false;
+}
+
+// Private method: time of the byte just read, if timestamps are enabled
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::latchTimestamp(BoolTag<true>)
+{
+    return readTimestamp(BoolTag<HasReadTimestamp<Transport>::value>());
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::latchTimestamp(BoolTag<false>)
+{
+    return 0;
+}
+
+// Private method: arrival time of mMessage for the clock follower and the
+// time code decoder, sampled now unless the message is already timestamped
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleArrivalTime(BoolTag<true>)
+{
+    return Platform::nowMicros();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::sampleArrivalTime(BoolTag<false>)
+{
+    return mMessage.timestamp;
+}
+
+// The transport timed the byte itself (eg: in its RX interrupt)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::readTimestamp(BoolTag<true>)
+{
+    return mTransport.readTimestamp();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::readTimestamp(BoolTag<false>)
+{
+    return Platform::nowMicros();
+}
+
+// Private method: store the assembled pending message into mMessage
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::completePendingMessage(byte inInfo)
+{
+    const StatusByte status = mPendingMessage[0];
+    const byte length = mPendingMessageExpectedLength;
+
+    if (inInfo & StatusInfo::ChannelMessage)
+    {
+        mMessage.type    = MidiType(status & 0xf0);
+        mMessage.channel = getChannelFromStatusByte(status);
+    }
+    else
+    {
+        mMessage.type    = MidiType(status);
+        mMessage.channel = 0;
+    }
+
+    mMessage.data1  = length > 1 ? mPendingMessage[1] : 0;
+    mMessage.data2  = length > 2 ? mPendingMessage[2] : 0;
+    mMessage.length = length;
+    mMessage.valid  = true;
+    mMessage.timestamp = this->timestampLatch().get();
+
+    // Reset local variables
+    mPendingMessageIndex = 0;
+    mPendingMessageExpectedLength = 0;
+}
+
+// Private method: expose the SysEx bytes received so far into mMessage
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::completeSysExChunk(bool inLastChunk)
+{
+    const unsigned length = this->sysExInput().getLength();
+
+    // The chunk length is stored in the data bytes (LSB first),
+    // @see getSysExArrayLength
+    mMessage.type    = SystemExclusive;
+    mMessage.channel = 0;
+    mMessage.data1   = length & 0xff;
+    mMessage.data2   = byte(length >> 8);
+    mMessage.length  = 0;
+    mMessage.valid   = true;
+    mMessage.timestamp = this->timestampLatch().get();
+
+    // The next chunk is written from the start of the buffer.
+    this->sysExInput().reset();
+
+    if (inLastChunk)
+    {
+        mPendingMessageIndex = 0;
+        mPendingMessageExpectedLength = 0;
+
+        mLastError &= ~(1UL << WarningSplitSysEx); // clear the WarningSplitSysEx bit
+    }
+    else
+    {
+        mLastError |= 1UL << WarningSplitSysEx; // set the WarningSplitSysEx bit
+        launchErrorCallback();
     }
 }
 
+// Private method: call the input handlers for the message in mMessage
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::launchCallback()
+{
+    byte* sysEx = this->sysExInput().getData();
+    const unsigned sysExLength = getSysExArrayLength();
+
+    callHandlers<Handlers>(mMessage, sysEx, sysExLength);
+    this->callCallbacks(mMessage, sysEx, sysExLength);
+}
+
+// Private method: notify the input handlers that mLastError has changed
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::launchErrorCallback()
+{
+    Handlers::handleError(mLastError);
+    this->callErrorCallback(mLastError);
+}
+
 // Private method, see midi_Settings.h for documentation
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::handleNullVelocityNoteOnAsNoteOff()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::handleNullVelocityNoteOnAsNoteOff()
 {
     if (Settings::HandleNullVelocityNoteOnAsNoteOff &&
         getType() == NoteOn && getData2() == 0)
@@ -967,24 +1982,37 @@ inline void MidiInterface<Transport, Settings, Platform>::handleNullVelocityNote
 }
 
 // Private method: check if the received message is on the listened channel
-template<class Transport, class Settings, class Platform>
-inline bool MidiInterface<Transport, Settings, Platform>::inputFilter(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::inputFilter(Channel inChannel)
 {
     // This method handles recognition of channel
     // (to know if the message is destinated to the Arduino)
 
+    // Messages parsed for the Thru only
+    if (!(mInputTypeMask & getTypeBit(mMessage.type)))
+    {
+        this->countFilteredMessage();
+        return false;
+    }
+
     // First, check if the received message is Channel
     if (mMessage.type >= NoteOff && mMessage.type <= PitchBend)
     {
         // Then we need to know if we listen to it
-        if ((mMessage.channel == inChannel) ||
-            (inChannel == MIDI_CHANNEL_OMNI))
+        if (!(mInputChannelMask & (1u << (mMessage.channel - 1))))
+        {
+            this->countFilteredMessage();
+            return false;
+        }
+        else if ((mMessage.channel == inChannel) ||
+                 (inChannel == MIDI_CHANNEL_OMNI))
         {
             return true;
         }
         else
         {
             // We don't listen to this channel
+            this->countFilteredMessage();
             return false;
         }
     }
@@ -995,9 +2023,49 @@ inline bool MidiInterface<Transport, Settings, Platform>::inputFilter(Channel in
     }
 }
 
+// Private method: early input filter, from the status byte of a message.
+// Messages rejected by the input masks are still parsed if the Thru wants them.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::acceptStatus(StatusByte inStatus,
+                                                                                 byte inInfo) const
+{
+    if (inStatus < 0x80)
+        return true; // Stray data byte, reported as a parse error
+
+    if (inInfo & StatusInfo::ChannelMessage)
+    {
+        const uint16_t channelBit = uint16_t(1) << (inStatus & 0x0f);
+        if ((mInputChannelMask & channelBit)
+            && (mInputTypeMask & getTypeBit(MidiType(inStatus & 0xf0))))
+            return true;
+
+        return mThruChannelMask & channelBit;
+    }
+
+    if (mInputTypeMask & getTypeBit(MidiType(inStatus)))
+        return true;
+
+    // Active Sensing feeds the receiver timeout, even if the application
+    // does not want to read it.
+    if (Settings::UseReceiverActiveSensing && inStatus == ActiveSensing)
+        return true;
+
+    return mThruFilterMode != Thru::Off;
+}
+
+// Private method: drop a message rejected by acceptStatus
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::skipPendingMessage()
+{
+    mPendingMessageIndex = 0;
+    mPendingMessageExpectedLength = 0;
+    this->countFilteredMessage();
+    refreshReceiverTimeout();
+}
+
 // Private method: reset input attributes
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::resetInput()
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::resetInput()
 {
     mPendingMessageIndex = 0;
     mPendingMessageExpectedLength = 0;
@@ -1010,8 +2078,8 @@ inline void MidiInterface<Transport, Settings, Platform>::resetInput()
 
  Returns an enumerated type. @see MidiType
  */
-template<class Transport, class Settings, class Platform>
-inline MidiType MidiInterface<Transport, Settings, Platform>::getType() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline MidiType MidiInterface<Transport, Settings, Platform, Handlers>::getType() const
 {
     return mMessage.type;
 }
@@ -1021,37 +2089,91 @@ inline MidiType MidiInterface<Transport, Settings, Platform>::getType() const
  \return Channel range is 1 to 16.
  For non-channel messages, this will return 0.
  */
-template<class Transport, class Settings, class Platform>
-inline Channel MidiInterface<Transport, Settings, Platform>::getChannel() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline Channel MidiInterface<Transport, Settings, Platform, Handlers>::getChannel() const
 {
     return mMessage.channel;
 }
 
 /*! \brief Get the first data byte of the last received message. */
-template<class Transport, class Settings, class Platform>
-inline DataByte MidiInterface<Transport, Settings, Platform>::getData1() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline DataByte MidiInterface<Transport, Settings, Platform, Handlers>::getData1() const
 {
     return mMessage.data1;
 }
 
 /*! \brief Get the second data byte of the last received message. */
-template<class Transport, class Settings, class Platform>
-inline DataByte MidiInterface<Transport, Settings, Platform>::getData2() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline DataByte MidiInterface<Transport, Settings, Platform, Handlers>::getData2() const
 {
     return mMessage.data2;
 }
 
+/*! \brief Get the SysEx chunk of the last received message.
+ \return The buffer given to setSysExBuffer, holding getSysExArrayLength() bytes.
+ The first chunk of a frame starts with 0xF0, the last one ends with 0xF7.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const byte* MidiInterface<Transport, Settings, Platform, Handlers>::getSysExArray() const
+{
+    return this->sysExInput().getData();
+}
+
+/*! \brief Get the length of the SysEx chunk of the last received message.
+ \return 0 if the last received message is not a SystemExclusive one.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned MidiInterface<Transport, Settings, Platform, Handlers>::getSysExArrayLength() const
+{
+    if (mMessage.type != SystemExclusive)
+        return 0;
+
+    return unsigned(mMessage.data2) << 8 | mMessage.data1;
+}
+
+/*! \brief Provide the buffer SysEx chunks are received into.
+ \param inBuffer Caller-owned storage, must outlive the reception.
+ \param inSize   Chunk size, in bytes.
+ Needs DefaultSettings::UseSysExInput, SysEx frames are rejected until a
+ buffer is set. Each chunk is only valid until the next call to read().
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setSysExBuffer(byte* inBuffer,
+                                                                                   unsigned inSize)
+{
+    this->sysExInput().setBuffer(inBuffer, inSize);
+}
+
 /*! \brief Check if a valid message is stored in the structure. */
-template<class Transport, class Settings, class Platform>
-inline bool MidiInterface<Transport, Settings, Platform>::check() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::check() const
 {
     return mMessage.valid;
 }
 
+/*! \brief Get the error and warning bits set by the last operations.
+ Test them with (1 << ErrorParse), (1 << WarningSplitSysEx)...
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline int8_t MidiInterface<Transport, Settings, Platform, Handlers>::getLastError() const
+{
+    return mLastError;
+}
+
+/*! \brief Get the time at which the last received message started, in microseconds.
+ For SysEx, all the chunks of a frame carry the time of the 0xF0 byte.
+ Always 0 unless Settings::UseTimestamps is enabled.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline unsigned long MidiInterface<Transport, Settings, Platform, Handlers>::getTimestamp() const
+{
+    return mMessage.timestamp;
+}
+
 // -----------------------------------------------------------------------------
 
-template<class Transport, class Settings, class Platform>
-inline Channel MidiInterface<Transport, Settings, Platform>::getInputChannel() const
+template<class Transport, class Settings, class Platform, class Handlers>
+inline Channel MidiInterface<Transport, Settings, Platform, Handlers>::getInputChannel() const
 {
     return mInputChannel;
 }
@@ -1060,10 +2182,159 @@ inline Channel MidiInterface<Transport, Settings, Platform>::getInputChannel() c
  \param inChannel the channel value. Valid values are 1 to 16, MIDI_CHANNEL_OMNI
  if you want to listen to all channels, and MIDI_CHANNEL_OFF to disable input.
  */
-template<class Transport, class Settings, class Platform>
-inline void MidiInterface<Transport, Settings, Platform>::setInputChannel(Channel inChannel)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setInputChannel(Channel inChannel)
 {
     mInputChannel = inChannel;
+    updateThruChannelMask();
+}
+
+/*! \brief Get the channels accepted on input, @see setInputChannelMask */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline uint16_t MidiInterface<Transport, Settings, Platform, Handlers>::getInputChannelMask() const
+{
+    return mInputChannelMask;
+}
+
+/*! \brief Restrict the input to a set of channels.
+ \param inChannelMask Bit 0 for channel 1 to bit 15 for channel 16 (default: all).
+
+ Unlike the channel given to read(), this is checked on the status byte:
+ the rest of the message is skipped without being stored, unless it goes
+ through the Thru. Both filters apply.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setInputChannelMask(uint16_t inChannelMask)
+{
+    mInputChannelMask = inChannelMask;
+}
+
+/*! \brief Get the message types accepted on input, @see setInputTypeMask */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline uint32_t MidiInterface<Transport, Settings, Platform, Handlers>::getInputTypeMask() const
+{
+    return mInputTypeMask;
+}
+
+/*! \brief Restrict the input to a set of message types.
+ \param inTypeMask OR'ed getTypeBit() of the accepted types (default: all).
+ Eg: ~(getTypeBit(AfterTouchPoly) | getTypeBit(Clock)).
+ Rejected messages are skipped from their status byte, @see setInputChannelMask.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setInputTypeMask(uint32_t inTypeMask)
+{
+    mInputTypeMask = inTypeMask;
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Tempo and position of the clock received,
+ see DefaultSettings::UseClockFollower.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const typename MidiInterface<Transport, Settings, Platform, Handlers>::MidiClockFollower&
+MidiInterface<Transport, Settings, Platform, Handlers>::getClockFollower() const
+{
+    return this->clockFollower();
+}
+
+/*! \brief Time code received, see DefaultSettings::UseTimeCodeDecoder.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const typename MidiInterface<Transport, Settings, Platform, Handlers>::MidiTimeCodeDecoder&
+MidiInterface<Transport, Settings, Platform, Handlers>::getTimeCodeDecoder() const
+{
+    return this->timeCodeDecoder();
+}
+
+/*! \brief Notes held and controllers received so far,
+ see DefaultSettings::UseStateTracker.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const typename MidiInterface<Transport, Settings, Platform, Handlers>::MidiStateTracker&
+MidiInterface<Transport, Settings, Platform, Handlers>::getStateTracker() const
+{
+    return this->stateTracker();
+}
+
+/*! \brief Send a NoteOff for each note held on the input, and forget them.
+
+ Only the notes actually held are released (2 bytes per note with
+ UseRunningStatus), rather than all 2048 notes of the 16 channels.
+ Called when Active Sensing times out, does nothing without UseStateTracker.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+void MidiInterface<Transport, Settings, Platform, Handlers>::panic()
+{
+    this->stateTracker().forEachHeldNote([this](Channel inChannel, DataByte inNote) {
+        sendNoteOff(inNote, 0, inChannel);
+    });
+    this->stateTracker().releaseAllNotes();
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Tell whether the last message read completes an RPN / NRPN operation.
+ Always false without Settings::UseParameterDecoder.
+ @see getParameterEvent
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::isParameterEvent() const
+{
+    return this->parameterDecoder().isEventReady();
+}
+
+/*! \brief Get the RPN / NRPN operation completed by the last message read.
+ Only valid when isParameterEvent() returns true. Eg:
+ \code{.cpp}
+ if (midi.read() && midi.isParameterEvent())
+ {
+     const midi::ParameterEvent& event = midi.getParameterEvent();
+     if (event.kind == midi::ParameterEvent::Registered &&
+         event.number == midi::RPN::PitchBendSensitivity)
+         setBendRange(event.channel, event.value >> 7);
+ }
+ \endcode
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const ParameterEvent& MidiInterface<Transport, Settings, Platform, Handlers>::getParameterEvent() const
+{
+    return this->parameterDecoder().getEvent();
+}
+
+/*! \brief Tell whether the last message read is a paired high resolution
+ Control Change. Its data bytes then hold the MSB controller number & value,
+ @see getControlChange14 for the 14-bit value.
+ Always false without Settings::UseControllerPairing.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::isControlChange14() const
+{
+    return this->controllerPairing().isEventReady();
+}
+
+/*! \brief Get the last paired Control Change, valid when isControlChange14() is true. */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline const ControlChange14& MidiInterface<Transport, Settings, Platform, Handlers>::getControlChange14() const
+{
+    return this->controllerPairing().getEvent();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline uint32_t MidiInterface<Transport, Settings, Platform, Handlers>::getPairedControllers() const
+{
+    return this->controllerPairing().getControllers();
+}
+
+/*! \brief Choose the Control Changes paired on input.
+ \param inControllers Bit n pairs CC n (MSB) with CC n + 32 (LSB). Defaults to
+ all but Data Entry (6 / 38), which belongs to RPN / NRPN.
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setPairedControllers(uint32_t inControllers)
+{
+    this->controllerPairing().setControllers(inControllers);
 }
 
 // -----------------------------------------------------------------------------
@@ -1073,8 +2344,8 @@ inline void MidiInterface<Transport, Settings, Platform>::setInputChannel(Channe
  This is a utility static method, used internally,
  made public so you can handle MidiTypes more easily.
  */
-template<class Transport, class Settings, class Platform>
-MidiType MidiInterface<Transport, Settings, Platform>::getTypeFromStatusByte(byte inStatus)
+template<class Transport, class Settings, class Platform, class Handlers>
+MidiType MidiInterface<Transport, Settings, Platform, Handlers>::getTypeFromStatusByte(byte inStatus)
 {
     if ((inStatus  < 0x80) ||
         (inStatus == Undefined_F4) ||
@@ -1091,14 +2362,14 @@ MidiType MidiInterface<Transport, Settings, Platform>::getTypeFromStatusByte(byt
 
 /*! \brief Returns channel in the range 1-16
  */
-template<class Transport, class Settings, class Platform>
-inline Channel MidiInterface<Transport, Settings, Platform>::getChannelFromStatusByte(byte inStatus)
+template<class Transport, class Settings, class Platform, class Handlers>
+inline Channel MidiInterface<Transport, Settings, Platform, Handlers>::getChannelFromStatusByte(byte inStatus)
 {
     return Channel((inStatus & 0x0f) + 1);
 }
 
-template<class Transport, class Settings, class Platform>
-bool MidiInterface<Transport, Settings, Platform>::isChannelMessage(MidiType inType)
+template<class Transport, class Settings, class Platform, class Handlers>
+bool MidiInterface<Transport, Settings, Platform, Handlers>::isChannelMessage(MidiType inType)
 {
     return (inType == NoteOff           ||
             inType == NoteOn            ||
@@ -1111,4 +2382,119 @@ bool MidiInterface<Transport, Settings, Platform>::isChannelMessage(MidiType inT
 
 /*! @} */ // End of doc group MIDI Input
 
+// -----------------------------------------------------------------------------
+//                                  Thru
+// -----------------------------------------------------------------------------
+
+/*! \addtogroup thru
+ @{
+ */
+
+/*! \brief Set the filter for thru mirroring
+ \param inThruFilterMode a filter mode
+
+ @see Thru
+ */
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::setThruFilterMode(Thru::Mode inThruFilterMode)
+{
+    mThruFilterMode = inThruFilterMode;
+    updateThruChannelMask();
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline Thru::Mode MidiInterface<Transport, Settings, Platform, Handlers>::getFilterMode() const
+{
+    return mThruFilterMode;
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline bool MidiInterface<Transport, Settings, Platform, Handlers>::getThruState() const
+{
+    return mThruFilterMode != Thru::Off;
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::turnThruOn(Thru::Mode inThruFilterMode)
+{
+    setThruFilterMode(inThruFilterMode);
+}
+
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::turnThruOff()
+{
+    setThruFilterMode(Thru::Off);
+}
+
+/*! @} */ // End of thru
+
+// Private method: precompute the channels forwarded by the Thru,
+// relative to the main input channel (bit 0 is channel 1).
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::updateThruChannelMask()
+{
+    const uint16_t inputMask = mInputChannel == MIDI_CHANNEL_OMNI ? uint16_t(0xffff)
+                             : mInputChannel <  MIDI_CHANNEL_OFF  ? uint16_t(1u << (mInputChannel - 1))
+                             : uint16_t(0);
+
+    switch (mThruFilterMode)
+    {
+        case Thru::Full:                mThruChannelMask = 0xffff;              break;
+        case Thru::SameChannel:         mThruChannelMask = inputMask;           break;
+        case Thru::DifferentChannel:    mThruChannelMask = uint16_t(~inputMask); break;
+        default:                        mThruChannelMask = 0;                   break;
+    }
+}
+
+// Private method: forward the message just parsed, as it was received.
+// The bytes come straight from the parser (pending message, SysEx chunk),
+// only the status byte may be dropped to apply TX running status.
+template<class Transport, class Settings, class Platform, class Handlers>
+inline void MidiInterface<Transport, Settings, Platform, Handlers>::thruFilter()
+{
+    if (mThruFilterMode == Thru::Off)
+        return;
+
+    const MidiType type = mMessage.type;
+    const byte realTime = type;
+    const byte* data = mPendingMessage;
+    size_t size = mMessage.length;
+
+    if (getStatusInfo(type) & StatusInfo::RealTime)
+    {
+        // Interleaved, not in the pending message.
+        // Do not invalidate Running Status for real-time messages.
+        data = &realTime;
+    }
+    else if (getStatusInfo(type) & StatusInfo::ChannelMessage)
+    {
+        const StatusByte status = mPendingMessage[0];
+        if (!(mThruChannelMask & (1u << (status & 0x0f))))
+            return;
+
+        if (omitStatus(status))
+        {
+            data++;
+            size--;
+        }
+    }
+    else
+    {
+        if (type == SystemExclusive)
+        {
+            data = getSysExArray();
+            size = getSysExArrayLength();
+        }
+
+        this->runningStatusTx().cancel();
+    }
+
+    if (mTransport.beginTransmission(type))
+    {
+        writeBytes(data, size);
+        mTransport.endTransmission();
+        updateLastSentTime();
+    }
+}
+
 END_MIDI_NAMESPACE
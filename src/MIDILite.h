@@ -31,6 +31,16 @@
 #include "midi_Platform.h"
 #include "midi_Settings.h"
 #include "midi_Message.h"
+#include "midi_TxQueue.h"
+#include "midi_Coalescer.h"
+#include "midi_RunningStatus.h"
+#include "midi_Statistics.h"
+#include "midi_SysEx.h"
+#include "midi_Handlers.h"
+#include "midi_StateTracker.h"
+#include "midi_Parameters.h"
+#include "midi_ControllerPairing.h"
+#include "midi_Features.h"
 
 #include "serialMIDI.h"
 
@@ -48,13 +58,20 @@ It is templated over the type of serial port to provide abstraction from
 the hardware interface, meaning you can use HardwareSerial, SoftwareSerial
 or ak47's Uart classes. The only requirement is that the class implements
 the begin, read, write and available methods.
+Input handlers are resolved at compile time from _Handlers, see DefaultHandlers.
  */
-template<class Transport, class _Settings = DefaultSettings, class _Platform = DefaultPlatform>
-class MidiInterface
+template<class Transport,
+         class _Settings = DefaultSettings,
+         class _Platform = DefaultPlatform,
+         class _Handlers = DefaultHandlers>
+class MidiInterface : public InputCallbacks<_Handlers::UseCallbacks>
+                    , public StatisticsCounters<_Settings::UseStatistics>
+                    , private InterfaceFeatures<_Settings>
 {
 public:
     typedef _Settings Settings;
     typedef _Platform Platform;
+    typedef _Handlers Handlers;
     typedef Message MidiMessage;
 
 public:
@@ -83,6 +100,10 @@ public:
                                   DataByte inControlValue,
                                   Channel inChannel);
 
+    inline void sendControlChange14(DataByte inControlNumber,
+                                    uint16_t inControlValue,
+                                    Channel inChannel);
+
     inline void sendPitchBend(int inPitchValue,    Channel inChannel);
     inline void sendPitchBend(double inPitchValue, Channel inChannel);
 
@@ -96,6 +117,10 @@ public:
                                DataByte inPressure,
                                Channel inChannel);
 
+    inline void sendSysEx(unsigned inLength,
+                          const byte* inArray,
+                          bool inArrayContainsBoundaries = false);
+
     inline void sendTimeCodeQuarterFrame(DataByte inTypeNibble,
                                          DataByte inValuesNibble);
     inline void sendTimeCodeQuarterFrame(DataByte inData);
@@ -143,6 +168,18 @@ public:
     inline void endNrpn(Channel inChannel);
 
     inline void send(const MidiMessage&);
+    inline void send(const PackedMessage&);
+
+    void flush();
+
+    inline bool sendAt(unsigned long inTime, const MidiMessage&);
+    bool sendAt(unsigned long inTime, const PackedMessage&);
+    void service(unsigned long inNow);
+    inline void service();
+    inline void clearSchedule();
+
+    inline unsigned long getStatusBytesSent() const;
+    inline unsigned long getStatusBytesSaved() const;
 
 public:
     void send(MidiType inType,
@@ -157,17 +194,92 @@ public:
     inline bool read();
     inline bool read(Channel inChannel);
 
+    inline unsigned readBatch(MidiMessage* outMessages, unsigned inMaxMessages);
+    unsigned readBatch(MidiMessage* outMessages,
+                       unsigned inMaxMessages,
+                       Channel inChannel);
+    inline unsigned readBatch(PackedMessage* outMessages, unsigned inMaxMessages);
+    unsigned readBatch(PackedMessage* outMessages,
+                       unsigned inMaxMessages,
+                       Channel inChannel);
+
+    bool poll(unsigned inMaxBytes);
+    bool pollFor(unsigned long inMicros);
+
+private:
+    template<class Event>
+    inline unsigned readEvents(Event* outMessages,
+                               unsigned inMaxMessages,
+                               Channel inChannel);
+    inline void beginPoll();
+    inline void pollBytes(unsigned inMaxBytes);
+
 public:
     inline MidiType getType() const;
     inline Channel  getChannel() const;
     inline DataByte getData1() const;
     inline DataByte getData2() const;
+    inline const byte* getSysExArray() const;
+    inline unsigned getSysExArrayLength() const;
     inline bool check() const;
+    inline int8_t getLastError() const;
+    inline unsigned long getTimestamp() const;
+
+public:
+    inline void setSysExBuffer(byte* inBuffer, unsigned inSize);
+    inline void setCurrentTime(unsigned long inTime);
 
 public:
     inline Channel getInputChannel() const;
     inline void setInputChannel(Channel inChannel);
 
+    inline uint16_t getInputChannelMask() const;
+    inline void setInputChannelMask(uint16_t inChannelMask);
+    inline uint32_t getInputTypeMask() const;
+    inline void setInputTypeMask(uint32_t inTypeMask);
+
+    // -------------------------------------------------------------------------
+    // Received state
+
+public:
+    typedef StateTracker<Settings::UseStateTracker,
+                         Settings::TrackedControllers> MidiStateTracker;
+
+    inline const MidiStateTracker& getStateTracker() const;
+    void panic();
+
+    typedef ClockFollower<Settings::UseClockFollower,
+                          Settings::ClockFollowerSmoothing> MidiClockFollower;
+
+    inline const MidiClockFollower& getClockFollower() const;
+
+    typedef TimeCodeDecoder<Settings::UseTimeCodeDecoder> MidiTimeCodeDecoder;
+
+    inline const MidiTimeCodeDecoder& getTimeCodeDecoder() const;
+
+    inline bool isParameterEvent() const;
+    inline const ParameterEvent& getParameterEvent() const;
+
+    inline bool isControlChange14() const;
+    inline const ControlChange14& getControlChange14() const;
+    inline uint32_t getPairedControllers() const;
+    inline void setPairedControllers(uint32_t inControllers);
+
+    // -------------------------------------------------------------------------
+    // MIDI Soft Thru
+
+public:
+    inline Thru::Mode getFilterMode() const;
+    inline bool getThruState() const;
+
+    inline void turnThruOn(Thru::Mode inThruFilterMode = Thru::Full);
+    inline void turnThruOff();
+    inline void setThruFilterMode(Thru::Mode inThruFilterMode);
+
+private:
+    inline void thruFilter();
+    inline void updateThruChannelMask();
+
 public:
     static inline MidiType getTypeFromStatusByte(byte inStatus);
     static inline Channel getChannelFromStatusByte(byte inStatus);
@@ -177,11 +289,57 @@ public:
     // MIDI Parsing
 
 private:
-    bool parse();
+    inline bool parse();
+    template<bool Bounded>
+    bool parse(unsigned& ioMaxBytes);
+    inline void completePendingMessage(byte inInfo);
+    inline void completeSysExChunk(bool inLastChunk);
+    inline void updateActiveSensing();
+    inline void sampleTime();
+    inline void processReceivedMessage();
+    inline bool decodeParameter();
+    inline bool pairController();
+    inline bool expireHeldController();
+    inline bool releaseHeldController();
+    inline bool takeDeferredMessage();
+    inline void storeControlChange14();
+    inline void launchCallback();
+    inline void launchErrorCallback();
     inline void handleNullVelocityNoteOnAsNoteOff();
     inline bool inputFilter(Channel inChannel);
+    inline bool acceptStatus(StatusByte inStatus, byte inInfo) const;
+    inline void skipPendingMessage();
+    inline void refreshReceiverTimeout();
     inline void resetInput();
+    inline unsigned long latchTimestamp(BoolTag<true>);
+    inline unsigned long latchTimestamp(BoolTag<false>);
+    inline unsigned long sampleArrivalTime(BoolTag<true>);
+    inline unsigned long sampleArrivalTime(BoolTag<false>);
+    inline unsigned long readTimestamp(BoolTag<true>);
+    inline unsigned long readTimestamp(BoolTag<false>);
     inline void updateLastSentTime();
+    inline bool enqueue(StatusByte inStatus,
+                        DataByte inData1 = 0,
+                        DataByte inData2 = 0);
+    inline void flushTxQueue();
+    inline bool omitStatus(StatusByte inStatus);
+    inline unsigned long sampleSendTime(BoolTag<true>);
+    inline unsigned long sampleSendTime(BoolTag<false>);
+    inline unsigned long sampleLineTime(BoolTag<true>);
+    inline unsigned long sampleLineTime(BoolTag<false>);
+    inline void occupyLine(size_t inSize);
+    inline void writeChannelMessage(StatusByte inStatus,
+                                    DataByte inData1,
+                                    DataByte inData2);
+    inline bool coalesce(StatusByte inStatus,
+                         DataByte inData1,
+                         DataByte inData2);
+    inline void drainCoalesced(int inRoom);
+    inline int getWriteRoom(BoolTag<true>);
+    inline int getWriteRoom(BoolTag<false>);
+    inline void serviceTransport(BoolTag<true>);
+    inline void serviceTransport(BoolTag<false>);
+    inline void writeMessage(const byte* inMessage);
 
     // -------------------------------------------------------------------------
     // Transport
@@ -198,22 +356,24 @@ private:
 private:
     Channel         mInputChannel;
     StatusByte      mRunningStatus_RX;
-    StatusByte      mRunningStatus_TX;
     byte            mPendingMessage[3];
     byte            mPendingMessageExpectedLength;
     unsigned        mPendingMessageIndex;
-    unsigned        mCurrentRpnNumber;
-    unsigned        mCurrentNrpnNumber;
     MidiMessage     mMessage;
-    unsigned long   mLastMessageSentTime;
-    unsigned long   mLastMessageReceivedTime;
-    unsigned long   mSenderActiveSensingPeriodicity;
-    bool            mReceiverActiveSensingActivated;
     int8_t          mLastError;
+    bool            mPendingMessageRejected;
+    Thru::Mode      mThruFilterMode;
+    uint16_t        mThruChannelMask;
+    uint16_t        mInputChannelMask;
+    uint32_t        mInputTypeMask;
 
 private:
     inline StatusByte getStatus(MidiType inType,
                                 Channel inChannel) const;
+
+    inline void writeBytes(const byte* inData, size_t inSize);
+    inline void writeBytes(const byte* inData, size_t inSize, BoolTag<true>);
+    inline void writeBytes(const byte* inData, size_t inSize, BoolTag<false>);
 };
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,225 @@
+/*!
+ *  @file       midi_ClockFollower.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - MIDI clock follower
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Tempo and song position of a MIDI clock master,
+ see DefaultSettings::UseClockFollower.
+
+ The period of the clock is smoothed with an exponential moving average in
+ fixed point (1/16 us), each new interval weighing 1/2^Smoothing. Intervals
+ of twice the period or more, or half of it or less (a lost or doubled
+ Clock) are ignored, unless 3 of them come in a row: the master changed
+ tempo, the follower then locks onto it. Each Clock costs a few additions
+ and shifts, the divisions are left to the getters.
+
+ The position counts the Clocks played since the start of the song: Start
+ rewinds it, Song Position moves it, Stop and Continue pause and resume it.
+ Clocks received while stopped only refine the tempo.
+ */
+template<bool Enabled, byte Smoothing>
+class ClockFollower
+{
+public:
+    static_assert(Smoothing < 8, "ClockFollowerSmoothing must be smaller than 8");
+
+    /*! Clocks per quarter note. */
+    static const unsigned ClocksPerBeat = 24;
+    /*! Clocks per MIDI beat (a 16th note), the unit of Song Position. */
+    static const unsigned ClocksPerSixteenth = 6;
+
+    inline ClockFollower()
+    {
+        reset();
+    }
+
+    /*! Forget the tempo and rewind to the start of the song. */
+    inline void reset()
+    {
+        mLastClock  = 0;
+        mPeriod     = 0;
+        mClocks     = 0;
+        mHasClock   = false;
+        mRunning    = false;
+        mRejected   = 0;
+    }
+
+    /*! Feed a received message, with the time (in us) of its arrival. */
+    inline void process(MidiType inType, DataByte inData1, DataByte inData2, unsigned long inMicros)
+    {
+        switch (inType)
+        {
+            case Clock:
+                measure(inMicros);
+                if (mRunning)
+                    mClocks++;
+                break;
+            case Start:
+                mClocks  = 0;
+                mRunning = true;
+                break;
+            case Continue:
+                mRunning = true;
+                break;
+            case Stop:
+                mRunning = false;
+                break;
+            case SongPosition:
+                mClocks = (unsigned long)(inData1 | inData2 << 7) * ClocksPerSixteenth;
+                break;
+            case SystemReset:
+                reset();
+                break;
+            default:
+                break;
+        }
+    }
+
+public:
+    inline bool isRunning() const
+    {
+        return mRunning;
+    }
+
+    /*! Smoothed time between two Clocks in us, 0 until two have been received. */
+    inline unsigned long getClockPeriod() const
+    {
+        return mPeriod >> sFraction;
+    }
+
+    /*! Tempo in hundredths of BPM (eg: 12000 for 120 BPM), 0 if unknown. */
+    inline uint16_t getTempo() const
+    {
+        if (mPeriod == 0)
+            return 0;
+
+        // 60 s / 24 clocks, in hundredths of BPM and 1/16 us: 4e9 fits 32 bits.
+        const unsigned long tempo = 4000000000UL / mPeriod;
+        return uint16_t(tempo > 0xffff ? 0xffff : tempo);
+    }
+
+    /*! Clocks played since the start of the song. */
+    inline unsigned long getClockCount() const
+    {
+        return mClocks;
+    }
+
+    /*! Position in MIDI beats (16th notes), as sent in Song Position. */
+    inline unsigned long getSongPosition() const
+    {
+        return mClocks / ClocksPerSixteenth;
+    }
+
+    /*! Quarter notes started since the start of the song. */
+    inline unsigned long getBeat() const
+    {
+        return mClocks ? (mClocks - 1) / ClocksPerBeat : 0;
+    }
+
+    /*! Position within the current quarter note at inMicros, 0 to 65535.
+     Interpolated from the last Clock with the smoothed period, to align a
+     local sequencer or LFO. 0 when stopped or before the first Clock.
+     */
+    inline uint16_t getBeatPhase(unsigned long inMicros) const
+    {
+        if (!mRunning || mClocks == 0 || mPeriod == 0)
+            return 0;
+
+        // 256 steps per Clock, 24 * 256 = 6144 steps per beat.
+        const unsigned long elapsed = inMicros - mLastClock;
+        const unsigned long step = (elapsed << sFraction) >= mPeriod
+                                 ? 255
+                                 : (elapsed << (sFraction + 8)) / mPeriod;
+        const unsigned long steps = ((mClocks - 1) % ClocksPerBeat) << 8 | step;
+        return uint16_t((steps << 5) / 3); // * 65536 / 6144
+    }
+
+private:
+    inline void measure(unsigned long inMicros)
+    {
+        const unsigned long interval = inMicros - mLastClock;
+        const bool hadClock = mHasClock;
+        mLastClock = inMicros;
+        mHasClock  = true;
+
+        // The master paused its clock, the interval means nothing.
+        if (!hadClock || interval > sMaxPeriod)
+            return;
+
+        const unsigned long sample = interval << sFraction;
+        if (mPeriod == 0)
+        {
+            mPeriod = sample;
+            return;
+        }
+        if (sample >= mPeriod * 2 || sample <= mPeriod / 2)
+        {
+            if (++mRejected < sMaxRejected)
+                return;
+
+            mPeriod = sample;
+        }
+        else
+        {
+            mPeriod = (unsigned long)(long(mPeriod) + ((long(sample) - long(mPeriod)) >> Smoothing));
+        }
+        mRejected = 0;
+    }
+
+private:
+    static const byte sFraction = 4;
+    static const unsigned long sMaxPeriod = 1000000; // 2.5 BPM
+    static const byte sMaxRejected = 3;
+
+    unsigned long   mLastClock;
+    unsigned long   mPeriod;      // In 1/16 us
+    unsigned long   mClocks;
+    bool            mHasClock;
+    bool            mRunning;
+    byte            mRejected;
+};
+
+/*! Clock not followed. */
+template<byte Smoothing>
+class ClockFollower<false, Smoothing>
+{
+public:
+    inline void reset() {}
+    inline void process(MidiType, DataByte, DataByte, unsigned long) {}
+    inline bool isRunning() const                       { return false; }
+    inline unsigned long getClockPeriod() const         { return 0; }
+    inline uint16_t getTempo() const                    { return 0; }
+    inline unsigned long getClockCount() const          { return 0; }
+    inline unsigned long getSongPosition() const        { return 0; }
+    inline unsigned long getBeat() const                { return 0; }
+    inline uint16_t getBeatPhase(unsigned long) const   { return 0; }
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,177 @@
+/*!
+ *  @file       midi_Coalescer.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Output value coalescing
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Pending output values, see DefaultSettings::CoalescedMessages.
+
+ Holds continuous controller updates (Control Change, Pitch Bend and both
+ After Touch) until the transport has room for them. A newer value for the
+ same (status, controller) replaces the pending one in place, so each key is
+ sent at most once per drain, with its latest value, in the order the keys
+ were first updated.
+ */
+template<unsigned Size>
+class OutputCoalescer
+{
+public:
+    static_assert(Size < 256, "CoalescedMessages must be smaller than 256");
+
+    inline OutputCoalescer()
+        : mCount(0)
+    {
+    }
+
+    /*! \brief Tell whether a channel message is a value that can be replaced.
+     Notes, Program Changes, channel mode messages and the RPN / NRPN
+     controllers (whose meaning depends on the order) are not.
+     */
+    static inline bool isCoalescable(StatusByte inStatus, DataByte inData1)
+    {
+        switch (inStatus & 0xf0)
+        {
+            case PitchBend:
+            case AfterTouchChannel:
+            case AfterTouchPoly:
+                return true;
+            case ControlChange:
+                return inData1 != DataEntryMSB
+                    && inData1 != DataEntryLSB
+                    && (inData1 < DataIncrement || inData1 > RPNMSB)
+                    && inData1 < AllSoundOff;
+            default:
+                return false;
+        }
+    }
+
+    inline bool isEmpty() const
+    {
+        return mCount == 0;
+    }
+
+    /*! \brief Store a value, replacing the pending one with the same key.
+     \return false if the value is new and there is no room for it.
+     */
+    inline bool store(StatusByte inStatus, DataByte inData1, DataByte inData2)
+    {
+        const bool keyed = hasKey(inStatus);
+        for (byte i = 0; i < mCount; ++i)
+        {
+            byte* slot = mData + i * 3;
+            if (slot[0] == inStatus && (!keyed || slot[1] == inData1))
+            {
+                slot[1] = inData1;
+                slot[2] = inData2;
+                return true;
+            }
+        }
+        if (mCount == Size)
+            return false;
+
+        byte* slot = mData + mCount * 3;
+        slot[0] = inStatus;
+        slot[1] = inData1;
+        slot[2] = inData2;
+        mCount++;
+        return true;
+    }
+
+    /*! Oldest pending message, as status + 2 data bytes. Must not be empty. */
+    inline const byte* front() const
+    {
+        return mData;
+    }
+
+    inline void pop()
+    {
+        remove(0);
+    }
+
+    /*! \brief Take the oldest value pending on a channel.
+     \param inChannel   Channel nibble of the status byte (0 to 15).
+     \param outMessage  Receives status + 2 data bytes.
+     */
+    inline bool take(byte inChannel, byte* outMessage)
+    {
+        for (byte i = 0; i < mCount; ++i)
+        {
+            const byte* slot = mData + i * 3;
+            if ((slot[0] & 0x0f) == inChannel)
+            {
+                outMessage[0] = slot[0];
+                outMessage[1] = slot[1];
+                outMessage[2] = slot[2];
+                remove(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void clear()
+    {
+        mCount = 0;
+    }
+
+private:
+    // Pitch Bend and Channel After Touch have a single value per channel.
+    static inline bool hasKey(StatusByte inStatus)
+    {
+        const byte type = inStatus & 0xf0;
+        return type == ControlChange || type == AfterTouchPoly;
+    }
+
+    inline void remove(byte inIndex)
+    {
+        mCount--;
+        for (unsigned i = unsigned(inIndex) * 3; i < unsigned(mCount) * 3; ++i)
+            mData[i] = mData[i + 3];
+    }
+
+private:
+    byte mData[Size * 3];
+    byte mCount;
+};
+
+/*! Disabled coalescing: values are sent as any other message. */
+template<>
+class OutputCoalescer<0>
+{
+public:
+    static inline bool isCoalescable(StatusByte, DataByte) { return false; }
+    inline bool isEmpty() const { return true; }
+    inline bool store(StatusByte, DataByte, DataByte) { return false; }
+    inline const byte* front() const { return nullptr; }
+    inline void pop() {}
+    inline bool take(byte, byte*) { return false; }
+    inline void clear() {}
+};
+
+END_MIDI_NAMESPACE
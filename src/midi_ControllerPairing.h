@@ -0,0 +1,290 @@
+/*!
+ *  @file       midi_ControllerPairing.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - 14-bit controller pairing
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Message.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief A high resolution controller value, from CC 0-31 (MSB) and 32-63 (LSB).
+ @see MidiInterface::isControlChange14
+ */
+struct ControlChange14
+{
+    Channel     channel;
+    DataByte    number;     ///< Controller number of the MSB (0 to 31)
+    uint16_t    value;      ///< 14-bit value
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Pairs MSB / LSB Control Changes, see DefaultSettings::UseControllerPairing.
+
+ An MSB is held until its LSB (giving the full value), until the timeout,
+ or until another message arrives on the same channel. It then gives a value
+ with a null LSB, as per the MIDI specification. Pairing does not reorder
+ the messages of a channel: a message that would overtake the MSB (eg: a
+ Program Change after a Bank Select) is deferred until the MSB is read.
+ With a null timeout, MSBs give a value (with a null LSB) right away, and
+ the LSB refines it.
+ An LSB alone updates the last MSB received on the channel if it is the
+ same controller (fine adjustments), it passes through unpaired otherwise.
+ */
+template<bool Enabled>
+class ControllerPairing
+{
+public:
+    enum Result
+    {
+        NotPaired   = 0,    ///< Message passes through as is
+        Held        = 1,    ///< MSB waiting for its LSB, no event
+        Event       = 2,    ///< A value is ready, @see getEvent
+    };
+
+    inline ControllerPairing()
+        : mControllers(0xffffffff & ~(uint32_t(1) << DataEntryMSB))
+    {
+        reset();
+    }
+
+    inline void reset()
+    {
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            mChannels[i].number = sNone;
+            mChannels[i].msb    = 0;
+            mChannels[i].held   = false;
+        }
+        mNumHeld = 0;
+        mEventReady = false;
+        mDeferredReady = false;
+    }
+
+    /*! Bit n pairs CC n with CC n + 32. Default: all but Data Entry (RPN / NRPN). */
+    inline void setControllers(uint32_t inControllers)
+    {
+        mControllers = inControllers;
+    }
+
+    inline uint32_t getControllers() const
+    {
+        return mControllers;
+    }
+
+    inline Result process(Channel inChannel,
+                          DataByte inNumber,
+                          DataByte inValue,
+                          unsigned long inTime,
+                          unsigned long inTimeout)
+    {
+        ChannelState& state = mChannels[inChannel - 1];
+
+        if (isPairedMsb(inNumber))
+        {
+            // Another MSB replaces the one held, which is given now.
+            const bool replaced = state.held;
+            if (replaced)
+                release(inChannel, state);
+
+            state.number = inNumber;
+            state.msb    = inValue;
+
+            if (inTimeout == 0)
+            {
+                setEvent(inChannel, inNumber, uint16_t(inValue) << 7);
+                return Event;
+            }
+
+            state.held     = true;
+            state.deadline = inTime + inTimeout;
+            mNumHeld++;
+            return replaced ? Event : Held;
+        }
+
+        if (isPairedLsb(state, inNumber))
+        {
+            if (state.held)
+            {
+                state.held = false;
+                mNumHeld--;
+            }
+            setEvent(inChannel, state.number, uint16_t(state.msb) << 7 | inValue);
+            return Event;
+        }
+
+        return NotPaired;
+    }
+
+    /*! \brief Give the first held MSB whose LSB did not come in time.
+     \return true if an event is ready, @see getEvent.
+     */
+    inline bool expire(unsigned long inTime)
+    {
+        if (mNumHeld == 0)
+            return false;
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            ChannelState& state = mChannels[i];
+            if (state.held && long(inTime - state.deadline) >= 0)
+            {
+                release(Channel(i + 1), state);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*! \brief Give the MSB held on the channel of inMessage, if inMessage
+     is not paired with it. inMessage is kept until takeDeferred.
+     \return true if an event is ready, @see getEvent.
+     */
+    inline bool defer(const Message& inMessage)
+    {
+        if (mNumHeld == 0 || inMessage.type < NoteOff || inMessage.type >= SystemExclusive)
+            return false; // Only channel messages can overtake an MSB
+
+        ChannelState& state = mChannels[inMessage.channel - 1];
+        if (!state.held)
+            return false;
+        if (inMessage.type == ControlChange
+            && (isPairedMsb(inMessage.data1) || isPairedLsb(state, inMessage.data1)))
+            return false;
+
+        mDeferred = inMessage;
+        mDeferredReady = true;
+        release(inMessage.channel, state);
+        return true;
+    }
+
+    /*! \brief Give back the message deferred behind an MSB.
+     \return false if there is none.
+     */
+    inline bool takeDeferred(Message& outMessage)
+    {
+        if (!mDeferredReady)
+            return false;
+
+        outMessage = mDeferred;
+        mDeferredReady = false;
+        return true;
+    }
+
+    inline const ControlChange14& getEvent() const
+    {
+        return mEvent;
+    }
+
+    /*! An event was given since the last clearEvent. */
+    inline bool isEventReady() const
+    {
+        return mEventReady;
+    }
+
+    inline void clearEvent()
+    {
+        mEventReady = false;
+    }
+
+private:
+    struct ChannelState
+    {
+        DataByte        number; ///< Last MSB controller, sNone if none
+        DataByte        msb;
+        bool            held;
+        unsigned long   deadline;
+    };
+
+    inline bool isPairedMsb(DataByte inNumber) const
+    {
+        return inNumber < 32 && (mControllers & (uint32_t(1) << inNumber));
+    }
+
+    inline bool isPairedLsb(const ChannelState& inState, DataByte inNumber) const
+    {
+        return inNumber >= 32 && inNumber < 64 && inState.number == inNumber - 32
+            && (mControllers & (uint32_t(1) << (inNumber - 32)));
+    }
+
+    inline void setEvent(Channel inChannel, DataByte inNumber, uint16_t inValue)
+    {
+        mEvent.channel = inChannel;
+        mEvent.number  = inNumber;
+        mEvent.value   = inValue;
+        mEventReady    = true;
+    }
+
+    inline void release(Channel inChannel, ChannelState& ioState)
+    {
+        ioState.held = false;
+        mNumHeld--;
+        setEvent(inChannel, ioState.number, uint16_t(ioState.msb) << 7);
+    }
+
+private:
+    static const DataByte sNone = 0x80;
+
+    uint32_t        mControllers;
+    ChannelState    mChannels[16];
+    byte            mNumHeld;
+    ControlChange14 mEvent;
+    bool            mEventReady;
+    Message         mDeferred;
+    bool            mDeferredReady;
+};
+
+/*! Disabled pairing: Control Changes pass through. */
+template<>
+class ControllerPairing<false>
+{
+public:
+    enum Result
+    {
+        NotPaired   = 0,
+        Held        = 1,
+        Event       = 2,
+    };
+
+    inline void reset() {}
+    inline void setControllers(uint32_t) {}
+    inline uint32_t getControllers() const { return 0; }
+    inline Result process(Channel, DataByte, DataByte, unsigned long, unsigned long) { return NotPaired; }
+    inline bool expire(unsigned long) { return false; }
+    inline bool defer(const Message&) { return false; }
+    inline bool takeDeferred(Message&) { return false; }
+    inline bool isEventReady() const { return false; }
+    inline void clearEvent() {}
+
+    inline const ControlChange14& getEvent() const
+    {
+        static const ControlChange14 event = ControlChange14();
+        return event;
+    }
+};
+
+END_MIDI_NAMESPACE
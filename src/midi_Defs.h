@@ -33,9 +33,42 @@
 #include <Arduino.h>
 #else
 #include <inttypes.h>
+#include <stddef.h>
 typedef uint8_t byte;
 #endif
 
+// Constant tables live in flash on AVR, read them with MIDI_READ_PROGMEM_BYTE.
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define MIDI_PROGMEM                    PROGMEM
+#define MIDI_READ_PROGMEM_BYTE(addr)    pgm_read_byte(addr)
+#else
+#define MIDI_PROGMEM
+#define MIDI_READ_PROGMEM_BYTE(addr)    (*(addr))
+#endif
+
+/*! Index loads / stores of the single producer / single consumer queues
+ (SpscRing, TxQueue). Acquire / release ordering is needed on multi-core
+ parts (ESP32, RP2040), where the producer runs on the other core. Single
+ byte accesses are atomic on AVR, where only interrupts can preempt the
+ consumer: volatile accesses are enough there, with a compiler barrier so
+ that the (non volatile) slot accesses are not moved across them.
+ */
+#if defined(__AVR__)
+#   define MIDI_RING_BARRIER()                      __asm__ __volatile__("" ::: "memory")
+#elif !defined(__GNUC__)
+#   include <atomic>
+#   define MIDI_RING_BARRIER()                      std::atomic_thread_fence(std::memory_order_seq_cst)
+#endif
+
+#if defined(__AVR__) || !defined(__GNUC__)
+#   define MIDI_RING_LOAD_ACQUIRE(index)            MIDI_NAMESPACE::ringLoadAcquire(index)
+#   define MIDI_RING_STORE_RELEASE(index, value)    MIDI_NAMESPACE::ringStoreRelease(index, value)
+#else
+#   define MIDI_RING_LOAD_ACQUIRE(index)            __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#   define MIDI_RING_STORE_RELEASE(index, value)    __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+#endif
+
 BEGIN_MIDI_NAMESPACE
 
 // -----------------------------------------------------------------------------
@@ -46,6 +79,25 @@ BEGIN_MIDI_NAMESPACE
 #define MIDI_PITCHBEND_MIN      -8192
 #define MIDI_PITCHBEND_MAX      8191
 
+#if defined(__AVR__) || !defined(__GNUC__)
+
+template<class Index>
+inline Index ringLoadAcquire(const volatile Index& inIndex)
+{
+    const Index value = inIndex;
+    MIDI_RING_BARRIER();
+    return value;
+}
+
+template<class Index>
+inline void ringStoreRelease(volatile Index& outIndex, Index inValue)
+{
+    MIDI_RING_BARRIER();
+    outIndex = inValue;
+}
+
+#endif
+
 /*! Receiving Active Sensing 
 */
 static const uint16_t ActiveSensingTimeout = 300;
@@ -63,6 +115,8 @@ typedef byte FilterMode;
 static const uint8_t ErrorParse = 0;
 static const uint8_t ErrorActiveSensingTimeout = 1;
 static const uint8_t WarningSplitSysEx = 2;
+static const uint8_t ErrorTxQueueOverflow = 3;
+static const uint8_t ErrorScheduleOverflow = 4;
 
 // -----------------------------------------------------------------------------
 
@@ -99,6 +153,169 @@ enum MidiType: uint8_t
 
 // -----------------------------------------------------------------------------
 
+/*! Enumeration of Thru filter modes */
+struct Thru
+{
+    enum Mode
+    {
+        Off                   = 0,  ///< Thru disabled (nothing passes through).
+        Full                  = 1,  ///< Fully enabled Thru (every incoming message is sent back).
+        SameChannel           = 2,  ///< Only the messages on the Input Channel will be sent back.
+        DifferentChannel      = 3,  ///< All the messages but the ones on the Input Channel will be sent back.
+    };
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Parser properties of a byte received on the wire.
+ @see getStatusInfo
+ */
+struct StatusInfo
+{
+    enum Flags: uint8_t
+    {
+        LengthMask      = 0x03, ///< Expected message length, 0 for data bytes, SysEx & undefined
+        ChannelMessage  = 0x04, ///< Status carries a channel in its low nibble
+        RunningStatus   = 0x08, ///< Status can be used as running status
+        RealTime        = 0x10, ///< Single byte message, can be interleaved anywhere
+        Ignored         = 0x20, ///< Byte is skipped by the parser (Undefined_FD)
+    };
+};
+
+/*! Lookup table of StatusInfo flags for each of the 256 byte values
+ (defined in MIDI.cpp, stored in flash on AVR).
+ */
+extern const byte StatusInfoTable[256];
+
+/*! \brief Get the StatusInfo flags of a received byte,
+ without any branching on the byte value.
+ */
+inline byte getStatusInfo(byte inByte)
+{
+    return MIDI_READ_PROGMEM_BYTE(&StatusInfoTable[inByte]);
+}
+
+/*! \brief Bit of a message type in type masks (input filter, router routes).
+ Channel messages use bits 0 to 6 (NoteOff to PitchBend),
+ system messages use bits 16 to 31 (0xF0 to 0xFF).
+ */
+inline uint32_t getTypeBit(MidiType inType)
+{
+    return inType < SystemExclusive ? uint32_t(1) << ((inType >> 4) - 8)
+                                    : uint32_t(1) << (16 + (inType & 0x0f));
+}
+
+// -----------------------------------------------------------------------------
+// Compile-time helpers
+
+/*! Tag type used to select an implementation from a compile-time condition
+ */
+template<bool Value>
+struct BoolTag
+{
+};
+
+/*! \brief Detects whether T implements a bulk write(const byte*, size_t).
+
+ Transports and serial ports only have to implement write(byte), the bulk
+ entry point is optional and used by the library when it exists.
+ */
+template<class T>
+struct HasBulkWrite
+{
+private:
+    typedef char Yes;
+    typedef long No;
+
+    template<class U>
+    static Yes test(decltype((static_cast<U*>(nullptr)->write(static_cast<const byte*>(nullptr), size_t(0)), 0))*);
+    template<class U>
+    static No test(...);
+
+public:
+    static const bool value = sizeof(test<T>(nullptr)) == sizeof(Yes);
+};
+
+template<class T>
+const bool HasBulkWrite<T>::value;
+
+/*! \brief Detects whether T implements readTimestamp().
+
+ Transports that can time the reception of each byte (eg: from their RX
+ interrupt) implement it, returning the time of the byte last returned by
+ read(). It then replaces Platform::nowMicros for Message::timestamp.
+ */
+template<class T>
+struct HasReadTimestamp
+{
+private:
+    typedef char Yes;
+    typedef long No;
+
+    template<class U>
+    static Yes test(decltype((static_cast<U*>(nullptr)->readTimestamp(), 0))*);
+    template<class U>
+    static No test(...);
+
+public:
+    static const bool value = sizeof(test<T>(nullptr)) == sizeof(Yes);
+};
+
+template<class T>
+const bool HasReadTimestamp<T>::value;
+
+/*! \brief Detects whether T implements availableForWrite().
+
+ Transports (and serial ports) that know how many bytes can be written
+ without blocking implement it. Output coalescing uses it to only write
+ what fits, a negative value means unknown.
+ */
+template<class T>
+struct HasAvailableForWrite
+{
+private:
+    typedef char Yes;
+    typedef long No;
+
+    template<class U>
+    static Yes test(decltype((static_cast<U*>(nullptr)->availableForWrite(), 0))*);
+    template<class U>
+    static No test(...);
+
+public:
+    static const bool value = sizeof(test<T>(nullptr)) == sizeof(Yes);
+};
+
+template<class T>
+const bool HasAvailableForWrite<T>::value;
+
+/*! \brief Detects whether T implements service().
+
+ Transports that hold outgoing bytes until a deadline (eg: a USB frame or
+ an RTP packet waiting for more messages) implement it, to send them once
+ the deadline has passed. MidiInterface::flush() calls it.
+ */
+template<class T>
+struct HasService
+{
+private:
+    typedef char Yes;
+    typedef long No;
+
+    template<class U>
+    static Yes test(decltype((static_cast<U*>(nullptr)->service(), 0))*);
+    template<class U>
+    static No test(...);
+
+public:
+    static const bool value = sizeof(test<T>(nullptr)) == sizeof(Yes);
+};
+
+template<class T>
+const bool HasService<T>::value;
+
+// -----------------------------------------------------------------------------
+
 /*! \brief Enumeration of Control Change command numbers.
  See the detailed controllers numbers & description here:
  http://www.somascape.org/midi/tech/spec.html#ctrlnums
@@ -0,0 +1,368 @@
+/*!
+ *  @file       midi_Features.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Optional interface state
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_TxQueue.h"
+#include "midi_Coalescer.h"
+#include "midi_RunningStatus.h"
+#include "midi_SysEx.h"
+#include "midi_StateTracker.h"
+#include "midi_Parameters.h"
+#include "midi_ControllerPairing.h"
+#include "midi_Scheduler.h"
+#include "midi_ClockFollower.h"
+#include "midi_TimeCode.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Time of the current read(), kept only if a feature needs it.
+ @see DefaultSettings::UseExternalTime
+ */
+template<bool Enabled>
+class InterfaceClock
+{
+public:
+    inline InterfaceClock()
+        : mTime(0)
+    {
+    }
+
+    inline unsigned long get() const        { return mTime; }
+    inline void set(unsigned long inTime)   { mTime = inTime; }
+
+private:
+    unsigned long mTime;
+};
+
+template<>
+class InterfaceClock<false>
+{
+public:
+    inline unsigned long get() const    { return 0; }
+    inline void set(unsigned long)      {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Deadline of the next Active Sensing to send,
+ see DefaultSettings::UseSenderActiveSensing.
+ */
+template<bool Enabled, uint16_t Periodicity>
+class SenderActiveSensing
+{
+public:
+    inline SenderActiveSensing()
+        : mDeadline(0)
+    {
+    }
+
+    inline bool isDue(unsigned long inTime) const
+    {
+        return long(inTime - mDeadline) > 0;
+    }
+
+    inline void schedule(unsigned long inTime)
+    {
+        mDeadline = inTime + Periodicity;
+    }
+
+private:
+    unsigned long mDeadline;
+};
+
+template<uint16_t Periodicity>
+class SenderActiveSensing<false, Periodicity>
+{
+public:
+    inline bool isDue(unsigned long) const  { return false; }
+    inline void schedule(unsigned long)     {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Watches the Active Sensing of the sender,
+ see DefaultSettings::UseReceiverActiveSensing.
+
+ Watching starts with the first Active Sensing received, any message then
+ pushes the deadline back by ActiveSensingTimeout.
+ */
+template<bool Enabled>
+class ReceiverActiveSensing
+{
+public:
+    inline ReceiverActiveSensing()
+        : mDeadline(0)
+        , mActivated(false)
+    {
+    }
+
+    inline bool isActivated() const
+    {
+        return mActivated;
+    }
+
+    inline void activate()
+    {
+        mActivated = true;
+    }
+
+    inline void refresh(unsigned long inTime)
+    {
+        if (mActivated)
+            mDeadline = inTime + ActiveSensingTimeout;
+    }
+
+    /*! Returns true (once) if the sender went silent, watching then stops. */
+    inline bool expire(unsigned long inTime)
+    {
+        if (!mActivated || long(inTime - mDeadline) <= 0)
+            return false;
+
+        mActivated = false;
+        return true;
+    }
+
+private:
+    unsigned long   mDeadline;
+    bool            mActivated;
+};
+
+template<>
+class ReceiverActiveSensing<false>
+{
+public:
+    inline bool isActivated() const     { return false; }
+    inline void activate()              {}
+    inline void refresh(unsigned long)  {}
+    inline bool expire(unsigned long)   { return false; }
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Time of the first byte of the message being parsed,
+ see DefaultSettings::UseTimestamps.
+ */
+template<bool Enabled>
+class TimestampLatch
+{
+public:
+    inline TimestampLatch()
+        : mTime(0)
+    {
+    }
+
+    inline unsigned long get() const        { return mTime; }
+    inline void set(unsigned long inTime)   { mTime = inTime; }
+
+private:
+    unsigned long mTime;
+};
+
+template<>
+class TimestampLatch<false>
+{
+public:
+    inline unsigned long get() const    { return 0; }
+    inline void set(unsigned long)      {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Last RPN / NRPN numbers selected on output,
+ see DefaultSettings::CacheParameterNumbers.
+ */
+template<bool Enabled>
+class ParameterNumbers
+{
+public:
+    inline ParameterNumbers()
+    {
+        reset();
+    }
+
+    inline void reset()
+    {
+        mRpn  = sNone;
+        mNrpn = sNone;
+    }
+
+    /*! Returns false if inNumber is already the selected RPN. */
+    inline bool selectRpn(unsigned inNumber)
+    {
+        if (mRpn == inNumber)
+            return false;
+
+        mRpn = inNumber;
+        return true;
+    }
+
+    /*! Returns false if inNumber is already the selected NRPN. */
+    inline bool selectNrpn(unsigned inNumber)
+    {
+        if (mNrpn == inNumber)
+            return false;
+
+        mNrpn = inNumber;
+        return true;
+    }
+
+    inline void deselectRpn()   { mRpn  = sNone; }
+    inline void deselectNrpn()  { mNrpn = sNone; }
+
+private:
+    static const unsigned sNone = 0xffff;
+
+    unsigned mRpn;
+    unsigned mNrpn;
+};
+
+/*! Nothing cached: the parameter number is sent with each beginRpn / beginNrpn. */
+template<>
+class ParameterNumbers<false>
+{
+public:
+    inline void reset()                 {}
+    inline bool selectRpn(unsigned)     { return true; }
+    inline bool selectNrpn(unsigned)    { return true; }
+    inline void deselectRpn()           {}
+    inline void deselectNrpn()          {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Types of the optional parts of MidiInterface, selected by Settings. */
+template<class Settings>
+struct FeatureTypes
+{
+    /*! The clock is only sampled (and stored) if a feature needs it. */
+    static const bool UseClock = Settings::UseSenderActiveSensing
+                              || Settings::UseReceiverActiveSensing
+                              || (Settings::UseControllerPairing && Settings::ControllerPairingTimeout > 0)
+                              || (Settings::UseRunningStatus && Settings::RunningStatusRefreshPeriod > 0);
+
+    /*! The input followers need the arrival time of messages not timestamped. */
+    static const bool UseArrivalTime = (Settings::UseClockFollower || Settings::UseTimeCodeDecoder)
+                                    && !Settings::UseTimestamps;
+
+    typedef InterfaceClock<UseClock> MidiInterfaceClock;
+    typedef SenderActiveSensing<Settings::UseSenderActiveSensing
+                                && Settings::SenderActiveSensingPeriodicity != 0,
+                                Settings::SenderActiveSensingPeriodicity> MidiSenderActiveSensing;
+    typedef ReceiverActiveSensing<Settings::UseReceiverActiveSensing> MidiReceiverActiveSensing;
+    typedef TimestampLatch<Settings::UseTimestamps> MidiTimestampLatch;
+    typedef ParameterNumbers<Settings::CacheParameterNumbers> MidiParameterNumbers;
+    typedef RunningStatusTx<Settings::UseRunningStatus,
+                            Settings::RunningStatusRefreshCount,
+                            Settings::RunningStatusRefreshPeriod> MidiRunningStatusTx;
+    typedef TxQueue<Settings::TxQueueSize> MidiTxQueue;
+    typedef OutputCoalescer<Settings::CoalescedMessages> MidiCoalescer;
+    typedef SysExInput<Settings::UseSysExInput> MidiSysExInput;
+    typedef StateTracker<Settings::UseStateTracker,
+                         Settings::TrackedControllers> MidiStateTracker;
+    typedef ParameterDecoder<Settings::UseParameterDecoder> MidiParameterDecoder;
+    typedef ControllerPairing<Settings::UseControllerPairing> MidiControllerPairing;
+    typedef OutputScheduler<Settings::ScheduledMessages,
+                            Settings::SchedulerBaudRate> MidiScheduler;
+    typedef ClockFollower<Settings::UseClockFollower,
+                          Settings::ClockFollowerSmoothing> MidiClockFollower;
+    typedef TimeCodeDecoder<Settings::UseTimeCodeDecoder> MidiTimeCodeDecoder;
+};
+
+/*! \brief Optional state of MidiInterface.
+
+ Each part is a private base, empty when its feature is disabled, so that the
+ empty base optimisation removes it from sizeof(MidiInterface), where an empty
+ member would still cost a byte plus padding. MidiInterface reaches them
+ through the accessors, which also keeps their member names apart.
+ */
+template<class Settings, class Types = FeatureTypes<Settings> >
+class InterfaceFeatures
+    : private Types::MidiInterfaceClock
+    , private Types::MidiSenderActiveSensing
+    , private Types::MidiReceiverActiveSensing
+    , private Types::MidiTimestampLatch
+    , private Types::MidiParameterNumbers
+    , private Types::MidiRunningStatusTx
+    , private Types::MidiTxQueue
+    , private Types::MidiCoalescer
+    , private Types::MidiSysExInput
+    , private Types::MidiStateTracker
+    , private Types::MidiParameterDecoder
+    , private Types::MidiControllerPairing
+    , private Types::MidiScheduler
+    , private Types::MidiClockFollower
+    , private Types::MidiTimeCodeDecoder
+{
+protected:
+    static const bool UseClock = Types::UseClock;
+    static const bool UseArrivalTime = Types::UseArrivalTime;
+
+    typedef typename Types::MidiInterfaceClock          MidiInterfaceClock;
+    typedef typename Types::MidiSenderActiveSensing     MidiSenderActiveSensing;
+    typedef typename Types::MidiReceiverActiveSensing   MidiReceiverActiveSensing;
+    typedef typename Types::MidiTimestampLatch          MidiTimestampLatch;
+    typedef typename Types::MidiParameterNumbers        MidiParameterNumbers;
+    typedef typename Types::MidiRunningStatusTx         MidiRunningStatusTx;
+    typedef typename Types::MidiTxQueue                 MidiTxQueue;
+    typedef typename Types::MidiCoalescer               MidiCoalescer;
+    typedef typename Types::MidiSysExInput              MidiSysExInput;
+    typedef typename Types::MidiStateTracker            MidiStateTracker;
+    typedef typename Types::MidiParameterDecoder        MidiParameterDecoder;
+    typedef typename Types::MidiControllerPairing       MidiControllerPairing;
+    typedef typename Types::MidiScheduler               MidiScheduler;
+    typedef typename Types::MidiClockFollower           MidiClockFollower;
+    typedef typename Types::MidiTimeCodeDecoder         MidiTimeCodeDecoder;
+
+protected:
+    inline unsigned long getTime() const        { return static_cast<const MidiInterfaceClock&>(*this).get(); }
+    inline void setTime(unsigned long inTime)   { static_cast<MidiInterfaceClock&>(*this).set(inTime); }
+
+    inline MidiSenderActiveSensing& senderActiveSensing()           { return *this; }
+    inline MidiReceiverActiveSensing& receiverActiveSensing()       { return *this; }
+    inline MidiTimestampLatch& timestampLatch()                     { return *this; }
+    inline MidiParameterNumbers& parameterNumbers()                 { return *this; }
+    inline MidiRunningStatusTx& runningStatusTx()                   { return *this; }
+    inline const MidiRunningStatusTx& runningStatusTx() const       { return *this; }
+    inline MidiTxQueue& txQueue()                                   { return *this; }
+    inline MidiCoalescer& coalescer()                               { return *this; }
+    inline MidiSysExInput& sysExInput()                             { return *this; }
+    inline const MidiSysExInput& sysExInput() const                 { return *this; }
+    inline MidiStateTracker& stateTracker()                         { return *this; }
+    inline const MidiStateTracker& stateTracker() const             { return *this; }
+    inline MidiParameterDecoder& parameterDecoder()                 { return *this; }
+    inline const MidiParameterDecoder& parameterDecoder() const     { return *this; }
+    inline MidiControllerPairing& controllerPairing()               { return *this; }
+    inline const MidiControllerPairing& controllerPairing() const   { return *this; }
+    inline MidiScheduler& scheduler()                               { return *this; }
+    inline MidiClockFollower& clockFollower()                       { return *this; }
+    inline const MidiClockFollower& clockFollower() const           { return *this; }
+    inline MidiTimeCodeDecoder& timeCodeDecoder()                   { return *this; }
+    inline const MidiTimeCodeDecoder& timeCodeDecoder() const       { return *this; }
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,337 @@
+/*!
+ *  @file       midi_Handlers.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Input handlers
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Message.h"
+
+BEGIN_MIDI_NAMESPACE
+
+typedef void (*ErrorCallback)(int8_t);
+typedef void (*MessageCallback)(const Message&);
+typedef void (*NoteOffCallback)(Channel channel, byte note, byte velocity);
+typedef void (*NoteOnCallback)(Channel channel, byte note, byte velocity);
+typedef void (*AfterTouchPolyCallback)(Channel channel, byte note, byte pressure);
+typedef void (*ControlChangeCallback)(Channel channel, byte number, byte value);
+typedef void (*ProgramChangeCallback)(Channel channel, byte number);
+typedef void (*AfterTouchChannelCallback)(Channel channel, byte pressure);
+typedef void (*PitchBendCallback)(Channel channel, int bend);
+typedef void (*SystemExclusiveCallback)(byte* array, unsigned size);
+typedef void (*TimeCodeQuarterFrameCallback)(byte data);
+typedef void (*SongPositionCallback)(unsigned beats);
+typedef void (*SongSelectCallback)(byte songNumber);
+typedef void (*RealTimeCallback)(void);
+
+/*! Signed value of a received PitchBend, between MIDI_PITCHBEND_MIN and MAX. */
+inline int getPitchBendValue(const Message& inMessage)
+{
+    return int((inMessage.data1 & 0x7f) | ((inMessage.data2 & 0x7f) << 7)) + MIDI_PITCHBEND_MIN;
+}
+
+/*! Value of a received SongPosition, in beats. */
+inline unsigned getSongPositionValue(const Message& inMessage)
+{
+    return unsigned((inMessage.data1 & 0x7f) | ((inMessage.data2 & 0x7f) << 7));
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Compile-time input handlers (none by default).
+
+ Handlers are static member functions of the _Handlers template parameter of
+ MidiInterface, called directly from read() when a message is received: no
+ function pointer is stored, and the handlers you don't define are empty
+ inline functions that compile to nothing.
+ To use them, create a subclass and define the ones you need with the same
+ signature, and pass it to your instance. Eg:
+ \code{.cpp}
+ struct MyHandlers : public MIDI_NAMESPACE::DefaultHandlers
+ {
+    static void handleNoteOn(byte inChannel, byte inNote, byte inVelocity)
+    {
+        // ...
+    }
+ };
+
+ typedef MIDI_NAMESPACE::SerialMIDI<HardwareSerial> Transport;
+ Transport serialMIDI(Serial);
+ MIDI_NAMESPACE::MidiInterface<Transport,
+                               MIDI_NAMESPACE::DefaultSettings,
+                               MIDI_NAMESPACE::DefaultPlatform,
+                               MyHandlers> MIDI(serialMIDI);
+ \endcode
+ @see CallbackHandlers to register handlers at runtime.
+ */
+struct DefaultHandlers
+{
+    /*! Set to true to add setHandleNoteOn() & co, see InputCallbacks.
+    Costs one function pointer per message type.
+    */
+    static const bool UseCallbacks = false;
+
+    static inline void handleError(int8_t)                          {}
+    static inline void handleMessage(const Message&)                {}
+    static inline void handleNoteOff(Channel, byte, byte)           {}
+    static inline void handleNoteOn(Channel, byte, byte)            {}
+    static inline void handleAfterTouchPoly(Channel, byte, byte)    {}
+    static inline void handleControlChange(Channel, byte, byte)     {}
+    static inline void handleProgramChange(Channel, byte)           {}
+    static inline void handleAfterTouchChannel(Channel, byte)       {}
+    static inline void handlePitchBend(Channel, int)                {}
+    static inline void handleSystemExclusive(byte*, unsigned)       {}
+    static inline void handleTimeCodeQuarterFrame(byte)             {}
+    static inline void handleSongPosition(unsigned)                 {}
+    static inline void handleSongSelect(byte)                       {}
+    static inline void handleTuneRequest()                          {}
+    static inline void handleClock()                                {}
+    static inline void handleStart()                                {}
+    static inline void handleTick()                                 {}
+    static inline void handleContinue()                             {}
+    static inline void handleStop()                                 {}
+    static inline void handleActiveSensing()                        {}
+    static inline void handleSystemReset()                          {}
+};
+
+/*! \brief Runtime input handlers, for sketches that need to change them.
+ Use it as the _Handlers template parameter of MidiInterface.
+ */
+struct CallbackHandlers : public DefaultHandlers
+{
+    static const bool UseCallbacks = true;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Function pointers set with setHandleNoteOn() & co.
+
+ MidiInterface derives from it, the disabled version is empty and takes no
+ space (see DefaultHandlers::UseCallbacks).
+ */
+template<bool Enabled>
+class InputCallbacks
+{
+public:
+    inline InputCallbacks()
+        : mErrorCallback(nullptr)
+        , mMessageCallback(nullptr)
+        , mNoteOffCallback(nullptr)
+        , mNoteOnCallback(nullptr)
+        , mAfterTouchPolyCallback(nullptr)
+        , mControlChangeCallback(nullptr)
+        , mProgramChangeCallback(nullptr)
+        , mAfterTouchChannelCallback(nullptr)
+        , mPitchBendCallback(nullptr)
+        , mSystemExclusiveCallback(nullptr)
+        , mTimeCodeQuarterFrameCallback(nullptr)
+        , mSongPositionCallback(nullptr)
+        , mSongSelectCallback(nullptr)
+        , mTuneRequestCallback(nullptr)
+        , mClockCallback(nullptr)
+        , mStartCallback(nullptr)
+        , mTickCallback(nullptr)
+        , mContinueCallback(nullptr)
+        , mStopCallback(nullptr)
+        , mActiveSensingCallback(nullptr)
+        , mSystemResetCallback(nullptr)
+    {
+    }
+
+public:
+    inline void setHandleError(ErrorCallback fptr)                                  { mErrorCallback = fptr; }
+    inline void setHandleMessage(MessageCallback fptr)                              { mMessageCallback = fptr; }
+    inline void setHandleNoteOff(NoteOffCallback fptr)                              { mNoteOffCallback = fptr; }
+    inline void setHandleNoteOn(NoteOnCallback fptr)                                { mNoteOnCallback = fptr; }
+    inline void setHandleAfterTouchPoly(AfterTouchPolyCallback fptr)                { mAfterTouchPolyCallback = fptr; }
+    inline void setHandleControlChange(ControlChangeCallback fptr)                  { mControlChangeCallback = fptr; }
+    inline void setHandleProgramChange(ProgramChangeCallback fptr)                  { mProgramChangeCallback = fptr; }
+    inline void setHandleAfterTouchChannel(AfterTouchChannelCallback fptr)          { mAfterTouchChannelCallback = fptr; }
+    inline void setHandlePitchBend(PitchBendCallback fptr)                          { mPitchBendCallback = fptr; }
+    inline void setHandleSystemExclusive(SystemExclusiveCallback fptr)              { mSystemExclusiveCallback = fptr; }
+    inline void setHandleTimeCodeQuarterFrame(TimeCodeQuarterFrameCallback fptr)    { mTimeCodeQuarterFrameCallback = fptr; }
+    inline void setHandleSongPosition(SongPositionCallback fptr)                    { mSongPositionCallback = fptr; }
+    inline void setHandleSongSelect(SongSelectCallback fptr)                        { mSongSelectCallback = fptr; }
+    inline void setHandleTuneRequest(RealTimeCallback fptr)                         { mTuneRequestCallback = fptr; }
+    inline void setHandleClock(RealTimeCallback fptr)                               { mClockCallback = fptr; }
+    inline void setHandleStart(RealTimeCallback fptr)                               { mStartCallback = fptr; }
+    inline void setHandleTick(RealTimeCallback fptr)                                { mTickCallback = fptr; }
+    inline void setHandleContinue(RealTimeCallback fptr)                            { mContinueCallback = fptr; }
+    inline void setHandleStop(RealTimeCallback fptr)                                { mStopCallback = fptr; }
+    inline void setHandleActiveSensing(RealTimeCallback fptr)                       { mActiveSensingCallback = fptr; }
+    inline void setHandleSystemReset(RealTimeCallback fptr)                         { mSystemResetCallback = fptr; }
+
+    /*! \brief Detach an external function from the given type.
+     Use this method to cancel the effects of setHandle********.
+     \param inType The type of message to unbind.
+     When a message of this type is received, no function will be called.
+     */
+    inline void disconnectCallbackFromType(MidiType inType)
+    {
+        switch (inType)
+        {
+            case NoteOff:               mNoteOffCallback                = nullptr; break;
+            case NoteOn:                mNoteOnCallback                 = nullptr; break;
+            case AfterTouchPoly:        mAfterTouchPolyCallback         = nullptr; break;
+            case ControlChange:         mControlChangeCallback          = nullptr; break;
+            case ProgramChange:         mProgramChangeCallback          = nullptr; break;
+            case AfterTouchChannel:     mAfterTouchChannelCallback      = nullptr; break;
+            case PitchBend:             mPitchBendCallback              = nullptr; break;
+            case SystemExclusive:       mSystemExclusiveCallback        = nullptr; break;
+            case TimeCodeQuarterFrame:  mTimeCodeQuarterFrameCallback   = nullptr; break;
+            case SongPosition:          mSongPositionCallback           = nullptr; break;
+            case SongSelect:            mSongSelectCallback             = nullptr; break;
+            case TuneRequest:           mTuneRequestCallback            = nullptr; break;
+            case Clock:                 mClockCallback                  = nullptr; break;
+            case Start:                 mStartCallback                  = nullptr; break;
+            case Tick:                  mTickCallback                   = nullptr; break;
+            case Continue:              mContinueCallback               = nullptr; break;
+            case Stop:                  mStopCallback                   = nullptr; break;
+            case ActiveSensing:         mActiveSensingCallback          = nullptr; break;
+            case SystemReset:           mSystemResetCallback            = nullptr; break;
+            default:
+                break;
+        }
+    }
+
+protected:
+    inline void callErrorCallback(int8_t inError)
+    {
+        if (mErrorCallback != nullptr)
+            mErrorCallback(inError);
+    }
+
+    inline void callCallbacks(const Message& inMessage, byte* inSysEx, unsigned inSysExLength)
+    {
+        if (mMessageCallback != nullptr)
+            mMessageCallback(inMessage);
+
+        // The order is mixed to allow frequent messages to trigger their callback faster.
+        switch (inMessage.type)
+        {
+                // Notes
+            case NoteOff:               if (mNoteOffCallback != nullptr)               mNoteOffCallback(inMessage.channel, inMessage.data1, inMessage.data2);   break;
+            case NoteOn:                if (mNoteOnCallback != nullptr)                mNoteOnCallback(inMessage.channel, inMessage.data1, inMessage.data2);    break;
+
+                // Real-time messages
+            case Clock:                 if (mClockCallback != nullptr)                 mClockCallback();           break;
+            case Start:                 if (mStartCallback != nullptr)                 mStartCallback();           break;
+            case Tick:                  if (mTickCallback != nullptr)                  mTickCallback();            break;
+            case Continue:              if (mContinueCallback != nullptr)              mContinueCallback();        break;
+            case Stop:                  if (mStopCallback != nullptr)                  mStopCallback();            break;
+            case ActiveSensing:         if (mActiveSensingCallback != nullptr)         mActiveSensingCallback();   break;
+
+                // Continuous controllers
+            case ControlChange:         if (mControlChangeCallback != nullptr)         mControlChangeCallback(inMessage.channel, inMessage.data1, inMessage.data2);    break;
+            case PitchBend:             if (mPitchBendCallback != nullptr)             mPitchBendCallback(inMessage.channel, getPitchBendValue(inMessage));           break;
+            case AfterTouchPoly:        if (mAfterTouchPolyCallback != nullptr)        mAfterTouchPolyCallback(inMessage.channel, inMessage.data1, inMessage.data2);   break;
+            case AfterTouchChannel:     if (mAfterTouchChannelCallback != nullptr)     mAfterTouchChannelCallback(inMessage.channel, inMessage.data1);                 break;
+
+            case ProgramChange:         if (mProgramChangeCallback != nullptr)         mProgramChangeCallback(inMessage.channel, inMessage.data1);     break;
+            case SystemExclusive:       if (mSystemExclusiveCallback != nullptr)       mSystemExclusiveCallback(inSysEx, inSysExLength);               break;
+
+                // Occasional messages
+            case TimeCodeQuarterFrame:  if (mTimeCodeQuarterFrameCallback != nullptr)  mTimeCodeQuarterFrameCallback(inMessage.data1);                 break;
+            case SongPosition:          if (mSongPositionCallback != nullptr)          mSongPositionCallback(getSongPositionValue(inMessage));         break;
+            case SongSelect:            if (mSongSelectCallback != nullptr)            mSongSelectCallback(inMessage.data1);                           break;
+            case TuneRequest:           if (mTuneRequestCallback != nullptr)           mTuneRequestCallback();                                         break;
+
+            case SystemReset:           if (mSystemResetCallback != nullptr)           mSystemResetCallback();                                         break;
+
+            default:
+                break;
+        }
+    }
+
+private:
+    ErrorCallback                   mErrorCallback;
+    MessageCallback                 mMessageCallback;
+    NoteOffCallback                 mNoteOffCallback;
+    NoteOnCallback                  mNoteOnCallback;
+    AfterTouchPolyCallback          mAfterTouchPolyCallback;
+    ControlChangeCallback           mControlChangeCallback;
+    ProgramChangeCallback           mProgramChangeCallback;
+    AfterTouchChannelCallback       mAfterTouchChannelCallback;
+    PitchBendCallback               mPitchBendCallback;
+    SystemExclusiveCallback         mSystemExclusiveCallback;
+    TimeCodeQuarterFrameCallback    mTimeCodeQuarterFrameCallback;
+    SongPositionCallback            mSongPositionCallback;
+    SongSelectCallback              mSongSelectCallback;
+    RealTimeCallback                mTuneRequestCallback;
+    RealTimeCallback                mClockCallback;
+    RealTimeCallback                mStartCallback;
+    RealTimeCallback                mTickCallback;
+    RealTimeCallback                mContinueCallback;
+    RealTimeCallback                mStopCallback;
+    RealTimeCallback                mActiveSensingCallback;
+    RealTimeCallback                mSystemResetCallback;
+};
+
+/*! Disabled runtime callbacks: only the compile-time handlers are called. */
+template<>
+class InputCallbacks<false>
+{
+protected:
+    inline void callErrorCallback(int8_t) {}
+    inline void callCallbacks(const Message&, byte*, unsigned) {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Call the compile-time handlers of a received message.
+ \param inSysEx The SysEx chunk (for SystemExclusive messages).
+ */
+template<class Handlers>
+inline void callHandlers(const Message& inMessage, byte* inSysEx, unsigned inSysExLength)
+{
+    Handlers::handleMessage(inMessage);
+
+    switch (inMessage.type)
+    {
+        case NoteOff:               Handlers::handleNoteOff(inMessage.channel, inMessage.data1, inMessage.data2);           break;
+        case NoteOn:                Handlers::handleNoteOn(inMessage.channel, inMessage.data1, inMessage.data2);            break;
+        case Clock:                 Handlers::handleClock();                                                                break;
+        case Start:                 Handlers::handleStart();                                                                break;
+        case Tick:                  Handlers::handleTick();                                                                 break;
+        case Continue:              Handlers::handleContinue();                                                             break;
+        case Stop:                  Handlers::handleStop();                                                                 break;
+        case ActiveSensing:         Handlers::handleActiveSensing();                                                        break;
+        case ControlChange:         Handlers::handleControlChange(inMessage.channel, inMessage.data1, inMessage.data2);     break;
+        case PitchBend:             Handlers::handlePitchBend(inMessage.channel, getPitchBendValue(inMessage));             break;
+        case AfterTouchPoly:        Handlers::handleAfterTouchPoly(inMessage.channel, inMessage.data1, inMessage.data2);    break;
+        case AfterTouchChannel:     Handlers::handleAfterTouchChannel(inMessage.channel, inMessage.data1);                  break;
+        case ProgramChange:         Handlers::handleProgramChange(inMessage.channel, inMessage.data1);                      break;
+        case SystemExclusive:       Handlers::handleSystemExclusive(inSysEx, inSysExLength);                                break;
+        case TimeCodeQuarterFrame:  Handlers::handleTimeCodeQuarterFrame(inMessage.data1);                                  break;
+        case SongPosition:          Handlers::handleSongPosition(getSongPositionValue(inMessage));                          break;
+        case SongSelect:            Handlers::handleSongSelect(inMessage.data1);                                            break;
+        case TuneRequest:           Handlers::handleTuneRequest();                                                          break;
+        case SystemReset:           Handlers::handleSystemReset();                                                          break;
+        default:
+            break;
+    }
+}
+
+END_MIDI_NAMESPACE
@@ -35,6 +35,62 @@
 
 BEGIN_MIDI_NAMESPACE
 
+struct Message;
+
+/*! \brief Wire form of a short MIDI message, in 4 bytes.
+
+ Holds the status byte (type & channel), the data bytes and the length, and
+ can be copied with memcpy: twice as many fit in the same RAM as Message,
+ for queues, routers and recorders. A null length marks an invalid message.
+ There is no timestamp, and SysEx chunks only keep their status byte, with a
+ length of 1 (their content stays in the SysEx buffer, its size in the data
+ bytes, as in Message).
+ Left uninitialised by default construction, like a plain struct.
+ @see MidiInterface::readBatch, MidiInterface::send
+ */
+struct PackedMessage
+{
+    PackedMessage() = default;
+
+    inline PackedMessage(StatusByte inStatus,
+                         DataByte inData1,
+                         DataByte inData2,
+                         byte inLength)
+        : status(inStatus)
+        , data1(inData1)
+        , data2(inData2)
+        , length(inLength)
+    {
+    }
+
+    inline explicit PackedMessage(const Message& inMessage);
+
+    inline MidiType getType() const
+    {
+        return MidiType(status < SystemExclusive ? status & 0xf0 : status);
+    }
+
+    /*! 1 to 16 for channel messages, 0 otherwise. */
+    inline Channel getChannel() const
+    {
+        return status < SystemExclusive ? Channel((status & 0x0f) + 1) : 0;
+    }
+
+    inline bool isValid() const
+    {
+        return length != 0;
+    }
+
+    StatusByte  status;
+    DataByte    data1;
+    DataByte    data2;
+    byte        length;
+};
+
+static_assert(sizeof(PackedMessage) == 4, "PackedMessage must fit in 4 bytes");
+
+// -----------------------------------------------------------------------------
+
 /*! The Message structure contains decoded data of a MIDI message
     read from the serial port with read()
  */
@@ -49,16 +105,20 @@ struct Message
         , data1(0)
         , data2(0)
         , valid(false)
+        , length(0)
+        , timestamp(0)
     {
     }
 
-    inline Message(const Message& inOther)
-        : channel(inOther.channel)
-        , type(inOther.type)
-        , data1(inOther.data1)
-        , data2(inOther.data2)
-        , valid(inOther.valid)
-        , length(inOther.length)
+    /*! Unpack a message, its timestamp is 0. */
+    inline explicit Message(const PackedMessage& inMessage)
+        : channel(inMessage.getChannel())
+        , type(inMessage.getType())
+        , data1(inMessage.data1)
+        , data2(inMessage.data2)
+        , valid(inMessage.isValid())
+        , length(inMessage.status == SystemExclusive ? 0 : inMessage.length)
+        , timestamp(0)
     {
     }
 
@@ -92,6 +152,23 @@ struct Message
     /*! Total Length of the message.
      */
     byte length;
+
+    /*! Time of reception of the first byte of the message, in microseconds.
+     Only set with DefaultSettings::UseTimestamps, otherwise 0.
+     */
+    unsigned long timestamp;
 };
 
+// -----------------------------------------------------------------------------
+
+inline PackedMessage::PackedMessage(const Message& inMessage)
+    : status(inMessage.channel != 0 && inMessage.type < SystemExclusive
+             ? StatusByte(inMessage.type | ((inMessage.channel - 1) & 0x0f))
+             : StatusByte(inMessage.type))
+    , data1(inMessage.data1)
+    , data2(inMessage.data2)
+    , length(!inMessage.valid ? 0 : inMessage.type == SystemExclusive ? 1 : inMessage.length)
+{
+}
+
 END_MIDI_NAMESPACE
@@ -0,0 +1,226 @@
+/*!
+ *  @file       midi_Parameters.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - RPN / NRPN input decoder
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief A complete RPN / NRPN operation, assembled from its Control Changes.
+ @see MidiInterface::getParameterEvent
+ */
+struct ParameterEvent
+{
+    enum Kind
+    {
+        Registered      = 0,    ///< RPN, selected with CC 101 / 100
+        NonRegistered   = 1,    ///< NRPN, selected with CC 99 / 98
+    };
+
+    enum Action
+    {
+        Value           = 0,    ///< Data Entry (CC 6 / 38), value holds the 14-bit value
+        Increment       = 1,    ///< Data Increment (CC 96), value holds the amount
+        Decrement       = 2,    ///< Data Decrement (CC 97), value holds the amount
+    };
+
+    byte        kind;
+    byte        action;
+    Channel     channel;
+    uint16_t    number;     ///< 14-bit parameter number
+    uint16_t    value;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Per-channel RPN / NRPN state machine, see DefaultSettings::UseParameterDecoder.
+
+ Parameter selection lasts until another one is selected, or until the
+ Null Function (127 / 127) deselects it: Data Entry is then left alone.
+ Each Data Entry MSB gives an event (with the LSB cleared), each Data Entry
+ LSB gives another one with the full 14-bit value.
+ */
+template<bool Enabled>
+class ParameterDecoder
+{
+public:
+    enum Result
+    {
+        NotParameter    = 0,    ///< Not part of an RPN / NRPN frame
+        Selection       = 1,    ///< Parameter number selection, no event yet
+        Event           = 2,    ///< An event is ready, @see getEvent
+    };
+
+    inline ParameterDecoder()
+    {
+        reset();
+    }
+
+    inline void reset()
+    {
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            mChannels[i].number = sNoParameter;
+            mChannels[i].valueMsb = 0;
+            mChannels[i].valueLsb = 0;
+        }
+        mEventReady = false;
+    }
+
+    inline Result process(Channel inChannel, DataByte inController, DataByte inValue)
+    {
+        ChannelState& state = mChannels[inChannel - 1];
+
+        switch (inController)
+        {
+            case RPNMSB:
+            case NRPNMSB:
+                select(state, inController == NRPNMSB, inValue, state.number & 0x7f);
+                return Selection;
+
+            case RPNLSB:
+            case NRPNLSB:
+                select(state, inController == NRPNLSB, (state.number >> 7) & 0x7f, inValue);
+                return Selection;
+
+            case DataEntryMSB:
+            case DataEntryLSB:
+            case DataIncrement:
+            case DataDecrement:
+                break;
+
+            default:
+                return NotParameter;
+        }
+
+        if (state.number & sNoParameter)
+            return NotParameter; // Nothing selected, or Null Function
+
+        mEvent.kind    = (state.number & sNonRegistered) ? ParameterEvent::NonRegistered
+                                                         : ParameterEvent::Registered;
+        mEvent.channel = inChannel;
+        mEvent.number  = state.number & 0x3fff;
+
+        if (inController == DataEntryMSB)
+        {
+            state.valueMsb = inValue;
+            state.valueLsb = 0;
+        }
+        else if (inController == DataEntryLSB)
+        {
+            state.valueLsb = inValue;
+        }
+
+        if (inController == DataIncrement || inController == DataDecrement)
+        {
+            mEvent.action = inController == DataIncrement ? ParameterEvent::Increment
+                                                          : ParameterEvent::Decrement;
+            mEvent.value  = inValue;
+        }
+        else
+        {
+            mEvent.action = ParameterEvent::Value;
+            mEvent.value  = uint16_t(state.valueMsb) << 7 | state.valueLsb;
+        }
+        mEventReady = true;
+        return Event;
+    }
+
+    inline const ParameterEvent& getEvent() const
+    {
+        return mEvent;
+    }
+
+    /*! An event was given since the last clearEvent. */
+    inline bool isEventReady() const
+    {
+        return mEventReady;
+    }
+
+    inline void clearEvent()
+    {
+        mEventReady = false;
+    }
+
+private:
+    struct ChannelState
+    {
+        uint16_t number;    ///< 14-bit number, sNonRegistered flag, sNoParameter if deselected
+        DataByte valueMsb;
+        DataByte valueLsb;
+    };
+
+    static inline void select(ChannelState& ioState, bool inNonRegistered, byte inMsb, byte inLsb)
+    {
+        // The other half of the number is kept, so that senders can only
+        // change the LSB. Both RPN and NRPN 127 / 127 deselect.
+        const uint16_t number = uint16_t(inMsb) << 7 | inLsb;
+
+        ioState.number = number;
+        if (inNonRegistered)
+            ioState.number |= sNonRegistered;
+        if (number == RPN::NullFunction)
+            ioState.number |= sNoParameter;
+
+        ioState.valueMsb = 0;
+        ioState.valueLsb = 0;
+    }
+
+private:
+    static const uint16_t sNonRegistered = 0x4000;
+    static const uint16_t sNoParameter   = 0x8000;
+
+    ChannelState mChannels[16];
+    ParameterEvent mEvent;
+    bool mEventReady;
+};
+
+/*! Disabled decoder: Control Changes are never part of a parameter. */
+template<>
+class ParameterDecoder<false>
+{
+public:
+    enum Result
+    {
+        NotParameter    = 0,
+        Selection       = 1,
+        Event           = 2,
+    };
+
+    inline void reset() {}
+    inline Result process(Channel, DataByte, DataByte) { return NotParameter; }
+    inline bool isEventReady() const { return false; }
+    inline void clearEvent() {}
+
+    inline const ParameterEvent& getEvent() const
+    {
+        static const ParameterEvent event = ParameterEvent();
+        return event;
+    }
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,473 @@
+/*!
+ *  @file       midi_Parser.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Transport-free buffer parser
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Message.h"
+#ifndef ARDUINO
+#include <string.h>
+#endif
+
+/*! Scan for status bytes 16 (SSE2, NEON) or 32 (AVX2) bytes at a time in
+ MidiParser. Defaults to on for GCC / Clang builds with SSE2 or AArch64,
+ off elsewhere (8-bit targets scan one byte at a time). Define it to 0 or 1
+ to override.
+ */
+#ifndef MIDI_PARSER_SIMD
+#   if defined(__GNUC__) && (defined(__SSE2__) || defined(__aarch64__))
+#       define MIDI_PARSER_SIMD 1
+#   else
+#       define MIDI_PARSER_SIMD 0
+#   endif
+#endif
+
+#if MIDI_PARSER_SIMD
+#   if defined(__SSE2__)
+#       include <immintrin.h>
+#   elif defined(__aarch64__)
+#       include <arm_neon.h>
+#   endif
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Parser for MIDI byte streams held in memory, without a transport.
+
+ Decodes whole buffers (eg: captured MIDI logs) for host-side tools, with
+ the parsing rules of MidiInterface::read: running status on channel
+ messages, Real Time messages interleaved anywhere (they are emitted first,
+ the message they interrupt is completed later), Undefined_FD ignored and
+ SysEx frames delivered in chunks through the buffer given to
+ setSysExBuffer. A stream can be fed in slices of any size, the state is
+ kept between calls to parse.
+
+ Runs of data bytes are located 16 or 32 bytes at a time (@see
+ MIDI_PARSER_SIMD): SysEx payloads are copied to the buffer in bulk, and
+ running status messages are decoded without going through the state
+ machine.
+
+ As in MidiInterface, a status byte received in the middle of a message
+ drops it as a parse error and starts a new message, and Tune Request cancels
+ running status, which are the MIDI 1.0 rules.
+ Messages are emitted raw: NoteOn with a null velocity stays a NoteOn, and
+ their timestamp is 0.
+ */
+class MidiParser
+{
+public:
+    inline MidiParser()
+        : mSysExBuffer(nullptr)
+        , mSysExSize(0)
+        , mSysExIndex(0)
+        , mSysExLength(0)
+    {
+        reset();
+    }
+
+    /*! Forget the message being received and the running status,
+     and clear the error count. The SysEx buffer is kept.
+     */
+    inline void reset()
+    {
+        mRunningStatus = 0;
+        mRunningInfo   = 0;
+        mPendingIndex  = 0;
+        mPendingLength = 0;
+        mPendingInfo   = 0;
+        mInSysEx       = false;
+        mSysExIndex    = 0;
+        mErrors        = 0;
+    }
+
+    /*! Receive SysEx frames in chunks of up to inSize bytes.\n
+     Each chunk is emitted as a SystemExclusive message holding its length in
+     data1 (LSB) and data2 (MSB), like MidiInterface does: the first chunk
+     starts with 0xF0, the last one ends with 0xF7, and the content is in
+     getSysExArray() until the next chunk. Without a buffer, SysEx frames are
+     skipped.
+     */
+    inline void setSysExBuffer(byte* inBuffer, unsigned inSize)
+    {
+        mSysExBuffer = inSize != 0 ? inBuffer : nullptr;
+        mSysExSize   = inSize;
+        mSysExIndex  = 0;
+    }
+
+    inline const byte* getSysExArray() const
+    {
+        return mSysExBuffer;
+    }
+
+    /*! Length of the last SysEx chunk emitted. */
+    inline unsigned getSysExArrayLength() const
+    {
+        return mSysExLength;
+    }
+
+    /*! Number of parse errors (data bytes without status, interrupted
+     messages and frames, undefined or stray status bytes) since reset().
+     */
+    inline unsigned long getErrorCount() const
+    {
+        return mErrors;
+    }
+
+    /*! \brief Decode inSize bytes, calling inSink(const Message&) for
+     each message, in stream order.
+     \return The number of messages emitted.
+     */
+    template<class Sink>
+    inline size_t parse(const byte* inData, size_t inSize, Sink&& inSink);
+
+    /*! \brief Decode inSize bytes, writing the messages to outMessages.
+     \return The iterator past the last message written.
+     */
+    template<class OutputIterator>
+    inline OutputIterator parseTo(const byte* inData,
+                                  size_t inSize,
+                                  OutputIterator outMessages);
+
+    /*! First byte of [inBegin, inEnd) with the high bit set, or inEnd. */
+    static inline const byte* findStatusByte(const byte* inBegin, const byte* inEnd);
+
+private:
+    template<class Sink>
+    inline const byte* parseRunningStatus(const byte* inData, const byte* inEnd, Sink& inSink);
+    template<class Sink>
+    inline void appendSysEx(const byte* inData, const byte* inEnd, Sink& inSink);
+    template<class Sink>
+    inline void appendSysEx(byte inByte, Sink& inSink);
+    template<class Sink>
+    inline void emitSysExChunk(Sink& inSink);
+    template<class Sink>
+    inline void emit(Sink& inSink,
+                     StatusByte inStatus,
+                     DataByte inData1,
+                     DataByte inData2,
+                     byte inLength,
+                     byte inInfo);
+
+private:
+    template<class OutputIterator>
+    struct IteratorSink
+    {
+        inline void operator()(const Message& inMessage)
+        {
+            *mIterator++ = inMessage;
+        }
+
+        OutputIterator& mIterator;
+    };
+
+private:
+    byte*           mSysExBuffer;
+    unsigned        mSysExSize;
+    unsigned        mSysExIndex;
+    unsigned        mSysExLength;
+    unsigned long   mErrors;
+    size_t          mNumEmitted;
+    StatusByte      mRunningStatus;
+    byte            mRunningInfo;
+    StatusByte      mPending[3];
+    byte            mPendingIndex;
+    byte            mPendingLength;
+    byte            mPendingInfo;
+    bool            mInSysEx;
+};
+
+// -----------------------------------------------------------------------------
+
+template<class Sink>
+inline size_t MidiParser::parse(const byte* inData, size_t inSize, Sink&& inSink)
+{
+    const byte* data = inData;
+    const byte* const end = inData + inSize;
+    mNumEmitted = 0;
+
+    while (data != end)
+    {
+        if (mInSysEx)
+        {
+            // Payload up to the next status byte goes to the buffer at once.
+            const byte* status = findStatusByte(data, end);
+            appendSysEx(data, status, inSink);
+            data = status;
+            if (data == end)
+                break;
+        }
+        else if (mPendingLength == 0 && mRunningStatus != 0 && *data < 0x80)
+        {
+            data = parseRunningStatus(data, end, inSink);
+            continue;
+        }
+
+        const byte extracted = *data++;
+        const byte info      = getStatusInfo(extracted);
+
+        if (info & StatusInfo::Ignored)
+            continue;
+
+        if (info & StatusInfo::RealTime)
+        {
+            // Leave the pending message (or frame) as is, it completes later.
+            emit(inSink, extracted, 0, 0, 1, info);
+            continue;
+        }
+
+        if (mInSysEx)
+        {
+            mInSysEx = false;
+            if (extracted == SystemExclusiveEnd)
+            {
+                appendSysEx(extracted, inSink);
+                continue;
+            }
+
+            // Frame interrupted, the status byte starts the next message.
+            mErrors++;
+            mSysExIndex = 0;
+        }
+
+        if (extracted < 0x80)
+        {
+            if (mPendingLength == 0)
+            {
+                // Data byte without running status
+                mErrors++;
+                continue;
+            }
+
+            mPending[mPendingIndex++] = extracted;
+            if (mPendingIndex == mPendingLength)
+            {
+                emit(inSink, mPending[0], mPending[1], mPending[2], mPendingLength, mPendingInfo);
+                mRunningStatus = (mPendingInfo & StatusInfo::RunningStatus) ? mPending[0] : 0;
+                mRunningInfo   = mPendingInfo;
+                mPendingLength = 0;
+            }
+            continue;
+        }
+
+        if (mPendingLength != 0)
+        {
+            // Message interrupted by a status byte
+            mErrors++;
+            mPendingLength = 0;
+        }
+
+        const byte length = info & StatusInfo::LengthMask;
+
+        if (extracted == SystemExclusiveStart)
+        {
+            // System Exclusive cancels running status.
+            mRunningStatus = 0;
+            mInSysEx       = true;
+            mSysExIndex    = 0;
+            appendSysEx(extracted, inSink);
+        }
+        else if (length == 0)
+        {
+            // EOX without a frame, or undefined status
+            mErrors++;
+            mRunningStatus = 0;
+        }
+        else if (length == 1)
+        {
+            // Tune Request
+            emit(inSink, extracted, 0, 0, 1, info);
+            mRunningStatus = 0;
+        }
+        else
+        {
+            mPending[0]    = extracted;
+            mPending[2]    = 0;
+            mPendingIndex  = 1;
+            mPendingLength = length;
+            mPendingInfo   = info;
+        }
+    }
+
+    return mNumEmitted;
+}
+
+template<class OutputIterator>
+inline OutputIterator MidiParser::parseTo(const byte* inData,
+                                          size_t inSize,
+                                          OutputIterator outMessages)
+{
+    IteratorSink<OutputIterator> sink = { outMessages };
+    parse(inData, inSize, sink);
+    return outMessages;
+}
+
+inline const byte* MidiParser::findStatusByte(const byte* inBegin, const byte* inEnd)
+{
+    const byte* data = inBegin;
+
+#if MIDI_PARSER_SIMD && defined(__AVX2__)
+    while (inEnd - data >= 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        const unsigned mask = unsigned(_mm256_movemask_epi8(block));
+        if (mask != 0)
+            return data + __builtin_ctz(mask);
+        data += 32;
+    }
+#endif
+#if MIDI_PARSER_SIMD && defined(__SSE2__)
+    while (inEnd - data >= 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const unsigned mask = unsigned(_mm_movemask_epi8(block));
+        if (mask != 0)
+            return data + __builtin_ctz(mask);
+        data += 16;
+    }
+#elif MIDI_PARSER_SIMD && defined(__aarch64__)
+    while (inEnd - data >= 16)
+    {
+        // No movemask on NEON: find the block, the byte loop below finds the status.
+        if (vmaxvq_u8(vld1q_u8(data)) & 0x80)
+            break;
+        data += 16;
+    }
+#endif
+
+    while (data != inEnd && *data < 0x80)
+        data++;
+    return data;
+}
+
+// Private method: messages using running status, from a run of data bytes
+template<class Sink>
+inline const byte* MidiParser::parseRunningStatus(const byte* inData,
+                                                  const byte* inEnd,
+                                                  Sink& inSink)
+{
+    const byte* data = inData;
+    const byte* const run = findStatusByte(inData, inEnd);
+    const byte length = mRunningInfo & StatusInfo::LengthMask;
+
+    if (length == 3)
+    {
+        for (; run - data >= 2; data += 2)
+            emit(inSink, mRunningStatus, data[0], data[1], 3, mRunningInfo);
+    }
+    else
+    {
+        for (; data != run; data++)
+            emit(inSink, mRunningStatus, data[0], 0, 2, mRunningInfo);
+    }
+
+    if (data != run)
+    {
+        // First half of a message, the next data byte completes it.
+        mPending[0]    = mRunningStatus;
+        mPending[1]    = *data++;
+        mPendingIndex  = 2;
+        mPendingLength = 3;
+        mPendingInfo   = mRunningInfo;
+    }
+    return data;
+}
+
+// Private method: copy SysEx payload to the buffer, chunk by chunk
+template<class Sink>
+inline void MidiParser::appendSysEx(const byte* inData, const byte* inEnd, Sink& inSink)
+{
+    if (mSysExBuffer == nullptr)
+        return;
+
+    while (inData != inEnd)
+    {
+        const size_t room  = mSysExSize - mSysExIndex;
+        const size_t count = size_t(inEnd - inData) < room ? size_t(inEnd - inData) : room;
+
+        memcpy(mSysExBuffer + mSysExIndex, inData, count);
+        mSysExIndex += unsigned(count);
+        inData      += count;
+
+        if (mSysExIndex == mSysExSize)
+            emitSysExChunk(inSink);
+    }
+}
+
+// Private method: SysEx start / end
+template<class Sink>
+inline void MidiParser::appendSysEx(byte inByte, Sink& inSink)
+{
+    if (mSysExBuffer == nullptr)
+        return;
+
+    mSysExBuffer[mSysExIndex++] = inByte;
+    if (mSysExIndex == mSysExSize || inByte == SystemExclusiveEnd)
+        emitSysExChunk(inSink);
+}
+
+template<class Sink>
+inline void MidiParser::emitSysExChunk(Sink& inSink)
+{
+    mSysExLength = mSysExIndex;
+    mSysExIndex  = 0;
+
+    // The chunk length is stored in the data bytes (LSB first).
+    Message message;
+    message.type  = SystemExclusive;
+    message.data1 = mSysExLength & 0xff;
+    message.data2 = byte(mSysExLength >> 8);
+    message.valid = true;
+    inSink(static_cast<const Message&>(message));
+    mNumEmitted++;
+}
+
+template<class Sink>
+inline void MidiParser::emit(Sink& inSink,
+                             StatusByte inStatus,
+                             DataByte inData1,
+                             DataByte inData2,
+                             byte inLength,
+                             byte inInfo)
+{
+    Message message;
+    if (inInfo & StatusInfo::ChannelMessage)
+    {
+        message.type    = MidiType(inStatus & 0xf0);
+        message.channel = Channel((inStatus & 0x0f) + 1);
+    }
+    else
+    {
+        message.type = MidiType(inStatus);
+    }
+    message.data1  = inLength > 1 ? inData1 : 0;
+    message.data2  = inLength > 2 ? inData2 : 0;
+    message.length = inLength;
+    message.valid  = true;
+    inSink(static_cast<const Message&>(message));
+    mNumEmitted++;
+}
+
+END_MIDI_NAMESPACE
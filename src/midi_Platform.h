@@ -29,6 +29,11 @@
 
 #include "midi_Defs.h"
 
+#if !ARDUINO && (defined(__unix__) || defined(__APPLE__))
+#include <time.h>
+#define MIDI_POSIX_PLATFORM 1
+#endif
+
 BEGIN_MIDI_NAMESPACE
 
 #if ARDUINO
@@ -37,6 +42,35 @@ BEGIN_MIDI_NAMESPACE
 struct DefaultPlatform
 {
    static unsigned long now() { return ::millis(); };
+   static unsigned long nowMicros() { return ::micros(); };
+};
+
+#elif MIDI_POSIX_PLATFORM
+
+/*! \brief Monotonic clock of POSIX hosts (Linux, Raspberry Pi, macOS).
+ Not affected by changes of the wall clock. Both counters wrap around like
+ Arduino's millis() and micros(), the library only compares differences.
+ */
+struct PosixPlatform
+{
+    static unsigned long now()
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (unsigned long)time.tv_sec * 1000UL + (unsigned long)(time.tv_nsec / 1000000);
+    }
+
+    static unsigned long nowMicros()
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (unsigned long)time.tv_sec * 1000000UL + (unsigned long)(time.tv_nsec / 1000);
+    }
+};
+
+// DefaultPlatform is the POSIX Platform
+struct DefaultPlatform : public PosixPlatform
+{
 };
 
 #else
@@ -44,6 +78,7 @@ struct DefaultPlatform
 struct DefaultPlatform
 {
    static unsigned long now() { return 0; };
+   static unsigned long nowMicros() { return 0; };
 };
 
 #endif
@@ -0,0 +1,461 @@
+/*!
+ *  @file       midi_PosixTransport.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - POSIX device transport
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Platform.h"
+
+#if MIDI_POSIX_PLATFORM
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+struct DefaultPosixSettings
+{
+    /*! Size of the receive and transmit buffers.\n
+    Each read(2) call takes up to this many bytes from the device.
+    */
+    static const unsigned BufferSize = 256;
+
+    /*! Line rate set on serial (tty) devices, 0 to keep the port's.\n
+    Only the standard termios rates are available (9600, 38400, 115200...):
+    for DIN MIDI at 31250, remap the UART clock so that 38400 gives 31250
+    (eg: on a Raspberry Pi) and use 38400. Raw MIDI devices (ALSA
+    /dev/snd/midiC*D*, OSS /dev/midi*) have no line rate.
+    */
+    static const unsigned long BaudRate = 0;
+
+    /*! How long (in ms) a write waits for a full device before dropping the rest. */
+    static const int WriteTimeout = 100;
+};
+
+/*! \brief Transport for the serial and raw MIDI devices of POSIX hosts.
+
+ The device is non-blocking: available() reads what the device holds in a
+ single read(2) call into the receive buffer, and returns 0 if there is
+ nothing, without waiting. Outgoing messages are gathered and written with
+ one write(2) per message (or per transmit buffer for long SysEx).
+
+ To sleep until there is input, wait on getFd() with poll(2), select(2)
+ or epoll (@see EpollPortSet), or call waitForInput(). Eg:
+ \code{.cpp}
+ midi::PosixMIDI<> transport;
+ midi::MidiInterface<midi::PosixMIDI<> > midi(transport);
+
+ transport.open("/dev/snd/midiC1D0");
+ midi.begin(MIDI_CHANNEL_OMNI);
+ while (transport.isOpen())
+ {
+     transport.waitForInput(250);
+     while (midi.read()) { ... }
+ }
+ \endcode
+ Read errors and end of file (eg: USB device unplugged) close the device.
+ */
+template<class _Settings = DefaultPosixSettings>
+class PosixMIDI
+{
+    typedef _Settings Settings;
+
+public:
+    static_assert(Settings::BufferSize >= 3, "BufferSize must hold a channel message");
+
+    inline PosixMIDI()
+        : mFd(-1)
+        , mOwned(false)
+        , mRxPosition(0)
+        , mRxSize(0)
+        , mTxSize(0)
+        , mDroppedBytes(0)
+    {
+    }
+
+    inline ~PosixMIDI()
+    {
+        close();
+    }
+
+public:
+    /*! \brief Open a device (eg: /dev/ttyAMA0, /dev/snd/midiC1D0).
+     Serial devices are set to raw mode, at Settings::BaudRate if not 0.
+     \return false if the device could not be opened or configured.
+     */
+    inline bool open(const char* inPath)
+    {
+        close();
+        const int fd = ::open(inPath, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        if (isatty(fd) && !configureTerminal(fd))
+        {
+            ::close(fd);
+            return false;
+        }
+        mFd = fd;
+        mOwned = true;
+        return true;
+    }
+
+    /*! \brief Use a descriptor opened by the application (eg: a pipe or a
+     socket), it is made non-blocking and is not closed by close().
+     Writing to a pipe or socket closed by the peer raises SIGPIPE, ignore
+     it in the application if that can happen.
+     */
+    inline void attach(int inFd)
+    {
+        close();
+        const int flags = fcntl(inFd, F_GETFL);
+        if (flags >= 0)
+            fcntl(inFd, F_SETFL, flags | O_NONBLOCK);
+        mFd = inFd;
+        mOwned = false;
+    }
+
+    inline void close()
+    {
+        if (mFd >= 0 && mOwned)
+            ::close(mFd);
+        mFd = -1;
+        mOwned = false;
+        mRxPosition = mRxSize = 0;
+        mTxSize = 0;
+    }
+
+    inline bool isOpen() const
+    {
+        return mFd >= 0;
+    }
+
+    /*! Descriptor to wait on for input (POLLIN / EPOLLIN), -1 if closed. */
+    inline int getFd() const
+    {
+        return mFd;
+    }
+
+    /*! \brief Wait until input is available, up to inTimeoutMs (-1: forever).
+     \return true if there is input to read.
+     */
+    inline bool waitForInput(int inTimeoutMs)
+    {
+        if (mRxPosition < mRxSize)
+            return true;
+        if (!isOpen())
+            return false;
+
+        pollfd descriptor;
+        descriptor.fd = mFd;
+        descriptor.events = POLLIN;
+        descriptor.revents = 0;
+        return ::poll(&descriptor, 1, inTimeoutMs) > 0;
+    }
+
+    /*! \brief Read what the device holds, if the receive buffer is empty.
+     \return The number of bytes read.
+     */
+    inline unsigned pump()
+    {
+        if (mRxPosition < mRxSize || !isOpen())
+            return 0;
+
+        mRxPosition = mRxSize = 0;
+        for (;;)
+        {
+            const ssize_t count = ::read(mFd, mRxBuffer, Settings::BufferSize);
+            if (count > 0)
+            {
+                mRxSize = unsigned(count);
+                return mRxSize;
+            }
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return 0;
+
+            close(); // End of file or device gone
+            return 0;
+        }
+    }
+
+    /*! Bytes dropped because the device stayed full for WriteTimeout, or closed. */
+    inline unsigned getDroppedBytes() const
+    {
+        return mDroppedBytes;
+    }
+
+public: // Used by MidiInterface
+    inline void begin()
+    {
+    }
+
+    inline void end()
+    {
+        close();
+    }
+
+    inline bool beginTransmission(MidiType)
+    {
+        return isOpen();
+    }
+
+    inline void write(byte inByte)
+    {
+        if (mTxSize == Settings::BufferSize)
+            flushOutput();
+        mTxBuffer[mTxSize++] = inByte;
+    }
+
+    inline void write(const byte* inData, size_t inSize)
+    {
+        if (mTxSize + inSize > Settings::BufferSize)
+        {
+            flushOutput();
+            if (inSize > Settings::BufferSize)
+            {
+                writeAll(inData, inSize);
+                return;
+            }
+        }
+        memcpy(mTxBuffer + mTxSize, inData, inSize);
+        mTxSize += unsigned(inSize);
+    }
+
+    inline void endTransmission()
+    {
+        flushOutput();
+    }
+
+    inline byte read()
+    {
+        return mRxBuffer[mRxPosition++];
+    }
+
+    inline unsigned available()
+    {
+        if (mRxPosition == mRxSize)
+            pump();
+        return mRxSize - mRxPosition;
+    }
+
+private:
+    inline void flushOutput()
+    {
+        writeAll(mTxBuffer, mTxSize);
+        mTxSize = 0;
+    }
+
+    inline void writeAll(const byte* inData, size_t inSize)
+    {
+        while (inSize > 0 && isOpen())
+        {
+            const ssize_t count = ::write(mFd, inData, inSize);
+            if (count > 0)
+            {
+                inData += count;
+                inSize -= size_t(count);
+                continue;
+            }
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                pollfd descriptor;
+                descriptor.fd = mFd;
+                descriptor.events = POLLOUT;
+                descriptor.revents = 0;
+                if (::poll(&descriptor, 1, Settings::WriteTimeout) > 0)
+                    continue;
+            }
+            break;
+        }
+        mDroppedBytes += unsigned(inSize);
+    }
+
+    static inline bool configureTerminal(int inFd)
+    {
+        termios options;
+        if (tcgetattr(inFd, &options) != 0)
+            return false;
+
+        cfmakeraw(&options);
+        options.c_cflag |= CLOCAL | CREAD;
+        options.c_cc[VMIN]  = 0;
+        options.c_cc[VTIME] = 0;
+
+        if (Settings::BaudRate != 0)
+        {
+            const speed_t speed = getSpeed(Settings::BaudRate);
+            if (speed == B0 || cfsetispeed(&options, speed) != 0 || cfsetospeed(&options, speed) != 0)
+                return false;
+        }
+        return tcsetattr(inFd, TCSANOW, &options) == 0;
+    }
+
+    static inline speed_t getSpeed(unsigned long inBaudRate)
+    {
+        switch (inBaudRate)
+        {
+            case 9600:      return B9600;
+            case 19200:     return B19200;
+            case 38400:     return B38400;
+            case 57600:     return B57600;
+            case 115200:    return B115200;
+            case 230400:    return B230400;
+            default:        return B0;
+        }
+    }
+
+private:
+    int         mFd;
+    bool        mOwned;
+    unsigned    mRxPosition;
+    unsigned    mRxSize;
+    unsigned    mTxSize;
+    unsigned    mDroppedBytes;
+    byte        mRxBuffer[Settings::BufferSize];
+    byte        mTxBuffer[Settings::BufferSize];
+};
+
+// -----------------------------------------------------------------------------
+
+#if defined(__linux__)
+
+/*! \brief Wakes a pool of threads on the ports that have input.
+
+ Each port is watched in one-shot mode: wait() hands it to a single thread,
+ and nobody else gets it until that thread calls rearm(). Any number of
+ threads can wait at the same time, and each MidiInterface is only ever
+ serviced by one thread at a time, without locks. Eg:
+ \code{.cpp}
+ struct Port
+ {
+     midi::PosixMIDI<> transport;
+     midi::MidiInterface<midi::PosixMIDI<> > midi;
+ };
+
+ void worker(midi::EpollPortSet& ports) // On each thread of the pool
+ {
+     for (;;)
+     {
+         Port* port = static_cast<Port*>(ports.wait(-1));
+         while (port->midi.poll(256)) {}     // Drain the ready port
+         ports.rearm(port->transport.getFd(), port);
+     }
+ }
+ \endcode
+ Drain a port before rearming it: bytes left in the receive buffer of
+ PosixMIDI don't wake the set, only the ones still in the device do.
+ */
+class EpollPortSet
+{
+public:
+    inline EpollPortSet()
+        : mFd(-1)
+    {
+    }
+
+    inline ~EpollPortSet()
+    {
+        end();
+    }
+
+    inline bool begin()
+    {
+        end();
+        mFd = epoll_create1(EPOLL_CLOEXEC);
+        return mFd >= 0;
+    }
+
+    inline void end()
+    {
+        if (mFd >= 0)
+            ::close(mFd);
+        mFd = -1;
+    }
+
+    /*! Watch inFd, wait() then returns inContext when it has input. */
+    inline bool add(int inFd, void* inContext)
+    {
+        return control(EPOLL_CTL_ADD, inFd, inContext);
+    }
+
+    inline bool remove(int inFd)
+    {
+        return control(EPOLL_CTL_DEL, inFd, nullptr);
+    }
+
+    /*! Watch inFd again after servicing it. */
+    inline bool rearm(int inFd, void* inContext)
+    {
+        return control(EPOLL_CTL_MOD, inFd, inContext);
+    }
+
+    /*! \brief Wait up to inTimeoutMs (-1: forever) for a port with input.
+     \return Its context, nullptr on timeout. The port is not watched any
+     more until rearm() is called.
+     */
+    inline void* wait(int inTimeoutMs)
+    {
+        epoll_event event;
+        int count;
+        do
+        {
+            count = epoll_wait(mFd, &event, 1, inTimeoutMs);
+        }
+        while (count < 0 && errno == EINTR);
+
+        return count > 0 ? event.data.ptr : nullptr;
+    }
+
+private:
+    inline bool control(int inOperation, int inFd, void* inContext)
+    {
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = inContext;
+        return epoll_ctl(mFd, inOperation, inFd, &event) == 0;
+    }
+
+private:
+    int mFd;
+};
+
+#endif
+
+END_MIDI_NAMESPACE
+
+#endif // MIDI_POSIX_PLATFORM
@@ -0,0 +1,288 @@
+/*!
+ *  @file       midi_RingTransport.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Lock-free receive ring transport
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "serialMIDI.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Wait-free single producer / single consumer ring.
+
+ push() must always be called from the same context (an ISR or a core), and
+ pop() / available() from another one (usually the one running MidiInterface).
+ Indices run freely and are wrapped with a mask, so all the Capacity slots
+ can be used.
+ */
+template<class T, unsigned Capacity>
+class SpscRing
+{
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Ring capacity must be a power of two");
+#if defined(__AVR__)
+    static_assert(Capacity <= 128, "Ring capacity is limited to 128 slots on AVR");
+    typedef byte Index;
+#else
+    typedef unsigned Index;
+#endif
+
+    inline SpscRing()
+        : mHead(0)
+        , mTail(0)
+    {
+    }
+
+public: // Producer side
+    /*! Returns false (and drops the value) if the ring is full. */
+    inline bool push(const T& inValue)
+    {
+        const Index head = mHead;
+        if (Index(head - MIDI_RING_LOAD_ACQUIRE(mTail)) >= Capacity)
+            return false;
+
+        mData[head & sMask] = inValue;
+        MIDI_RING_STORE_RELEASE(mHead, Index(head + 1));
+        return true;
+    }
+
+public: // Consumer side
+    inline unsigned available() const
+    {
+        return Index(MIDI_RING_LOAD_ACQUIRE(mHead) - mTail);
+    }
+
+    /*! Ring must not be empty. */
+    inline T pop()
+    {
+        const Index tail = mTail;
+        const T value = mData[tail & sMask];
+        MIDI_RING_STORE_RELEASE(mTail, Index(tail + 1));
+        return value;
+    }
+
+    /*! Drop all pending values. */
+    inline void clear()
+    {
+        MIDI_RING_STORE_RELEASE(mTail, Index(MIDI_RING_LOAD_ACQUIRE(mHead)));
+    }
+
+private:
+    static const Index sMask = Capacity - 1;
+
+    T mData[Capacity];
+    volatile Index mHead; // Written by the producer only
+    volatile Index mTail; // Written by the consumer only
+};
+
+template<unsigned Capacity>
+using SpscByteRing = SpscRing<byte, Capacity>;
+
+// -----------------------------------------------------------------------------
+
+/*! Ring slots of RingSerialMIDI: plain bytes, or bytes with the time at which
+ the producer received them (see DefaultSettings::UseTimestamps).
+ */
+template<bool Timestamps>
+class RingTimestamps
+{
+protected:
+    typedef byte Slot;
+
+    static inline Slot makeSlot(byte inData, unsigned long) { return inData; }
+    inline byte unpackSlot(Slot inSlot) { return inSlot; }
+};
+
+template<>
+class RingTimestamps<true>
+{
+public:
+    inline RingTimestamps()
+        : mLastTimestamp(0)
+    {
+    }
+
+    /*! Time at which the byte last returned by read() was pushed. */
+    inline unsigned long readTimestamp() const
+    {
+        return mLastTimestamp;
+    }
+
+protected:
+    struct Slot
+    {
+        byte data;
+        unsigned long time;
+    };
+
+    static inline Slot makeSlot(byte inData, unsigned long inTime)
+    {
+        Slot slot;
+        slot.data = inData;
+        slot.time = inTime;
+        return slot;
+    }
+
+    inline byte unpackSlot(const Slot& inSlot)
+    {
+        mLastTimestamp = inSlot.time;
+        return inSlot.data;
+    }
+
+private:
+    unsigned long mLastTimestamp;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Serial transport that receives through a SpscRing.
+
+ The bytes are fed by another context, either one at a time with push()
+ (eg: from a UART RX interrupt), or by calling pump() on the other core to
+ move what the serial port has received. MidiInterface reads from the ring,
+ transmission goes straight to the serial port.
+
+ With Timestamps enabled, push() also takes the time of reception, and
+ MidiInterface uses it for Message::timestamp rather than sampling the clock
+ when it gets to parse the byte.
+
+ The high-water mark is the largest number of bytes seen waiting in the ring,
+ use it to size Capacity from real traffic. Eg:
+ \code{.cpp}
+ typedef midi::RingSerialMIDI<HardwareSerial, 64> Transport;
+ Transport transport(Serial1);
+ midi::MidiInterface<Transport> midi(transport);
+
+ ISR(USART1_RX_vect) { transport.push(UDR1); }
+ \endcode
+ */
+template <class SerialPort,
+          unsigned Capacity = 64,
+          class _Settings = DefaultSerialSettings,
+          bool Timestamps = false>
+class RingSerialMIDI : public SerialMIDI<SerialPort, _Settings>
+                     , public RingTimestamps<Timestamps>
+{
+    typedef SerialMIDI<SerialPort, _Settings> Base;
+    typedef RingTimestamps<Timestamps> Stamps;
+    typedef typename Stamps::Slot Slot;
+
+public:
+    inline RingSerialMIDI(SerialPort& inSerial)
+        : Base(inSerial)
+        , mHighWaterMark(0)
+        , mOverflowCount(0)
+    {
+    }
+
+public: // Producer side
+    /*! \brief Store a received byte, safe to call from an ISR.
+     \param inTime Time of reception, ignored without Timestamps.
+     \return false if the ring was full and the byte was dropped.
+     */
+    inline bool push(byte inData, unsigned long inTime = 0)
+    {
+        if (mRing.push(Stamps::makeSlot(inData, inTime)))
+            return true;
+
+        mOverflowCount++;
+        return false;
+    }
+
+    /*! \brief Move the bytes received by the serial port into the ring.
+     \param inTime Time of reception, ignored without Timestamps.
+     \return The number of bytes moved.
+     */
+    inline unsigned pump(unsigned long inTime = 0)
+    {
+        unsigned count = 0;
+        while (this->mSerial.available() > 0)
+        {
+            push(byte(this->mSerial.read()), inTime);
+            count++;
+        }
+        return count;
+    }
+
+    /*! Bytes dropped because the ring was full (written by the producer). */
+    inline unsigned getOverflowCount() const
+    {
+#if defined(__AVR__)
+        unsigned count;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) // Not a single byte
+        {
+            count = mOverflowCount;
+        }
+        return count;
+#else
+        return mOverflowCount;
+#endif
+    }
+
+public: // Consumer side, used by MidiInterface
+    inline byte read()
+    {
+        updateHighWaterMark(mRing.available());
+        return Stamps::unpackSlot(mRing.pop());
+    }
+
+    inline unsigned available()
+    {
+        const unsigned count = mRing.available();
+        updateHighWaterMark(count);
+        return count;
+    }
+
+    inline unsigned getHighWaterMark() const
+    {
+        return mHighWaterMark;
+    }
+
+    inline void resetHighWaterMark()
+    {
+        mHighWaterMark = 0;
+    }
+
+private:
+    inline void updateHighWaterMark(unsigned inCount)
+    {
+        // The ring only empties on read, so sampling here catches every peak.
+        if (inCount > mHighWaterMark)
+            mHighWaterMark = inCount;
+    }
+
+private:
+    SpscRing<Slot, Capacity> mRing;
+    unsigned mHighWaterMark;
+    volatile unsigned mOverflowCount;
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,340 @@
+/*!
+ *  @file       midi_Router.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - N-port merger / splitter
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Message.h"
+#include "midi_TxQueue.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Routes the messages of N MIDI interfaces to each other (merge / split).
+
+ Each (input, output) pair of ports has a route, with a mask of channels and
+ a mask of message types to forward (see getTypeBit). Every call to service()
+ reads at most the byte budget of each port, starting from a different port
+ each time, so a chatty input cannot starve the others and the latency of
+ each port is bounded by the sum of the budgets.
+
+ Routed channel & system common messages are stored in per-output queues and
+ sent at the end of service(). Real-time messages are sent straight away.
+ While an output carries a SysEx frame, the messages other inputs route to
+ it wait in its queue until the frame ends (their Real-Time messages still
+ go right away), so merged streams never interleave partial messages. A SysEx
+ frame from another input is dropped meanwhile. If the frame does not go on
+ within the SysEx timeout (eg: the sender was unplugged), the output is
+ released and its queue sent, which aborts the frame on the receiver.
+
+ The interfaces must use byte-per-byte parsing (the default, see
+ DefaultSettings::Use1ByteParsing) for the budget to hold, and usually have
+ their own Thru turned off. Eg:
+ \code{.cpp}
+ midi::MidiInterface<Transport>* ports[2] = { &midiA, &midiB };
+ midi::MidiRouter<midi::MidiInterface<Transport>, 2> router(ports);
+
+ router.setRoute(0, 1);                  // Merge A in into B out
+ router.setRoute(1, 0, 0x0001);          // Channel 1 only from B in to A out
+ // ...
+ router.service();                       // In loop()
+ \endcode
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize = 16>
+class MidiRouter
+{
+public:
+    static_assert(NumPorts > 0 && NumPorts < 255, "Invalid number of ports");
+    static_assert(Interface::Settings::Use1ByteParsing,
+                  "MidiRouter needs Use1ByteParsing to bound the bytes read per port");
+
+    typedef typename Interface::MidiMessage MidiMessage;
+
+    static const uint32_t AllTypes    = 0xffffffff;
+    static const uint16_t AllChannels = 0xffff;
+
+    inline explicit MidiRouter(Interface* const inPorts[NumPorts]);
+
+public:
+    inline void setRoute(unsigned inInput,
+                         unsigned inOutput,
+                         uint16_t inChannelMask = AllChannels,
+                         uint32_t inTypeMask = AllTypes);
+    inline void clearRoute(unsigned inInput, unsigned inOutput);
+    inline void setByteBudget(unsigned inPort, byte inBudget);
+    inline void setSysExTimeout(uint16_t inTimeout);
+
+    unsigned service();
+
+    inline unsigned getDroppedCount() const;
+
+private:
+    struct Route
+    {
+        uint16_t channels;
+        uint32_t types;
+    };
+
+    inline void expireOwners();
+    inline unsigned route(unsigned inInput);
+    inline void releaseOutputs(unsigned inInput);
+    inline void drainQueue(unsigned inOutput);
+
+private:
+    static const byte sNoOwner = 0xff;
+
+    Interface*          mPorts[NumPorts];
+    Route               mRoutes[NumPorts][NumPorts];
+    byte                mBudgets[NumPorts];
+    byte                mOutputOwners[NumPorts];
+    unsigned long       mOwnerTimes[NumPorts];
+    TxQueue<QueueSize>  mQueues[NumPorts];
+    byte                mFirstInput;
+    unsigned            mDroppedCount;
+    uint16_t            mSysExTimeout;
+    unsigned long       mTime;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Create a router with no route between the ports.
+ \param inPorts The interfaces to route, they must outlive the router.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline MidiRouter<Interface, NumPorts, QueueSize>::MidiRouter(Interface* const inPorts[NumPorts])
+    : mFirstInput(0)
+    , mDroppedCount(0)
+    , mSysExTimeout(1000)
+    , mTime(0)
+{
+    for (unsigned i = 0; i < NumPorts; ++i)
+    {
+        mPorts[i]        = inPorts[i];
+        mBudgets[i]      = 16;
+        mOutputOwners[i] = sNoOwner;
+        mOwnerTimes[i]   = 0;
+
+        for (unsigned j = 0; j < NumPorts; ++j)
+            clearRoute(i, j);
+    }
+}
+
+/*! \brief Forward messages from an input port to an output port.
+ \param inChannelMask Channels to forward, bit 0 is channel 1.
+ \param inTypeMask    Message types to forward, @see getTypeBit.
+ A port can be routed to itself, to replace its Thru.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::setRoute(unsigned inInput,
+                                                                 unsigned inOutput,
+                                                                 uint16_t inChannelMask,
+                                                                 uint32_t inTypeMask)
+{
+    mRoutes[inInput][inOutput].channels = inChannelMask;
+    mRoutes[inInput][inOutput].types    = inTypeMask;
+}
+
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::clearRoute(unsigned inInput,
+                                                                   unsigned inOutput)
+{
+    setRoute(inInput, inOutput, 0, 0);
+}
+
+/*! \brief Set the maximum number of bytes read from a port per call to service().
+ Defaults to 16, 0 mutes the port.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::setByteBudget(unsigned inPort,
+                                                                      byte inBudget)
+{
+    mBudgets[inPort] = inBudget;
+}
+
+/*! \brief Set how long (in ms) an output waits for the next chunk of a SysEx
+ frame before it is released. Defaults to 1000.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::setSysExTimeout(uint16_t inTimeout)
+{
+    mSysExTimeout = inTimeout;
+}
+
+/*! \brief Number of messages dropped because an output queue was full, or
+ SysEx chunks dropped because the output carried another frame.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline unsigned MidiRouter<Interface, NumPorts, QueueSize>::getDroppedCount() const
+{
+    return mDroppedCount;
+}
+
+/*! \brief Read the input ports and forward their messages.
+ Call it as often as possible, eg: in loop().
+ \return The number of messages read from the inputs.
+ */
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+unsigned MidiRouter<Interface, NumPorts, QueueSize>::service()
+{
+    unsigned count = 0;
+
+    mTime = Interface::Platform::now();
+    expireOwners();
+
+    for (unsigned n = 0; n < NumPorts; ++n)
+    {
+        const unsigned input = (mFirstInput + n) % NumPorts;
+        Interface& port = *mPorts[input];
+
+        // One byte per read with Use1ByteParsing
+        for (byte budget = mBudgets[input];
+             budget != 0 && port.getTransport()->available() > 0;
+             --budget)
+        {
+            if (port.read(MIDI_CHANNEL_OMNI))
+            {
+                route(input);
+                count++;
+            }
+        }
+    }
+
+    // Next time, another port goes first.
+    mFirstInput = byte((mFirstInput + 1) % NumPorts);
+
+    for (unsigned output = 0; output < NumPorts; ++output)
+    {
+        if (mOutputOwners[output] == sNoOwner)
+            drainQueue(output);
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+// Private method: release the outputs whose SysEx frame did not go on in time.
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::expireOwners()
+{
+    for (unsigned output = 0; output < NumPorts; ++output)
+    {
+        if (mOutputOwners[output] != sNoOwner && mTime - mOwnerTimes[output] >= mSysExTimeout)
+            mOutputOwners[output] = sNoOwner;
+    }
+}
+
+// Private method: forward the last message read on an input.
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline unsigned MidiRouter<Interface, NumPorts, QueueSize>::route(unsigned inInput)
+{
+    const Interface& port = *mPorts[inInput];
+    const MidiType type = port.getType();
+    const byte info = getStatusInfo(type);
+    const Channel channel = (info & StatusInfo::ChannelMessage) ? port.getChannel() : Channel(0);
+    const uint32_t typeBit = getTypeBit(type);
+
+    if (!(info & StatusInfo::RealTime) && type != SystemExclusive)
+        releaseOutputs(inInput); // Aborted SysEx frame
+
+    unsigned count = 0;
+    for (unsigned output = 0; output < NumPorts; ++output)
+    {
+        const Route& route = mRoutes[inInput][output];
+        if (!(route.types & typeBit))
+            continue;
+        if (channel != 0 && !(route.channels & (1u << (channel - 1))))
+            continue;
+
+        Interface& target = *mPorts[output];
+
+        if (info & StatusInfo::RealTime)
+        {
+            // Allowed anywhere, even in the middle of a SysEx frame.
+            target.sendRealTime(type);
+        }
+        else if (type == SystemExclusive)
+        {
+            const byte* data = port.getSysExArray();
+            const unsigned length = port.getSysExArrayLength();
+
+            // Messages queued before the frame go first.
+            if (data[0] == SystemExclusiveStart && mOutputOwners[output] == sNoOwner)
+            {
+                drainQueue(output);
+                mOutputOwners[output] = byte(inInput);
+            }
+            if (mOutputOwners[output] != inInput)
+            {
+                // Output busy with another frame, or this one timed out.
+                mDroppedCount++;
+                continue;
+            }
+
+            mOwnerTimes[output] = mTime;
+            if (data[length - 1] == SystemExclusiveEnd)
+                mOutputOwners[output] = sNoOwner;
+
+            target.sendSysEx(length, data, true);
+        }
+        else
+        {
+            const StatusByte status = channel != 0 ? StatusByte(type | (channel - 1))
+                                                   : StatusByte(type);
+            if (!mQueues[output].push(status, port.getData1(), port.getData2()))
+                mDroppedCount++;
+        }
+        count++;
+    }
+    return count;
+}
+
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::releaseOutputs(unsigned inInput)
+{
+    for (unsigned output = 0; output < NumPorts; ++output)
+    {
+        if (mOutputOwners[output] == inInput)
+            mOutputOwners[output] = sNoOwner;
+    }
+}
+
+template<class Interface, unsigned NumPorts, unsigned QueueSize>
+inline void MidiRouter<Interface, NumPorts, QueueSize>::drainQueue(unsigned inOutput)
+{
+    TxQueue<QueueSize>& queue = mQueues[inOutput];
+    Interface& target = *mPorts[inOutput];
+
+    while (!queue.isEmpty())
+    {
+        // Sent in its packed form, with the running status of the target.
+        const byte* slot = queue.front();
+        const byte info  = getStatusInfo(slot[0]);
+
+        target.send(PackedMessage(slot[0], slot[1], slot[2], info & StatusInfo::LengthMask));
+        queue.pop();
+    }
+}
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,591 @@
+/*!
+ *  @file       midi_RtpTransport.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - RTP-MIDI datagram transport
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Platform.h"
+
+BEGIN_MIDI_NAMESPACE
+
+struct DefaultRtpSettings
+{
+    /*! Largest datagram sent, RTP header included.\n
+    Keep it under the path MTU (1472 bytes of UDP payload on Ethernet).
+    */
+    static const unsigned PacketSize = 256;
+
+    /*! How long (in us) a packet waits for more commands before it is sent.\n
+    A full packet is sent right away. Set to 0 to send each message on its own.
+    */
+    static const unsigned long FlushLatency = 1000;
+
+    /*! Duration (in us) of an RTP timestamp tick, 100 for the 10 kHz clock of AppleMIDI. */
+    static const unsigned long TickPeriod = 100;
+
+    /*! RTP payload type, from the dynamic range. */
+    static const byte PayloadType = 97;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Zero-copy reader of the MIDI list of an RTP-MIDI packet (RFC 6295).
+
+ Commands are returned as views into the datagram, with the running status
+ left as is (the status byte is then omitted) and their delta time in ticks.
+ The recovery journal, if any, is ignored.
+ */
+class RtpMidiList
+{
+public:
+    static const unsigned HeaderSize = 12;
+
+    inline RtpMidiList()
+        : mPosition(nullptr)
+        , mEnd(nullptr)
+        , mTimestamp(0)
+        , mSequenceNumber(0)
+        , mHasFirstDelta(false)
+        , mRunningStatus(0)
+    {
+    }
+
+    /*! \brief Parse the RTP and command section headers of a datagram.
+     \return false if it is not an RTP-MIDI packet.
+     */
+    inline bool open(const byte* inPacket, unsigned inSize)
+    {
+        mPosition = mEnd = nullptr;
+        if (inPacket == nullptr || inSize <= HeaderSize || (inPacket[0] >> 6) != 2)
+            return false;
+
+        unsigned offset = HeaderSize + 4 * (inPacket[0] & 0x0f);
+        if ((inPacket[0] & 0x10) && offset + 4 <= inSize)
+            offset += 4 + 4 * (unsigned(inPacket[offset + 2]) << 8 | inPacket[offset + 3]);
+        if (offset >= inSize)
+            return false;
+
+        const byte header = inPacket[offset];
+        unsigned length = header & 0x0f;
+        if (header & 0x80)
+        {
+            if (offset + 1 >= inSize)
+                return false;
+            length = length << 8 | inPacket[offset + 1];
+            offset++;
+        }
+        offset++;
+        if (length > inSize - offset)
+            length = inSize - offset;
+
+        mSequenceNumber = uint16_t(inPacket[2] << 8 | inPacket[3]);
+        mTimestamp      = uint32_t(inPacket[4]) << 24 | uint32_t(inPacket[5]) << 16
+                        | uint32_t(inPacket[6]) << 8  | inPacket[7];
+        mHasFirstDelta  = header & 0x20;
+        mRunningStatus  = 0;
+        mPosition       = inPacket + offset;
+        mEnd            = mPosition + length;
+        return true;
+    }
+
+    /*! \brief Get the next command of the list.
+     \param outDelta  Ticks since the previous command (the packet timestamp for the first one).
+     \param outData   Points into the datagram, starts with a data byte with running status.
+     \param outLength Bytes in outData.
+     \return false at the end of the list.
+     */
+    inline bool next(unsigned long& outDelta, const byte*& outData, unsigned& outLength)
+    {
+        if (mPosition >= mEnd)
+            return false;
+
+        outDelta = 0;
+        if (mHasFirstDelta)
+        {
+            for (unsigned i = 0; i < 4 && mPosition < mEnd; ++i)
+            {
+                const byte octet = *mPosition++;
+                outDelta = outDelta << 7 | (octet & 0x7f);
+                if (!(octet & 0x80))
+                    break;
+            }
+            if (mPosition >= mEnd)
+                return false;
+        }
+        mHasFirstDelta = true;
+
+        const byte first = *mPosition;
+        unsigned length = 1;
+        if (first == SystemExclusiveStart || first == SystemExclusiveEnd)
+        {
+            // Until the end of the (segment of) SysEx, F7, or F0 if it continues.
+            while (mPosition + length < mEnd)
+            {
+                const byte octet = mPosition[length++];
+                if (octet == SystemExclusiveEnd || octet == SystemExclusiveStart)
+                    break;
+            }
+            mRunningStatus = 0;
+        }
+        else if (first & 0x80)
+        {
+            const byte info = getStatusInfo(first);
+            if (info & StatusInfo::LengthMask)
+                length = info & StatusInfo::LengthMask;
+            if (!(info & StatusInfo::RealTime))
+                mRunningStatus = (info & StatusInfo::RunningStatus) ? first : 0;
+        }
+        else
+        {
+            if (mRunningStatus == 0)
+            {
+                // No status to apply, the rest of the list can't be parsed.
+                mPosition = mEnd;
+                return false;
+            }
+            length = (getStatusInfo(mRunningStatus) & StatusInfo::LengthMask) - 1u;
+        }
+
+        if (length > unsigned(mEnd - mPosition))
+            length = unsigned(mEnd - mPosition);
+        outData   = mPosition;
+        outLength = length;
+        mPosition += length;
+        return true;
+    }
+
+    inline unsigned long getTimestamp() const
+    {
+        return mTimestamp;
+    }
+
+    inline uint16_t getSequenceNumber() const
+    {
+        return mSequenceNumber;
+    }
+
+private:
+    const byte*     mPosition;
+    const byte*     mEnd;
+    unsigned long   mTimestamp;
+    uint16_t        mSequenceNumber;
+    bool            mHasFirstDelta;
+    StatusByte      mRunningStatus;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Datagram transport, packing several messages per RTP-MIDI packet.
+
+ The Socket adapts the network stack (eg: WiFiUDP, EthernetUDP):
+ \code{.cpp}
+ struct Socket
+ {
+     void begin();
+     // Send a datagram to the peer, false if it could not be sent now.
+     bool send(const byte* inPacket, unsigned inSize);
+     // Next received datagram (nullptr if none), valid until the next call.
+     const byte* receive(unsigned& outSize);
+ };
+ \endcode
+
+ Outgoing commands are appended to the MIDI list of the current packet, each
+ with its delta time, and with running status within the packet. The packet
+ is sent when the next command would not fit, or FlushLatency us after its
+ first command. The deadline is checked by service(), which
+ MidiInterface::flush() and read() call: an application that only sends
+ must call flush() in its loop. SysEx larger than a packet is sent in
+ segments (F0..F0, F7..F0, F7..F7).
+
+ Received commands are read straight from the datagram given by the Socket,
+ without copy. Only the RTP-MIDI payload is handled: sessions (eg: AppleMIDI
+ invitations & clock sync) are left to the application.
+ */
+template<class Socket,
+         class _Settings = DefaultRtpSettings,
+         class Platform = DefaultPlatform>
+class RtpMIDI
+{
+    typedef _Settings Settings;
+
+public:
+    static const unsigned HeaderSize = RtpMidiList::HeaderSize + 2;
+
+    static_assert(Settings::PacketSize >= HeaderSize + 8 && Settings::PacketSize <= HeaderSize + 0x0fff,
+                  "PacketSize is out of the RTP-MIDI command section range");
+
+    inline RtpMIDI(Socket& inSocket, uint32_t inSsrc = 0)
+        : mSocket(inSocket)
+        , mSsrc(inSsrc)
+        , mSequenceNumber(0)
+        , mTxSize(HeaderSize)
+        , mTxDeadline(0)
+        , mTxFirstTime(0)
+        , mTxTime(0)
+        , mTxListStatus(0)
+        , mTxStatus(0)
+        , mTxIndex(0)
+        , mTxLength(0)
+        , mTxSysEx(false)
+        , mRxData(nullptr)
+        , mRxLength(0)
+        , mDroppedCommands(0)
+    {
+    }
+
+public:
+    inline void begin()
+    {
+        mSocket.begin();
+        mTxSize   = HeaderSize;
+        mTxStatus = 0;
+        mTxIndex  = 0;
+        mTxSysEx  = false;
+        mRxLength = 0;
+    }
+
+    inline bool beginTransmission(MidiType)
+    {
+        return true;
+    }
+
+    inline void write(byte inByte)
+    {
+        encode(inByte);
+    }
+
+    inline void write(const byte* inData, size_t inSize)
+    {
+        for (size_t i = 0; i < inSize; ++i)
+            encode(inData[i]);
+    }
+
+    inline void endTransmission()
+    {
+        if (Settings::FlushLatency == 0 && !mTxSysEx)
+            flush();
+    }
+
+    inline byte read()
+    {
+        mRxLength--;
+        return *mRxData++;
+    }
+
+    inline unsigned available()
+    {
+        service();
+
+        while (mRxLength == 0 && nextCommand())
+        {
+        }
+        return mRxLength;
+    }
+
+    /*! Bytes of MIDI that surely fit in the current packet. */
+    inline int availableForWrite() const
+    {
+        const int room = int(Settings::PacketSize - mTxSize) - 4;
+        return room > 0 ? room : 0;
+    }
+
+public:
+    /*! \brief Send the pending commands now.
+     \return false if the socket could not send, they are then kept for later.
+     */
+    inline bool flush()
+    {
+        if (!isPending())
+            return true;
+
+        // A SysEx being written goes on in the next packet (a byte is kept for this).
+        const bool segmented = mTxSysEx;
+        if (segmented)
+            mTxPacket[mTxSize++] = SystemExclusiveStart;
+
+        byte* packet = mTxPacket;
+        const unsigned length = mTxSize - HeaderSize;
+        const unsigned long timestamp = mTxFirstTime;
+        packet[0]  = 0x80;                          // Version 2
+        packet[1]  = 0x80 | Settings::PayloadType;  // Marker: the command section is not empty
+        packet[2]  = byte(mSequenceNumber >> 8);
+        packet[3]  = byte(mSequenceNumber);
+        packet[4]  = byte(timestamp >> 24);
+        packet[5]  = byte(timestamp >> 16);
+        packet[6]  = byte(timestamp >> 8);
+        packet[7]  = byte(timestamp);
+        packet[8]  = byte(mSsrc >> 24);
+        packet[9]  = byte(mSsrc >> 16);
+        packet[10] = byte(mSsrc >> 8);
+        packet[11] = byte(mSsrc);
+        packet[12] = byte(0x80 | (length >> 8));    // Long header, no journal, no first delta
+        packet[13] = byte(length);
+
+        if (!mSocket.send(packet, mTxSize))
+        {
+            if (segmented)
+                mTxSize--;
+            return false;
+        }
+
+        mSequenceNumber++;
+        mTxSize = HeaderSize;
+        mTxListStatus = 0;
+        if (segmented)
+        {
+            appendDelta();
+            mTxPacket[mTxSize++] = SystemExclusiveEnd;
+        }
+        return true;
+    }
+
+    /*! Send the pending commands if FlushLatency has passed since the first one. */
+    inline void service()
+    {
+        if (isPending() && long(Platform::nowMicros() - mTxDeadline) >= 0)
+            flush();
+    }
+
+    /*! Commands lost because the packet was full and could not be sent. */
+    inline unsigned getDroppedCommands() const
+    {
+        return mDroppedCommands;
+    }
+
+    inline void setSsrc(uint32_t inSsrc)
+    {
+        mSsrc = inSsrc;
+    }
+
+private:
+    inline bool isPending() const
+    {
+        return mTxSize > HeaderSize;
+    }
+
+    inline unsigned long getTicks() const
+    {
+        return Platform::nowMicros() / Settings::TickPeriod;
+    }
+
+    inline void encode(byte inByte)
+    {
+        const byte info = getStatusInfo(inByte);
+
+        if (info & StatusInfo::Ignored)
+            return;
+
+        if (mTxSysEx && (inByte < 0x80 || (info & StatusInfo::RealTime)))
+        {
+            // RFC 6295 allows real-time commands within SysEx.
+            appendSysEx(inByte);
+            return;
+        }
+        if (info & StatusInfo::RealTime)
+        {
+            appendCommand(&inByte, 1);
+            return;
+        }
+        if (inByte == SystemExclusiveEnd)
+        {
+            if (mTxSysEx)
+            {
+                appendSysEx(inByte);
+                mTxSysEx = false;
+            }
+            return;
+        }
+
+        if (inByte & 0x80)
+        {
+            if (mTxSysEx)
+            {
+                // Any other status aborts the SysEx, close it to keep the list valid.
+                appendSysEx(SystemExclusiveEnd);
+                mTxSysEx = false;
+            }
+            if (inByte == SystemExclusiveStart)
+            {
+                beginSysEx();
+                return;
+            }
+            mTxStatus = (info & StatusInfo::RunningStatus) ? inByte : 0;
+            mTxLength = info & StatusInfo::LengthMask;
+            mTxBytes[0] = inByte;
+            mTxIndex = 1;
+            if (mTxLength == 1)
+                completeMessage();
+            else if (mTxLength == 0)
+                mTxIndex = 0; // Undefined status, its data is dropped
+            return;
+        }
+
+        if (mTxIndex == 0)
+        {
+            // Running status of the sender, the packet has its own one.
+            if (mTxStatus == 0)
+                return;
+            mTxBytes[0] = mTxStatus;
+            mTxLength = getStatusInfo(mTxStatus) & StatusInfo::LengthMask;
+            mTxIndex = 1;
+        }
+        mTxBytes[mTxIndex++] = inByte;
+        if (mTxIndex == mTxLength)
+            completeMessage();
+    }
+
+    inline void completeMessage()
+    {
+        appendCommand(mTxBytes, mTxLength);
+        mTxIndex = 0;
+    }
+
+    /*! Room for the delta time, and the first status or segment byte. */
+    inline bool makeRoom(unsigned inSize)
+    {
+        if (mTxSize + 4 + inSize <= Settings::PacketSize || flush())
+            return true;
+
+        mDroppedCommands++;
+        return false;
+    }
+
+    inline void appendDelta()
+    {
+        const unsigned long now = getTicks();
+        if (!isPending())
+        {
+            // The first command is timed by the packet timestamp.
+            mTxFirstTime = now;
+            mTxTime = now;
+            mTxDeadline = Platform::nowMicros() + Settings::FlushLatency;
+            return;
+        }
+
+        unsigned long delta = now - mTxTime;
+        if (delta > 0x0fffffff)
+            delta = 0x0fffffff;
+        mTxTime = now;
+
+        byte* out = mTxPacket + mTxSize;
+        if (delta >= 1ul << 21) *out++ = byte(0x80 | ((delta >> 21) & 0x7f));
+        if (delta >= 1ul << 14) *out++ = byte(0x80 | ((delta >> 14) & 0x7f));
+        if (delta >= 1ul << 7)  *out++ = byte(0x80 | ((delta >> 7)  & 0x7f));
+        *out++ = byte(delta & 0x7f);
+        mTxSize = unsigned(out - mTxPacket);
+    }
+
+    inline void appendCommand(const byte* inData, byte inLength)
+    {
+        if (!makeRoom(inLength))
+            return;
+
+        const StatusByte status = inData[0];
+        appendDelta();
+        for (byte i = status == mTxListStatus ? 1 : 0; i < inLength; ++i)
+            mTxPacket[mTxSize++] = inData[i];
+
+        const byte info = getStatusInfo(status);
+        if (!(info & StatusInfo::RealTime))
+            mTxListStatus = (info & StatusInfo::RunningStatus) ? status : 0;
+    }
+
+    inline void beginSysEx()
+    {
+        mTxStatus = 0;
+        mTxIndex  = 0;
+        mTxSysEx  = makeRoom(2);
+        if (!mTxSysEx)
+            return;
+
+        appendDelta();
+        mTxPacket[mTxSize++] = SystemExclusiveStart;
+        mTxListStatus = 0;
+    }
+
+    inline void appendSysEx(byte inByte)
+    {
+        // One byte is kept to close the segment.
+        if (inByte != SystemExclusiveEnd && mTxSize + 2 > Settings::PacketSize && !flush())
+        {
+            mDroppedCommands++;
+            return;
+        }
+        mTxPacket[mTxSize++] = inByte;
+    }
+
+    inline bool nextCommand()
+    {
+        unsigned long delta;
+        const byte* data;
+        unsigned length;
+        while (!mRxList.next(delta, data, length))
+        {
+            unsigned size = 0;
+            const byte* packet = mSocket.receive(size);
+            if (packet == nullptr)
+                return false;
+            mRxList.open(packet, size);
+        }
+
+        // SysEx segments: drop the markers that are not part of the MIDI stream.
+        if (length > 1 && data[0] == SystemExclusiveEnd)
+        {
+            data++;
+            length--;
+        }
+        if (length > 1 && data[length - 1] == SystemExclusiveStart)
+            length--;
+        else if (length == 1 && data[0] == SystemExclusiveEnd)
+            length = 0; // Lone segment marker (cancelled SysEx)
+
+        mRxData = data;
+        mRxLength = length;
+        return true;
+    }
+
+private:
+    Socket&         mSocket;
+    uint32_t        mSsrc;
+    uint16_t        mSequenceNumber;
+    byte            mTxPacket[Settings::PacketSize];
+    unsigned        mTxSize;
+    unsigned long   mTxDeadline;
+    unsigned long   mTxFirstTime;
+    unsigned long   mTxTime;
+    StatusByte      mTxListStatus;
+    byte            mTxBytes[3];
+    StatusByte      mTxStatus;
+    byte            mTxIndex;
+    byte            mTxLength;
+    bool            mTxSysEx;
+    RtpMidiList     mRxList;
+    const byte*     mRxData;
+    unsigned        mRxLength;
+    unsigned        mDroppedCommands;
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,118 @@
+/*!
+ *  @file       midi_RunningStatus.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Output running status
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Refresh policy and counters of the output running status.
+
+ See DefaultSettings::UseRunningStatus, RunningStatusRefreshCount and
+ RunningStatusRefreshPeriod. The status byte is forced after RefreshCount
+ messages (status included) or RefreshPeriod ms without one, so that a
+ receiver connected mid-stream can synchronise. Zero disables either rule.
+ */
+template<bool Enabled, uint16_t RefreshCount, uint16_t RefreshPeriod>
+class RunningStatusTx
+{
+public:
+    inline RunningStatusTx()
+        : mStatus(InvalidType)
+        , mNumMessages(0)
+        , mDeadline(0)
+        , mStatusBytesSent(0)
+        , mStatusBytesSaved(0)
+    {
+    }
+
+    /*! Tell whether inStatus can be left out, remember it as the new one otherwise. */
+    inline bool omit(StatusByte inStatus, unsigned long inTime)
+    {
+        if (mStatus == inStatus && !isRefreshDue(inTime))
+        {
+            statusSaved();
+            return true;
+        }
+        mStatus = inStatus;
+        statusSent(inTime);
+        return false;
+    }
+
+    /*! Something else was written, the next status byte must be sent. */
+    inline void cancel()
+    {
+        mStatus = InvalidType;
+    }
+
+    inline bool isRefreshDue(unsigned long inTime) const
+    {
+        return (RefreshCount > 0 && mNumMessages >= RefreshCount)
+            || (RefreshPeriod > 0 && long(inTime - mDeadline) >= 0);
+    }
+
+    /*! The status byte was written. */
+    inline void statusSent(unsigned long inTime)
+    {
+        mNumMessages = 1;
+        mDeadline = inTime + RefreshPeriod;
+        mStatusBytesSent++;
+    }
+
+    /*! The status byte was left out. */
+    inline void statusSaved()
+    {
+        mNumMessages++;
+        mStatusBytesSaved++;
+    }
+
+    inline unsigned long getStatusBytesSent() const  { return mStatusBytesSent; }
+    inline unsigned long getStatusBytesSaved() const { return mStatusBytesSaved; }
+
+private:
+    StatusByte      mStatus;
+    uint16_t        mNumMessages;
+    unsigned long   mDeadline;
+    unsigned long   mStatusBytesSent;
+    unsigned long   mStatusBytesSaved;
+};
+
+/*! Running status disabled: every status byte is sent, nothing to count. */
+template<uint16_t RefreshCount, uint16_t RefreshPeriod>
+class RunningStatusTx<false, RefreshCount, RefreshPeriod>
+{
+public:
+    inline bool omit(StatusByte, unsigned long) { return false; }
+    inline void cancel() {}
+    inline bool isRefreshDue(unsigned long) const { return true; }
+    inline void statusSent(unsigned long) {}
+    inline void statusSaved() {}
+    inline unsigned long getStatusBytesSent() const  { return 0; }
+    inline unsigned long getStatusBytesSaved() const { return 0; }
+};
+
+END_MIDI_NAMESPACE
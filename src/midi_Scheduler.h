@@ -0,0 +1,213 @@
+/*!
+ *  @file       midi_Scheduler.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Timestamped output scheduler
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Messages waiting for their time, see DefaultSettings::ScheduledMessages.
+
+ Real Time messages and the others are kept in two binary heaps sharing the
+ same Size slots (one grows from each end), ordered by time (in us,
+ wrap-around safe). The scheduler also estimates when the bytes already
+ written to the transport are done: each byte keeps the line busy for
+ ByteTime us (10 bits at BaudRate), 0 if the transport has no line rate.
+ */
+template<unsigned Size, unsigned long BaudRate>
+class OutputScheduler
+{
+public:
+    static_assert(Size < 255, "ScheduledMessages must be smaller than 255");
+
+    static const unsigned long ByteTime = BaudRate != 0 ? 10000000ul / BaudRate : 0;
+
+    struct Entry
+    {
+        unsigned long   time;
+        byte            message[3];
+    };
+
+    inline OutputScheduler()
+        : mNumRealTime(0)
+        , mNumOthers(0)
+        , mLineFree(0)
+    {
+    }
+
+    inline bool isEmpty() const
+    {
+        return mNumRealTime == 0 && mNumOthers == 0;
+    }
+
+    /*! Returns false (and drops the message) if all the slots are used. */
+    inline bool push(unsigned long inTime, StatusByte inStatus, DataByte inData1, DataByte inData2)
+    {
+        if (mNumRealTime + mNumOthers >= Size)
+            return false;
+
+        const bool realTime = getStatusInfo(inStatus) & StatusInfo::RealTime;
+        byte& count = realTime ? mNumRealTime : mNumOthers;
+
+        Entry& entry     = at(realTime, count);
+        entry.time       = inTime;
+        entry.message[0] = inStatus;
+        entry.message[1] = inData1;
+        entry.message[2] = inData2;
+        siftUp(realTime, count++);
+        return true;
+    }
+
+    /*! Earliest Real Time message (real-time) or other message, if any. */
+    inline const Entry* top(bool inRealTime) const
+    {
+        const byte count = inRealTime ? mNumRealTime : mNumOthers;
+        return count != 0 ? &at(inRealTime, 0) : nullptr;
+    }
+
+    inline void pop(bool inRealTime)
+    {
+        byte& count = inRealTime ? mNumRealTime : mNumOthers;
+        at(inRealTime, 0) = at(inRealTime, --count);
+        siftDown(inRealTime, 0);
+    }
+
+    inline void clear()
+    {
+        mNumRealTime = 0;
+        mNumOthers   = 0;
+    }
+
+    /*! When a byte written at inNow starts on the line. */
+    inline unsigned long getLineFree(unsigned long inNow) const
+    {
+        return long(mLineFree - inNow) > 0 ? mLineFree : inNow;
+    }
+
+    /*! inSize bytes were written to the transport at inNow. */
+    inline void occupyLine(unsigned long inNow, size_t inSize)
+    {
+        if (ByteTime != 0)
+            mLineFree = getLineFree(inNow) + (unsigned long)inSize * ByteTime;
+    }
+
+    static inline bool isDue(const Entry& inEntry, unsigned long inTime)
+    {
+        return long(inEntry.time - inTime) <= 0;
+    }
+
+private:
+    // Real Time messages are stored from the end of the slots.
+    inline Entry& at(bool inRealTime, byte inIndex)
+    {
+        return mEntries[inRealTime ? Size - 1 - inIndex : inIndex];
+    }
+
+    inline const Entry& at(bool inRealTime, byte inIndex) const
+    {
+        return mEntries[inRealTime ? Size - 1 - inIndex : inIndex];
+    }
+
+    static inline bool isBefore(const Entry& inA, const Entry& inB)
+    {
+        return long(inA.time - inB.time) < 0;
+    }
+
+    inline void siftUp(bool inRealTime, byte inIndex)
+    {
+        while (inIndex > 0)
+        {
+            const byte parent = byte((inIndex - 1) / 2);
+            if (!isBefore(at(inRealTime, inIndex), at(inRealTime, parent)))
+                return;
+            swap(at(inRealTime, inIndex), at(inRealTime, parent));
+            inIndex = parent;
+        }
+    }
+
+    inline void siftDown(bool inRealTime, byte inIndex)
+    {
+        const byte count = inRealTime ? mNumRealTime : mNumOthers;
+        while (true)
+        {
+            const unsigned left = 2u * inIndex + 1;
+            byte first = inIndex;
+            if (left < count && isBefore(at(inRealTime, byte(left)), at(inRealTime, first)))
+                first = byte(left);
+            if (left + 1 < count && isBefore(at(inRealTime, byte(left + 1)), at(inRealTime, first)))
+                first = byte(left + 1);
+            if (first == inIndex)
+                return;
+            swap(at(inRealTime, inIndex), at(inRealTime, first));
+            inIndex = first;
+        }
+    }
+
+    static inline void swap(Entry& inA, Entry& inB)
+    {
+        const Entry swapped = inA;
+        inA = inB;
+        inB = swapped;
+    }
+
+private:
+    Entry           mEntries[Size];
+    byte            mNumRealTime;
+    byte            mNumOthers;
+    unsigned long   mLineFree;
+};
+
+template<unsigned Size, unsigned long BaudRate>
+const unsigned long OutputScheduler<Size, BaudRate>::ByteTime;
+
+/*! Disabled scheduler: sendAt sends right away. */
+template<unsigned long BaudRate>
+class OutputScheduler<0, BaudRate>
+{
+public:
+    static const unsigned long ByteTime = 0;
+
+    struct Entry
+    {
+        unsigned long   time;
+        byte            message[3];
+    };
+
+    inline bool isEmpty() const { return true; }
+    inline bool push(unsigned long, StatusByte, DataByte, DataByte) { return false; }
+    inline const Entry* top(bool) const { return nullptr; }
+    inline void pop(bool) {}
+    inline void clear() {}
+    inline unsigned long getLineFree(unsigned long inNow) const { return inNow; }
+    inline void occupyLine(unsigned long, size_t) {}
+    static inline bool isDue(const Entry&, unsigned long) { return true; }
+};
+
+template<unsigned long BaudRate>
+const unsigned long OutputScheduler<0, BaudRate>::ByteTime;
+
+END_MIDI_NAMESPACE
@@ -55,6 +55,42 @@ struct DefaultSettings
     */
     static const bool UseRunningStatus = false;
 
+    /*! Force the running status byte every N outgoing channel messages.\n
+    Set to 0 to only send it when the status changes.\n
+    Otherwise, receivers connected mid-stream (or that lost a byte) get the
+    status back after at most N messages. Only used with UseRunningStatus.
+    */
+    static const uint16_t RunningStatusRefreshCount = 0;
+
+    /*! Force the running status byte after this many ms without one.\n
+    Set to 0 to only send it when the status changes. Uses the time sampled
+    by read() (or given to setCurrentTime) like Active Sensing does.
+    Only used with UseRunningStatus.
+    */
+    static const uint16_t RunningStatusRefreshPeriod = 0;
+
+    /*! Send NoteOff messages as NoteOn with a null velocity.\n
+    Set to true to keep the running status through note streams (most notes
+    then take 2 bytes instead of 3), the release velocity is lost.
+    This is the mirror of HandleNullVelocityNoteOnAsNoteOff.
+    */
+    static const bool SendNoteOffAsNullVelocityNoteOn = false;
+
+    /*! Remember the RPN / NRPN numbers selected by beginRpn / beginNrpn.\n
+    Set to true to skip the selection when the number is already selected.\n
+    Set to false to select it each time (saves 2 unsigned of RAM).
+    */
+    static const bool CacheParameterNumbers = true;
+
+    /*! Count the traffic (bytes, messages per type, errors, filtered
+    messages, running status and time spent sending).\n
+    Set to false to compile the counters out entirely (no RAM, no code).\n
+    Set to true to read them with MidiInterface::getStatistics or
+    takeStatistics (snapshot & reset). Costs about 120 bytes of RAM, and a
+    Platform::nowMicros call around each write to the transport.
+    */
+    static const bool UseStatistics = false;
+
     /*! NoteOn with 0 velocity should be handled as NoteOf.\n
     Set to true  to get NoteOff events when receiving null-velocity NoteOn messages.\n
     Set to false to get NoteOn  events when receiving null-velocity NoteOn messages.
@@ -64,6 +100,7 @@ struct DefaultSettings
     /*! Setting this to true will make MIDI.read parse only one byte of data for each
     call when data is available. This can speed up your application if receiving
     a lot of traffic, but might induce MIDI Thru and treatment latency.
+    MidiInterface::poll and pollFor ignore it, and take their budget at run time.
     */
     static const bool Use1ByteParsing = true;
 
@@ -94,6 +131,138 @@ struct DefaultSettings
     Setting this field to 0 will disable sending MIDI active sensing.
     */
     static const uint16_t SenderActiveSensingPeriodicity = 0;
+
+    /*! Let the application provide the time used by Active Sensing.\n
+    Set to false to sample Platform::now() once per read().\n
+    Set to true to never call the clock from the library, the time (in ms)
+    is given with MidiInterface::setCurrentTime instead (eg: from a tick ISR).
+    */
+    static const bool UseExternalTime = false;
+
+    /*! Number of outgoing messages that can be queued before transmission.\n
+    Set to 0 to send messages as soon as the send methods are called.\n
+    Otherwise, the send methods only queue the message and return immediately
+    (messages sent while the queue is full are dropped), and flush() (also
+    called by read()) writes the whole queue to the transport at once,
+    applying running status if enabled, or keeps it if the transport refuses
+    the transmission. Queueing from an ISR is fine as long
+    as only one context sends, and only one context flushes.
+    Costs 3 bytes of RAM per message.
+    */
+    static const unsigned TxQueueSize = 0;
+
+    /*! Number of continuous controller values that can wait for the transport.\n
+    Set to 0 to send Control Change, Pitch Bend and After Touch messages as
+    any other message.\n
+    Otherwise, they are kept pending until the transport has room
+    (availableForWrite) or flush() is called (read() calls it), and a newer
+    value for the same controller replaces the pending one: encoders and
+    touch strips can't saturate the output. Values pending on a channel are
+    written before the next note or Program Change on that channel, the
+    RPN / NRPN controllers and channel mode messages are never held.
+    Costs 3 bytes of RAM per value.
+    */
+    static const unsigned CoalescedMessages = 0;
+
+    /*! Number of messages that MidiInterface::sendAt can hold until their time.\n
+    Set to 0 to send them right away (saves memory).\n
+    Otherwise, service() (also called by flush() and read()) writes each
+    message once it is due, or earlier if the bytes already written keep the
+    line busy until then (@see SchedulerBaudRate). Real Time messages go
+    first: a message that would still be on the line when one of them is due
+    waits until it has been written. Costs 7 bytes of RAM per message.
+    */
+    static const unsigned ScheduledMessages = 0;
+
+    /*! Rate of the output line, for ScheduledMessages (each byte takes 10 bits).\n
+    31250 for DIN MIDI, 0 for transports without a line rate (USB, network):
+    scheduled messages are then written when due.
+    */
+    static const unsigned long SchedulerBaudRate = 31250;
+
+    /*! Enable reception of System Exclusive messages.\n
+    Set to false to treat SysEx frames as parse errors (saves memory).\n
+    Set to true to receive them in chunks, straight into the buffer given to
+    setSysExBuffer (no buffer means SysEx is still rejected). read() returns
+    a SystemExclusive message each time the buffer is full or the frame ends:
+    the first chunk starts with 0xF0, the last one ends with 0xF7, and
+    WarningSplitSysEx is set while more chunks are to come.
+    */
+    static const bool UseSysExInput = false;
+
+    /*! Stamp received messages with the time of their first byte.\n
+    Set to true to fill Message::timestamp (@see MidiInterface::getTimestamp)
+    with Platform::nowMicros(), sampled when the first byte of the message is
+    read from the transport, or with the transport's own readTimestamp() if it
+    has one (eg: RingSerialMIDI with Timestamps).\n
+    Set to false to leave it to 0, the platform then needs no nowMicros().
+    */
+    static const bool UseTimestamps = false;
+
+    /*! Keep track of the notes held and of the controllers received.\n
+    Set to true to feed a StateTracker (@see MidiInterface::getStateTracker)
+    from every received channel message, and enable MidiInterface::panic,
+    which is also called on ErrorActiveSensingTimeout.
+    Costs 258 bytes of RAM, plus the controllers.
+    */
+    static const bool UseStateTracker = false;
+
+    /*! Number of controllers tracked with UseStateTracker, over all channels.\n
+    0 to only track notes, up to DenseControllerSlots (3 bytes each), or
+    DenseControllerSlots to track them all (2 KB).
+    */
+    static const unsigned TrackedControllers = 0;
+
+    /*! Decode received RPN / NRPN frames.\n
+    Set to true to assemble Control Changes 98-101, 6, 38, 96 & 97 into
+    ParameterEvents: read() returns the Data Entry / Increment / Decrement
+    CC as usual, and MidiInterface::isParameterEvent tells it completes one.
+    Costs 4 bytes of RAM per channel.
+    */
+    static const bool UseParameterDecoder = false;
+
+    /*! With UseParameterDecoder, don't return the parameter number selection
+    CCs (98-101) from read(): each RPN / NRPN operation then reads as a single
+    message.
+    */
+    static const bool SwallowParameterControllers = false;
+
+    /*! Pair received high resolution Control Changes (0-31 MSB, 32-63 LSB).\n
+    Set to true to read each MSB + LSB pair as a single Control Change on the
+    MSB controller, MidiInterface::isControlChange14 then gives the 14-bit
+    value. Pick the pairs with MidiInterface::setPairedControllers.
+    Costs 8 bytes of RAM per channel, plus a Message (deferred behind an MSB).
+    */
+    static const bool UseControllerPairing = false;
+
+    /*! How long (in ms) a received MSB waits for its LSB, with UseControllerPairing.\n
+    Once expired, the MSB is read with a null LSB.
+    Set to 0 to read each MSB right away (with a null LSB), and the LSB as
+    another, refined value.
+    */
+    static const uint16_t ControllerPairingTimeout = 10;
+
+    /*! Follow the tempo and song position of a MIDI clock master.\n
+    Set to true to feed a ClockFollower (@see MidiInterface::getClockFollower)
+    from the Clock, Start, Stop, Continue and Song Position messages received.
+    Clocks are timed with Message::timestamp if UseTimestamps is enabled, with
+    Platform::nowMicros() otherwise. Costs 15 bytes of RAM.
+    */
+    static const bool UseClockFollower = false;
+
+    /*! Weight of each new Clock interval in the tempo, as a power of 2.\n
+    3 averages over about 8 Clocks: higher values are steadier, lower values
+    follow tempo changes faster. Only used with UseClockFollower.
+    */
+    static const byte ClockFollowerSmoothing = 3;
+
+    /*! Decode received MIDI Time Code.\n
+    Set to true to feed a TimeCodeDecoder (@see MidiInterface::getTimeCodeDecoder)
+    from the Quarter Frame messages received, and from the Full Frame SysEx
+    if UseSysExInput is enabled. Quarter Frames are timed like the Clocks of
+    UseClockFollower. Costs 25 bytes of RAM.
+    */
+    static const bool UseTimeCodeDecoder = false;
 };
 
 END_MIDI_NAMESPACE
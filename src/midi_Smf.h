@@ -0,0 +1,860 @@
+/*!
+ *  @file       midi_Smf.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Standard MIDI File reader & writer
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Message.h"
+#include "midi_RunningStatus.h"
+#ifndef ARDUINO
+#include <string.h>
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+struct DefaultSmfSettings
+{
+    /*! Most tracks followed by SmfReader, the next ones are ignored (and
+    counted as errors, @see SmfReader::getErrorCount).\n
+    Costs WindowSize + 19 bytes of RAM per track (on 8-bit targets).
+    */
+    static const unsigned MaxTracks = 16;
+
+    /*! Bytes of a track read from the file at once.\n
+    Each track has its own window, so that merged playback reads each of
+    them sequentially. Up to 65535.
+    */
+    static const unsigned WindowSize = 16;
+
+    /*! Write channel events with running status (SmfWriter), the status
+    byte is then omitted while it does not change.
+    */
+    static const bool UseRunningStatus = true;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief A file held in memory (eg: memory-mapped on a host), for
+ SmfReader and SmfWriter.
+
+ SD card files need an adapter with the same methods, on top of seek(),
+ read() and write().
+ */
+class SmfMemoryFile
+{
+public:
+    /*! Read-only file. */
+    inline SmfMemoryFile(const byte* inData, unsigned long inSize)
+        : mData(const_cast<byte*>(inData))
+        , mCapacity(0)
+        , mSize(inSize)
+    {
+    }
+
+    /*! Writable file of up to inCapacity bytes, holding inSize bytes already. */
+    inline SmfMemoryFile(byte* inBuffer, unsigned long inCapacity, unsigned long inSize)
+        : mData(inBuffer)
+        , mCapacity(inCapacity)
+        , mSize(inSize)
+    {
+    }
+
+    /*! \return The number of bytes copied to outData, 0 past the end. */
+    inline unsigned read(unsigned long inOffset, byte* outData, unsigned inSize)
+    {
+        if (inOffset >= mSize)
+            return 0;
+        const unsigned long left = mSize - inOffset;
+        const unsigned count = left < inSize ? unsigned(left) : inSize;
+        memcpy(outData, mData + inOffset, count);
+        return count;
+    }
+
+    /*! Append inSize bytes, false if they don't fit. */
+    inline bool write(const byte* inData, unsigned inSize)
+    {
+        if (!writeAt(mSize, inData, inSize))
+            return false;
+        mSize += inSize;
+        return true;
+    }
+
+    /*! Overwrite bytes already written (eg: a chunk length). */
+    inline bool writeAt(unsigned long inOffset, const byte* inData, unsigned inSize)
+    {
+        if (inOffset > mCapacity || inSize > mCapacity - inOffset)
+            return false;
+        memcpy(mData + inOffset, inData, inSize);
+        return true;
+    }
+
+    inline unsigned long getSize() const
+    {
+        return mSize;
+    }
+
+private:
+    byte*           mData;
+    unsigned long   mCapacity;
+    unsigned long   mSize;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief An event read from a Standard MIDI File.
+
+ Channel events are decoded in message, like MidiInterface::read does.
+ SysEx (0xF0 or escaped 0xF7) and meta (0xFF) events give their payload in
+ data: dataLength bytes of it, out of length (the rest is skipped if the
+ buffer given to SmfReader::setDataBuffer is too small).
+ */
+struct SmfEvent
+{
+    static const byte EndOfTrack    = 0x2f;
+    static const byte Tempo         = 0x51;
+    static const byte TimeSignature = 0x58;
+
+    inline bool isMeta(byte inType) const
+    {
+        return status == 0xff && metaType == inType;
+    }
+
+    /*! Microseconds per quarter note of a Tempo event, 0 otherwise. */
+    inline unsigned long getTempo() const
+    {
+        if (!isMeta(Tempo) || dataLength < 3)
+            return 0;
+        return (unsigned long)data[0] << 16 | (unsigned long)data[1] << 8 | data[2];
+    }
+
+    unsigned long   tick;       ///< Absolute, in file ticks (@see SmfReader::getDivision)
+    byte            track;
+    StatusByte      status;     ///< Channel status, 0xF0 / 0xF7 (SysEx) or 0xFF (meta)
+    byte            metaType;
+    Message         message;    ///< Channel events, SystemExclusive for SysEx events
+    unsigned long   length;     ///< Payload of SysEx & meta events
+    unsigned        dataLength;
+    const byte*     data;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Streaming reader of Standard MIDI Files (format 0, 1 & 2).
+
+ Events are decoded straight from the file, without loading it: each track
+ keeps its position, running status, absolute tick and a small window of
+ Settings::WindowSize bytes, which is refilled from File::read(offset,
+ data, size) when consumed. RAM is independent of the file size.
+
+ readTrackEvent reads a track on its own, readEvent merges all of them in
+ tick order through a heap of the tracks (ties go to the lowest track
+ first), for format 1 playback.
+ */
+template<class File, class Settings = DefaultSmfSettings>
+class SmfReader
+{
+public:
+    static_assert(Settings::MaxTracks > 0 && Settings::MaxTracks < 256, "MaxTracks must be between 1 and 255");
+    static_assert(Settings::WindowSize > 0 && Settings::WindowSize < 65536, "WindowSize must be between 1 and 65535");
+
+    inline explicit SmfReader(File& inFile)
+        : mFile(inFile)
+        , mData(mShortData)
+        , mDataSize(sizeof(mShortData))
+        , mFormat(0)
+        , mDivision(0)
+        , mNumTracks(0)
+        , mHeapSize(0)
+        , mHeapReady(false)
+        , mErrors(0)
+    {
+    }
+
+    /*! \brief Read the header and locate the tracks, then rewind them.
+     \return false if the file doesn't start with an MThd chunk.
+     Only the first Settings::MaxTracks tracks are followed, each track
+     beyond them counts as an error (@see getErrorCount).
+     */
+    inline bool open();
+
+    inline uint16_t getFormat() const   { return mFormat; }
+    inline uint16_t getDivision() const { return mDivision; }
+
+    /*! Number of tracks followed, up to Settings::MaxTracks. */
+    inline byte getNumTracks() const    { return mNumTracks; }
+
+    /*! Malformed or truncated tracks (they end where the error is), and
+     tracks left out because of Settings::MaxTracks.
+     */
+    inline unsigned long getErrorCount() const { return mErrors; }
+
+    /*! Where SysEx & meta event payloads are copied. Without a buffer, only
+     the first 4 bytes are kept (enough for Tempo events).
+     */
+    inline void setDataBuffer(byte* inBuffer, unsigned inSize)
+    {
+        mData     = inBuffer != nullptr ? inBuffer : mShortData;
+        mDataSize = inBuffer != nullptr ? inSize : unsigned(sizeof(mShortData));
+    }
+
+    /*! \brief Next event of all tracks, in tick order.
+     \return false once all the tracks are over.
+     */
+    inline bool readEvent(SmfEvent& outEvent);
+
+    /*! \brief Next event of inTrack.
+     \return false once the track is over.
+     */
+    inline bool readTrackEvent(byte inTrack, SmfEvent& outEvent);
+
+    inline bool isTrackOver(byte inTrack) const
+    {
+        return inTrack >= mNumTracks || mTracks[inTrack].over;
+    }
+
+private:
+    struct Track
+    {
+        unsigned long   offset;     // of window[0] in the file
+        unsigned long   end;        // of the chunk
+        unsigned long   tick;       // of the next event
+        uint16_t        index;
+        uint16_t        length;
+        StatusByte      runningStatus;
+        bool            over;
+        byte            window[Settings::WindowSize];
+    };
+
+    inline bool readByte(Track& inTrack, byte& outByte);
+    inline bool readVariableLength(Track& inTrack, unsigned long& outValue);
+    inline bool readDelta(Track& inTrack);
+    inline bool readData(Track& inTrack, SmfEvent& outEvent);
+    inline bool decodeEvent(byte inTrack, SmfEvent& outEvent);
+    inline void endTrack(Track& inTrack, bool inError);
+
+    inline bool isBefore(byte inA, byte inB) const;
+    inline void siftDown(byte inIndex);
+    inline void buildHeap();
+
+    static inline unsigned long readBigEndian(const byte* inData, byte inSize);
+
+private:
+    File&       mFile;
+    byte*       mData;
+    unsigned    mDataSize;
+    uint16_t    mFormat;
+    uint16_t    mDivision;
+    byte        mNumTracks;
+    byte        mHeapSize;
+    bool        mHeapReady;
+    unsigned long mErrors;
+    byte        mShortData[4];
+    byte        mHeap[Settings::MaxTracks];
+    Track       mTracks[Settings::MaxTracks];
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Streaming writer of Standard MIDI Files.
+
+ Events are appended with File::write(data, size) as they come (eg: straight
+ from MidiInterface::read, with the delta time measured by the caller), the
+ chunk lengths are patched with File::writeAt(offset, data, size) by
+ endTrack and end. Channel events use running status if
+ Settings::UseRunningStatus is set, like MidiInterface::send does.
+ */
+template<class File, class Settings = DefaultSmfSettings>
+class SmfWriter
+{
+public:
+    inline explicit SmfWriter(File& inFile)
+        : mFile(inFile)
+        , mPosition(0)
+        , mTrackStart(0)
+        , mTick(0)
+        , mNumTracks(0)
+        , mInTrack(false)
+        , mError(false)
+    {
+    }
+
+    /*! Write the header chunk, the track count is set by end(). */
+    inline bool begin(uint16_t inFormat, uint16_t inDivision);
+
+    inline bool beginTrack();
+
+    /*! \brief Append a channel message, inDelta ticks after the previous event.
+     \return false for other messages (Real Time & System Common messages
+     can't be stored in a file, SysEx go through writeSysEx).
+     */
+    inline bool write(const Message& inMessage, unsigned long inDelta);
+
+    /*! Same arguments as MidiInterface::sendSysEx. */
+    inline bool writeSysEx(unsigned long inDelta,
+                           unsigned inLength,
+                           const byte* inArray,
+                           bool inArrayContainsBoundaries = false);
+
+    inline bool writeMeta(unsigned long inDelta, byte inType, const byte* inData, unsigned inLength);
+
+    inline bool writeTempo(unsigned long inDelta, unsigned long inMicrosPerQuarter);
+
+    /*! Write End Of Track and the track length. */
+    inline bool endTrack(unsigned long inDelta = 0);
+
+    /*! Write the track count. The writer can begin() another file after. */
+    inline bool end();
+
+    /*! Absolute tick of the last event of the current track. */
+    inline unsigned long getTick() const { return mTick; }
+
+    inline uint16_t getNumTracks() const { return mNumTracks; }
+
+    /*! A write to the file failed (eg: disk full) since begin(). */
+    inline bool hasError() const { return mError; }
+
+private:
+    inline bool put(const byte* inData, unsigned inSize);
+    inline bool putEventHeader(unsigned long inDelta, byte inStatus, byte inMetaType, unsigned long inLength);
+
+private:
+    File&           mFile;
+    unsigned long   mPosition;
+    unsigned long   mTrackStart;
+    unsigned long   mTick;
+    uint16_t        mNumTracks;
+    bool            mInTrack;
+    bool            mError;
+    RunningStatusTx<Settings::UseRunningStatus, 0, 0> mRunningStatus;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! Encode inValue (up to 0x0FFFFFFF) as a variable length quantity.
+ \return The number of bytes written to outData (1 to 4).
+ */
+inline byte encodeVariableLength(unsigned long inValue, byte* outData)
+{
+    byte length = 1;
+    while (length < 4 && (inValue >> (7 * length)) != 0)
+        length++;
+
+    for (byte i = 0; i < length; ++i)
+    {
+        const byte group = byte(inValue >> (7 * (length - 1 - i))) & 0x7f;
+        outData[i] = i + 1 < length ? byte(group | 0x80) : group;
+    }
+    return length;
+}
+
+// -----------------------------------------------------------------------------
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::open()
+{
+    mNumTracks = 0;
+    mHeapReady = false;
+    mErrors    = 0;
+
+    byte header[14];
+    if (mFile.read(0, header, 14) != 14 || memcmp(header, "MThd", 4) != 0)
+        return false;
+
+    const unsigned long headerLength = readBigEndian(header + 4, 4);
+    if (headerLength < 6)
+        return false;
+
+    mFormat = uint16_t(readBigEndian(header + 8, 2));
+    mDivision = uint16_t(readBigEndian(header + 12, 2));
+    const unsigned long numChunks = readBigEndian(header + 10, 2);
+
+    // Unknown chunks are skipped, as the specification requires.
+    unsigned long offset = 8 + headerLength;
+    for (unsigned long found = 0; found < numChunks && mNumTracks < Settings::MaxTracks; )
+    {
+        byte chunk[8];
+        if (mFile.read(offset, chunk, 8) != 8)
+            break;
+
+        const unsigned long length = readBigEndian(chunk + 4, 4);
+        offset += 8;
+        if (memcmp(chunk, "MTrk", 4) == 0)
+        {
+            Track& track        = mTracks[mNumTracks++];
+            track.offset        = offset;
+            track.end           = offset + length;
+            track.tick          = 0;
+            track.index         = 0;
+            track.length        = 0;
+            track.runningStatus = 0;
+            track.over          = false;
+            readDelta(track);
+            found++;
+        }
+        offset += length;
+    }
+
+    // The header gives the number of tracks.
+    if (numChunks > Settings::MaxTracks)
+        mErrors += numChunks - Settings::MaxTracks;
+    return true;
+}
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readEvent(SmfEvent& outEvent)
+{
+    if (!mHeapReady)
+        buildHeap();
+
+    while (mHeapSize != 0)
+    {
+        const byte track = mHeap[0];
+        const bool decoded = decodeEvent(track, outEvent);
+
+        if (mTracks[track].over)
+            mHeap[0] = mHeap[--mHeapSize];
+        siftDown(0);
+
+        if (decoded)
+            return true;
+    }
+    return false;
+}
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readTrackEvent(byte inTrack, SmfEvent& outEvent)
+{
+    if (isTrackOver(inTrack))
+        return false;
+
+    // The tracks no longer are in heap order.
+    mHeapReady = false;
+    return decodeEvent(inTrack, outEvent);
+}
+
+// Private method: the delta time has been read, decode the event after it
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::decodeEvent(byte inTrack, SmfEvent& outEvent)
+{
+    Track& track = mTracks[inTrack];
+    byte first = 0;
+    if (!readByte(track, first))
+    {
+        endTrack(track, true);
+        return false;
+    }
+
+    outEvent.tick       = track.tick;
+    outEvent.track      = inTrack;
+    outEvent.metaType   = 0;
+    outEvent.message    = Message();
+    outEvent.length     = 0;
+    outEvent.dataLength = 0;
+    outEvent.data       = mData;
+
+    if (first == 0xff || first == SystemExclusiveStart || first == SystemExclusiveEnd)
+    {
+        // SysEx and meta events cancel running status.
+        track.runningStatus = 0;
+        outEvent.status     = first;
+
+        if (first == 0xff && !readByte(track, outEvent.metaType))
+        {
+            endTrack(track, true);
+            return false;
+        }
+        if (!readVariableLength(track, outEvent.length) || !readData(track, outEvent))
+        {
+            endTrack(track, true);
+            return false;
+        }
+
+        if (first != 0xff)
+        {
+            outEvent.message.type  = SystemExclusive;
+            outEvent.message.valid = true;
+        }
+        else if (outEvent.metaType == SmfEvent::EndOfTrack)
+        {
+            endTrack(track, false);
+            return true;
+        }
+    }
+    else
+    {
+        // Channel event, with running status if it starts with a data byte
+        StatusByte status = first;
+        byte data[2] = { 0, 0 };
+        byte numData = 0;
+        if (first < 0x80)
+        {
+            status      = track.runningStatus;
+            data[0]     = first;
+            numData     = 1;
+        }
+
+        const byte info = getStatusInfo(status);
+        if (!(info & StatusInfo::ChannelMessage))
+        {
+            endTrack(track, true);
+            return false;
+        }
+
+        const byte length = info & StatusInfo::LengthMask;
+        for (; numData + 1 < length; ++numData)
+        {
+            if (!readByte(track, data[numData]) || data[numData] >= 0x80)
+            {
+                endTrack(track, true);
+                return false;
+            }
+        }
+
+        track.runningStatus      = status;
+        outEvent.status          = status;
+        outEvent.message.type    = MidiType(status & 0xf0);
+        outEvent.message.channel = Channel((status & 0x0f) + 1);
+        outEvent.message.data1   = data[0];
+        outEvent.message.data2   = data[1];
+        outEvent.message.length  = length;
+        outEvent.message.valid   = true;
+    }
+
+    // Tracks without End Of Track end with their chunk.
+    if (!readDelta(track))
+        endTrack(track, false);
+    return true;
+}
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readByte(Track& inTrack, byte& outByte)
+{
+    if (inTrack.index == inTrack.length)
+    {
+        inTrack.offset += inTrack.length;
+        inTrack.index   = 0;
+        inTrack.length  = 0;
+        if (inTrack.offset >= inTrack.end)
+            return false;
+
+        const unsigned long left = inTrack.end - inTrack.offset;
+        const unsigned size = left < Settings::WindowSize ? unsigned(left) : Settings::WindowSize;
+        inTrack.length = uint16_t(mFile.read(inTrack.offset, inTrack.window, size));
+        if (inTrack.length == 0)
+            return false;
+    }
+    outByte = inTrack.window[inTrack.index++];
+    return true;
+}
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readVariableLength(Track& inTrack, unsigned long& outValue)
+{
+    outValue = 0;
+    for (byte i = 0; i < 4; ++i)
+    {
+        byte octet = 0;
+        if (!readByte(inTrack, octet))
+            return false;
+        outValue = outValue << 7 | (octet & 0x7f);
+        if (!(octet & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Private method: advance the track to its next event, false at its end
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readDelta(Track& inTrack)
+{
+    if (inTrack.offset + inTrack.index >= inTrack.end)
+        return false;
+
+    unsigned long delta = 0;
+    if (!readVariableLength(inTrack, delta))
+    {
+        mErrors++;
+        return false;
+    }
+    inTrack.tick += delta;
+    return true;
+}
+
+// Private method: copy what fits of the payload, skip the rest without reading it
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::readData(Track& inTrack, SmfEvent& outEvent)
+{
+    unsigned long left = outEvent.length;
+    const unsigned copied = left < mDataSize ? unsigned(left) : mDataSize;
+
+    for (unsigned i = 0; i < copied; ++i)
+    {
+        if (!readByte(inTrack, mData[i]))
+            return false;
+    }
+    left -= copied;
+    outEvent.dataLength = copied;
+
+    const unsigned buffered = unsigned(inTrack.length - inTrack.index);
+    if (left <= buffered)
+    {
+        inTrack.index = uint16_t(inTrack.index + left);
+    }
+    else
+    {
+        inTrack.offset += inTrack.length + (left - buffered);
+        inTrack.index   = 0;
+        inTrack.length  = 0;
+    }
+    return inTrack.offset + inTrack.index <= inTrack.end;
+}
+
+template<class File, class Settings>
+inline void SmfReader<File, Settings>::endTrack(Track& inTrack, bool inError)
+{
+    if (inError)
+        mErrors++;
+    inTrack.over = true;
+}
+
+template<class File, class Settings>
+inline bool SmfReader<File, Settings>::isBefore(byte inA, byte inB) const
+{
+    const unsigned long tickA = mTracks[inA].tick;
+    const unsigned long tickB = mTracks[inB].tick;
+    return tickA < tickB || (tickA == tickB && inA < inB);
+}
+
+template<class File, class Settings>
+inline void SmfReader<File, Settings>::siftDown(byte inIndex)
+{
+    unsigned parent = inIndex;
+    while (true)
+    {
+        const unsigned left  = 2 * parent + 1;
+        const unsigned right = left + 1;
+        unsigned first = parent;
+
+        if (left < mHeapSize && isBefore(mHeap[left], mHeap[first]))
+            first = left;
+        if (right < mHeapSize && isBefore(mHeap[right], mHeap[first]))
+            first = right;
+        if (first == parent)
+            return;
+
+        const byte swapped = mHeap[parent];
+        mHeap[parent] = mHeap[first];
+        mHeap[first]  = swapped;
+        parent = first;
+    }
+}
+
+template<class File, class Settings>
+inline void SmfReader<File, Settings>::buildHeap()
+{
+    mHeapSize = 0;
+    for (byte i = 0; i < mNumTracks; ++i)
+    {
+        if (!mTracks[i].over)
+            mHeap[mHeapSize++] = i;
+    }
+    for (byte i = mHeapSize / 2; i-- > 0; )
+        siftDown(i);
+    mHeapReady = true;
+}
+
+template<class File, class Settings>
+inline unsigned long SmfReader<File, Settings>::readBigEndian(const byte* inData, byte inSize)
+{
+    unsigned long value = 0;
+    for (byte i = 0; i < inSize; ++i)
+        value = value << 8 | inData[i];
+    return value;
+}
+
+// -----------------------------------------------------------------------------
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::begin(uint16_t inFormat, uint16_t inDivision)
+{
+    mPosition  = 0;
+    mNumTracks = 0;
+    mInTrack   = false;
+    mError     = false;
+
+    const byte header[14] = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6,
+        byte(inFormat >> 8), byte(inFormat),
+        0, 0,
+        byte(inDivision >> 8), byte(inDivision),
+    };
+    return put(header, sizeof(header));
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::beginTrack()
+{
+    if (mInTrack && !endTrack())
+        return false;
+
+    static const byte header[8] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+    mTrackStart = mPosition + 8;
+    mTick       = 0;
+    mInTrack    = true;
+    mRunningStatus.cancel();
+    return put(header, sizeof(header));
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::write(const Message& inMessage, unsigned long inDelta)
+{
+    if (inMessage.type < NoteOff || inMessage.type >= SystemExclusive || !inMessage.valid)
+        return false;
+
+    const StatusByte status = StatusByte(inMessage.type | ((inMessage.channel - 1) & 0x0f));
+    const byte length = getStatusInfo(status) & StatusInfo::LengthMask;
+
+    byte event[7];
+    byte size = encodeVariableLength(inDelta, event);
+    if (!mRunningStatus.omit(status, 0))
+        event[size++] = status;
+    event[size++] = inMessage.data1 & 0x7f;
+    if (length > 2)
+        event[size++] = inMessage.data2 & 0x7f;
+
+    mTick += inDelta;
+    return put(event, size);
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::writeSysEx(unsigned long inDelta,
+                                                  unsigned inLength,
+                                                  const byte* inArray,
+                                                  bool inArrayContainsBoundaries)
+{
+    // The 0xF0 is the event type, the 0xF7 is part of the payload.
+    const byte* data = inArray;
+    unsigned length = inLength;
+    if (inArrayContainsBoundaries)
+    {
+        if (length < 2)
+            return false;
+        data++;
+        length -= 2;
+    }
+
+    static const byte end = SystemExclusiveEnd;
+    return putEventHeader(inDelta, SystemExclusiveStart, 0, length + 1ul)
+        && put(data, length)
+        && put(&end, 1);
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::writeMeta(unsigned long inDelta,
+                                                 byte inType,
+                                                 const byte* inData,
+                                                 unsigned inLength)
+{
+    return putEventHeader(inDelta, 0xff, inType, inLength)
+        && put(inData, inLength);
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::writeTempo(unsigned long inDelta, unsigned long inMicrosPerQuarter)
+{
+    const byte tempo[3] = {
+        byte(inMicrosPerQuarter >> 16), byte(inMicrosPerQuarter >> 8), byte(inMicrosPerQuarter)
+    };
+    return writeMeta(inDelta, SmfEvent::Tempo, tempo, 3);
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::endTrack(unsigned long inDelta)
+{
+    if (!mInTrack)
+        return false;
+
+    mInTrack = false;
+    if (!writeMeta(inDelta, SmfEvent::EndOfTrack, nullptr, 0))
+        return false;
+
+    const unsigned long length = mPosition - mTrackStart;
+    const byte size[4] = { byte(length >> 24), byte(length >> 16), byte(length >> 8), byte(length) };
+    if (!mFile.writeAt(mTrackStart - 4, size, 4))
+    {
+        mError = true;
+        return false;
+    }
+    mNumTracks++;
+    return true;
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::end()
+{
+    if (mInTrack && !endTrack())
+        return false;
+
+    const byte count[2] = { byte(mNumTracks >> 8), byte(mNumTracks) };
+    if (!mFile.writeAt(10, count, 2))
+        mError = true;
+    return !mError;
+}
+
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::put(const byte* inData, unsigned inSize)
+{
+    if (inSize == 0)
+        return !mError;
+    if (!mFile.write(inData, inSize))
+    {
+        mError = true;
+        return false;
+    }
+    mPosition += inSize;
+    return true;
+}
+
+// Private method: delta time, event type, meta type (0xFF events) and payload length
+template<class File, class Settings>
+inline bool SmfWriter<File, Settings>::putEventHeader(unsigned long inDelta,
+                                                      byte inStatus,
+                                                      byte inMetaType,
+                                                      unsigned long inLength)
+{
+    byte header[10];
+    byte size = encodeVariableLength(inDelta, header);
+    header[size++] = inStatus;
+    if (inStatus == 0xff)
+        header[size++] = inMetaType & 0x7f;
+    size = byte(size + encodeVariableLength(inLength, header + size));
+
+    mTick += inDelta;
+    mRunningStatus.cancel();
+    return put(header, size);
+}
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,365 @@
+/*!
+ *  @file       midi_StateTracker.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Received notes & controllers state
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#ifndef ARDUINO
+#include <string.h>
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+/*! Number of controller slots that holds every controller of every channel,
+ the table is then indexed directly (1 byte per controller) instead of
+ being searched (3 bytes per slot). @see DefaultSettings::TrackedControllers
+ */
+static const unsigned DenseControllerSlots = 16 * 128;
+
+// Private helper: index of the lowest bit set in a non-null word
+inline byte lowestBit(uint32_t inWord)
+{
+#if defined(__GNUC__)
+    return byte(__builtin_ctzl((unsigned long)inWord));
+#else
+    byte index = 0;
+    while (!(inWord & 1))
+    {
+        inWord >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Last values of up to Slots controllers, searched linearly.
+ When all the slots are used, new controllers are not tracked.
+ */
+template<unsigned Slots, bool Dense = (Slots >= DenseControllerSlots)>
+class ControllerTable
+{
+public:
+    inline ControllerTable()
+        : mCount(0)
+    {
+    }
+
+    inline void set(Channel inChannel, DataByte inNumber, DataByte inValue)
+    {
+        const uint16_t key = makeKey(inChannel, inNumber);
+        for (unsigned i = 0; i < mCount; ++i)
+        {
+            if (mKeys[i] == key)
+            {
+                mValues[i] = inValue;
+                return;
+            }
+        }
+        if (mCount < Slots)
+        {
+            mKeys[mCount]   = key;
+            mValues[mCount] = inValue;
+            mCount++;
+        }
+    }
+
+    inline bool get(Channel inChannel, DataByte inNumber, DataByte& outValue) const
+    {
+        const uint16_t key = makeKey(inChannel, inNumber);
+        for (unsigned i = 0; i < mCount; ++i)
+        {
+            if (mKeys[i] == key)
+            {
+                outValue = mValues[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*! Forget the controllers of a channel (1-16), or of all of them (0). */
+    inline void clear(Channel inChannel = 0)
+    {
+        unsigned count = 0;
+        for (unsigned i = 0; i < mCount; ++i)
+        {
+            if (inChannel == 0 || (mKeys[i] >> 7) == unsigned(inChannel - 1))
+                continue;
+
+            mKeys[count]   = mKeys[i];
+            mValues[count] = mValues[i];
+            count++;
+        }
+        mCount = count;
+    }
+
+    template<class Function>
+    inline void forEach(Function inFunction) const
+    {
+        for (unsigned i = 0; i < mCount; ++i)
+            inFunction(Channel((mKeys[i] >> 7) + 1), DataByte(mKeys[i] & 0x7f), mValues[i]);
+    }
+
+private:
+    static inline uint16_t makeKey(Channel inChannel, DataByte inNumber)
+    {
+        return uint16_t((inChannel - 1) << 7 | inNumber);
+    }
+
+private:
+    uint16_t mKeys[Slots];
+    DataByte mValues[Slots];
+    unsigned mCount;
+};
+
+/*! Every controller of every channel, indexed directly. */
+template<unsigned Slots>
+class ControllerTable<Slots, true>
+{
+public:
+    inline ControllerTable()
+    {
+        clear();
+    }
+
+    inline void set(Channel inChannel, DataByte inNumber, DataByte inValue)
+    {
+        mValues[inChannel - 1][inNumber] = inValue;
+    }
+
+    inline bool get(Channel inChannel, DataByte inNumber, DataByte& outValue) const
+    {
+        const byte value = mValues[inChannel - 1][inNumber];
+        if (value == sUnset)
+            return false;
+
+        outValue = value;
+        return true;
+    }
+
+    inline void clear(Channel inChannel = 0)
+    {
+        if (inChannel == 0)
+            memset(mValues, sUnset, sizeof(mValues));
+        else
+            memset(mValues[inChannel - 1], sUnset, sizeof(mValues[0]));
+    }
+
+    template<class Function>
+    inline void forEach(Function inFunction) const
+    {
+        for (unsigned channel = 0; channel < 16; ++channel)
+        {
+            for (unsigned number = 0; number < 128; ++number)
+            {
+                if (mValues[channel][number] != sUnset)
+                    inFunction(Channel(channel + 1), DataByte(number), mValues[channel][number]);
+            }
+        }
+    }
+
+private:
+    static const byte sUnset = 0xff;
+
+    byte mValues[16][128];
+};
+
+/*! No controller tracking. */
+template<>
+class ControllerTable<0, false>
+{
+public:
+    inline void set(Channel, DataByte, DataByte) {}
+    inline bool get(Channel, DataByte, DataByte&) const { return false; }
+    inline void clear(Channel = 0) {}
+    template<class Function>
+    inline void forEach(Function) const {}
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Shadow copy of the notes held and the controllers received on the
+ 16 channels, see DefaultSettings::UseStateTracker.
+
+ Held notes are stored as one 128-bit set per channel, iterating over them
+ only visits the notes actually held. All Notes Off / All Sound Off, and the
+ mode messages that imply All Notes Off (Omni Off / On, Mono / Poly, CC 124
+ to 127) release the notes of their channel, System Reset forgets everything.
+ */
+template<bool Enabled, unsigned ControllerSlots>
+class StateTracker
+{
+public:
+    inline StateTracker()
+    {
+        clear();
+    }
+
+public:
+    inline void process(MidiType inType, Channel inChannel, DataByte inData1, DataByte inData2)
+    {
+        switch (inType)
+        {
+            case NoteOn:
+                if (inData2 != 0)
+                    holdNote(inChannel, inData1);
+                else
+                    releaseNote(inChannel, inData1);
+                break;
+
+            case NoteOff:
+                releaseNote(inChannel, inData1);
+                break;
+
+            case ControlChange:
+                if (inData1 == AllSoundOff || inData1 >= AllNotesOff)
+                    releaseChannel(inChannel); // Mode messages (124-127) imply All Notes Off
+                else
+                    mControllers.set(inChannel, inData1, inData2);
+                break;
+
+            case SystemReset:
+                clear();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    inline void clear()
+    {
+        releaseAllNotes();
+        mControllers.clear();
+    }
+
+    inline void releaseAllNotes()
+    {
+        memset(mNotes, 0, sizeof(mNotes));
+        mChannelsWithNotes = 0;
+    }
+
+    inline void releaseChannel(Channel inChannel)
+    {
+        memset(mNotes[inChannel - 1], 0, sizeof(mNotes[0]));
+        mChannelsWithNotes &= ~(uint16_t(1) << (inChannel - 1));
+    }
+
+public:
+    inline bool isNoteOn(Channel inChannel, DataByte inNote) const
+    {
+        return mNotes[inChannel - 1][inNote >> 5] & (uint32_t(1) << (inNote & 0x1f));
+    }
+
+    inline bool hasHeldNotes() const
+    {
+        return mChannelsWithNotes != 0;
+    }
+
+    /*! \brief Call inFunction(Channel, DataByte note) for each held note,
+     by channel and note number.
+     */
+    template<class Function>
+    inline void forEachHeldNote(Function inFunction) const
+    {
+        uint16_t channels = mChannelsWithNotes;
+        while (channels != 0)
+        {
+            const byte channel = lowestBit(channels);
+            channels &= channels - 1;
+
+            for (byte word = 0; word < 4; ++word)
+            {
+                uint32_t bits = mNotes[channel][word];
+                while (bits != 0)
+                {
+                    inFunction(Channel(channel + 1), DataByte(word << 5 | lowestBit(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    /*! \brief Last value received for a controller.
+     \return false if it was not received (or not tracked).
+     */
+    inline bool getController(Channel inChannel, DataByte inNumber, DataByte& outValue) const
+    {
+        return mControllers.get(inChannel, inNumber, outValue);
+    }
+
+    /*! \brief Call inFunction(Channel, DataByte number, DataByte value)
+     for each tracked controller.
+     */
+    template<class Function>
+    inline void forEachController(Function inFunction) const
+    {
+        mControllers.forEach(inFunction);
+    }
+
+private:
+    inline void holdNote(Channel inChannel, DataByte inNote)
+    {
+        mNotes[inChannel - 1][inNote >> 5] |= uint32_t(1) << (inNote & 0x1f);
+        mChannelsWithNotes |= uint16_t(1) << (inChannel - 1);
+    }
+
+    inline void releaseNote(Channel inChannel, DataByte inNote)
+    {
+        uint32_t* notes = mNotes[inChannel - 1];
+        notes[inNote >> 5] &= ~(uint32_t(1) << (inNote & 0x1f));
+
+        if (!(notes[0] | notes[1] | notes[2] | notes[3]))
+            mChannelsWithNotes &= ~(uint16_t(1) << (inChannel - 1));
+    }
+
+private:
+    uint32_t mNotes[16][4];
+    uint16_t mChannelsWithNotes;
+    ControllerTable<ControllerSlots> mControllers;
+};
+
+/*! Disabled tracker: nothing is held, nothing is stored. */
+template<unsigned ControllerSlots>
+class StateTracker<false, ControllerSlots>
+{
+public:
+    inline void process(MidiType, Channel, DataByte, DataByte) {}
+    inline void clear() {}
+    inline void releaseAllNotes() {}
+    inline void releaseChannel(Channel) {}
+    inline bool isNoteOn(Channel, DataByte) const { return false; }
+    inline bool hasHeldNotes() const { return false; }
+    template<class Function>
+    inline void forEachHeldNote(Function) const {}
+    inline bool getController(Channel, DataByte, DataByte&) const { return false; }
+    template<class Function>
+    inline void forEachController(Function) const {}
+};
+
+END_MIDI_NAMESPACE
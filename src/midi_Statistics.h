@@ -0,0 +1,141 @@
+/*!
+ *  @file       midi_Statistics.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Traffic statistics
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Traffic counters, see DefaultSettings::UseStatistics.
+ @see MidiInterface::getStatistics, MidiInterface::takeStatistics
+ */
+struct MidiStatistics
+{
+    /*! Channel messages first (NoteOff to PitchBend), then F0 to FF. */
+    static const unsigned NumTypes = 7 + 16;
+
+    static inline unsigned getTypeIndex(MidiType inType)
+    {
+        return inType < SystemExclusive ? unsigned((inType >> 4) & 0x07)
+                                        : 7u + (inType & 0x0f);
+    }
+
+    inline unsigned long getMessagesReceived(MidiType inType) const
+    {
+        return messagesReceived[getTypeIndex(inType)];
+    }
+
+    unsigned long bytesReceived;                ///< Read from the transport
+    unsigned long messagesReceived[NumTypes];   ///< Parsed, before filtering (SysEx: per chunk)
+    unsigned long parseErrors;                  ///< Each time ErrorParse was set
+    unsigned long undefinedBytes;               ///< Ignored Undefined_FD bytes
+    unsigned long filteredMessages;             ///< Rejected by the input channel / masks
+    unsigned long runningStatusReceived;        ///< Messages received without status byte
+    unsigned long runningStatusSent;            ///< Messages sent without status byte
+    unsigned long sendMicros;                   ///< Time spent writing to the transport
+};
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Counts the traffic of a MidiInterface, which derives from it.
+ The disabled version is empty and takes no space, and its counting methods
+ compile to nothing.
+ */
+template<bool Enabled>
+class StatisticsCounters
+{
+public:
+    inline StatisticsCounters()
+    {
+        resetStatistics();
+    }
+
+    /*! Snapshot of the counters since the last reset. */
+    inline MidiStatistics getStatistics() const
+    {
+        return mStatistics;
+    }
+
+    /*! Snapshot of the counters, which are then reset. */
+    inline MidiStatistics takeStatistics()
+    {
+        const MidiStatistics statistics = mStatistics;
+        resetStatistics();
+        return statistics;
+    }
+
+    inline void resetStatistics()
+    {
+        mStatistics = MidiStatistics();
+    }
+
+protected:
+    inline void countByteReceived()                 { mStatistics.bytesReceived++; }
+    inline void countMessageReceived(MidiType inType)
+    {
+        mStatistics.messagesReceived[MidiStatistics::getTypeIndex(inType)]++;
+    }
+    inline void countParseError()                   { mStatistics.parseErrors++; }
+    inline void countUndefinedByte()                { mStatistics.undefinedBytes++; }
+    inline void countFilteredMessage()              { mStatistics.filteredMessages++; }
+    inline void countRunningStatusReceived()        { mStatistics.runningStatusReceived++; }
+    inline void countRunningStatusSent()            { mStatistics.runningStatusSent++; }
+    inline void countSendTime(unsigned long inMicros) { mStatistics.sendMicros += inMicros; }
+
+private:
+    MidiStatistics mStatistics;
+};
+
+/*! Disabled statistics: nothing is counted, snapshots are all zeros. */
+template<>
+class StatisticsCounters<false>
+{
+public:
+    inline MidiStatistics getStatistics() const
+    {
+        return MidiStatistics();
+    }
+
+    inline MidiStatistics takeStatistics()
+    {
+        return getStatistics();
+    }
+
+    inline void resetStatistics() {}
+
+protected:
+    inline void countByteReceived() {}
+    inline void countMessageReceived(MidiType) {}
+    inline void countParseError() {}
+    inline void countUndefinedByte() {}
+    inline void countFilteredMessage() {}
+    inline void countRunningStatusReceived() {}
+    inline void countRunningStatusSent() {}
+    inline void countSendTime(unsigned long) {}
+};
+
+END_MIDI_NAMESPACE
@@ -0,0 +1,199 @@
+/*!
+ *  @file       midi_SysEx.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - System Exclusive
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+/*! Pack and unpack full 7-byte groups with 32-bit word operations rather
+ than one bit at a time. Defaults to off on 8-bit AVR, where the per-byte
+ loop is cheaper than 32-bit multiplies. Define it to 0 or 1 to override.
+ */
+#ifndef MIDI_SYSEX_WORD_CODEC
+#   if defined(__AVR__)
+#       define MIDI_SYSEX_WORD_CODEC 0
+#   else
+#       define MIDI_SYSEX_WORD_CODEC 1
+#   endif
+#endif
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Streaming 8-bit to 7-bit SysEx encoder, see doc/sysex-codec.md.
+
+ Data can be fed in slices of any size: the bytes of an incomplete 7-byte
+ group are kept until the next call (or finish()), so a large payload can
+ be encoded piece by piece without staging it in RAM.
+ */
+class SysExEncoder
+{
+public:
+    explicit SysExEncoder(bool inFlipHeaderBits = false);
+
+public:
+    /*! Encode inLength bytes, only complete groups are written.
+     outSysEx must have room for ((inLength + 6) / 7) * 8 bytes.
+     \return The number of bytes written to outSysEx.
+     */
+    unsigned encode(const byte* inData, unsigned inLength, byte* outSysEx);
+
+    /*! Write the last (incomplete) group, up to 8 bytes.
+     \return The number of bytes written to outSysEx.
+     */
+    unsigned finish(byte* outSysEx);
+
+    inline void reset()
+    {
+        mCount = 0;
+    }
+
+private:
+    unsigned encodeGroup(const byte* inGroup, byte inSize, byte* outSysEx) const;
+
+private:
+    byte mGroup[7];
+    byte mCount;
+    bool mFlipHeaderBits;
+};
+
+/*! \brief Streaming 7-bit to 8-bit SysEx decoder, see doc/sysex-codec.md.
+
+ Encoded data can be fed in slices of any size, the position in the
+ current 8-byte group is kept between calls.
+ */
+class SysExDecoder
+{
+public:
+    explicit SysExDecoder(bool inFlipHeaderBits = false);
+
+public:
+    /*! Decode inLength bytes, outData must have room for inLength bytes.
+     \return The number of bytes written to outData.
+     */
+    unsigned decode(const byte* inSysEx, unsigned inLength, byte* outData);
+
+    inline void reset()
+    {
+        mIndex = 0;
+    }
+
+private:
+    byte mHeader;
+    byte mIndex;
+    bool mFlipHeaderBits;
+};
+
+unsigned encodeSysEx(const byte* inData,
+                     byte* outSysEx,
+                     unsigned inLength,
+                     bool inFlipHeaderBits = false);
+unsigned decodeSysEx(const byte* inSysEx,
+                     byte* outData,
+                     unsigned inLength,
+                     bool inFlipHeaderBits = false);
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Receives SysEx frames into a caller-owned buffer, in chunks.
+ @see DefaultSettings::UseSysExInput
+
+ Bytes are written straight from the parser, with no intermediate frame
+ buffer. A chunk is complete when the buffer is full or when the End of
+ Exclusive is received: the first chunk starts with SystemExclusiveStart,
+ the last one ends with SystemExclusiveEnd.
+ */
+template<bool Enabled>
+class SysExInput
+{
+public:
+    inline SysExInput()
+        : mBuffer(nullptr)
+        , mSize(0)
+        , mIndex(0)
+    {
+    }
+
+    inline void setBuffer(byte* inBuffer, unsigned inSize)
+    {
+        mBuffer = inBuffer;
+        mSize   = inSize;
+        mIndex  = 0;
+    }
+
+    inline bool isReady() const
+    {
+        return mBuffer != nullptr && mSize != 0;
+    }
+
+    /*! Returns true when the chunk is complete. */
+    inline bool write(byte inByte)
+    {
+        mBuffer[mIndex++] = inByte;
+        return mIndex >= mSize || inByte == SystemExclusiveEnd;
+    }
+
+    inline byte* getData()
+    {
+        return mBuffer;
+    }
+
+    inline const byte* getData() const
+    {
+        return mBuffer;
+    }
+
+    inline unsigned getLength() const
+    {
+        return mIndex;
+    }
+
+    /*! Start a new chunk, the buffer content is left untouched. */
+    inline void reset()
+    {
+        mIndex = 0;
+    }
+
+private:
+    byte*       mBuffer;
+    unsigned    mSize;
+    unsigned    mIndex;
+};
+
+/*! Disabled SysEx input: SysEx frames are parse errors. */
+template<>
+class SysExInput<false>
+{
+public:
+    inline void setBuffer(byte*, unsigned) {}
+    inline bool isReady() const { return false; }
+    inline bool write(byte) { return false; }
+    inline byte* getData() { return nullptr; }
+    inline const byte* getData() const { return nullptr; }
+    inline unsigned getLength() const { return 0; }
+    inline void reset() {}
+};
+
+END_MIDI_NAMESPACE
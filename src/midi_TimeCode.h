@@ -0,0 +1,319 @@
+/*!
+ *  @file       midi_TimeCode.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - MIDI Time Code decoder
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Frame rates of MIDI Time Code, as coded in the hours. */
+struct TimeCodeRate
+{
+    enum Type
+    {
+        Fps24       = 0,    ///< 24 frames per second (film).
+        Fps25       = 1,    ///< 25 frames per second (PAL / SECAM).
+        Fps30Drop   = 2,    ///< 29.97 frames per second, drop-frame numbering (NTSC).
+        Fps30       = 3,    ///< 30 frames per second.
+    };
+};
+
+/*! \brief A time code position, as hours:minutes:seconds:frames. */
+struct TimeCode
+{
+    byte hours;
+    byte minutes;
+    byte seconds;
+    byte frames;
+    TimeCodeRate::Type rate;
+};
+
+/*! \brief Number of frames from 00:00:00:00 to inTimeCode.
+ With Fps30Drop, the frame numbers 0 and 1 skipped at the start of each
+ minute (except every 10th) are not counted.
+ */
+inline unsigned long timeCodeToFrames(const TimeCode& inTimeCode)
+{
+    static const byte framesPerSecond[4] = { 24, 25, 30, 30 };
+    const unsigned long minutes = inTimeCode.hours * 60UL + inTimeCode.minutes;
+    const unsigned long frames = (minutes * 60 + inTimeCode.seconds)
+                               * framesPerSecond[inTimeCode.rate & 3] + inTimeCode.frames;
+    if (inTimeCode.rate != TimeCodeRate::Fps30Drop)
+        return frames;
+
+    return frames - 2 * (minutes - minutes / 10);
+}
+
+/*! \brief Time code of the frame inFrames frames after 00:00:00:00. */
+inline TimeCode framesToTimeCode(unsigned long inFrames, TimeCodeRate::Type inRate)
+{
+    static const byte framesPerSecond[4] = { 24, 25, 30, 30 };
+    if (inRate == TimeCodeRate::Fps30Drop)
+    {
+        // 17982 frames per 10 minutes: the first minute has 1800 frames,
+        // the 9 others 1798.
+        const unsigned long tens = inFrames / 17982;
+        const unsigned long rest = inFrames % 17982;
+        inFrames += 18 * tens + (rest < 2 ? 0 : 2 * ((rest - 2) / 1798));
+    }
+
+    const byte rate = framesPerSecond[inRate & 3];
+    const unsigned long seconds = inFrames / rate;
+    TimeCode timeCode;
+    timeCode.frames  = byte(inFrames % rate);
+    timeCode.seconds = byte(seconds % 60);
+    timeCode.minutes = byte(seconds / 60 % 60);
+    timeCode.hours   = byte(seconds / 3600 % 24);
+    timeCode.rate    = inRate;
+    return timeCode;
+}
+
+// -----------------------------------------------------------------------------
+
+/*! \brief Assembles received MIDI Time Code, see DefaultSettings::UseTimeCodeDecoder.
+
+ The eight Quarter Frame pieces are gathered as they come, each one moves
+ the position by a quarter frame, and the time code they carry is checked
+ against it once all eight have been received (after piece 7 when running
+ forward, piece 0 in reverse). Pieces out of sequence or a time code that
+ disagrees with the position relock the decoder. Full Frame messages
+ (Universal Real Time SysEx F0 7F dd 01 01 hh mm ss ff F7) locate it.
+
+ The position of piece k of the time code F is F * 4 + k quarter frames,
+ in both directions. Drift compares the time between the Quarter Frames
+ to the frame rate, since the last relock.
+ */
+template<bool Enabled>
+class TimeCodeDecoder
+{
+public:
+    inline TimeCodeDecoder()
+    {
+        reset();
+    }
+
+    inline void reset()
+    {
+        mQuarters       = 0;
+        mLastQuarter    = 0;
+        mDrift          = 0;
+        mRate           = TimeCodeRate::Fps30;
+        mPiece          = 0;
+        mSequence       = 0;
+        mLocked         = false;
+        mReverse        = false;
+        for (byte i = 0; i < 8; ++i)
+            mNibbles[i] = 0;
+    }
+
+    /*! Feed a received message, with the time (in us) of its arrival. */
+    inline void process(MidiType inType, DataByte inData, unsigned long inMicros)
+    {
+        if (inType == TimeCodeQuarterFrame)
+            processQuarterFrame(inData, inMicros);
+        else if (inType == SystemReset)
+            reset();
+    }
+
+    /*! Feed a received SysEx frame (from F0 to F7), ignored unless it is
+     an MTC Full Frame.
+     */
+    inline void processFullFrame(const byte* inData, unsigned inLength, unsigned long inMicros)
+    {
+        if (inLength != 10 || inData[0] != 0xf0 || inData[1] != 0x7f
+            || inData[3] != 0x01 || inData[4] != 0x01 || inData[9] != 0xf7)
+            return;
+
+        TimeCode timeCode;
+        timeCode.hours   = inData[5] & 0x1f;
+        timeCode.minutes = inData[6] & 0x3f;
+        timeCode.seconds = inData[7] & 0x3f;
+        timeCode.frames  = inData[8] & 0x1f;
+        timeCode.rate    = TimeCodeRate::Type((inData[5] >> 5) & 3);
+
+        mRate        = byte(timeCode.rate);
+        mQuarters    = timeCodeToFrames(timeCode) * 4;
+        mLastQuarter = inMicros;
+        mDrift       = 0;
+        mSequence    = 0;
+        mLocked      = true;
+    }
+
+public:
+    /*! True once a full time code has been received. */
+    inline bool isLocked() const
+    {
+        return mLocked;
+    }
+
+    inline bool isReverse() const
+    {
+        return mReverse;
+    }
+
+    /*! True if Quarter Frames came in the last frame before inMicros. */
+    inline bool isRunning(unsigned long inMicros) const
+    {
+        return mLocked && mSequence > 0
+            && inMicros - mLastQuarter < getQuarterPeriod12() / 3;
+    }
+
+    inline TimeCodeRate::Type getRate() const
+    {
+        return TimeCodeRate::Type(mRate);
+    }
+
+    /*! Frame of the last Quarter Frame received. */
+    inline TimeCode getTimeCode() const
+    {
+        return framesToTimeCode(mQuarters / 4, getRate());
+    }
+
+    /*! Position at inMicros, in 1/256 of a frame from 00:00:00:00.
+     Interpolated from the last Quarter Frame with the frame rate, up to the
+     next one: the position stops when the time code does.
+     */
+    inline unsigned long getPosition(unsigned long inMicros) const
+    {
+        if (!mLocked)
+            return 0;
+
+        unsigned long fraction = 0;
+        if (mSequence > 0)
+        {
+            const unsigned long elapsed = inMicros - mLastQuarter;
+            const unsigned long period12 = getQuarterPeriod12();
+            fraction = elapsed < period12 / 12 ? elapsed * 12 * 64 / period12 : 63;
+        }
+        const unsigned long position = mQuarters << 6;
+        return mReverse ? position - fraction : position + fraction;
+    }
+
+    /*! Time (in us) the Quarter Frames are late on the local clock, since
+     the last relock. Negative if the time code runs faster than the clock.
+     */
+    inline long getDrift() const
+    {
+        return mDrift / 12;
+    }
+
+private:
+    inline void processQuarterFrame(DataByte inData, unsigned long inMicros)
+    {
+        const byte piece = (inData >> 4) & 7;
+        const bool forward = piece == ((mPiece + 1) & 7);
+        const bool reverse = piece == ((mPiece - 1) & 7);
+        mNibbles[piece] = inData & 0x0f;
+        mPiece = piece;
+
+        const bool late = inMicros - mLastQuarter >= getQuarterPeriod12() / 3;
+        if ((!forward && !reverse) || (mSequence > 0 && (reverse != mReverse || late)))
+        {
+            // Lost a piece, changed direction or restarted: wait for 8 in a row.
+            mReverse  = reverse;
+            mSequence = 1;
+            mDrift    = 0;
+            mLastQuarter = inMicros;
+            return;
+        }
+
+        if (mSequence > 0 && mLocked)
+        {
+            mQuarters += reverse ? -1 : 1;
+            mDrift += long((inMicros - mLastQuarter) * 12 - getQuarterPeriod12());
+        }
+        mReverse = reverse;
+        mLastQuarter = inMicros;
+        if (mSequence < 8)
+            mSequence++;
+
+        if (mSequence == 8 && piece == (reverse ? 0 : 7))
+            relock(piece);
+    }
+
+    // Takes the complete time code, unless it matches the position.
+    inline void relock(byte inPiece)
+    {
+        TimeCode timeCode;
+        timeCode.frames  = byte(mNibbles[0] | (mNibbles[1] & 0x01) << 4);
+        timeCode.seconds = byte(mNibbles[2] | (mNibbles[3] & 0x03) << 4);
+        timeCode.minutes = byte(mNibbles[4] | (mNibbles[5] & 0x03) << 4);
+        timeCode.hours   = byte(mNibbles[6] | (mNibbles[7] & 0x01) << 4);
+        timeCode.rate    = TimeCodeRate::Type((mNibbles[7] >> 1) & 3);
+
+        const unsigned long quarters = timeCodeToFrames(timeCode) * 4 + inPiece;
+        if (mLocked && quarters == mQuarters && timeCode.rate == getRate())
+            return;
+
+        mQuarters = quarters;
+        mRate     = byte(timeCode.rate);
+        mDrift    = 0;
+        mLocked   = true;
+    }
+
+    // Duration of a quarter frame, in 1/12 us.
+    inline unsigned long getQuarterPeriod12() const
+    {
+        static const unsigned long periods[4] = {
+            125000, // 1 / 96 s
+            120000, // 1 / 100 s
+            100100, // 1.001 / 120 s
+            100000, // 1 / 120 s
+        };
+        return periods[mRate & 3];
+    }
+
+private:
+    unsigned long       mQuarters;
+    unsigned long       mLastQuarter;
+    long                mDrift;       // In 1/12 us
+    byte                mRate;
+    byte                mNibbles[8];
+    byte                mPiece;
+    byte                mSequence;
+    bool                mLocked;
+    bool                mReverse;
+};
+
+/*! Time code not decoded. */
+template<>
+class TimeCodeDecoder<false>
+{
+public:
+    inline void reset() {}
+    inline void process(MidiType, DataByte, unsigned long) {}
+    inline void processFullFrame(const byte*, unsigned, unsigned long) {}
+    inline bool isLocked() const                            { return false; }
+    inline bool isReverse() const                           { return false; }
+    inline bool isRunning(unsigned long) const              { return false; }
+    inline TimeCodeRate::Type getRate() const               { return TimeCodeRate::Fps30; }
+    inline TimeCode getTimeCode() const                     { return TimeCode(); }
+    inline unsigned long getPosition(unsigned long) const   { return 0; }
+    inline long getDrift() const                            { return 0; }
+};
+
+END_MIDI_NAMESPACE
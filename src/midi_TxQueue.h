@@ -0,0 +1,112 @@
+/*!
+ *  @file       midi_TxQueue.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - Output message queue
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+
+BEGIN_MIDI_NAMESPACE
+
+/*! \brief Fixed capacity queue of outgoing messages, see DefaultSettings::TxQueueSize.
+
+ Each message is stored as its full status byte and two data bytes, running
+ status is applied when the queue is flushed. Indices are single bytes, with
+ acquire / release ordering (see MIDI_RING_LOAD_ACQUIRE), so that one context
+ (eg: a timer ISR, or another core) can push while another one pops, without
+ locking.
+ */
+template<unsigned Size>
+class TxQueue
+{
+public:
+    static_assert(Size < 255, "TxQueueSize must be smaller than 255");
+
+    inline TxQueue()
+        : mHead(0)
+        , mTail(0)
+    {
+    }
+
+    inline bool isEmpty() const
+    {
+        return MIDI_RING_LOAD_ACQUIRE(mHead) == mTail;
+    }
+
+    /*! Returns false (and drops the message) if the queue is full. */
+    inline bool push(StatusByte inStatus, DataByte inData1, DataByte inData2)
+    {
+        const byte head = mHead;
+        const byte next = byte(head + 1u < sNumSlots ? head + 1u : 0u);
+        if (next == MIDI_RING_LOAD_ACQUIRE(mTail))
+            return false;
+
+        byte* slot = mData + head * 3;
+        slot[0] = inStatus;
+        slot[1] = inData1;
+        slot[2] = inData2;
+        MIDI_RING_STORE_RELEASE(mHead, next);
+        return true;
+    }
+
+    /*! Oldest message, as status + 2 data bytes. Queue must not be empty. */
+    inline const byte* front() const
+    {
+        return mData + mTail * 3;
+    }
+
+    inline void pop()
+    {
+        const byte tail = mTail;
+        MIDI_RING_STORE_RELEASE(mTail, byte(tail + 1u < sNumSlots ? tail + 1u : 0u));
+    }
+
+    inline void clear()
+    {
+        MIDI_RING_STORE_RELEASE(mTail, byte(MIDI_RING_LOAD_ACQUIRE(mHead)));
+    }
+
+private:
+    // One slot is kept free to tell a full queue from an empty one.
+    static const unsigned sNumSlots = Size + 1;
+
+    byte mData[sNumSlots * 3];
+    volatile byte mHead;
+    volatile byte mTail;
+};
+
+/*! Disabled queue: messages are sent immediately. */
+template<>
+class TxQueue<0>
+{
+public:
+    inline bool isEmpty() const { return true; }
+    inline bool push(StatusByte, DataByte, DataByte) { return false; }
+    inline const byte* front() const { return nullptr; }
+    inline void pop() {}
+    inline void clear() {}
+};
+
+END_MIDI_NAMESPACE
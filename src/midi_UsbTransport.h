@@ -0,0 +1,343 @@
+/*!
+ *  @file       midi_UsbTransport.h
+ *  Project     Arduino MIDI Library
+ *  @brief      MIDI Library for the Arduino - USB-MIDI event packet transport
+ *  @date       14/10/26
+ *  @license    MIT - Copyright (c) 2015 Francois Best
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "midi_Defs.h"
+#include "midi_Platform.h"
+
+BEGIN_MIDI_NAMESPACE
+
+struct DefaultUsbSettings
+{
+    /*! Virtual cable (0 to 15) of the packets sent.
+    Received packets on other cables are ignored.
+    */
+    static const byte Cable = 0;
+
+    /*! Size of the bulk endpoint frames, 64 bytes (16 packets) on full-speed USB. */
+    static const unsigned FrameSize = 64;
+
+    /*! How long (in us) a frame waits for more packets before it is submitted.\n
+    A full frame is submitted right away. Set to 0 to submit each message on
+    its own (one USB transaction per message, about 1000 messages/s at most).
+    */
+    static const unsigned long FlushPeriod = 1000;
+};
+
+/*! \brief USB-MIDI (class compliant) transport, over bulk endpoints.
+
+ Outgoing messages are packed into 4-byte USB-MIDI event packets (cable
+ number & code index number, then up to 3 MIDI bytes), which are gathered
+ into a frame of Settings::FrameSize bytes. The frame is submitted when full,
+ or FlushPeriod us after its first packet. The deadline is checked by
+ service(), which MidiInterface::flush() and read() call: a sketch that only
+ sends must call MIDI.flush() in its loop. Running status is expanded,
+ USB-MIDI has none.
+
+ Received frames are unpacked whole into a buffer, that MidiInterface then
+ parses as a byte stream.
+
+ The UsbDevice adapts the USB stack:
+ \code{.cpp}
+ struct UsbDevice
+ {
+     void begin();
+     // Submit a frame to the bulk IN endpoint, false if it is busy.
+     bool writeFrame(const byte* inFrame, unsigned inSize);
+     // Fetch a frame from the bulk OUT endpoint, returns its size (0 if none).
+     unsigned readFrame(byte* outFrame, unsigned inMaxSize);
+ };
+ \endcode
+ */
+template<class UsbDevice,
+         class _Settings = DefaultUsbSettings,
+         class Platform = DefaultPlatform>
+class UsbMIDI
+{
+    typedef _Settings Settings;
+
+public:
+    static_assert(Settings::FrameSize >= 4 && Settings::FrameSize % 4 == 0,
+                  "FrameSize must be a multiple of 4");
+    static_assert(Settings::Cable < 16, "Cable must be between 0 and 15");
+
+    static const unsigned PacketSize = 4;
+    static const unsigned PacketsPerFrame = Settings::FrameSize / PacketSize;
+
+    inline UsbMIDI(UsbDevice& inDevice)
+        : mDevice(inDevice)
+        , mTxSize(0)
+        , mTxDeadline(0)
+        , mTxStatus(0)
+        , mTxIndex(0)
+        , mTxLength(0)
+        , mTxSysEx(false)
+        , mRxSize(0)
+        , mRxIndex(0)
+        , mDroppedPackets(0)
+    {
+    }
+
+public:
+    inline void begin()
+    {
+        mDevice.begin();
+        mTxSize   = 0;
+        mTxStatus = 0;
+        mTxIndex  = 0;
+        mTxSysEx  = false;
+        mRxSize   = 0;
+        mRxIndex  = 0;
+    }
+
+    inline bool beginTransmission(MidiType)
+    {
+        return true;
+    }
+
+    inline void write(byte inByte)
+    {
+        encode(inByte);
+    }
+
+    inline void write(const byte* inData, size_t inSize)
+    {
+        for (size_t i = 0; i < inSize; ++i)
+            encode(inData[i]);
+    }
+
+    inline void endTransmission()
+    {
+        if (Settings::FlushPeriod == 0)
+            flush();
+    }
+
+    inline byte read()
+    {
+        return mRxData[mRxIndex++];
+    }
+
+    inline unsigned available()
+    {
+        service();
+
+        if (mRxIndex == mRxSize)
+            receiveFrame();
+        return mRxSize - mRxIndex;
+    }
+
+    /*! MIDI bytes that surely fit in the current frame (3 per packet left). */
+    inline int availableForWrite() const
+    {
+        return int(PacketsPerFrame - mTxSize / PacketSize) * 3;
+    }
+
+public:
+    /*! \brief Submit the pending packets now.
+     \return false if the endpoint is busy, they are then kept for later.
+     */
+    inline bool flush()
+    {
+        if (mTxSize == 0)
+            return true;
+        if (!mDevice.writeFrame(mTxFrame, mTxSize))
+            return false;
+
+        mTxSize = 0;
+        return true;
+    }
+
+    /*! Submit the pending packets if FlushPeriod has passed since the first one. */
+    inline void service()
+    {
+        if (mTxSize > 0 && long(Platform::nowMicros() - mTxDeadline) >= 0)
+            flush();
+    }
+
+    /*! Packets lost because the frame was full and the endpoint busy. */
+    inline unsigned getDroppedPackets() const
+    {
+        return mDroppedPackets;
+    }
+
+public:
+    /*! Code index number of a complete message, from its status and length. */
+    static inline byte getCodeIndex(StatusByte inStatus, byte inLength)
+    {
+        if (inStatus < SystemExclusiveStart)
+            return byte(inStatus >> 4);
+
+        return inLength == 1 ? 0x5 : inLength == 2 ? 0x2 : 0x3;
+    }
+
+    /*! MIDI bytes carried by a packet, from its code index number. */
+    static inline byte getPacketLength(byte inCodeIndex)
+    {
+        return sPacketLengths[inCodeIndex & 0x0f];
+    }
+
+private:
+    // Misc & cable events (code index numbers 0 & 1) are reserved, they carry nothing.
+    static const byte sPacketLengths[16];
+
+    inline void encode(byte inByte)
+    {
+        const byte info = getStatusInfo(inByte);
+
+        if (info & StatusInfo::RealTime)
+        {
+            pushPacket(0xf, inByte, 0, 0);
+            return;
+        }
+        if (info & StatusInfo::Ignored)
+            return;
+
+        if (inByte == SystemExclusiveEnd)
+        {
+            if (mTxSysEx)
+            {
+                mTxBytes[mTxIndex++] = inByte;
+                for (byte i = mTxIndex; i < 3; ++i)
+                    mTxBytes[i] = 0;
+                pushPacket(byte(0x4 + mTxIndex), mTxBytes[0], mTxBytes[1], mTxBytes[2]);
+                mTxSysEx = false;
+                mTxIndex = 0;
+            }
+            return;
+        }
+
+        if (inByte & 0x80)
+        {
+            // Any other status aborts an unfinished message.
+            mTxSysEx  = inByte == SystemExclusiveStart;
+            mTxStatus = (info & StatusInfo::RunningStatus) ? inByte : 0;
+            mTxLength = info & StatusInfo::LengthMask;
+            mTxBytes[0] = inByte;
+            mTxBytes[1] = 0;
+            mTxBytes[2] = 0;
+            mTxIndex = 1;
+            if (mTxLength == 1)
+                completeMessage();
+            else if (mTxLength == 0 && !mTxSysEx)
+                mTxIndex = 0; // Undefined status, its data is dropped
+            return;
+        }
+
+        if (mTxSysEx)
+        {
+            mTxBytes[mTxIndex++] = inByte;
+            if (mTxIndex == 3)
+            {
+                pushPacket(0x4, mTxBytes[0], mTxBytes[1], mTxBytes[2]);
+                mTxIndex = 0;
+            }
+            return;
+        }
+
+        if (mTxIndex == 0)
+        {
+            // Running status: USB-MIDI packets always carry the status.
+            if (mTxStatus == 0)
+                return;
+            mTxBytes[0] = mTxStatus;
+            mTxBytes[2] = 0;
+            mTxLength = getStatusInfo(mTxStatus) & StatusInfo::LengthMask;
+            mTxIndex = 1;
+        }
+        mTxBytes[mTxIndex++] = inByte;
+        if (mTxIndex == mTxLength)
+            completeMessage();
+    }
+
+    inline void completeMessage()
+    {
+        pushPacket(getCodeIndex(mTxBytes[0], mTxLength), mTxBytes[0], mTxBytes[1], mTxBytes[2]);
+        mTxIndex = 0;
+    }
+
+    inline void pushPacket(byte inCodeIndex, byte inByte0, byte inByte1, byte inByte2)
+    {
+        if (mTxSize == Settings::FrameSize && !flush())
+        {
+            mDroppedPackets++;
+            return;
+        }
+        if (mTxSize == 0)
+            mTxDeadline = Platform::nowMicros() + Settings::FlushPeriod;
+
+        byte* packet = mTxFrame + mTxSize;
+        packet[0] = byte(Settings::Cable << 4 | inCodeIndex);
+        packet[1] = inByte0;
+        packet[2] = inByte1;
+        packet[3] = inByte2;
+        mTxSize += PacketSize;
+
+        if (mTxSize == Settings::FrameSize)
+            flush();
+    }
+
+    inline void receiveFrame()
+    {
+        byte frame[Settings::FrameSize];
+        const unsigned size = mDevice.readFrame(frame, Settings::FrameSize);
+
+        mRxSize  = 0;
+        mRxIndex = 0;
+        for (unsigned i = 0; i + PacketSize <= size; i += PacketSize)
+        {
+            const byte* packet = frame + i;
+            if ((packet[0] >> 4) != Settings::Cable)
+                continue;
+
+            const byte length = getPacketLength(packet[0]);
+            for (byte j = 0; j < length; ++j)
+                mRxData[mRxSize++] = packet[1 + j];
+        }
+    }
+
+private:
+    UsbDevice&      mDevice;
+    byte            mTxFrame[Settings::FrameSize];
+    unsigned        mTxSize;
+    unsigned long   mTxDeadline;
+    byte            mTxBytes[3];
+    StatusByte      mTxStatus;
+    byte            mTxIndex;
+    byte            mTxLength;
+    bool            mTxSysEx;
+    byte            mRxData[PacketsPerFrame * 3];
+    unsigned        mRxSize;
+    unsigned        mRxIndex;
+    unsigned        mDroppedPackets;
+};
+
+template<class UsbDevice, class Settings, class Platform>
+const byte UsbMIDI<UsbDevice, Settings, Platform>::sPacketLengths[16] = {
+    0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1
+};
+
+END_MIDI_NAMESPACE
@@ -26,7 +26,7 @@
  */
  #pragma once
 
-#include "midi_Namespace.h"
+#include "midi_Defs.h"
 
 BEGIN_MIDI_NAMESPACE
 
@@ -76,6 +76,11 @@ public:
 		mSerial.write(value);
 	};
 
+	void write(const byte* buffer, size_t size)
+	{
+        write(buffer, size, BoolTag<HasBulkWrite<SerialPort>::value>());
+	};
+
 	void endTransmission()
 	{
 	};
@@ -90,7 +95,35 @@ public:
         return mSerial.available();
 	};
 
+    /*! Bytes that can be written without blocking, -1 if the port can't tell. */
+    int availableForWrite()
+    {
+        return availableForWrite(BoolTag<HasAvailableForWrite<SerialPort>::value>());
+    }
+
 private:
+    void write(const byte* buffer, size_t size, BoolTag<true>)
+    {
+        mSerial.write(buffer, size);
+    }
+
+    void write(const byte* buffer, size_t size, BoolTag<false>)
+    {
+        for (size_t i = 0; i < size; ++i)
+            mSerial.write(buffer[i]);
+    }
+
+    int availableForWrite(BoolTag<true>)
+    {
+        return int(mSerial.availableForWrite());
+    }
+
+    int availableForWrite(BoolTag<false>)
+    {
+        return -1;
+    }
+
+protected:
     SerialPort& mSerial;
 };
 
@@ -0,0 +1,337 @@
+// Host throughput benchmarks for read() and send*(), against SerialMock,
+// and for MidiParser on the same streams.
+// Prints one JSON object per line, to track results across releases:
+// {"benchmark":"read/noteFlood","settings":"default","bytes":...,
+//  "messages":...,"seconds":...,"bytesPerSecond":...,"nsPerMessage":...}
+//
+// Usage: benchmarks [minimum milliseconds per benchmark, default 200]
+
+#include <src/MIDILite.h>
+#include <src/midi_Parser.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef std::vector<byte> Stream;
+
+static const int sBufferSize = 4096;
+typedef test_mocks::SerialMock<sBufferSize> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+
+static double gMinimumSeconds = 0.2;
+
+// Keeps the compiler from optimising the work away.
+static volatile unsigned gSink = 0;
+
+// -----------------------------------------------------------------------------
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+};
+
+struct RunningStatusSettings : public midi::DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+};
+
+struct NoteOnSettings : public RunningStatusSettings
+{
+    static const bool SendNoteOffAsNullVelocityNoteOn = true;
+};
+
+struct QueueSettings : public RunningStatusSettings
+{
+    static const unsigned TxQueueSize = 32;
+};
+
+struct CoalescingSettings : public midi::DefaultSettings
+{
+    static const unsigned CoalescedMessages = 16;
+};
+
+struct StatisticsSettings : public midi::DefaultSettings
+{
+    static const bool UseStatistics = true;
+};
+
+struct MultiByteSettings : public midi::DefaultSettings
+{
+    static const bool Use1ByteParsing = false;
+};
+
+// -----------------------------------------------------------------------------
+
+void report(const char* inBenchmark,
+            const char* inSettings,
+            unsigned long long inBytes,
+            unsigned long long inMessages,
+            double inSeconds)
+{
+    const double seconds = inSeconds > 0 ? inSeconds : 1e-9;
+    printf("{\"benchmark\":\"%s\",\"settings\":\"%s\",\"bytes\":%llu,\"messages\":%llu,"
+           "\"seconds\":%.6f,\"bytesPerSecond\":%.0f,\"nsPerMessage\":%.2f}\n",
+           inBenchmark, inSettings, inBytes, inMessages, seconds,
+           double(inBytes) / seconds,
+           inMessages ? seconds * 1e9 / double(inMessages) : 0.0);
+}
+
+// Repeats a traffic pattern to fill most of the mock RX buffer.
+Stream repeat(const Stream& inPattern)
+{
+    Stream stream;
+    while (stream.size() + inPattern.size() < unsigned(sBufferSize))
+        stream.insert(stream.end(), inPattern.begin(), inPattern.end());
+    return stream;
+}
+
+template<class Interface>
+void benchRead(const char* inBenchmark,
+               const char* inSettings,
+               const Stream& inPattern,
+               midi::Channel inChannel,
+               bool inBatch = false)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    Interface midi(transport);
+    static byte sysEx[256];
+    midi.setSysExBuffer(sysEx, sizeof(sysEx));
+    midi.begin(inChannel);
+
+    const Stream stream = repeat(inPattern);
+    midi::Message messages[16];
+    unsigned long long bytes = 0;
+    unsigned long long numMessages = 0;
+    Clock::duration elapsed(0);
+
+    while (std::chrono::duration<double>(elapsed).count() < gMinimumSeconds)
+    {
+        serial.mRxBuffer.write(&stream[0], int(stream.size()));
+
+        const Clock::time_point start = Clock::now();
+        if (inBatch)
+        {
+            while (serial.mRxBuffer.getLength() > 0)
+                numMessages += midi.readBatch(messages, 16);
+        }
+        else
+        {
+            while (serial.mRxBuffer.getLength() > 0)
+                numMessages += midi.read() ? 1 : 0;
+        }
+        elapsed += Clock::now() - start;
+        bytes += stream.size();
+    }
+    gSink = gSink + midi.getData1();
+    report(inBenchmark, inSettings, bytes, numMessages,
+           std::chrono::duration<double>(elapsed).count());
+}
+
+struct CountingSink
+{
+    void operator()(const midi::Message& inMessage)
+    {
+        mData1 += inMessage.data1;
+    }
+
+    unsigned mData1;
+};
+
+void benchParse(const char* inBenchmark, const Stream& inPattern)
+{
+    midi::MidiParser parser;
+    static byte sysEx[256];
+    parser.setSysExBuffer(sysEx, sizeof(sysEx));
+
+    const Stream stream = repeat(inPattern);
+    CountingSink sink = { 0 };
+    unsigned long long bytes = 0;
+    unsigned long long numMessages = 0;
+    Clock::duration elapsed(0);
+
+    while (std::chrono::duration<double>(elapsed).count() < gMinimumSeconds)
+    {
+        const Clock::time_point start = Clock::now();
+        for (unsigned i = 0; i < 16; ++i)
+            numMessages += parser.parse(&stream[0], stream.size(), sink);
+        elapsed += Clock::now() - start;
+        bytes += 16 * stream.size();
+    }
+    gSink = gSink + sink.mData1;
+    report(inBenchmark, "parser", bytes, numMessages,
+           std::chrono::duration<double>(elapsed).count());
+}
+
+// Calls inSend(midi, i) in rounds that fit in the mock TX buffer.
+template<class Interface, class Sender>
+void benchSend(const char* inBenchmark, const char* inSettings, Sender inSend)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    Interface midi(transport);
+    midi.begin();
+
+    static const unsigned numPerRound = 1024;
+    unsigned long long numMessages = 0;
+    unsigned long long bytes = 0;
+    Clock::duration elapsed(0);
+
+    while (std::chrono::duration<double>(elapsed).count() < gMinimumSeconds)
+    {
+        serial.mTxBuffer.clear();
+
+        const Clock::time_point start = Clock::now();
+        for (unsigned i = 0; i < numPerRound; ++i)
+        {
+            inSend(midi, i);
+            if ((i & 15) == 15)
+                midi.flush(); // Keeps the TX queue from overflowing
+        }
+        elapsed += Clock::now() - start;
+
+        numMessages += numPerRound;
+        bytes += unsigned(serial.mTxBuffer.getLength());
+    }
+    report(inBenchmark, inSettings, bytes, numMessages,
+           std::chrono::duration<double>(elapsed).count());
+}
+
+// -----------------------------------------------------------------------------
+
+Stream noteFlood()
+{
+    Stream pattern;
+    for (byte i = 0; i < 16; ++i)
+    {
+        const byte data[6] = { byte(0x90 | i), byte(60 + i), 100, byte(0x80 | i), byte(60 + i), 0 };
+        pattern.insert(pattern.end(), data, data + 6);
+    }
+    return pattern;
+}
+
+Stream runningStatusStream()
+{
+    Stream pattern(1, 0x90);
+    for (byte i = 0; i < 32; ++i)
+    {
+        pattern.push_back(byte(36 + i));
+        pattern.push_back(byte(i & 1 ? 0 : 100));
+    }
+    return pattern;
+}
+
+Stream realTimeInterleaved()
+{
+    Stream pattern;
+    for (byte i = 0; i < 16; ++i)
+    {
+        const byte data[5] = { 0xb0, 0xf8, byte(i), 0xf8, 64 };
+        pattern.insert(pattern.end(), data, data + 5);
+    }
+    return pattern;
+}
+
+Stream sysExHeavy()
+{
+    Stream pattern(1, 0xf0);
+    for (byte i = 0; i < 126; ++i)
+        pattern.push_back(i);
+    pattern.push_back(0xf7);
+    const byte note[3] = { 0x90, 60, 100 };
+    pattern.insert(pattern.end(), note, note + 3);
+    return pattern;
+}
+
+// One message in 16 is on the channel listened to.
+Stream mostlyFiltered()
+{
+    Stream pattern;
+    for (byte i = 0; i < 16; ++i)
+    {
+        const byte data[3] = { byte(0x90 | i), 60, 100 };
+        pattern.insert(pattern.end(), data, data + 3);
+    }
+    return pattern;
+}
+
+template<class Interface>
+void sendNotes(Interface& midi, unsigned i)
+{
+    if (i & 1)
+        midi.sendNoteOff(byte(i >> 1) & 0x7f, 0, 1);
+    else
+        midi.sendNoteOn(byte(i >> 1) & 0x7f, 100, 1);
+}
+
+template<class Interface>
+void sendControllers(Interface& midi, unsigned i)
+{
+    midi.sendControlChange(byte(i & 3), byte(i) & 0x7f, 1);
+}
+
+template<class Interface>
+void sendMixed(Interface& midi, unsigned i)
+{
+    switch (i & 3)
+    {
+        case 0:  midi.sendNoteOn(byte(i) & 0x7f, 100, 2);     break;
+        case 1:  midi.sendPitchBend(int(i & 0xfff), 2);       break;
+        case 2:  midi.sendClock();                            break;
+        default: midi.sendNoteOff(byte(i) & 0x7f, 0, 2);      break;
+    }
+}
+
+template<class Settings>
+void benchSends(const char* inSettings)
+{
+    typedef midi::MidiInterface<Transport, Settings> Interface;
+    benchSend<Interface>("send/notes",       inSettings, sendNotes<Interface>);
+    benchSend<Interface>("send/controllers", inSettings, sendControllers<Interface>);
+    benchSend<Interface>("send/mixed",       inSettings, sendMixed<Interface>);
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        gMinimumSeconds = atof(argv[1]) / 1000.0;
+
+    typedef midi::MidiInterface<Transport> DefaultInterface;
+    typedef midi::MidiInterface<Transport, SysExSettings> SysExInterface;
+    typedef midi::MidiInterface<Transport, MultiByteSettings> MultiByteInterface;
+    typedef midi::MidiInterface<Transport, StatisticsSettings> StatisticsInterface;
+
+    benchRead<DefaultInterface>("read/noteFlood",           "default", noteFlood(),           MIDI_CHANNEL_OMNI);
+    benchRead<DefaultInterface>("read/runningStatus",       "default", runningStatusStream(), MIDI_CHANNEL_OMNI);
+    benchRead<DefaultInterface>("read/realTimeInterleaved", "default", realTimeInterleaved(), MIDI_CHANNEL_OMNI);
+    benchRead<SysExInterface>  ("read/sysExHeavy",          "sysEx",   sysExHeavy(),          MIDI_CHANNEL_OMNI);
+    benchRead<DefaultInterface>("read/mostlyFiltered",      "default", mostlyFiltered(),      1);
+
+    benchRead<MultiByteInterface>("read/noteFlood",         "multiByte",  noteFlood(),  MIDI_CHANNEL_OMNI);
+    benchRead<StatisticsInterface>("read/noteFlood",        "statistics", noteFlood(),  MIDI_CHANNEL_OMNI);
+    benchRead<DefaultInterface>("readBatch/noteFlood",      "default",    noteFlood(),  MIDI_CHANNEL_OMNI, true);
+    benchRead<DefaultInterface>("readBatch/mostlyFiltered", "default",    mostlyFiltered(), 1, true);
+
+    benchParse("parse/noteFlood",           noteFlood());
+    benchParse("parse/runningStatus",       runningStatusStream());
+    benchParse("parse/realTimeInterleaved", realTimeInterleaved());
+    benchParse("parse/sysExHeavy",          sysExHeavy());
+
+    benchSends<midi::DefaultSettings>("default");
+    benchSends<RunningStatusSettings>("runningStatus");
+    benchSends<NoteOnSettings>("runningStatusNoteOn");
+    benchSends<QueueSettings>("txQueue");
+    benchSends<CoalescingSettings>("coalescing");
+    benchSends<StatisticsSettings>("statistics");
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+// Prints the RAM taken by MidiInterface in each footprint configuration.
+// The code size of each configuration is printed by `size` on the
+// footprint-<Config> libraries, see the footprint target.
+
+#include "footprint_Configs.h"
+#include <cstdio>
+
+#define FOOTPRINT_PRINT_SIZEOF(Config)                                          \
+    printf("%-20s %6u %+6d\n", #Config,                                         \
+           unsigned(sizeof(midi::Footprint<midi::Config##Footprint>::Interface)),  \
+           int(sizeof(midi::Footprint<midi::Config##Footprint>::Interface))        \
+         - int(sizeof(midi::Footprint<midi::DefaultFootprint>::Interface)));
+
+int main()
+{
+    printf("%-20s %6s %6s\n", "config", "sizeof", "delta");
+    FOOTPRINT_CONFIGS(FOOTPRINT_PRINT_SIZEOF)
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Instantiates the library for FOOTPRINT_CONFIG (eg: -DFOOTPRINT_CONFIG=TxQueue),
+// with calls to the whole API so that each feature's code gets compiled in.
+
+#include "footprint_Configs.h"
+
+#ifndef FOOTPRINT_CONFIG
+#error "Define FOOTPRINT_CONFIG to one of the FOOTPRINT_CONFIGS"
+#endif
+
+#define FOOTPRINT_CONCAT(A, B)      FOOTPRINT_CONCAT_(A, B)
+#define FOOTPRINT_CONCAT_(A, B)     A##B
+
+BEGIN_MIDI_NAMESPACE
+
+volatile byte FootprintPort::sData = 0;
+volatile unsigned FootprintPort::sAvailable = 0;
+volatile unsigned long FootprintPort::sTime = 0;
+
+END_MIDI_NAMESPACE
+
+typedef midi::Footprint<midi::FOOTPRINT_CONCAT(FOOTPRINT_CONFIG, Footprint)> Footprint;
+
+static midi::FootprintPort sPort;
+static Footprint::Transport sTransport(sPort);
+static Footprint::Interface sMidi(sTransport);
+static byte sSysEx[64];
+
+void footprintSetup()
+{
+    sMidi.setSysExBuffer(sSysEx, sizeof(sSysEx));
+    sMidi.begin(MIDI_CHANNEL_OMNI);
+}
+
+unsigned footprintLoop()
+{
+    midi::Message messages[4];
+    unsigned count = sMidi.readBatch(messages, 4);
+    if (sMidi.read())
+    {
+        count += sMidi.getData1() + sMidi.getClockFollower().getTempo();
+        count += unsigned(sMidi.getTimeCodeDecoder().getPosition(midi::FootprintPort::sTime));
+        sMidi.sendNoteOn(sMidi.getData1(), sMidi.getData2(), sMidi.getChannel());
+    }
+    sMidi.sendNoteOff(60, 0, 1);
+    sMidi.sendControlChange(7, 100, 1);
+    sMidi.sendPitchBend(1000, 1);
+    sMidi.sendProgramChange(3, 1);
+    sMidi.sendClock();
+    sMidi.sendSysEx(sizeof(sSysEx), sSysEx);
+    sMidi.beginRpn(0, 1);
+    sMidi.sendRpnValue(2u, 1);
+    sMidi.endRpn(1);
+    sMidi.send(messages[0]);
+    sMidi.sendAt(midi::FootprintPort::sTime + 1000, messages[1]);
+    sMidi.flush();
+    return count;
+}
@@ -0,0 +1,157 @@
+// Representative configurations for the footprint report, one per feature.
+// Each one extends DefaultSettings (Default) with a single feature, so that
+// its RAM (sizeof) and code (text) cost read as a difference to Default.
+
+#pragma once
+
+#include <src/MIDILite.h>
+
+BEGIN_MIDI_NAMESPACE
+
+#define FOOTPRINT_CONFIGS(X)    \
+    X(Default)                  \
+    X(NoParameterCache)         \
+    X(RunningStatus)            \
+    X(ActiveSensing)            \
+    X(Timestamps)               \
+    X(SysExInput)               \
+    X(TxQueue)                  \
+    X(Coalescing)               \
+    X(StateTracker)             \
+    X(ParameterDecoder)         \
+    X(ControllerPairing)        \
+    X(Statistics)               \
+    X(Scheduler)                \
+    X(ClockFollower)            \
+    X(TimeCode)                 \
+    X(Full)
+
+struct DefaultFootprint : public DefaultSettings
+{
+};
+
+struct NoParameterCacheFootprint : public DefaultSettings
+{
+    static const bool CacheParameterNumbers = false;
+};
+
+struct RunningStatusFootprint : public DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+    static const uint16_t RunningStatusRefreshPeriod = 1000;
+};
+
+struct ActiveSensingFootprint : public DefaultSettings
+{
+    static const bool UseSenderActiveSensing = true;
+    static const bool UseReceiverActiveSensing = true;
+    static const uint16_t SenderActiveSensingPeriodicity = 250;
+};
+
+struct TimestampsFootprint : public DefaultSettings
+{
+    static const bool UseTimestamps = true;
+};
+
+struct SysExInputFootprint : public DefaultSettings
+{
+    static const bool UseSysExInput = true;
+};
+
+struct TxQueueFootprint : public DefaultSettings
+{
+    static const unsigned TxQueueSize = 16;
+};
+
+struct CoalescingFootprint : public DefaultSettings
+{
+    static const unsigned CoalescedMessages = 16;
+};
+
+struct StateTrackerFootprint : public DefaultSettings
+{
+    static const bool UseStateTracker = true;
+    static const unsigned TrackedControllers = 16;
+};
+
+struct ParameterDecoderFootprint : public DefaultSettings
+{
+    static const bool UseParameterDecoder = true;
+};
+
+struct ControllerPairingFootprint : public DefaultSettings
+{
+    static const bool UseControllerPairing = true;
+};
+
+struct StatisticsFootprint : public DefaultSettings
+{
+    static const bool UseStatistics = true;
+};
+
+struct SchedulerFootprint : public DefaultSettings
+{
+    static const unsigned ScheduledMessages = 16;
+};
+
+struct ClockFollowerFootprint : public DefaultSettings
+{
+    static const bool UseClockFollower = true;
+};
+
+struct TimeCodeFootprint : public DefaultSettings
+{
+    static const bool UseTimeCodeDecoder = true;
+};
+
+struct FullFootprint : public DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+    static const uint16_t RunningStatusRefreshPeriod = 1000;
+    static const bool UseSenderActiveSensing = true;
+    static const bool UseReceiverActiveSensing = true;
+    static const uint16_t SenderActiveSensingPeriodicity = 250;
+    static const bool UseTimestamps = true;
+    static const bool UseSysExInput = true;
+    static const unsigned TxQueueSize = 16;
+    static const unsigned CoalescedMessages = 16;
+    static const bool UseStateTracker = true;
+    static const unsigned TrackedControllers = 16;
+    static const bool UseParameterDecoder = true;
+    static const bool UseControllerPairing = true;
+    static const bool UseStatistics = true;
+    static const unsigned ScheduledMessages = 16;
+    static const bool UseClockFollower = true;
+    static const bool UseTimeCodeDecoder = true;
+};
+
+// -----------------------------------------------------------------------------
+
+/*! Stands for a UART and a clock, so that the code measured is the library's. */
+struct FootprintPort
+{
+    static volatile byte sData;
+    static volatile unsigned sAvailable;
+    static volatile unsigned long sTime;
+
+    inline void begin(long) {}
+    inline void end() {}
+    inline unsigned available() { return sAvailable; }
+    inline byte read() { return sData; }
+    inline void write(byte inByte) { sData = inByte; }
+};
+
+struct FootprintPlatform
+{
+    static inline unsigned long now() { return FootprintPort::sTime; }
+    static inline unsigned long nowMicros() { return FootprintPort::sTime; }
+};
+
+template<class Settings>
+struct Footprint
+{
+    typedef SerialMIDI<FootprintPort> Transport;
+    typedef MidiInterface<Transport, Settings, FootprintPlatform> Interface;
+};
+
+END_MIDI_NAMESPACE
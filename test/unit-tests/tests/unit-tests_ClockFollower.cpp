@@ -0,0 +1,215 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::ClockFollower<true, 3> ClockFollower;
+
+struct FollowerSettings : public midi::DefaultSettings
+{
+    static const bool UseClockFollower = true;
+};
+
+struct ClockPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros; }
+    static unsigned long sMicros;
+};
+
+unsigned long ClockPlatform::sMicros = 0;
+
+typedef midi::MidiInterface<Transport, FollowerSettings, ClockPlatform> MidiInterface;
+
+// 120 BPM: 500 ms per beat, 24 clocks per beat.
+static const unsigned long sPeriod = 20833;
+
+void sendClocks(ClockFollower& ioFollower, unsigned long& ioTime,
+                unsigned inCount, unsigned long inPeriod)
+{
+    for (unsigned i = 0; i < inCount; ++i)
+    {
+        ioTime += inPeriod;
+        ioFollower.process(midi::Clock, 0, 0, ioTime);
+    }
+}
+
+TEST(ClockFollower, disabledTakesNoSpace)
+{
+    EXPECT_TRUE((std::is_empty<midi::ClockFollower<false, 3> >::value));
+    EXPECT_TRUE((std::is_empty<midi::MidiInterface<Transport>::MidiClockFollower>::value));
+}
+
+TEST(ClockFollower, steadyTempo)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+    EXPECT_EQ(follower.getTempo(), 0);
+
+    sendClocks(follower, time, 1, sPeriod);
+    EXPECT_EQ(follower.getTempo(), 0);
+    EXPECT_EQ(follower.getClockPeriod(), 0ul);
+
+    sendClocks(follower, time, 48, sPeriod);
+    EXPECT_EQ(follower.getClockPeriod(), sPeriod);
+    EXPECT_EQ(follower.getTempo(), 12000);
+    EXPECT_FALSE(follower.isRunning());
+    EXPECT_EQ(follower.getClockCount(), 0ul); // Not started
+}
+
+TEST(ClockFollower, jitterIsSmoothed)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+    sendClocks(follower, time, 2, sPeriod);
+    for (unsigned i = 0; i < 200; ++i)
+    {
+        // +/- 1 ms of jitter on each clock
+        time += sPeriod + (i & 1 ? 1000 : -1000);
+        follower.process(midi::Clock, 0, 0, time);
+        EXPECT_NEAR(follower.getTempo(), 12000, 300);
+    }
+}
+
+TEST(ClockFollower, lostClocksAreIgnored)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+    sendClocks(follower, time, 24, sPeriod);
+
+    // One clock byte lost: the double interval is not averaged in.
+    sendClocks(follower, time, 1, 2 * sPeriod);
+    sendClocks(follower, time, 1, sPeriod);
+    EXPECT_EQ(follower.getTempo(), 12000);
+}
+
+TEST(ClockFollower, tempoJumpRelocks)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+    sendClocks(follower, time, 24, sPeriod);
+
+    // 60 BPM: rejected twice, then taken as the new tempo.
+    sendClocks(follower, time, 2, 2 * sPeriod);
+    EXPECT_EQ(follower.getTempo(), 12000);
+    sendClocks(follower, time, 1, 2 * sPeriod);
+    EXPECT_EQ(follower.getTempo(), 6000);
+
+    // Small changes are followed smoothly.
+    sendClocks(follower, time, 96, 2 * sPeriod * 6000 / 6600);
+    EXPECT_NEAR(follower.getTempo(), 6600, 2);
+
+    // A paused clock does not count as a tempo.
+    sendClocks(follower, time, 1, 5000000);
+    sendClocks(follower, time, 1, 2 * sPeriod * 6000 / 6600);
+    EXPECT_NEAR(follower.getTempo(), 6600, 2);
+}
+
+TEST(ClockFollower, songPosition)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+
+    follower.process(midi::Start, 0, 0, time);
+    EXPECT_TRUE(follower.isRunning());
+    sendClocks(follower, time, 30, sPeriod);
+    EXPECT_EQ(follower.getClockCount(), 30ul);
+    EXPECT_EQ(follower.getSongPosition(), 5ul);
+    EXPECT_EQ(follower.getBeat(), 1ul);
+
+    follower.process(midi::Stop, 0, 0, time);
+    EXPECT_FALSE(follower.isRunning());
+    sendClocks(follower, time, 10, sPeriod);
+    EXPECT_EQ(follower.getClockCount(), 30ul);
+
+    // Song Position 1000 (16ths): 0x68 | 0x07 << 7
+    follower.process(midi::SongPosition, 0x68, 0x07, time);
+    EXPECT_EQ(follower.getSongPosition(), 1000ul);
+    follower.process(midi::Continue, 0, 0, time);
+    sendClocks(follower, time, 6, sPeriod);
+    EXPECT_EQ(follower.getSongPosition(), 1001ul);
+    EXPECT_EQ(follower.getBeat(), 250ul);
+
+    follower.process(midi::Start, 0, 0, time);
+    EXPECT_EQ(follower.getClockCount(), 0ul);
+    EXPECT_EQ(follower.getTempo(), 12000);
+
+    follower.process(midi::SystemReset, 0, 0, time);
+    EXPECT_FALSE(follower.isRunning());
+    EXPECT_EQ(follower.getTempo(), 0);
+}
+
+TEST(ClockFollower, beatPhase)
+{
+    ClockFollower follower;
+    unsigned long time = 0;
+    sendClocks(follower, time, 24, sPeriod);
+    EXPECT_EQ(follower.getBeatPhase(time), 0);
+
+    follower.process(midi::Start, 0, 0, time);
+    EXPECT_EQ(follower.getBeatPhase(time), 0);
+
+    // First clock of the song: start of the beat.
+    sendClocks(follower, time, 1, sPeriod);
+    EXPECT_EQ(follower.getBeatPhase(time), 0);
+
+    // Clock 13 is half the beat, then 127 / 256 of a clock later.
+    sendClocks(follower, time, 12, sPeriod);
+    EXPECT_EQ(follower.getBeatPhase(time), 32768);
+    EXPECT_EQ(follower.getBeatPhase(time + sPeriod / 2), (12 * 256 + 127) * 32 / 3);
+
+    // Late clock: the phase holds at the end of the clock.
+    EXPECT_EQ(follower.getBeatPhase(time + 3 * sPeriod), (12 * 256 + 255) * 32 / 3);
+
+    // Next beat starts over.
+    sendClocks(follower, time, 12, sPeriod);
+    EXPECT_EQ(follower.getBeat(), 1ul);
+    EXPECT_EQ(follower.getBeatPhase(time), 0);
+}
+
+TEST(ClockFollower, fedByRead)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    ClockPlatform::sMicros = 1000;
+    serial.mRxBuffer.write(midi::Start);
+    EXPECT_TRUE(midi.read());
+    for (unsigned i = 0; i < 48; ++i)
+    {
+        ClockPlatform::sMicros += 25000; // 100 BPM
+        serial.mRxBuffer.write(midi::Clock);
+        EXPECT_TRUE(midi.read());
+    }
+    // Real Time bytes are processed as they come, even within a message.
+    static const byte rxData[] = { 0x90, 60, midi::Clock, 100 };
+    ClockPlatform::sMicros += 25000;
+    serial.mRxBuffer.write(rxData, 4);
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    EXPECT_TRUE(midi.getClockFollower().isRunning());
+    EXPECT_EQ(midi.getClockFollower().getClockCount(), 49ul);
+    EXPECT_EQ(midi.getClockFollower().getTempo(), 10000);
+    EXPECT_EQ(midi.getClockFollower().getBeat(), 2ul);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    EXPECT_EQ(midi.getClockFollower().getTempo(), 0);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,169 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+
+struct ActiveSensingSettings : public midi::DefaultSettings
+{
+    static const bool UseSenderActiveSensing = true;
+    static const bool UseReceiverActiveSensing = true;
+    static const uint16_t SenderActiveSensingPeriodicity = 250;
+};
+
+const bool ActiveSensingSettings::UseSenderActiveSensing;
+const bool ActiveSensingSettings::UseReceiverActiveSensing;
+const uint16_t ActiveSensingSettings::SenderActiveSensingPeriodicity;
+
+struct ExternalTimeSettings : public ActiveSensingSettings
+{
+    static const bool UseExternalTime = true;
+};
+
+const bool ExternalTimeSettings::UseExternalTime;
+
+struct CountingPlatform
+{
+    static unsigned long now() { sCalls++; return sMillis; }
+    static unsigned long sMillis;
+    static unsigned sCalls;
+};
+
+unsigned long CountingPlatform::sMillis = 0;
+unsigned CountingPlatform::sCalls = 0;
+
+typedef midi::MidiInterface<Transport, ActiveSensingSettings, CountingPlatform> MidiInterface;
+typedef midi::MidiInterface<Transport, ExternalTimeSettings, CountingPlatform> ExternalTimeMidiInterface;
+
+static const int8_t timeoutBit = 1 << midi::ErrorActiveSensingTimeout;
+
+TEST(MidiActiveSensing, senderPeriod)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    CountingPlatform::sMillis = 1000;
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    CountingPlatform::sMillis = 1250;
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    CountingPlatform::sMillis = 1251;
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 1);
+    EXPECT_EQ(serial.mTxBuffer.read(), midi::ActiveSensing);
+
+    // Sending pushes the next one back.
+    CountingPlatform::sMillis = 1400;
+    midi.read();
+    midi.sendProgramChange(1, 1);
+    serial.mTxBuffer.clear();
+    CountingPlatform::sMillis = 1650;
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    CountingPlatform::sMillis = 1651;
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 1);
+}
+
+TEST(MidiActiveSensing, receiverTimeout)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    CountingPlatform::sMillis = 0;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+
+    serial.mRxBuffer.write(midi::ActiveSensing);
+    EXPECT_EQ(midi.read(), true);
+    serial.mTxBuffer.clear();
+
+    CountingPlatform::sMillis = 300;
+    midi.read();
+    EXPECT_EQ(midi.getLastError() & timeoutBit, 0);
+
+    CountingPlatform::sMillis = 301;
+    midi.read();
+    EXPECT_EQ(midi.getLastError() & timeoutBit, timeoutBit);
+}
+
+TEST(MidiActiveSensing, singleClockSamplePerRead)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = { 0xfe, 0x90, 12, 34 };
+    CountingPlatform::sMillis = 0;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    CountingPlatform::sCalls = 0;
+    midi::Message messages[2];
+    EXPECT_EQ(midi.readBatch(messages, 2), 2u);
+    EXPECT_EQ(CountingPlatform::sCalls, 1u);
+
+    // Thru and active sensing sends don't sample the clock either.
+    CountingPlatform::sMillis = 1000;
+    CountingPlatform::sCalls = 0;
+    serial.mRxBuffer.write(midi::Clock);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(CountingPlatform::sCalls, 1u);
+}
+
+TEST(MidiActiveSensing, externalTime)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    ExternalTimeMidiInterface midi(transport);
+
+    CountingPlatform::sCalls = 0;
+    CountingPlatform::sMillis = 5000;
+    midi.setCurrentTime(100);
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    midi.setCurrentTime(350);
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    midi.setCurrentTime(351);
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 1);
+    EXPECT_EQ(CountingPlatform::sCalls, 0u);
+}
+
+TEST(MidiActiveSensing, clockWrapAround)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    CountingPlatform::sMillis = (unsigned long)(-300); // Deadline is at -50
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    CountingPlatform::sMillis = (unsigned long)(-100);
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    CountingPlatform::sMillis = 10;
+    midi.read();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 1);
+}
+
+END_UNNAMED_NAMESPACE
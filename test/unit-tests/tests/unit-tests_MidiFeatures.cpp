@@ -0,0 +1,103 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<uint8_t> Buffer;
+
+struct NoCacheSettings : public midi::DefaultSettings
+{
+    static const bool CacheParameterNumbers = false;
+};
+
+struct ActiveSensingSettings : public midi::DefaultSettings
+{
+    static const bool UseSenderActiveSensing = true;
+    static const bool UseReceiverActiveSensing = true;
+    static const uint16_t SenderActiveSensingPeriodicity = 250;
+};
+
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef midi::MidiInterface<Transport, NoCacheSettings> NoCacheMidiInterface;
+typedef midi::MidiInterface<Transport, ActiveSensingSettings> ActiveSensingMidiInterface;
+typedef midi::MidiInterface<Transport, VariableSettings<true, true> > RunningStatusMidiInterface;
+
+static Buffer readTx(SerialMock& inSerial)
+{
+    Buffer buffer(inSerial.mTxBuffer.getLength());
+    if (!buffer.empty())
+        inSerial.mTxBuffer.read(&buffer[0], int(buffer.size()));
+    return buffer;
+}
+
+TEST(MidiFeatures, disabledFeaturesAreEmpty)
+{
+    typedef midi::FeatureTypes<midi::DefaultSettings> Types;
+    EXPECT_TRUE(std::is_empty<Types::MidiInterfaceClock>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiSenderActiveSensing>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiReceiverActiveSensing>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiTimestampLatch>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiRunningStatusTx>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiTxQueue>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiCoalescer>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiSysExInput>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiStateTracker>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiParameterDecoder>::value);
+    EXPECT_TRUE(std::is_empty<Types::MidiControllerPairing>::value);
+    EXPECT_FALSE(std::is_empty<Types::MidiParameterNumbers>::value);
+
+    EXPECT_TRUE(std::is_empty<midi::InterfaceFeatures<NoCacheSettings> >::value);
+}
+
+TEST(MidiFeatures, enabledFeaturesCostRam)
+{
+    EXPECT_LT(sizeof(NoCacheMidiInterface), sizeof(MidiInterface));
+    EXPECT_LT(sizeof(MidiInterface), sizeof(RunningStatusMidiInterface));
+    EXPECT_LT(sizeof(MidiInterface), sizeof(ActiveSensingMidiInterface));
+}
+
+TEST(MidiFeatures, parameterNumberCache)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.beginRpn(0, 1);
+    midi.beginRpn(0, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 100, 0, 0xb0, 101, 0 }));
+
+    midi.endRpn(1);
+    readTx(serial);
+    midi.beginRpn(0, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 100, 0, 0xb0, 101, 0 }));
+}
+
+TEST(MidiFeatures, noParameterNumberCache)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    NoCacheMidiInterface midi(transport);
+
+    midi.begin();
+    midi.beginNrpn(0x81, 1);
+    midi.beginNrpn(0x81, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 98, 1, 0xb0, 99, 1,
+                                                   0xb0, 98, 1, 0xb0, 99, 1 }));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,125 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef midi::Message Message;
+
+TEST(MidiInputBatch, empty)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    Message messages[4];
+    midi.begin(MIDI_CHANNEL_OMNI);
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(0));
+}
+
+TEST(MidiInputBatch, drainsEverything)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 10;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 34,   // NoteOn
+        56, 78,         // Running status
+        0xf8,           // Clock
+        0xc0, 42,       // ProgramChange
+        0xb0, 7         // Incomplete ControlChange
+    };
+    Message messages[8];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 8), unsigned(4));
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 0);
+
+    EXPECT_EQ(messages[0].type,    midi::NoteOn);
+    EXPECT_EQ(messages[0].channel, 12);
+    EXPECT_EQ(messages[0].data1,   12);
+    EXPECT_EQ(messages[0].data2,   34);
+    EXPECT_EQ(messages[1].type,    midi::NoteOn);
+    EXPECT_EQ(messages[1].channel, 12);
+    EXPECT_EQ(messages[1].data1,   56);
+    EXPECT_EQ(messages[1].data2,   78);
+    EXPECT_EQ(messages[2].type,    midi::Clock);
+    EXPECT_EQ(messages[3].type,    midi::ProgramChange);
+    EXPECT_EQ(messages[3].channel, 1);
+    EXPECT_EQ(messages[3].data1,   42);
+
+    // Pending message is completed on the next batch
+    serial.mRxBuffer.write(64);
+    EXPECT_EQ(midi.readBatch(messages, 8), unsigned(1));
+    EXPECT_EQ(messages[0].type,    midi::ControlChange);
+    EXPECT_EQ(messages[0].data1,   7);
+    EXPECT_EQ(messages[0].data2,   64);
+}
+
+TEST(MidiInputBatch, stopsWhenFull)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 4;
+    static const byte rxData[rxSize] = { 0xf8, 0xfa, 0xfc, 0xfe };
+    Message messages[2];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 2), unsigned(2));
+    EXPECT_EQ(messages[0].type, midi::Clock);
+    EXPECT_EQ(messages[1].type, midi::Start);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 2);
+
+    EXPECT_EQ(midi.readBatch(messages, 2), unsigned(2));
+    EXPECT_EQ(messages[0].type, midi::Stop);
+    EXPECT_EQ(messages[1].type, midi::ActiveSensing);
+}
+
+TEST(MidiInputBatch, filtersChannels)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 9;
+    static const byte rxData[rxSize] = {
+        0x90, 12, 34,   // NoteOn channel 1
+        0x91, 56, 78,   // NoteOn channel 2
+        0x90, 12, 0,    // NoteOn channel 1, null velocity
+    };
+    Message messages[4];
+
+    midi.begin(1);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(2));
+    EXPECT_EQ(messages[0].type,    midi::NoteOn);
+    EXPECT_EQ(messages[0].channel, 1);
+    EXPECT_EQ(messages[1].type,    midi::NoteOff);
+    EXPECT_EQ(messages[1].channel, 1);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 0);
+
+    // Input disabled
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4, MIDI_CHANNEL_OFF), unsigned(0));
+    EXPECT_EQ(serial.mRxBuffer.getLength(), int(rxSize));
+}
+
+END_UNNAMED_NAMESPACE
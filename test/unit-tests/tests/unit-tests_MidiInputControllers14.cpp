@@ -0,0 +1,286 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<uint8_t> Buffer;
+
+struct PairingSettings : public midi::DefaultSettings
+{
+    static const bool UseControllerPairing = true;
+};
+
+struct ImmediatePairingSettings : public PairingSettings
+{
+    static const uint16_t ControllerPairingTimeout = 0;
+};
+
+struct RunningStatusSettings : public midi::DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+};
+
+const bool PairingSettings::UseControllerPairing;
+const uint16_t ImmediatePairingSettings::ControllerPairingTimeout;
+const bool RunningStatusSettings::UseRunningStatus;
+
+struct ManualPlatform
+{
+    static unsigned long now() { return sMillis; }
+    static unsigned long sMillis;
+};
+
+unsigned long ManualPlatform::sMillis = 0;
+
+typedef midi::MidiInterface<Transport, PairingSettings, ManualPlatform> MidiInterface;
+typedef midi::MidiInterface<Transport, ImmediatePairingSettings, ManualPlatform> ImmediateMidiInterface;
+typedef midi::MidiInterface<Transport, RunningStatusSettings> RunningStatusMidiInterface;
+typedef midi::MidiInterface<Transport> DefaultMidiInterface;
+
+TEST(MidiInputControllers14, pair)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = {
+        0xb2, 7, 0x12,   // Volume MSB
+        0xb2, 39, 0x34,  // Volume LSB
+    };
+    ManualPlatform::sMillis = 0;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), false); // MSB is held
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), true);
+    EXPECT_EQ(midi.getType(),    midi::ControlChange);
+    EXPECT_EQ(midi.getChannel(), 3);
+    EXPECT_EQ(midi.getData1(),   7);
+    EXPECT_EQ(midi.getData2(),   0x12);
+    EXPECT_EQ(midi.getControlChange14().channel, 3);
+    EXPECT_EQ(midi.getControlChange14().number,  7);
+    EXPECT_EQ(midi.getControlChange14().value,   (0x12 << 7) | 0x34);
+
+    // A fine adjustment: LSB alone updates the last MSB.
+    serial.mRxBuffer.write(0xb2);
+    serial.mRxBuffer.write(39);
+    serial.mRxBuffer.write(0x35);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), true);
+    EXPECT_EQ(midi.getControlChange14().value, (0x12 << 7) | 0x35);
+
+    // Other controllers pass through.
+    serial.mRxBuffer.write(0xb2);
+    serial.mRxBuffer.write(64);
+    serial.mRxBuffer.write(127);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), false);
+    EXPECT_EQ(midi.getData1(), 64);
+}
+
+TEST(MidiInputControllers14, loneMsbTimeout)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 3;
+    static const byte rxData[rxSize] = { 0xb0, 1, 0x40 };
+    ManualPlatform::sMillis = 100;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), 0u);
+
+    ManualPlatform::sMillis = 109;
+    EXPECT_EQ(midi.read(), false);
+
+    ManualPlatform::sMillis = 110;
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), true);
+    EXPECT_EQ(midi.getData1(), 1);
+    EXPECT_EQ(midi.getData2(), 0x40);
+    EXPECT_EQ(midi.getControlChange14().value, 0x40 << 7);
+    EXPECT_EQ(midi.read(), false);
+
+    // Through readBatch, and replaced by another MSB.
+    static const unsigned rxSize2 = 6;
+    static const byte rxData2[rxSize2] = { 0xb0, 1, 0x10, 0xb0, 2, 0x20 };
+    serial.mRxBuffer.write(rxData2, rxSize2);
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].data1, 1);
+    EXPECT_EQ(messages[0].data2, 0x10);
+
+    ManualPlatform::sMillis = 200;
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].data1, 2);
+    EXPECT_EQ(messages[0].data2, 0x20);
+    EXPECT_EQ(midi.isControlChange14(), true);
+}
+
+TEST(MidiInputControllers14, keepsChannelOrder)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 8;
+    static const byte rxData[rxSize] = {
+        0xb0, 0, 0x05,   // Bank Select MSB
+        0xc0, 0x0a,      // Program Change, in that bank
+        0xb0, 7, 0x10,   // Volume MSB
+    };
+    ManualPlatform::sMillis = 0;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.readBatch(messages, 4), 2u);
+    EXPECT_EQ(messages[0].type,  midi::ControlChange);
+    EXPECT_EQ(messages[0].data1, 0);
+    EXPECT_EQ(messages[0].data2, 0x05);
+    EXPECT_EQ(messages[1].type,  midi::ProgramChange);
+    EXPECT_EQ(messages[1].data1, 0x0a);
+
+    // Through read(), the deferred message comes on the next call.
+    static const unsigned rxSize2 = 3;
+    static const byte rxData2[rxSize2] = { 0x90, 60, 100 };
+    serial.mRxBuffer.write(rxData2, rxSize2);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), true);
+    EXPECT_EQ(midi.getData1(), 7);
+    EXPECT_EQ(midi.getData2(), 0x10);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.isControlChange14(), false);
+    EXPECT_EQ(midi.getType(),  midi::NoteOn);
+    EXPECT_EQ(midi.getData1(), 60);
+    EXPECT_EQ(midi.read(), false);
+
+    // Other channels are not held back.
+    static const unsigned rxSize3 = 5;
+    static const byte rxData3[rxSize3] = { 0xb0, 1, 0x20, 0xc1, 0x03 };
+    serial.mRxBuffer.write(rxData3, rxSize3);
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].type,    midi::ProgramChange);
+    EXPECT_EQ(messages[0].channel, 2);
+}
+
+TEST(MidiInputControllers14, immediatePolicy)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    ImmediateMidiInterface midi(transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = {
+        0xb0, 10, 0x40,  // Pan MSB
+        0xb0, 42, 0x01,  // Pan LSB
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), 2u);
+    EXPECT_EQ(messages[0].data1, 10);
+    EXPECT_EQ(messages[0].data2, 0x40);
+    EXPECT_EQ(messages[1].data1, 10);
+    EXPECT_EQ(messages[1].data2, 0x40);
+    EXPECT_EQ(midi.getControlChange14().value, (0x40 << 7) | 0x01);
+}
+
+TEST(MidiInputControllers14, pairedControllers)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    ImmediateMidiInterface midi(transport);
+    midi::Message messages[4];
+
+    // Data Entry is left to RPN / NRPN by default.
+    EXPECT_EQ(midi.getPairedControllers() & (1u << midi::DataEntryMSB), 0u);
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = {
+        0xb0, 1, 0x40,
+        0xb0, 33, 0x01,
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setPairedControllers(1u << midi::DataEntryMSB);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), 2u);
+    EXPECT_EQ(messages[0].data1, 1);
+    EXPECT_EQ(messages[1].data1, 33);
+    EXPECT_EQ(midi.isControlChange14(), false);
+}
+
+TEST(MidiInputControllers14, disabled)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    DefaultMidiInterface midi(transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = {
+        0xb0, 1, 0x40,
+        0xb0, 33, 0x01,
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), 2u);
+    EXPECT_EQ(midi.isControlChange14(), false);
+}
+
+TEST(MidiInputControllers14, send)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    DefaultMidiInterface midi(transport);
+    Buffer buffer;
+
+    midi.begin();
+    midi.sendControlChange14(7, 0x1234, 5);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 6);
+    buffer.resize(6);
+    serial.mTxBuffer.read(&buffer[0], 6);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0xb4, 7, 0x24, 0xb4, 39, 0x34 }));
+}
+
+TEST(MidiInputControllers14, sendRunningStatus)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    RunningStatusMidiInterface midi(transport);
+    Buffer buffer;
+
+    midi.begin();
+    midi.sendControlChange14(7, 0x3fff, 5);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 5);
+    buffer.resize(5);
+    serial.mTxBuffer.read(&buffer[0], 5);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0xb4, 7, 0x7f, 39, 0x7f }));
+}
+
+END_UNNAMED_NAMESPACE
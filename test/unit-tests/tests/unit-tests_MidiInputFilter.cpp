@@ -0,0 +1,145 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef midi::Message Message;
+typedef std::vector<byte> Buffer;
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+};
+
+const bool SysExSettings::UseSysExInput;
+
+TEST(MidiInputFilter, defaultMasks)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    EXPECT_EQ(midi.getInputChannelMask(), 0xffff);
+    EXPECT_EQ(midi.getInputTypeMask(),    0xffffffffu);
+}
+
+TEST(MidiInputFilter, channelMask)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0x90, 12, 34,   // NoteOn channel 1
+        0x91, 56, 78,   // NoteOn channel 2, rejected
+        90, 12,         // Running status on channel 2, rejected
+        0x93, 42, 42,   // NoteOn channel 4
+        12, 34,         // Running status on channel 4
+    };
+    Message messages[8];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    midi.setInputChannelMask(0x0009);
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 8), 3u);
+    EXPECT_EQ(messages[0].channel, 1);
+    EXPECT_EQ(messages[1].channel, 4);
+    EXPECT_EQ(messages[1].data1,   42);
+    EXPECT_EQ(messages[2].channel, 4);
+    EXPECT_EQ(messages[2].data1,   12);
+    EXPECT_EQ(midi.getLastError(), 0);
+}
+
+TEST(MidiInputFilter, typeMask)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0xa0, 12, 0xf8, 34,     // AfterTouchPoly with interleaved Clock
+        0xb0, 7, 64,            // ControlChange
+        0xf8,                   // Clock
+        0xd0, 0xfa, 42,         // AfterTouchChannel with interleaved Start
+    };
+    Message messages[8];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    midi.setInputTypeMask(~(midi::getTypeBit(midi::AfterTouchPoly)
+                          | midi::getTypeBit(midi::AfterTouchChannel)
+                          | midi::getTypeBit(midi::Clock)));
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 8), 2u);
+    EXPECT_EQ(messages[0].type,  midi::ControlChange);
+    EXPECT_EQ(messages[0].data1, 7);
+    EXPECT_EQ(messages[0].data2, 64);
+    EXPECT_EQ(messages[1].type,  midi::Start);
+    EXPECT_EQ(midi.getLastError(), 0);
+}
+
+TEST(MidiInputFilter, rejectedMessagesGoThroughThru)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0x91, 56, 78,   // NoteOn channel 2
+        0xf8,           // Clock
+    };
+    Message messages[4];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setInputChannelMask(0x0001);
+    midi.setInputTypeMask(~midi::getTypeBit(midi::Clock));
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 4), 0u);
+
+    Buffer buffer(4);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 4);
+    serial.mTxBuffer.read(&buffer[0], 4);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0x91, 56, 78, 0xf8 }));
+}
+
+TEST(MidiInputFilter, rejectedSysExIsSkipped)
+{
+    typedef midi::MidiInterface<Transport, SysExSettings> SysExMidiInterface;
+
+    SerialMock serial;
+    Transport transport(serial);
+    SysExMidiInterface midi(transport);
+    byte sysExBuffer[4];
+
+    static const byte rxData[] = {
+        0xf0, 1, 2, 3, 4, 5, 6, 0xf7,
+        0xc0, 42
+    };
+    Message messages[4];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    midi.setSysExBuffer(sysExBuffer, sizeof(sysExBuffer));
+    midi.setInputTypeMask(~midi::getTypeBit(midi::SystemExclusive));
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].type,  midi::ProgramChange);
+    EXPECT_EQ(messages[0].data1, 42);
+    EXPECT_EQ(midi.getLastError(), 0);
+}
+
+END_UNNAMED_NAMESPACE
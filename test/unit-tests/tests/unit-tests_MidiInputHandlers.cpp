@@ -0,0 +1,213 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<int> Events;
+
+Events sEvents;
+
+struct RecordingHandlers : public midi::DefaultHandlers
+{
+    static void handleError(int8_t inError)
+    {
+        sEvents.push_back(-inError);
+    }
+    static void handleNoteOn(byte inChannel, byte inNote, byte inVelocity)
+    {
+        sEvents.push_back(midi::NoteOn);
+        sEvents.push_back(inChannel);
+        sEvents.push_back(inNote);
+        sEvents.push_back(inVelocity);
+    }
+    static void handleNoteOff(byte inChannel, byte inNote, byte)
+    {
+        sEvents.push_back(midi::NoteOff);
+        sEvents.push_back(inChannel);
+        sEvents.push_back(inNote);
+    }
+    static void handlePitchBend(byte inChannel, int inValue)
+    {
+        sEvents.push_back(midi::PitchBend);
+        sEvents.push_back(inChannel);
+        sEvents.push_back(inValue);
+    }
+    static void handleSongPosition(unsigned inBeats)
+    {
+        sEvents.push_back(midi::SongPosition);
+        sEvents.push_back(int(inBeats));
+    }
+    static void handleClock()
+    {
+        sEvents.push_back(midi::Clock);
+    }
+};
+
+struct RecordingCallbackHandlers : public RecordingHandlers
+{
+    static const bool UseCallbacks = true;
+};
+
+const bool RecordingCallbackHandlers::UseCallbacks;
+
+typedef midi::MidiInterface<Transport> DefaultMidiInterface;
+typedef midi::MidiInterface<Transport,
+                            midi::DefaultSettings,
+                            midi::DefaultPlatform,
+                            RecordingHandlers> StaticMidiInterface;
+typedef midi::MidiInterface<Transport,
+                            midi::DefaultSettings,
+                            midi::DefaultPlatform,
+                            midi::CallbackHandlers> CallbackMidiInterface;
+typedef midi::MidiInterface<Transport,
+                            midi::DefaultSettings,
+                            midi::DefaultPlatform,
+                            RecordingCallbackHandlers> MixedMidiInterface;
+
+void recordProgramChange(byte inChannel, byte inNumber)
+{
+    sEvents.push_back(midi::ProgramChange);
+    sEvents.push_back(inChannel);
+    sEvents.push_back(inNumber);
+}
+
+void recordNoteOn(byte inChannel, byte inNote, byte)
+{
+    sEvents.push_back(-midi::NoteOn);
+    sEvents.push_back(inChannel);
+    sEvents.push_back(inNote);
+}
+
+void recordMessage(const midi::Message& inMessage)
+{
+    sEvents.push_back(inMessage.type);
+}
+
+TEST(MidiInputHandlers, noStorageByDefault)
+{
+    // Runtime callbacks are an empty base, they take no space.
+    EXPECT_EQ(sizeof(DefaultMidiInterface), sizeof(StaticMidiInterface));
+    EXPECT_GT(sizeof(CallbackMidiInterface), sizeof(DefaultMidiInterface));
+}
+
+TEST(MidiInputHandlers, staticHandlers)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    StaticMidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 13;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 34,
+        0x9b, 12, 0,        // NoteOff
+        0xe2, 0, 0x40,      // PitchBend, centered
+        0xf8,
+        0xf2, 0x05, 0x01,   // SongPosition
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    sEvents.clear();
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    EXPECT_THAT(sEvents, ElementsAre(midi::NoteOn, 12, 12, 34,
+                                     midi::NoteOff, 12, 12,
+                                     midi::PitchBend, 3, 0,
+                                     midi::Clock,
+                                     midi::SongPosition, 0x85));
+}
+
+TEST(MidiInputHandlers, channelFilter)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    StaticMidiInterface midi((Transport&)transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = { 0x90, 12, 34, 0x91, 56, 78 };
+    midi.begin(2);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    sEvents.clear();
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(1));
+    EXPECT_THAT(sEvents, ElementsAre(midi::NoteOn, 2, 56, 78));
+}
+
+TEST(MidiInputHandlers, errorHandler)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    StaticMidiInterface midi((Transport&)transport);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(12); // Data without running status
+
+    sEvents.clear();
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_THAT(sEvents, ElementsAre(-(1 << midi::ErrorParse)));
+}
+
+TEST(MidiInputHandlers, runtimeCallbacks)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    CallbackMidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 5;
+    static const byte rxData[rxSize] = { 0xc3, 42, 0x90, 12, 34 };
+    midi.setHandleProgramChange(recordProgramChange);
+    midi.setHandleMessage(recordMessage);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    sEvents.clear();
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_THAT(sEvents, ElementsAre(midi::ProgramChange,
+                                     midi::ProgramChange, 4, 42));
+
+    midi.disconnectCallbackFromType(midi::ProgramChange);
+    serial.mRxBuffer.write(rxData, 2);
+
+    sEvents.clear();
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+    EXPECT_THAT(sEvents, ElementsAre(midi::NoteOn,
+                                     midi::ProgramChange));
+}
+
+TEST(MidiInputHandlers, staticAndRuntime)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MixedMidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 3;
+    static const byte rxData[rxSize] = { 0x90, 12, 34 };
+    midi.setHandleNoteOn(recordNoteOn);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    sEvents.clear();
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+    EXPECT_THAT(sEvents, ElementsAre(midi::NoteOn, 1, 12, 34,
+                                     -midi::NoteOn, 1, 12));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,187 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::Message Message;
+typedef midi::ParameterEvent Event;
+
+template<bool Swallow>
+struct ParameterSettings : public midi::DefaultSettings
+{
+    static const bool UseParameterDecoder = true;
+    static const bool SwallowParameterControllers = Swallow;
+};
+
+template<bool Swallow>
+const bool ParameterSettings<Swallow>::UseParameterDecoder;
+template<bool Swallow>
+const bool ParameterSettings<Swallow>::SwallowParameterControllers;
+
+typedef midi::MidiInterface<Transport, ParameterSettings<false> > MidiInterface;
+typedef midi::MidiInterface<Transport, ParameterSettings<true> > SwallowMidiInterface;
+
+// Read everything, keep the parameter events
+template<class Interface>
+std::vector<Event> readEvents(Interface& inMidi, SerialMock& inSerial, unsigned* outNumMessages = nullptr)
+{
+    std::vector<Event> events;
+    unsigned numMessages = 0;
+    while (inSerial.mRxBuffer.getLength() > 0)
+    {
+        if (inMidi.read())
+        {
+            numMessages++;
+            if (inMidi.isParameterEvent())
+                events.push_back(inMidi.getParameterEvent());
+        }
+    }
+    if (outNumMessages)
+        *outNumMessages = numMessages;
+    return events;
+}
+
+TEST(MidiInputParameters, disabledByDefault)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    midi::MidiInterface<Transport> midi(transport);
+
+    static const byte rxData[] = { 0xb0, 101, 0, 100, 0, 6, 12 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    unsigned numMessages = 0;
+    EXPECT_EQ(readEvents(midi, serial, &numMessages).size(), 0u);
+    EXPECT_EQ(numMessages, 3u);
+}
+
+TEST(MidiInputParameters, rpnValue)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0xb2, 100, 0, 101, 0,   // Select Pitch Bend Sensitivity
+        6, 12,                  // MSB: 12 semitones
+        38, 50,                 // LSB: 50 cents
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    unsigned numMessages = 0;
+    const std::vector<Event> events = readEvents(midi, serial, &numMessages);
+    EXPECT_EQ(numMessages, 4u);
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].kind,    Event::Registered);
+    EXPECT_EQ(events[0].action,  Event::Value);
+    EXPECT_EQ(events[0].channel, 3);
+    EXPECT_EQ(events[0].number,  midi::RPN::PitchBendSensitivity);
+    EXPECT_EQ(events[0].value,   12 << 7);
+    EXPECT_EQ(events[1].value,   12 << 7 | 50);
+}
+
+TEST(MidiInputParameters, nrpnIncrementDecrement)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    SwallowMidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0xb0, 99, 0x12, 98, 0x34,   // Select NRPN 0x12 / 0x34
+        96, 3,                      // Increment
+        97, 1,                      // Decrement
+        0xb1, 99, 1,                // Other channel, only MSB
+        6, 42
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    unsigned numMessages = 0;
+    const std::vector<Event> events = readEvents(midi, serial, &numMessages);
+    EXPECT_EQ(numMessages, 3u); // Selections are swallowed
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].kind,    Event::NonRegistered);
+    EXPECT_EQ(events[0].action,  Event::Increment);
+    EXPECT_EQ(events[0].number,  0x12 << 7 | 0x34);
+    EXPECT_EQ(events[0].value,   3);
+    EXPECT_EQ(events[1].action,  Event::Decrement);
+    EXPECT_EQ(events[1].value,   1);
+    EXPECT_EQ(events[2].channel, 2);
+    EXPECT_EQ(events[2].number,  1 << 7);
+    EXPECT_EQ(events[2].value,   42 << 7);
+}
+
+TEST(MidiInputParameters, nullFunction)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0xb0, 101, 0, 100, 1,       // Fine tuning
+        6, 64,
+        101, 127, 100, 127,         // Null Function
+        6, 10,                      // Plain Data Entry CC
+        100, 2,                     // Only the LSB, MSB is still 127
+        6, 11,
+        101, 0,                     // Coarse tuning
+        6, 12,
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    unsigned numMessages = 0;
+    const std::vector<Event> events = readEvents(midi, serial, &numMessages);
+    EXPECT_EQ(numMessages, 10u);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].number, midi::RPN::ChannelFineTuning);
+    EXPECT_EQ(events[1].number, 127 << 7 | 2);
+    EXPECT_EQ(events[1].value,  11 << 7);
+    EXPECT_EQ(events[2].number, midi::RPN::ChannelCoarseTuning);
+    EXPECT_EQ(events[2].value,  12 << 7);
+}
+
+TEST(MidiInputParameters, batchStopsOnEvent)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    SwallowMidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0xb0, 101, 0, 100, 0, 6, 2,
+        0xc0, 5
+    };
+    Message messages[4];
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].type,  midi::ControlChange);
+    EXPECT_EQ(messages[0].data1, midi::DataEntryMSB);
+    EXPECT_EQ(midi.isParameterEvent(), true);
+    EXPECT_EQ(midi.getParameterEvent().value, 2 << 7);
+
+    EXPECT_EQ(midi.readBatch(messages, 4), 1u);
+    EXPECT_EQ(messages[0].type, midi::ProgramChange);
+    EXPECT_EQ(midi.isParameterEvent(), false);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,157 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<2048> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef VariableSettings<false, false> MultiByteSettings;
+typedef midi::MidiInterface<Transport, MultiByteSettings> MultiByteMidiInterface;
+
+TEST(MidiInputParser, statusInfoTable)
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        const byte status = byte(i);
+        const byte info   = midi::getStatusInfo(status);
+        const midi::MidiType type = MidiInterface::getTypeFromStatusByte(status);
+        const bool isChannel = MidiInterface::isChannelMessage(type);
+
+        EXPECT_EQ(bool(info & midi::StatusInfo::ChannelMessage), isChannel);
+        EXPECT_EQ(bool(info & midi::StatusInfo::RunningStatus),  isChannel);
+        EXPECT_EQ(bool(info & midi::StatusInfo::Ignored), status == midi::Undefined_FD);
+        EXPECT_EQ(bool(info & midi::StatusInfo::RealTime),
+                  status >= midi::Clock && status != midi::Undefined_FD);
+    }
+    EXPECT_EQ(midi::getStatusInfo(0x42) & midi::StatusInfo::LengthMask, 0);
+    EXPECT_EQ(midi::getStatusInfo(0x9b) & midi::StatusInfo::LengthMask, 3);
+    EXPECT_EQ(midi::getStatusInfo(0xc4) & midi::StatusInfo::LengthMask, 2);
+    EXPECT_EQ(midi::getStatusInfo(0xd4) & midi::StatusInfo::LengthMask, 2);
+    EXPECT_EQ(midi::getStatusInfo(0xf0) & midi::StatusInfo::LengthMask, 0);
+    EXPECT_EQ(midi::getStatusInfo(0xf1) & midi::StatusInfo::LengthMask, 2);
+    EXPECT_EQ(midi::getStatusInfo(0xf2) & midi::StatusInfo::LengthMask, 3);
+    EXPECT_EQ(midi::getStatusInfo(0xf3) & midi::StatusInfo::LengthMask, 2);
+    EXPECT_EQ(midi::getStatusInfo(0xf6) & midi::StatusInfo::LengthMask, 1);
+    EXPECT_EQ(midi::getStatusInfo(0xf7) & midi::StatusInfo::LengthMask, 0);
+    EXPECT_EQ(midi::getStatusInfo(0xf8) & midi::StatusInfo::LengthMask, 1);
+}
+
+TEST(MidiInputParser, messageLength)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+    midi::Message messages[4];
+
+    static const unsigned rxSize = 7;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 34,
+        0xc0, 12,
+        0xf8,
+        42  // Running status on ProgramChange
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(4));
+    EXPECT_EQ(messages[0].length, 3);
+    EXPECT_EQ(messages[1].length, 2);
+    EXPECT_EQ(messages[2].length, 1);
+    EXPECT_EQ(messages[3].type,   midi::ProgramChange);
+    EXPECT_EQ(messages[3].data1,  42);
+    EXPECT_EQ(messages[3].length, 2);
+}
+
+TEST(MidiInputParser, longBurstMultiByteParsing)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MultiByteMidiInterface midi(transport);
+
+    // A lot of stray bytes before a message should not grow the stack.
+    midi.begin(12);
+    for (unsigned i = 0; i < 2000; ++i)
+    {
+        serial.mRxBuffer.write(midi::Undefined_FD);
+    }
+    static const unsigned rxSize = 3;
+    static const byte rxData[rxSize] = { 0x9b, 12, 34 };
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getChannel(),    12);
+    EXPECT_EQ(midi.getData1(),      12);
+    EXPECT_EQ(midi.getData2(),      34);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 0);
+}
+
+TEST(MidiInputParser, runningStatusMultiByteParsing)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MultiByteMidiInterface midi(transport);
+
+    static const unsigned rxSize = 10;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 0xf8, 34,
+        56, 0xfd, 78,
+        0xc0, 0xfe, 42,
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::Clock);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getData1(),      12);
+    EXPECT_EQ(midi.getData2(),      34);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getData1(),      56);
+    EXPECT_EQ(midi.getData2(),      78);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::ActiveSensing);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::ProgramChange);
+    EXPECT_EQ(midi.getChannel(),    1);
+    EXPECT_EQ(midi.getData1(),      42);
+    EXPECT_EQ(midi.read(), false);
+}
+
+TEST(MidiInputParser, errorStopsMultiByteParsing)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MultiByteMidiInterface midi(transport);
+
+    static const unsigned rxSize = 5;
+    static const byte rxData[rxSize] = {
+        12, 34,         // Data without running status
+        0x8b, 42, 0
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 4);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOff);
+    EXPECT_EQ(midi.getChannel(),    12);
+    EXPECT_EQ(midi.getData1(),      42);
+    EXPECT_EQ(midi.getData2(),      0);
+}
+
+END_UNNAMED_NAMESPACE
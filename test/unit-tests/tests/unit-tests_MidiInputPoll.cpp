@@ -0,0 +1,140 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<256> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef VariableSettings<false, false> MultiByteSettings;
+
+// Every call to nowMicros advances the clock by 10us
+struct SteppingPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros += 10; }
+    static unsigned long sMicros;
+};
+
+unsigned long SteppingPlatform::sMicros = 0;
+
+std::vector<byte> sNotes;
+
+struct NoteHandlers : public midi::DefaultHandlers
+{
+    static void handleNoteOn(byte, byte inPitch, byte)
+    {
+        sNotes.push_back(inPitch);
+    }
+};
+
+typedef midi::MidiInterface<Transport, midi::DefaultSettings, SteppingPlatform, NoteHandlers> MidiInterface;
+typedef midi::MidiInterface<Transport, MultiByteSettings, SteppingPlatform, NoteHandlers> MultiByteMidiInterface;
+
+void writeNotes(SerialMock& ioSerial, unsigned inCount)
+{
+    for (unsigned i = 0; i < inCount; ++i)
+    {
+        const byte data[3] = { 0x90, byte(60 + i), 100 };
+        ioSerial.mRxBuffer.write(data, 3);
+    }
+}
+
+template<class Interface>
+void checkByteBudget()
+{
+    SerialMock serial;
+    Transport transport(serial);
+    Interface midi(transport);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    sNotes.clear();
+
+    writeNotes(serial, 3);
+    EXPECT_TRUE(midi.poll(4));
+    EXPECT_EQ(sNotes.size(), 1u);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 5);
+
+    // Resumes in the middle of the second note.
+    EXPECT_TRUE(midi.poll(4));
+    EXPECT_EQ(sNotes.size(), 2u);
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 1);
+
+    EXPECT_FALSE(midi.poll(4));
+    ASSERT_EQ(sNotes.size(), 3u);
+    EXPECT_EQ(sNotes[2], 62);
+    EXPECT_EQ(midi.getType(),  midi::NoteOn);
+    EXPECT_EQ(midi.getData1(), 62);
+
+    EXPECT_FALSE(midi.poll(4));
+    EXPECT_EQ(sNotes.size(), 3u);
+}
+
+TEST(MidiInputPoll, byteBudget)
+{
+    // Same budget with and without Use1ByteParsing.
+    checkByteBudget<MidiInterface>();
+    checkByteBudget<MultiByteMidiInterface>();
+}
+
+TEST(MidiInputPoll, runningStatusAndRealTime)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    sNotes.clear();
+
+    static const byte rxData[] = { 0x90, 60, 0xf8, 100, 61, 100, 62, 100 };
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_TRUE(midi.poll(3));
+    EXPECT_EQ(midi.getType(), midi::Clock);
+    EXPECT_FALSE(midi.poll(16));
+    EXPECT_EQ(sNotes, (std::vector<byte>{ 60, 61, 62 }));
+}
+
+TEST(MidiInputPoll, channelFilter)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin(2);
+    sNotes.clear();
+
+    static const byte rxData[] = { 0x90, 60, 100, 0x91, 61, 100 };
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_FALSE(midi.poll(16));
+    EXPECT_EQ(sNotes, (std::vector<byte>{ 61 }));
+
+    midi.setInputChannel(MIDI_CHANNEL_OFF);
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_TRUE(midi.poll(16));
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 6);
+}
+
+TEST(MidiInputPoll, timeBudget)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    sNotes.clear();
+
+    // The clock is read once at the start, then once per 3 bytes.
+    writeNotes(serial, 20);
+    EXPECT_TRUE(midi.pollFor(50));
+    EXPECT_EQ(sNotes.size(), 5u);
+
+    EXPECT_FALSE(midi.pollFor(1000));
+    EXPECT_EQ(sNotes.size(), 20u);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,236 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<uint8_t> Buffer;
+
+template<bool OneByteParsing>
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput   = true;
+    static const bool Use1ByteParsing = OneByteParsing;
+};
+
+template<bool A>
+const bool SysExSettings<A>::UseSysExInput;
+template<bool A>
+const bool SysExSettings<A>::Use1ByteParsing;
+
+typedef midi::MidiInterface<Transport> DefaultMidiInterface;
+typedef midi::MidiInterface<Transport, SysExSettings<false> > MidiInterface;
+typedef midi::MidiInterface<Transport, SysExSettings<true> > OneByteMidiInterface;
+
+static const bool kSplit = true;
+
+Buffer getChunk(const MidiInterface& inMidi)
+{
+    const byte* data = inMidi.getSysExArray();
+    return Buffer(data, data + inMidi.getSysExArrayLength());
+}
+
+TEST(MidiInputSysEx, disabledByDefault)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    DefaultMidiInterface midi((Transport&)transport);
+    byte buffer[8];
+
+    static const unsigned rxSize = 7;
+    static const byte rxData[rxSize] = { 0xf0, 1, 2, 0xf7, 0x90, 12, 34 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.getLastError() & (1 << midi::ErrorParse), 1 << midi::ErrorParse);
+    EXPECT_EQ(midi.getSysExArrayLength(), unsigned(0));
+}
+
+TEST(MidiInputSysEx, noBuffer)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    static const unsigned rxSize = 4;
+    static const byte rxData[rxSize] = { 0xf0, 1, 2, 0xf7 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.getLastError() & (1 << midi::ErrorParse), 1 << midi::ErrorParse);
+}
+
+TEST(MidiInputSysEx, singleChunk)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+    byte buffer[16];
+
+    static const unsigned rxSize = 9;
+    static const byte rxData[rxSize] = {
+        0xf0, 'H', 'e', 'l', 'l', 'o', 0xf7,
+        0xc3, 42
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::SystemExclusive);
+    EXPECT_EQ(midi.getChannel(), 0);
+    EXPECT_EQ(midi.getSysExArray(), buffer);
+    EXPECT_THAT(getChunk(midi), ElementsAreArray(rxData, 7));
+    EXPECT_EQ(midi.getLastError() & (1 << midi::WarningSplitSysEx), 0);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::ProgramChange);
+    EXPECT_EQ(midi.getChannel(), 4);
+    EXPECT_EQ(midi.getData1(), 42);
+    EXPECT_EQ(midi.getSysExArrayLength(), unsigned(0));
+}
+
+TEST(MidiInputSysEx, splitChunks)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+    byte buffer[4];
+
+    static const unsigned rxSize = 10;
+    static const byte rxData[rxSize] = {
+        0xf0, 1, 2, 3, 4, 5, 6, 7, 8, 0xf7
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::SystemExclusive);
+    EXPECT_THAT(getChunk(midi), ElementsAre(0xf0, 1, 2, 3));
+    EXPECT_EQ(bool(midi.getLastError() & (1 << midi::WarningSplitSysEx)), kSplit);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_THAT(getChunk(midi), ElementsAre(4, 5, 6, 7));
+    EXPECT_EQ(bool(midi.getLastError() & (1 << midi::WarningSplitSysEx)), kSplit);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_THAT(getChunk(midi), ElementsAre(8, 0xf7));
+    EXPECT_EQ(bool(midi.getLastError() & (1 << midi::WarningSplitSysEx)), !kSplit);
+    EXPECT_EQ(midi.read(), false);
+}
+
+TEST(MidiInputSysEx, interleavedRealTime)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    OneByteMidiInterface midi((Transport&)transport);
+    byte buffer[16];
+
+    static const unsigned rxSize = 8;
+    static const byte rxData[rxSize] = {
+        0xf0, 1, 0xf8, 2, 0xfd, 3, 0xfe, 0xf7
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::Clock);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::ActiveSensing);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::SystemExclusive);
+    EXPECT_EQ(midi.getSysExArrayLength(), unsigned(5));
+    EXPECT_EQ(buffer[0], 0xf0);
+    EXPECT_EQ(buffer[1], 1);
+    EXPECT_EQ(buffer[2], 2);
+    EXPECT_EQ(buffer[3], 3);
+    EXPECT_EQ(buffer[4], 0xf7);
+}
+
+TEST(MidiInputSysEx, interruptedByStatus)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+    byte buffer[16];
+
+    static const unsigned rxSize = 12;
+    static const byte rxData[rxSize] = {
+        0x90, 12, 34,
+        0xf0, 1, 2,
+        0x80, 12, 0,    // Frame is aborted, the Note Off is received
+        0x90, 56, 78
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::NoteOn);
+    EXPECT_EQ(midi.read(), true);   // Not the SysEx chunk
+    EXPECT_EQ(midi.getType(), midi::NoteOff);
+    EXPECT_EQ(midi.getData1(), 12);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::NoteOn);
+    EXPECT_EQ(midi.getData1(), 56);
+    EXPECT_EQ(midi.getData2(), 78);
+
+    // SysEx cancels running status
+    serial.mRxBuffer.write(rxData + 3, 1);
+    serial.mRxBuffer.write(0xf7);
+    serial.mRxBuffer.write(12);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(), midi::SystemExclusive);
+    EXPECT_EQ(midi.getSysExArrayLength(), unsigned(2));
+    EXPECT_EQ(midi.read(), false);
+}
+
+TEST(MidiInputSysEx, batchStopsAfterChunk)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+    midi::Message messages[4];
+    byte buffer[4];
+
+    static const unsigned rxSize = 9;
+    static const byte rxData[rxSize] = {
+        0xf8, 0xf0, 1, 2, 0xf7, 0xf8, 0xf0, 3, 0xf7
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(buffer, sizeof(buffer));
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(2));
+    EXPECT_EQ(messages[0].type, midi::Clock);
+    EXPECT_EQ(messages[1].type, midi::SystemExclusive);
+    EXPECT_THAT(getChunk(midi), ElementsAre(0xf0, 1, 2, 0xf7));
+
+    EXPECT_EQ(midi.readBatch(messages, 4), unsigned(2));
+    EXPECT_EQ(messages[0].type, midi::Clock);
+    EXPECT_EQ(messages[1].type, midi::SystemExclusive);
+    EXPECT_THAT(getChunk(midi), ElementsAre(0xf0, 3, 0xf7));
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 0);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,145 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_RingTransport.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::RingSerialMIDI<SerialMock, 16, midi::DefaultSerialSettings, true> RingTransport;
+
+struct TimestampSettings : public midi::DefaultSettings
+{
+    static const bool UseTimestamps = true;
+    static const bool UseSysExInput = true;
+};
+
+const bool TimestampSettings::UseTimestamps;
+const bool TimestampSettings::UseSysExInput;
+
+// Every call to nowMicros advances the clock by 10us
+struct SteppingPlatform
+{
+    static unsigned long now() { return 0; }
+    static unsigned long nowMicros() { return sMicros += 10; }
+    static unsigned long sMicros;
+};
+
+unsigned long SteppingPlatform::sMicros = 0;
+
+typedef midi::MidiInterface<Transport, TimestampSettings, SteppingPlatform> MidiInterface;
+typedef midi::MidiInterface<RingTransport, TimestampSettings, SteppingPlatform> RingMidiInterface;
+
+TEST(MidiInputTimestamps, disabledByDefault)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    midi::MidiInterface<Transport> midi(transport);
+
+    static const byte rxData[] = { 0x90, 12, 34 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getTimestamp(), 0u);
+}
+
+TEST(MidiInputTimestamps, latchedOnFirstByte)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0x90, 12, 0xf8, 34, // NoteOn with interleaved Clock
+        56, 78              // Running status
+    };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    SteppingPlatform::sMicros = 1000;
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),      midi::Clock);
+    EXPECT_EQ(midi.getTimestamp(), 1020u);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),      midi::NoteOn);
+    EXPECT_EQ(midi.getTimestamp(), 1010u);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getData1(),     56);
+    EXPECT_EQ(midi.getTimestamp(), 1030u);
+
+    // Copied into batched messages
+    midi::Message messages[2];
+    serial.mRxBuffer.write(0xfa);
+    EXPECT_EQ(midi.readBatch(messages, 2), 1u);
+    EXPECT_EQ(messages[0].timestamp, 1040u);
+}
+
+TEST(MidiInputTimestamps, sysExChunksKeepFrameStart)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    byte sysExBuffer[3];
+
+    static const byte rxData[] = { 0xf0, 1, 2, 3, 4, 0xf7 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    midi.setSysExBuffer(sysExBuffer, sizeof(sysExBuffer));
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+
+    SteppingPlatform::sMicros = 0;
+    unsigned chunks = 0;
+    while (serial.mRxBuffer.getLength() > 0)
+    {
+        if (midi.read())
+        {
+            EXPECT_EQ(midi.getType(),      midi::SystemExclusive);
+            EXPECT_EQ(midi.getTimestamp(), 10u);
+            chunks++;
+        }
+    }
+    EXPECT_EQ(chunks, 2u);
+}
+
+TEST(MidiInputTimestamps, transportTimestamps)
+{
+    SerialMock serial;
+    RingTransport transport(serial);
+    RingMidiInterface midi(transport);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    transport.push(0xc3, 500);
+    transport.push(42,   600);
+    transport.push(0xfe, 700);
+
+    SteppingPlatform::sMicros = 0;
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),      midi::ProgramChange);
+    EXPECT_EQ(midi.getTimestamp(), 500u);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),      midi::ActiveSensing);
+    EXPECT_EQ(midi.getTimestamp(), 700u);
+
+    // The platform clock is not used.
+    EXPECT_EQ(SteppingPlatform::sMicros, 0u);
+}
+
+END_UNNAMED_NAMESPACE
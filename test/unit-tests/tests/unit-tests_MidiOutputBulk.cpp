@@ -0,0 +1,140 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef std::vector<uint8_t> Buffer;
+
+// A serial port exposing a bulk write, like Arduino's Print class does.
+class BulkSerialMock : public SerialMock
+{
+public:
+    BulkSerialMock()
+        : mNumBulkWrites(0)
+    {
+    }
+
+    using SerialMock::write;
+    size_t write(const uint8_t* inData, size_t inSize)
+    {
+        mTxBuffer.write(inData, int(inSize));
+        mNumBulkWrites++;
+        return inSize;
+    }
+
+    unsigned mNumBulkWrites;
+};
+
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::SerialMIDI<BulkSerialMock> BulkTransport;
+typedef midi::MidiInterface<BulkTransport> BulkMidiInterface;
+
+TEST(MidiOutputBulk, detection)
+{
+    EXPECT_EQ(midi::HasBulkWrite<SerialMock>::value,     false);
+    EXPECT_EQ(midi::HasBulkWrite<BulkSerialMock>::value, true);
+    EXPECT_EQ(midi::HasBulkWrite<Transport>::value,      true);
+    EXPECT_EQ(midi::HasBulkWrite<BulkTransport>::value,  true);
+}
+
+TEST(MidiOutputBulk, serialFallback)
+{
+    SerialMock serial;
+    Transport transport(serial);
+
+    static const byte data[3] = { 0x9b, 12, 34 };
+    transport.write(data, 3);
+
+    Buffer buffer;
+    buffer.resize(3);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 3);
+    serial.mTxBuffer.read(&buffer[0], 3);
+    EXPECT_THAT(buffer, ElementsAreArray({0x9b, 12, 34}));
+}
+
+TEST(MidiOutputBulk, onePerMessage)
+{
+    BulkSerialMock serial;
+    BulkTransport transport(serial);
+    BulkMidiInterface midi(transport);
+
+    Buffer buffer;
+    buffer.resize(10);
+
+    midi.begin();
+    midi.sendNoteOn(12, 34, 1);
+    midi.sendProgramChange(42, 2);
+    midi.sendSongPosition(1234);
+    midi.sendTuneRequest();
+    midi.sendClock();
+    EXPECT_EQ(serial.mNumBulkWrites, unsigned(4));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 10);
+    serial.mTxBuffer.read(&buffer[0], 10);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0x90, 12, 34,
+        0xc1, 42,
+        0xf2, 0x52, 0x09,
+        0xf6,
+        0xf8
+    }));
+}
+
+TEST(MidiOutputBulk, runningStatus)
+{
+    typedef VariableSettings<true, true> Settings;
+    typedef midi::MidiInterface<BulkTransport, Settings> RsMidiInterface;
+
+    BulkSerialMock serial;
+    BulkTransport transport(serial);
+    RsMidiInterface midi(transport);
+
+    Buffer buffer;
+    buffer.resize(5);
+
+    midi.begin();
+    midi.sendNoteOn(12, 34, 1);
+    midi.sendNoteOn(56, 78, 1);
+    EXPECT_EQ(serial.mNumBulkWrites, unsigned(2));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 5);
+    serial.mTxBuffer.read(&buffer[0], 5);
+    EXPECT_THAT(buffer, ElementsAreArray({0x90, 12, 34, 56, 78}));
+}
+
+TEST(MidiOutputBulk, message)
+{
+    BulkSerialMock serial;
+    BulkTransport transport(serial);
+    BulkMidiInterface midi(transport);
+
+    midi::Message message;
+    message.type    = midi::ControlChange;
+    message.channel = 3;
+    message.data1   = 7;
+    message.data2   = 100;
+    message.valid   = true;
+    message.length  = 3;
+
+    Buffer buffer;
+    buffer.resize(3);
+
+    midi.begin();
+    midi.send(message);
+    EXPECT_EQ(serial.mNumBulkWrites, unsigned(1));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 3);
+    serial.mTxBuffer.read(&buffer[0], 3);
+    EXPECT_THAT(buffer, ElementsAreArray({0xb2, 7, 100}));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,180 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef std::vector<uint8_t> Buffer;
+
+// A UART with mCapacity bytes of TX buffer, drained by reading mTxBuffer.
+class LimitedSerial : public SerialMock
+{
+public:
+    LimitedSerial()
+        : mCapacity(0)
+    {
+    }
+
+    int availableForWrite() const
+    {
+        return mCapacity - mTxBuffer.getLength();
+    }
+
+    int mCapacity;
+};
+
+template<unsigned Size>
+struct CoalescingSettings : public midi::DefaultSettings
+{
+    static const unsigned CoalescedMessages = Size;
+};
+
+typedef midi::SerialMIDI<LimitedSerial> LimitedTransport;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiInterface<LimitedTransport, CoalescingSettings<8> > MidiInterface;
+typedef midi::MidiInterface<LimitedTransport, CoalescingSettings<2> > SmallMidiInterface;
+typedef midi::MidiInterface<Transport, CoalescingSettings<8> > BlindMidiInterface;
+
+static Buffer readTx(SerialMock& inSerial)
+{
+    Buffer buffer(inSerial.mTxBuffer.getLength());
+    if (!buffer.empty())
+        inSerial.mTxBuffer.read(&buffer[0], int(buffer.size()));
+    return buffer;
+}
+
+TEST(MidiOutputCoalescing, lastValueWins)
+{
+    LimitedSerial serial;
+    LimitedTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    for (byte i = 0; i < 10; ++i)
+    {
+        midi.sendControlChange(7, i, 1);
+        midi.sendPitchBend(int(i) * 100, 1);
+        midi.sendControlChange(7, i, 2);
+    }
+    midi.sendAfterTouch(12, 1);
+    midi.sendAfterTouch(34, 1);
+    midi.sendAfterTouch(60, 56, 1);
+    midi.sendAfterTouch(60, 78, 1);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    serial.mCapacity = 64;
+    midi.flush();
+    EXPECT_THAT(readTx(serial), ElementsAreArray({
+        0xb0, 7, 9,
+        0xe0, 0x04, 0x47,   // 900 + 8192
+        0xb1, 7, 9,
+        0xd0, 34,
+        0xa0, 60, 78,
+    }));
+}
+
+TEST(MidiOutputCoalescing, drainsAsRoomAllows)
+{
+    LimitedSerial serial;
+    LimitedTransport transport(serial);
+    MidiInterface midi(transport);
+
+    serial.mCapacity = 3;
+    midi.begin();
+    midi.sendControlChange(1, 10, 1);   // Room for it, written now
+    midi.sendControlChange(1, 11, 1);
+    midi.sendControlChange(1, 12, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 1, 10 }));
+
+    midi.sendControlChange(2, 20, 1);   // Room again: oldest first
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 1, 12 }));
+
+    midi.read();                        // read() flushes
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 2, 20 }));
+    midi.flush();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+}
+
+TEST(MidiOutputCoalescing, notesKeepTheirOrder)
+{
+    LimitedSerial serial;
+    LimitedTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendControlChange(midi::Sustain, 127, 1);
+    midi.sendControlChange(midi::ModulationWheel, 10, 2);
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendClock();
+    midi.sendProgramChange(5, 2);
+    midi.sendNoteOff(60, 0, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({
+        0xb0, 64, 127,      // Released before the note on its channel
+        0x90, 60, 100,
+        0xf8,
+        0xb1, 1, 10,
+        0xc1, 5,
+        0x80, 60, 0,
+    }));
+}
+
+TEST(MidiOutputCoalescing, parametersAreNotCoalesced)
+{
+    LimitedSerial serial;
+    LimitedTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.beginRpn(midi::RPN::PitchBendSensitivity, 1);
+    midi.sendRpnValue(2, 0, 1);
+    midi.beginRpn(midi::RPN::ChannelFineTuning, 1);
+    midi.sendRpnValue(64, 0, 1);
+    midi.sendControlChange(midi::AllNotesOff, 0, 1);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 9 * 3);
+}
+
+TEST(MidiOutputCoalescing, fullWritesOldest)
+{
+    LimitedSerial serial;
+    LimitedTransport transport(serial);
+    SmallMidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendControlChange(1, 1, 1);
+    midi.sendControlChange(2, 2, 1);
+    midi.sendControlChange(2, 3, 1);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    midi.sendControlChange(3, 4, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 1, 1 }));
+
+    serial.mCapacity = 64;
+    midi.flush();
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 2, 3, 0xb0, 3, 4 }));
+}
+
+TEST(MidiOutputCoalescing, unknownRoomWaitsForFlush)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    BlindMidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendControlChange(7, 1, 1);
+    midi.sendControlChange(7, 2, 1);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    midi.flush();
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb0, 7, 2 }));
+}
+
+END_UNNAMED_NAMESPACE
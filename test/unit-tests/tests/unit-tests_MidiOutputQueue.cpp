@@ -0,0 +1,184 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef std::vector<uint8_t> Buffer;
+
+// Counts transmissions, to check that a flush is a single one.
+class CountingTransport : public midi::SerialMIDI<SerialMock>
+{
+public:
+    CountingTransport(SerialMock& inSerial)
+        : midi::SerialMIDI<SerialMock>(inSerial)
+        , mNumTransmissions(0)
+        , mReady(true)
+    {
+    }
+
+    bool beginTransmission(midi::MidiType)
+    {
+        if (!mReady)
+            return false;
+
+        mNumTransmissions++;
+        return true;
+    }
+
+    unsigned mNumTransmissions;
+    bool mReady;
+};
+
+template<unsigned Size, bool RunningStatus>
+struct QueueSettings : public midi::DefaultSettings
+{
+    static const unsigned TxQueueSize = Size;
+    static const bool UseRunningStatus = RunningStatus;
+};
+
+typedef midi::MidiInterface<CountingTransport, QueueSettings<4, false> > MidiInterface;
+typedef midi::MidiInterface<CountingTransport, QueueSettings<8, true> > RsMidiInterface;
+
+TEST(MidiOutputQueue, sendQueuesUntilFlush)
+{
+    SerialMock serial;
+    CountingTransport transport(serial);
+    MidiInterface midi(transport);
+
+    Buffer buffer;
+    buffer.resize(9);
+
+    midi.begin();
+    midi.sendNoteOn(12, 34, 1);
+    midi.sendClock();
+    midi.sendSongSelect(42);
+    midi.sendProgramChange(56, 2);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(0));
+
+    midi.flush();
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(1));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 8);
+    serial.mTxBuffer.read(&buffer[0], 8);
+    buffer.resize(8);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0x90, 12, 34,
+        0xf8,
+        0xf3, 42,
+        0xc1, 56
+    }));
+
+    // Nothing left to send
+    midi.flush();
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(1));
+}
+
+TEST(MidiOutputQueue, overflowDrops)
+{
+    SerialMock serial;
+    CountingTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    for (byte i = 0; i < 6; ++i)
+    {
+        midi.sendProgramChange(i, 1);
+    }
+    midi.flush();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 8);
+
+    Buffer buffer;
+    buffer.resize(8);
+    serial.mTxBuffer.read(&buffer[0], 8);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0xc0, 0, 0xc0, 1, 0xc0, 2, 0xc0, 3
+    }));
+}
+
+TEST(MidiOutputQueue, keptWhenTransportNotReady)
+{
+    SerialMock serial;
+    CountingTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendProgramChange(1, 1);
+    midi.sendProgramChange(2, 1);
+
+    transport.mReady = false;
+    midi.flush();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(0));
+
+    transport.mReady = true;
+    midi.flush();
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(1));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 4);
+
+    Buffer buffer;
+    buffer.resize(4);
+    serial.mTxBuffer.read(&buffer[0], 4);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0xc0, 1, 0xc0, 2
+    }));
+}
+
+TEST(MidiOutputQueue, readFlushes)
+{
+    SerialMock serial;
+    CountingTransport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendNoteOff(12, 0, 3);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 3);
+}
+
+TEST(MidiOutputQueue, runningStatusPacking)
+{
+    SerialMock serial;
+    CountingTransport transport(serial);
+    RsMidiInterface midi(transport);
+
+    Buffer buffer;
+    buffer.resize(17);
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendNoteOn(64, 100, 1);
+    midi.sendClock();              // Does not break running status
+    midi.sendNoteOn(67, 100, 1);
+    midi.sendControlChange(7, 90, 1);
+    midi.sendControlChange(7, 91, 1);
+    midi.sendTuneRequest();        // Resets running status
+    midi.sendControlChange(7, 92, 1);
+    midi.flush();
+
+    EXPECT_EQ(transport.mNumTransmissions, unsigned(1));
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 17);
+    serial.mTxBuffer.read(&buffer[0], 17);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0x90, 60, 100, 64, 100,
+        0xf8,
+        67, 100,
+        0xb0, 7, 90, 7, 91,
+        0xf6,
+        0xb0, 7, 92,
+    }));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,149 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<uint8_t> Buffer;
+
+template<uint16_t Count, uint16_t Period, bool NullVelocity>
+struct RefreshSettings : public midi::DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+    static const uint16_t RunningStatusRefreshCount = Count;
+    static const uint16_t RunningStatusRefreshPeriod = Period;
+    static const bool SendNoteOffAsNullVelocityNoteOn = NullVelocity;
+    static const bool UseExternalTime = true;
+};
+
+typedef midi::MidiInterface<Transport, RefreshSettings<0, 0, true> > NoteOnMidiInterface;
+typedef midi::MidiInterface<Transport, RefreshSettings<3, 0, false> > CountMidiInterface;
+typedef midi::MidiInterface<Transport, RefreshSettings<0, 100, false> > PeriodMidiInterface;
+typedef midi::MidiInterface<Transport> MidiInterface;
+
+static Buffer readTx(SerialMock& inSerial)
+{
+    Buffer buffer(inSerial.mTxBuffer.getLength());
+    if (!buffer.empty())
+        inSerial.mTxBuffer.read(&buffer[0], int(buffer.size()));
+    return buffer;
+}
+
+TEST(MidiOutputRunningStatus, noteOffAsNullVelocityNoteOn)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    NoteOnMidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendNoteOff(60, 64, 1);
+    midi.sendNoteOn(62, 100, 1);
+    midi.sendNoteOff(62, 64, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0x90, 60, 100, 60, 0, 62, 100, 62, 0 }));
+    EXPECT_EQ(midi.getStatusBytesSent(),  1u);
+    EXPECT_EQ(midi.getStatusBytesSaved(), 3u);
+}
+
+TEST(MidiOutputRunningStatus, sendMessages)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    NoteOnMidiInterface midi(transport);
+
+    midi::Message controlChange;
+    controlChange.type    = midi::ControlChange;
+    controlChange.channel = 1;
+    controlChange.data1   = 7;
+    controlChange.data2   = 64;
+    controlChange.length  = 3;
+    controlChange.valid   = true;
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.send(controlChange);
+    midi.sendNoteOn(61, 100, 1);
+    midi.send(midi::PackedMessage(0x90, 62, 100, 3));
+    EXPECT_THAT(readTx(serial), ElementsAreArray({
+        0x90, 60, 100, 0xb0, 7, 64, 0x90, 61, 100, 62, 100
+    }));
+
+    // System Common messages cancel the running status.
+    midi.send(midi::PackedMessage(midi::SongSelect, 3, 0, 2));
+    midi.sendNoteOn(63, 100, 1);
+    midi.send(midi::PackedMessage(midi::Clock, 0, 0, 1));
+    midi.sendNoteOn(64, 100, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({
+        0xf3, 3, 0x90, 63, 100, 0xf8, 64, 100
+    }));
+}
+
+TEST(MidiOutputRunningStatus, refreshCount)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    CountMidiInterface midi(transport);
+
+    midi.begin();
+    for (byte i = 0; i < 7; ++i)
+        midi.sendControlChange(1, i, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({
+        0xb0, 1, 0, 1, 1, 1, 2,
+        0xb0, 1, 3, 1, 4, 1, 5,
+        0xb0, 1, 6,
+    }));
+    EXPECT_EQ(midi.getStatusBytesSent(),  3u);
+    EXPECT_EQ(midi.getStatusBytesSaved(), 4u);
+
+    // A new status restarts the count.
+    midi.sendControlChange(1, 7, 2);
+    midi.sendControlChange(1, 8, 2);
+    midi.sendControlChange(1, 9, 2);
+    midi.sendControlChange(1, 10, 2);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0xb1, 1, 7, 1, 8, 1, 9, 0xb1, 1, 10 }));
+}
+
+TEST(MidiOutputRunningStatus, refreshPeriod)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    PeriodMidiInterface midi(transport);
+
+    midi.setCurrentTime(1000);
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.setCurrentTime(1099);
+    midi.sendNoteOn(61, 100, 1);
+    midi.setCurrentTime(1100);
+    midi.sendNoteOn(62, 100, 1);
+    midi.sendNoteOn(63, 100, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0x90, 60, 100, 61, 100, 0x90, 62, 100, 63, 100 }));
+}
+
+TEST(MidiOutputRunningStatus, disabled)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendNoteOff(60, 64, 1);
+    EXPECT_THAT(readTx(serial), ElementsAreArray({ 0x90, 60, 100, 0x80, 60, 64 }));
+    EXPECT_EQ(midi.getStatusBytesSent(),  0u);
+    EXPECT_EQ(midi.getStatusBytesSaved(), 0u);
+}
+
+END_UNNAMED_NAMESPACE
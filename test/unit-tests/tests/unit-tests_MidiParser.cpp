@@ -0,0 +1,437 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_Parser.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef std::vector<byte> Buffer;
+typedef test_mocks::SerialMock<8192> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+
+struct ReferenceSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+    static const bool Use1ByteParsing = false;
+    static const bool HandleNullVelocityNoteOnAsNoteOff = false;
+};
+typedef midi::MidiInterface<Transport, ReferenceSettings> ReferenceInterface;
+
+// Decoded message, with the content of SysEx chunks.
+struct Record
+{
+    bool operator==(const Record& inOther) const
+    {
+        return type == inOther.type
+            && channel == inOther.channel
+            && data1 == inOther.data1
+            && data2 == inOther.data2
+            && length == inOther.length
+            && sysEx == inOther.sysEx;
+    }
+
+    midi::MidiType type;
+    midi::Channel channel;
+    byte data1;
+    byte data2;
+    byte length;
+    Buffer sysEx;
+};
+
+typedef std::vector<Record> Records;
+
+Record makeRecord(const midi::Message& inMessage, const byte* inSysEx, unsigned inSysExLength)
+{
+    Record record;
+    record.type    = inMessage.type;
+    record.channel = inMessage.channel;
+    record.data1   = inMessage.data1;
+    record.data2   = inMessage.data2;
+    record.length  = inMessage.length;
+    if (inMessage.type == midi::SystemExclusive)
+        record.sysEx.assign(inSysEx, inSysEx + inSysExLength);
+    return record;
+}
+
+class Recorder
+{
+public:
+    explicit Recorder(const midi::MidiParser& inParser)
+        : mParser(inParser)
+    {
+    }
+
+    void operator()(const midi::Message& inMessage)
+    {
+        mRecords.push_back(makeRecord(inMessage,
+                                      mParser.getSysExArray(),
+                                      mParser.getSysExArrayLength()));
+    }
+
+    const midi::MidiParser& mParser;
+    Records mRecords;
+};
+
+Records parseAll(const Buffer& inStream, unsigned inSysExSize, size_t inSlice)
+{
+    Buffer sysEx(inSysExSize);
+    midi::MidiParser parser;
+    parser.setSysExBuffer(sysEx.empty() ? nullptr : &sysEx[0], inSysExSize);
+    Recorder recorder(parser);
+
+    for (size_t offset = 0; offset < inStream.size(); offset += inSlice)
+    {
+        const size_t size = std::min(inSlice, inStream.size() - offset);
+        parser.parse(&inStream[offset], size, recorder);
+    }
+    return recorder.mRecords;
+}
+
+Records readAll(const Buffer& inStream, unsigned inSysExSize)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    ReferenceInterface midi(transport);
+    Buffer sysEx(inSysExSize);
+    midi.setSysExBuffer(&sysEx[0], inSysExSize);
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(&inStream[0], int(inStream.size()));
+
+    Records records;
+    while (serial.mRxBuffer.getLength() > 0)
+    {
+        if (midi.read())
+        {
+            midi::Message message;
+            message.type    = midi.getType();
+            message.channel = midi.getChannel();
+            message.data1   = midi.getData1();
+            message.data2   = midi.getData2();
+            const byte status = message.type < midi::SystemExclusive
+                              ? byte(message.type | (message.channel - 1))
+                              : byte(message.type);
+            message.length  = message.type == midi::SystemExclusive
+                            ? 0 : midi::getStatusInfo(status) & midi::StatusInfo::LengthMask;
+            records.push_back(makeRecord(message,
+                                         midi.getSysExArray(),
+                                         midi.getSysExArrayLength()));
+        }
+    }
+    return records;
+}
+
+// Valid traffic: running status, Real Time bytes anywhere, SysEx frames.
+Buffer makeStream(unsigned inSeed, unsigned inNumMessages)
+{
+    unsigned state = inSeed;
+    struct Random
+    {
+        unsigned& state;
+        unsigned operator()(unsigned inRange)
+        {
+            state = state * 1103515245u + 12345u;
+            return (state >> 16) % inRange;
+        }
+    } random = { state };
+
+    Buffer stream;
+    byte runningStatus = 0;
+    for (unsigned i = 0; i < inNumMessages; ++i)
+    {
+        Buffer message;
+        const unsigned kind = random(10);
+        if (kind < 6)
+        {
+            static const byte types[] = { 0x80, 0x90, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0 };
+            const byte status = random(3) == 0 && runningStatus != 0
+                              ? runningStatus
+                              : byte(types[random(7)] | random(16));
+            if (status != runningStatus || random(2) == 0)
+                message.push_back(status);
+            message.push_back(byte(random(128)));
+            if ((status & 0xe0) != 0xc0)
+                message.push_back(byte(random(128)));
+            runningStatus = status;
+        }
+        else if (kind < 8)
+        {
+            message.push_back(0xf0);
+            const unsigned length = random(100);
+            for (unsigned j = 0; j < length; ++j)
+                message.push_back(byte(random(128)));
+            message.push_back(0xf7);
+            runningStatus = 0;
+        }
+        else
+        {
+            static const byte types[] = { 0xf1, 0xf2, 0xf3 };
+            const byte status = types[random(3)];
+            message.push_back(status);
+            message.push_back(byte(random(128)));
+            if (status == 0xf2)
+                message.push_back(byte(random(128)));
+            runningStatus = 0;
+        }
+
+        for (size_t j = 0; j < message.size(); ++j)
+        {
+            if (random(8) == 0)
+                stream.push_back(random(4) ? byte(0xf8) : byte(0xfd));
+            stream.push_back(message[j]);
+        }
+    }
+    return stream;
+}
+
+// Invalid traffic: bytes dropped, stray status bytes, Tune Requests.
+Buffer corruptStream(const Buffer& inStream, unsigned inSeed)
+{
+    unsigned state = inSeed;
+    struct Random
+    {
+        unsigned& state;
+        unsigned operator()(unsigned inRange)
+        {
+            state = state * 1103515245u + 12345u;
+            return (state >> 16) % inRange;
+        }
+    } random = { state };
+
+    static const byte strays[] = { 0x90, 0xb3, 0xc5, 0xf0, 0xf2, 0xf4, 0xf6, 0xf7 };
+    Buffer stream;
+    for (size_t i = 0; i < inStream.size(); ++i)
+    {
+        const unsigned kind = random(20);
+        if (kind == 0)
+            continue;
+        if (kind == 1)
+            stream.push_back(strays[random(8)]);
+        stream.push_back(inStream[i]);
+    }
+    return stream;
+}
+
+// -----------------------------------------------------------------------------
+
+TEST(MidiParser, findStatusByte)
+{
+    Buffer data(100, 0x42);
+    for (size_t begin = 0; begin < 40; ++begin)
+    {
+        for (size_t end = begin; end < data.size(); end += 7)
+        {
+            EXPECT_EQ(midi::MidiParser::findStatusByte(&data[begin], &data[end]), &data[end]);
+        }
+        for (size_t status = begin; status < data.size(); ++status)
+        {
+            data[status] = 0x80 | byte(status);
+            EXPECT_EQ(midi::MidiParser::findStatusByte(&data[begin], &data[0] + data.size()),
+                      &data[status]);
+            data[status] = 0x42;
+        }
+    }
+}
+
+TEST(MidiParser, runningStatus)
+{
+    Buffer stream(1, 0x9b);
+    for (byte i = 0; i < 50; ++i)
+    {
+        stream.push_back(i);
+        stream.push_back(byte(127 - i));
+    }
+    stream.push_back(0xc0);
+    stream.push_back(12);
+    stream.push_back(34);
+
+    std::vector<midi::Message> messages;
+    midi::MidiParser parser;
+    EXPECT_EQ(parser.parse(&stream[0], stream.size(),
+                           [&](const midi::Message& inMessage) { messages.push_back(inMessage); }),
+              size_t(52));
+    ASSERT_EQ(messages.size(), size_t(52));
+    for (byte i = 0; i < 50; ++i)
+    {
+        EXPECT_EQ(messages[i].type,    midi::NoteOn);
+        EXPECT_EQ(messages[i].channel, 12);
+        EXPECT_EQ(messages[i].data1,   i);
+        EXPECT_EQ(messages[i].data2,   127 - i);
+        EXPECT_EQ(messages[i].length,  3);
+        EXPECT_EQ(messages[i].valid,   true);
+    }
+    EXPECT_EQ(messages[50].type,   midi::ProgramChange);
+    EXPECT_EQ(messages[50].data1,  12);
+    EXPECT_EQ(messages[50].length, 2);
+    EXPECT_EQ(messages[51].data1,  34);
+    EXPECT_EQ(parser.getErrorCount(), 0ul);
+}
+
+TEST(MidiParser, realTimeInterleaved)
+{
+    static const byte stream[] = {
+        0xb3, 0xf8, 7, 0xfd, 0xfa, 100,
+        8, 0xfe, 90,
+    };
+    midi::Message messages[8];
+    midi::MidiParser parser;
+    EXPECT_EQ(parser.parseTo(stream, sizeof(stream), messages) - messages, 5);
+    EXPECT_EQ(messages[0].type,    midi::Clock);
+    EXPECT_EQ(messages[0].length,  1);
+    EXPECT_EQ(messages[0].channel, 0);
+    EXPECT_EQ(messages[1].type,    midi::Start);
+    EXPECT_EQ(messages[2].type,    midi::ControlChange);
+    EXPECT_EQ(messages[2].channel, 4);
+    EXPECT_EQ(messages[2].data1,   7);
+    EXPECT_EQ(messages[2].data2,   100);
+    EXPECT_EQ(messages[3].type,    midi::ActiveSensing);
+    EXPECT_EQ(messages[4].type,    midi::ControlChange);
+    EXPECT_EQ(messages[4].data1,   8);
+    EXPECT_EQ(messages[4].data2,   90);
+}
+
+TEST(MidiParser, sysExChunks)
+{
+    Buffer stream(1, 0xf0);
+    for (byte i = 0; i < 40; ++i)
+        stream.push_back(i);
+    stream.push_back(0xf8);
+    stream.push_back(40);
+    stream.push_back(0xf7);
+    stream.push_back(0xc1);
+    stream.push_back(5);
+
+    const Records records = parseAll(stream, 16, stream.size());
+    ASSERT_EQ(records.size(), size_t(5));
+    EXPECT_EQ(records[0].type,  midi::SystemExclusive);
+    EXPECT_EQ(records[0].data1, 16);
+    EXPECT_EQ(records[0].data2, 0);
+    EXPECT_EQ(records[0].length, 0);
+    EXPECT_EQ(records[1].sysEx.size(), size_t(16));
+    EXPECT_EQ(records[2].type,  midi::Clock);
+    EXPECT_EQ(records[3].type,  midi::SystemExclusive);
+    EXPECT_EQ(records[3].data1, 11);
+    EXPECT_EQ(records[4].type,  midi::ProgramChange);
+
+    Buffer frame;
+    for (unsigned i = 0; i < 4; ++i)
+        frame.insert(frame.end(), records[i].sysEx.begin(), records[i].sysEx.end());
+    stream.erase(stream.begin() + 41); // Clock
+    EXPECT_EQ(frame, Buffer(stream.begin(), stream.end() - 2));
+}
+
+TEST(MidiParser, sysExSkippedWithoutBuffer)
+{
+    static const byte stream[] = {
+        0xf0, 1, 2, 3, 0xf8, 4, 0xf7,
+        0xe0, 0, 64,
+    };
+    midi::Message messages[4];
+    midi::MidiParser parser;
+    EXPECT_EQ(parser.parseTo(stream, sizeof(stream), messages) - messages, 2);
+    EXPECT_EQ(messages[0].type, midi::Clock);
+    EXPECT_EQ(messages[1].type, midi::PitchBend);
+    EXPECT_EQ(parser.getErrorCount(), 0ul);
+}
+
+TEST(MidiParser, errors)
+{
+    static const byte stream[] = {
+        12, 34,             // Data without running status
+        0x90, 60,           // Interrupted by a status byte
+        0x80, 60, 0,
+        0xf0, 1, 2,         // Interrupted SysEx frame
+        0xb0, 7, 100,
+        0xf7,               // EOX without frame
+        0xf4,               // Undefined
+        1,                  // Running status was cancelled
+    };
+    byte sysEx[16];
+    midi::Message messages[4];
+    midi::MidiParser parser;
+    parser.setSysExBuffer(sysEx, sizeof(sysEx));
+    EXPECT_EQ(parser.parseTo(stream, sizeof(stream), messages) - messages, 2);
+    EXPECT_EQ(messages[0].type,  midi::NoteOff);
+    EXPECT_EQ(messages[0].data1, 60);
+    EXPECT_EQ(messages[1].type,  midi::ControlChange);
+    EXPECT_EQ(messages[1].data2, 100);
+    EXPECT_EQ(parser.getErrorCount(), 7ul);
+
+    parser.reset();
+    EXPECT_EQ(parser.getErrorCount(), 0ul);
+}
+
+TEST(MidiParser, tuneRequestCancelsRunningStatus)
+{
+    static const byte stream[] = { 0x90, 60, 100, 0xf6, 62, 100 };
+    midi::Message messages[4];
+    midi::MidiParser parser;
+    EXPECT_EQ(parser.parseTo(stream, sizeof(stream), messages) - messages, 2);
+    EXPECT_EQ(messages[1].type,   midi::TuneRequest);
+    EXPECT_EQ(messages[1].length, 1);
+    EXPECT_EQ(parser.getErrorCount(), 2ul);
+}
+
+TEST(MidiParser, matchesMidiInterface)
+{
+    for (unsigned seed = 1; seed <= 8; ++seed)
+    {
+        const Buffer stream = makeStream(seed, 150);
+        const Records expected = readAll(stream, 32);
+        ASSERT_FALSE(expected.empty());
+        EXPECT_EQ(parseAll(stream, 32, stream.size()), expected) << "seed " << seed;
+    }
+}
+
+TEST(MidiParser, matchesMidiInterfaceOnErrors)
+{
+    static const byte interrupted[] = { 0x90, 0x3c, 0xb0, 0x07, 0x40 };
+    static const byte tuneRequest[] = { 0x90, 0x3c, 0x64, 0xf6, 0x3d, 0x64 };
+    static const byte errors[] = {
+        12, 34, 0x90, 60, 0x80, 60, 0, 0xf0, 1, 2, 0xb0, 7, 100, 0xf7, 0xf4, 1,
+    };
+
+    const Buffer interruptedStream(interrupted, interrupted + sizeof(interrupted));
+    const Records interruptedRecords = parseAll(interruptedStream, 32, interruptedStream.size());
+    ASSERT_EQ(interruptedRecords.size(), size_t(1));
+    EXPECT_EQ(interruptedRecords[0].type,  midi::ControlChange);
+    EXPECT_EQ(interruptedRecords[0].data1, 7);
+    EXPECT_EQ(interruptedRecords[0].data2, 64);
+    EXPECT_EQ(readAll(interruptedStream, 32), interruptedRecords);
+
+    const Buffer tuneRequestStream(tuneRequest, tuneRequest + sizeof(tuneRequest));
+    const Records tuneRequestRecords = parseAll(tuneRequestStream, 32, tuneRequestStream.size());
+    ASSERT_EQ(tuneRequestRecords.size(), size_t(2));
+    EXPECT_EQ(tuneRequestRecords[1].type, midi::TuneRequest);
+    EXPECT_EQ(readAll(tuneRequestStream, 32), tuneRequestRecords);
+
+    const Buffer errorsStream(errors, errors + sizeof(errors));
+    EXPECT_EQ(readAll(errorsStream, 32), parseAll(errorsStream, 32, errorsStream.size()));
+
+    for (unsigned seed = 1; seed <= 8; ++seed)
+    {
+        const Buffer stream = corruptStream(makeStream(seed, 150), seed);
+        EXPECT_EQ(parseAll(stream, 32, stream.size()), readAll(stream, 32)) << "seed " << seed;
+    }
+}
+
+TEST(MidiParser, slicesOfAnySize)
+{
+    const Buffer stream = makeStream(42, 300);
+    const Records expected = parseAll(stream, 24, stream.size());
+    for (size_t slice = 1; slice < 40; ++slice)
+    {
+        EXPECT_EQ(parseAll(stream, 24, slice), expected) << "slice " << slice;
+    }
+}
+
+END_UNNAMED_NAMESPACE
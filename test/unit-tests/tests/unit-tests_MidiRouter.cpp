@@ -0,0 +1,316 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_Router.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<byte> Buffer;
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+};
+
+struct RunningStatusSettings : public SysExSettings
+{
+    static const bool UseRunningStatus = true;
+};
+
+const bool SysExSettings::UseSysExInput;
+const bool RunningStatusSettings::UseRunningStatus;
+
+struct ManualPlatform
+{
+    static unsigned long now()          { return sMillis; }
+    static unsigned long nowMicros()    { return sMillis * 1000; }
+    static unsigned long sMillis;
+};
+
+unsigned long ManualPlatform::sMillis = 0;
+
+typedef midi::MidiInterface<Transport, SysExSettings, ManualPlatform> MidiInterface;
+typedef midi::MidiInterface<Transport, RunningStatusSettings, ManualPlatform> RunningStatusMidiInterface;
+
+template<unsigned NumPorts, class Interface = MidiInterface>
+struct Ports
+{
+    typedef midi::MidiRouter<Interface, NumPorts> Router;
+
+    Ports()
+    {
+        for (unsigned i = 0; i < NumPorts; ++i)
+        {
+            transports[i] = new Transport(serials[i]);
+            interfaces[i] = new Interface(*transports[i]);
+            interfaces[i]->begin(MIDI_CHANNEL_OMNI);
+            interfaces[i]->turnThruOff();
+            interfaces[i]->setSysExBuffer(sysExBuffers[i], sizeof(sysExBuffers[i]));
+        }
+    }
+    ~Ports()
+    {
+        for (unsigned i = 0; i < NumPorts; ++i)
+        {
+            delete interfaces[i];
+            delete transports[i];
+        }
+    }
+
+    Buffer readTx(unsigned inPort)
+    {
+        Buffer buffer(unsigned(serials[inPort].mTxBuffer.getLength()));
+        if (!buffer.empty())
+            serials[inPort].mTxBuffer.read(&buffer[0], unsigned(buffer.size()));
+        return buffer;
+    }
+
+    SerialMock      serials[NumPorts];
+    Transport*      transports[NumPorts];
+    Interface*      interfaces[NumPorts];
+    byte            sysExBuffers[NumPorts][4];
+};
+
+// -----------------------------------------------------------------------------
+
+TEST(MidiRouter, typeBits)
+{
+    EXPECT_EQ(midi::getTypeBit(midi::NoteOff),         uint32_t(1) << 0);
+    EXPECT_EQ(midi::getTypeBit(midi::PitchBend),       uint32_t(1) << 6);
+    EXPECT_EQ(midi::getTypeBit(midi::SystemExclusive), uint32_t(1) << 16);
+    EXPECT_EQ(midi::getTypeBit(midi::Clock),           uint32_t(1) << 24);
+    EXPECT_EQ(midi::getTypeBit(midi::SystemReset),     uint32_t(1) << 31);
+}
+
+TEST(MidiRouter, noRoute)
+{
+    Ports<2> ports;
+    Ports<2>::Router router(ports.interfaces);
+
+    static const byte rxData[] = { 0x90, 12, 34, 0xf8 };
+    ports.serials[0].mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(router.service(), unsigned(2));
+    EXPECT_EQ(ports.serials[0].mRxBuffer.getLength(), 0);
+    EXPECT_EQ(ports.serials[0].mTxBuffer.getLength(), 0);
+    EXPECT_EQ(ports.serials[1].mTxBuffer.getLength(), 0);
+}
+
+TEST(MidiRouter, merge)
+{
+    Ports<3> ports;
+    Ports<3>::Router router(ports.interfaces);
+    router.setRoute(0, 2);
+    router.setRoute(1, 2);
+
+    static const byte rxData0[] = { 0x90, 12, 34 };
+    static const byte rxData1[] = { 0xb1, 7, 64, 0xf8 };
+    ports.serials[0].mRxBuffer.write(rxData0, sizeof(rxData0));
+    ports.serials[1].mRxBuffer.write(rxData1, sizeof(rxData1));
+
+    EXPECT_EQ(router.service(), unsigned(3));
+    // Real-time goes first, queued messages are sent at the end.
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0xf8, 0x90, 12, 34, 0xb1, 7, 64
+    }));
+    EXPECT_EQ(ports.serials[0].mTxBuffer.getLength(), 0);
+    EXPECT_EQ(ports.serials[1].mTxBuffer.getLength(), 0);
+}
+
+TEST(MidiRouter, splitWithMasks)
+{
+    typedef Ports<3>::Router Router;
+    Ports<3> ports;
+    Router router(ports.interfaces);
+    router.setRoute(0, 1, 0x0001);
+    router.setRoute(0, 2, 0x0002, midi::getTypeBit(midi::NoteOn));
+
+    static const byte rxData[] = {
+        0x90, 12, 34,   // NoteOn channel 1
+        0x91, 56, 78,   // NoteOn channel 2
+        0xb1, 7, 64,    // ControlChange channel 2
+        0xf3, 5         // SongSelect
+    };
+    ports.serials[0].mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(router.service(), unsigned(4));
+
+    EXPECT_THAT(ports.readTx(1), ElementsAreArray({
+        0x90, 12, 34, 0xf3, 5
+    }));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0x91, 56, 78
+    }));
+}
+
+TEST(MidiRouter, byteBudget)
+{
+    Ports<3> ports;
+    Ports<3>::Router router(ports.interfaces);
+    router.setRoute(0, 2);
+    router.setRoute(1, 2);
+    router.setByteBudget(0, 3);
+    router.setByteBudget(1, 3);
+
+    // Port 0 is flooded, port 1 still gets through on every service.
+    static const byte rxData0[] = {
+        0x90, 1, 1, 0x90, 2, 2, 0x90, 3, 3
+    };
+    static const byte rxData1[] = {
+        0x81, 4, 0, 0x81, 5, 0
+    };
+    ports.serials[0].mRxBuffer.write(rxData0, sizeof(rxData0));
+    ports.serials[1].mRxBuffer.write(rxData1, sizeof(rxData1));
+
+    EXPECT_EQ(router.service(), unsigned(2));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0x90, 1, 1, 0x81, 4, 0
+    }));
+    EXPECT_EQ(ports.serials[0].mRxBuffer.getLength(), 6);
+    EXPECT_EQ(ports.serials[1].mRxBuffer.getLength(), 3);
+
+    // Port 1 is serviced first this time.
+    EXPECT_EQ(router.service(), unsigned(2));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0x81, 5, 0, 0x90, 2, 2
+    }));
+
+    EXPECT_EQ(router.service(), unsigned(1));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0x90, 3, 3
+    }));
+
+    // Muted port
+    router.setByteBudget(0, 0);
+    ports.serials[0].mRxBuffer.write(rxData0, sizeof(rxData0));
+    EXPECT_EQ(router.service(), unsigned(0));
+    EXPECT_EQ(ports.serials[0].mRxBuffer.getLength(), int(sizeof(rxData0)));
+}
+
+TEST(MidiRouter, sysExIsNotInterleaved)
+{
+    Ports<3> ports;
+    Ports<3>::Router router(ports.interfaces);
+    router.setRoute(0, 2);
+    router.setRoute(1, 2);
+    router.setByteBudget(0, 4);
+    router.setByteBudget(1, 4);
+
+    static const byte rxData0[] = { 0xf0, 1, 2, 3, 4, 5, 6, 0xf7 };
+    static const byte rxData1[] = { 0x91, 12, 34, 0xf8 };
+    ports.serials[0].mRxBuffer.write(rxData0, sizeof(rxData0));
+    ports.serials[1].mRxBuffer.write(rxData1, sizeof(rxData1));
+
+    // First chunk of the frame locks the output, port 1 is still read:
+    // its Clock goes right away, its Note On waits for the end of the frame.
+    EXPECT_EQ(router.service(), unsigned(3));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0xf0, 1, 2, 3, 0xf8
+    }));
+    EXPECT_EQ(ports.serials[1].mRxBuffer.getLength(), 0);
+
+    EXPECT_EQ(router.service(), unsigned(1));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        4, 5, 6, 0xf7, 0x91, 12, 34
+    }));
+
+    // Another frame meanwhile is dropped.
+    static const byte rxData2[] = { 0xf0, 7, 8, 0xf7 };
+    ports.serials[0].mRxBuffer.write(rxData0, 4);
+    ports.serials[1].mRxBuffer.write(rxData2, sizeof(rxData2));
+    EXPECT_EQ(router.service(), unsigned(2));
+    EXPECT_EQ(router.getDroppedCount(), unsigned(1));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0xf0, 1, 2, 3
+    }));
+}
+
+TEST(MidiRouter, sysExTimeout)
+{
+    Ports<3> ports;
+    Ports<3>::Router router(ports.interfaces);
+    router.setRoute(0, 2);
+    router.setRoute(1, 2);
+    router.setByteBudget(0, 4);
+    router.setSysExTimeout(100);
+
+    // Sender stops in the middle of a frame.
+    static const byte rxData0[] = { 0xf0, 1, 2, 3 };
+    static const byte rxData1[] = { 0xc1, 5 };
+    ManualPlatform::sMillis = 1000;
+    ports.serials[0].mRxBuffer.write(rxData0, sizeof(rxData0));
+    ports.serials[1].mRxBuffer.write(rxData1, sizeof(rxData1));
+    EXPECT_EQ(router.service(), unsigned(2));
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0xf0, 1, 2, 3
+    }));
+
+    ManualPlatform::sMillis = 1099;
+    router.service();
+    EXPECT_TRUE(ports.readTx(2).empty());
+
+    ManualPlatform::sMillis = 1100;
+    router.service();
+    EXPECT_THAT(ports.readTx(2), ElementsAreArray({
+        0xc1, 5
+    }));
+
+    // The rest of the timed out frame is dropped.
+    static const byte rxData2[] = { 4, 5, 0xf7 };
+    ports.serials[0].mRxBuffer.write(rxData2, sizeof(rxData2));
+    router.service();
+    EXPECT_TRUE(ports.readTx(2).empty());
+    EXPECT_EQ(router.getDroppedCount(), unsigned(1));
+}
+
+TEST(MidiRouter, runningStatusOutput)
+{
+    typedef Ports<2, RunningStatusMidiInterface> RunningStatusPorts;
+    RunningStatusPorts ports;
+    RunningStatusPorts::Router router(ports.interfaces);
+    router.setRoute(0, 1);
+
+    // The application also sends on the output.
+    static const byte rxData[] = { 0xb0, 7, 64, 0xf3, 2, 0x90, 62, 100 };
+    ports.serials[0].mRxBuffer.write(rxData, sizeof(rxData));
+    ports.interfaces[1]->sendNoteOn(60, 100, 1);
+    router.service();
+    ports.interfaces[1]->sendNoteOn(61, 100, 1);
+    EXPECT_THAT(ports.readTx(1), ElementsAreArray({
+        0x90, 60, 100,
+        0xb0, 7, 64,
+        0xf3, 2,
+        0x90, 62, 100,
+        61, 100
+    }));
+}
+
+TEST(MidiRouter, queueOverflow)
+{
+    typedef midi::MidiRouter<MidiInterface, 2, 2> Router;
+    Ports<2> ports;
+    Router router(ports.interfaces);
+    router.setRoute(0, 1);
+    router.setByteBudget(0, 255);
+
+    static const byte rxData[] = {
+        0xc0, 1, 0xc0, 2, 0xc0, 3, 0xc0, 4
+    };
+    ports.serials[0].mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(router.service(), unsigned(4));
+    EXPECT_EQ(router.getDroppedCount(), unsigned(2));
+    EXPECT_THAT(ports.readTx(1), ElementsAreArray({
+        0xc0, 1, 0xc0, 2
+    }));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,261 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<byte> Buffer;
+
+struct SchedulerSettings : public midi::DefaultSettings
+{
+    static const unsigned ScheduledMessages = 8;
+};
+
+struct UsbSchedulerSettings : public SchedulerSettings
+{
+    static const unsigned long SchedulerBaudRate = 0;
+};
+
+struct ExternalTimeSettings : public SchedulerSettings
+{
+    static const bool UseExternalTime = true;
+};
+
+struct ClockPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros; }
+    static unsigned long sMicros;
+};
+
+unsigned long ClockPlatform::sMicros = 0;
+
+typedef midi::MidiInterface<Transport, SchedulerSettings, ClockPlatform> MidiInterface;
+typedef midi::MidiInterface<Transport, UsbSchedulerSettings, ClockPlatform> UsbMidiInterface;
+typedef midi::MidiInterface<Transport, ExternalTimeSettings, ClockPlatform> ExternalTimeMidiInterface;
+typedef midi::MidiInterface<Transport, midi::DefaultSettings, ClockPlatform> DefaultMidiInterface;
+
+Buffer takeSent(SerialMock& inSerial)
+{
+    Buffer sent(unsigned(inSerial.mTxBuffer.getLength()));
+    if (!sent.empty())
+        inSerial.mTxBuffer.read(&sent[0], int(sent.size()));
+    return sent;
+}
+
+midi::PackedMessage noteOn(byte inNote)
+{
+    return midi::PackedMessage(0x90, inNote, 100, 3);
+}
+
+const midi::PackedMessage sClock(midi::Clock, 0, 0, 1);
+
+TEST(MidiScheduler, disabledTakesNoSpace)
+{
+    EXPECT_TRUE((std::is_empty<midi::OutputScheduler<0, 31250> >::value));
+    EXPECT_EQ((midi::OutputScheduler<8, 31250>::ByteTime), 320ul);
+
+    SerialMock serial;
+    Transport transport(serial);
+    DefaultMidiInterface midi(transport);
+    midi.begin();
+
+    ClockPlatform::sMicros = 0;
+    EXPECT_TRUE(midi.sendAt(5000, noteOn(60)));
+    static const byte expected[] = { 0x90, 60, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(expected, expected + 3));
+}
+
+TEST(MidiScheduler, sendsInTimeOrder)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin();
+    ClockPlatform::sMicros = 0;
+
+    EXPECT_TRUE(midi.sendAt(3000, noteOn(62)));
+    EXPECT_TRUE(midi.sendAt(1000, noteOn(60)));
+    EXPECT_TRUE(midi.sendAt(2000, midi::PackedMessage(0xf3, 4, 0, 2))); // Song Select
+    EXPECT_FALSE(midi.sendAt(0, midi::PackedMessage(0xf0, 0, 0, 1)));   // No SysEx
+
+    midi.service(999);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    midi.service(1000);
+    static const byte first[] = { 0x90, 60, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(first, first + 3));
+
+    // The line is busy until 1960.
+    midi.service(2000);
+    midi.service(3500);
+    static const byte next[] = { 0xf3, 4, 0x90, 62, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(next, next + 5));
+}
+
+TEST(MidiScheduler, accountsForQueuedBytes)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin();
+
+    // 10 bytes written at 0 keep the line busy until 3200 us.
+    ClockPlatform::sMicros = 0;
+    static const byte sysEx[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    midi.sendSysEx(8, sysEx);
+    takeSent(serial);
+
+    EXPECT_TRUE(midi.sendAt(3000, noteOn(60)));
+    EXPECT_TRUE(midi.sendAt(7000, noteOn(62)));
+
+    // Written now, it reaches the line at 3200 anyway.
+    ClockPlatform::sMicros = 100;
+    midi.service(100);
+    EXPECT_EQ(takeSent(serial).size(), 3u);
+
+    // Busy until 4160: the next note must wait.
+    ClockPlatform::sMicros = 5000;
+    midi.service(5000);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    // A message written at 6500 keeps the line until 7460:
+    // the note can go, it will be on time.
+    ClockPlatform::sMicros = 6500;
+    midi.sendControlChange(1, 2, 1);
+    takeSent(serial);
+    midi.service(6500);
+    EXPECT_EQ(takeSent(serial).size(), 3u);
+}
+
+TEST(MidiScheduler, realTimeGoesFirst)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin();
+    ClockPlatform::sMicros = 0;
+
+    // The note (960 us on the line) would delay the clock by 460 us.
+    EXPECT_TRUE(midi.sendAt(1000, noteOn(60)));
+    EXPECT_TRUE(midi.sendAt(1500, sClock));
+    EXPECT_TRUE(midi.sendAt(5000, sClock));
+
+    ClockPlatform::sMicros = 1000;
+    midi.service(1000);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    ClockPlatform::sMicros = 1500;
+    midi.service(1500);
+    static const byte expected[] = { 0xf8, 0x90, 60, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(expected, expected + 4));
+
+    // Late messages: the clock is written before the note due earlier.
+    EXPECT_TRUE(midi.sendAt(4000, noteOn(62)));
+    ClockPlatform::sMicros = 6000;
+    midi.service(6000);
+    static const byte late[] = { 0xf8, 0x90, 62, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(late, late + 4));
+}
+
+TEST(MidiScheduler, withoutLineRate)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    UsbMidiInterface midi(transport);
+    midi.begin();
+    ClockPlatform::sMicros = 0;
+
+    EXPECT_TRUE(midi.sendAt(1000, noteOn(60)));
+    EXPECT_TRUE(midi.sendAt(1001, sClock));
+    EXPECT_TRUE(midi.sendAt(1001, noteOn(62)));
+
+    midi.service(1000);
+    EXPECT_EQ(takeSent(serial).size(), 3u);
+    midi.service(1001);
+    static const byte expected[] = { 0xf8, 0x90, 62, 100 };
+    EXPECT_EQ(takeSent(serial), Buffer(expected, expected + 4));
+}
+
+TEST(MidiScheduler, overflow)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin();
+
+    for (byte i = 0; i < 6; ++i)
+        EXPECT_TRUE(midi.sendAt(1000u + i, noteOn(i)));
+    EXPECT_TRUE(midi.sendAt(1000, sClock));
+    EXPECT_TRUE(midi.sendAt(2000, sClock));
+    EXPECT_EQ(midi.getLastError() & (1 << midi::ErrorScheduleOverflow), 0);
+
+    EXPECT_FALSE(midi.sendAt(1000, sClock));
+    EXPECT_NE(midi.getLastError() & (1 << midi::ErrorScheduleOverflow), 0);
+
+    midi.clearSchedule();
+    midi.service(100000);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    EXPECT_TRUE(midi.sendAt(1000, sClock));
+}
+
+TEST(MidiScheduler, flushAndRead)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    midi.begin();
+
+    ClockPlatform::sMicros = 0;
+    EXPECT_TRUE(midi.sendAt(500, sClock));
+    midi.flush();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+
+    ClockPlatform::sMicros = 500;
+    EXPECT_FALSE(midi.read());
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 1);
+
+    // With external time, only service() writes them.
+    SerialMock externalSerial;
+    Transport externalTransport(externalSerial);
+    ExternalTimeMidiInterface external(externalTransport);
+    external.begin();
+    EXPECT_TRUE(external.sendAt(500, sClock));
+    external.flush();
+    EXPECT_EQ(externalSerial.mTxBuffer.getLength(), 0);
+    external.service(500);
+    EXPECT_EQ(externalSerial.mTxBuffer.getLength(), 1);
+}
+
+TEST(MidiScheduler, wrapAround)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    UsbMidiInterface midi(transport);
+    midi.begin();
+
+    const unsigned long now = 0xffffff00ul;
+    EXPECT_TRUE(midi.sendAt(now + 0x200, noteOn(62)));   // After the wrap
+    EXPECT_TRUE(midi.sendAt(now + 0x10, noteOn(60)));
+
+    midi.service(now + 0x10);
+    EXPECT_EQ(takeSent(serial).size(), 3u);
+    midi.service(now + 0x1ff);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+    midi.service(now + 0x200);
+    EXPECT_EQ(takeSent(serial).size(), 3u);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,117 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiStatistics MidiStatistics;
+
+struct StatisticsSettings : public midi::DefaultSettings
+{
+    static const bool UseStatistics = true;
+    static const bool UseRunningStatus = true;
+};
+
+const bool StatisticsSettings::UseStatistics;
+const bool StatisticsSettings::UseRunningStatus;
+
+// Each reading of the clock takes 5 us.
+struct SlowPlatform
+{
+    static unsigned long now() { return 0; }
+    static unsigned long nowMicros() { return sMicros += 5; }
+    static unsigned long sMicros;
+};
+
+unsigned long SlowPlatform::sMicros = 0;
+
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef midi::MidiInterface<Transport, StatisticsSettings, SlowPlatform> StatisticsMidiInterface;
+
+TEST(MidiStatistics, disabledTakesNoSpace)
+{
+    EXPECT_TRUE(std::is_empty<midi::StatisticsCounters<false> >::value);
+    EXPECT_GE(sizeof(StatisticsMidiInterface), sizeof(MidiInterface) + sizeof(MidiStatistics));
+
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(0xf8);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getStatistics().bytesReceived, 0u);
+    EXPECT_EQ(midi.getStatistics().getMessagesReceived(midi::Clock), 0u);
+}
+
+TEST(MidiStatistics, input)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    StatisticsMidiInterface midi(transport);
+
+    static const unsigned rxSize = 12;
+    static const byte rxData[rxSize] = {
+        12,             // Data without running status
+        0x90, 60, 100,
+        62, 100,        // Running status
+        0xfd,           // Undefined
+        0xf8,
+        0x91, 1, 1,     // Other channel
+        0xf6,
+    };
+    midi.begin(1);
+    serial.mRxBuffer.write(rxData, rxSize);
+
+    unsigned numMessages = 0;
+    for (unsigned i = 0; i < rxSize; ++i)
+        numMessages += midi.read() ? 1 : 0;
+    EXPECT_EQ(numMessages, 4u);
+
+    const MidiStatistics statistics = midi.takeStatistics();
+    EXPECT_EQ(statistics.bytesReceived,         12u);
+    EXPECT_EQ(statistics.getMessagesReceived(midi::NoteOn),      3u);
+    EXPECT_EQ(statistics.getMessagesReceived(midi::Clock),       1u);
+    EXPECT_EQ(statistics.getMessagesReceived(midi::TuneRequest), 1u);
+    EXPECT_EQ(statistics.getMessagesReceived(midi::NoteOff),     0u);
+    EXPECT_EQ(statistics.parseErrors,           1u);
+    EXPECT_EQ(statistics.undefinedBytes,        1u);
+    EXPECT_EQ(statistics.filteredMessages,      1u);
+    EXPECT_EQ(statistics.runningStatusReceived, 1u);
+
+    // Reset by takeStatistics
+    EXPECT_EQ(midi.getStatistics().bytesReceived, 0u);
+    EXPECT_EQ(midi.getStatistics().getMessagesReceived(midi::NoteOn), 0u);
+}
+
+TEST(MidiStatistics, output)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    StatisticsMidiInterface midi(transport);
+
+    midi.begin();
+    midi.resetStatistics();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendNoteOn(62, 100, 1);
+    midi.sendNoteOn(64, 100, 1);
+    midi.sendClock();
+
+    const MidiStatistics statistics = midi.getStatistics();
+    EXPECT_EQ(statistics.runningStatusSent, 2u);
+    EXPECT_EQ(statistics.sendMicros, 4u * 5u);
+}
+
+END_UNNAMED_NAMESPACE
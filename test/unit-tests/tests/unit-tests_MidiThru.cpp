@@ -1,6 +1,6 @@
 #include "unit-tests.h"
 #include "unit-tests_Settings.h"
-#include <src/MIDI.h>
+#include <src/MIDILite.h>
 #include <test/mocks/test-mocks_SerialMock.h>
 
 BEGIN_MIDI_NAMESPACE
@@ -386,4 +386,102 @@ TEST(MidiThru, invalidMode)
     EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
 }
 
+TEST(MidiThru, inputChannelChange)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi((Transport&)transport);
+
+    Buffer buffer;
+
+    midi.begin(12);
+    midi.setThruFilterMode(midi::Thru::SameChannel);
+    midi.setInputChannel(13);
+
+    static const unsigned rxSize = 6;
+    static const byte rxData[rxSize] = { 0x9b, 12, 34, 0x9c, 56, 78 };
+    serial.mRxBuffer.write(rxData, rxSize);
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    buffer.clear();
+    buffer.resize(3);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 3);
+    serial.mTxBuffer.read(&buffer[0], 3);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0x9c, 56, 78
+    }));
+}
+
+TEST(MidiThru, realTimeKeepsTxRunningStatus)
+{
+    typedef VariableSettings<true, true> Settings;
+    typedef midi::MidiInterface<Transport, Settings> RsMidiInterface;
+
+    SerialMock serial;
+    Transport transport(serial);
+    RsMidiInterface midi((Transport&)transport);
+
+    Buffer buffer;
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    static const unsigned rxSize = 10;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 0xf8, 34,
+        56, 0xfe, 78,
+        0xf6,               // TuneRequest cancels running status
+        0x9b, 90
+    };
+    serial.mRxBuffer.write(rxData, rxSize);
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+    serial.mRxBuffer.write(0);
+    midi.read();
+
+    buffer.clear();
+    buffer.resize(11);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 11);
+    serial.mTxBuffer.read(&buffer[0], 11);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0xf8, 0x9b, 12, 34, 0xfe, 56, 78, 0xf6, 0x9b, 90, 0
+    }));
+}
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+};
+
+const bool SysExSettings::UseSysExInput;
+
+TEST(MidiThru, sysExChunks)
+{
+    typedef midi::MidiInterface<Transport, SysExSettings> SysExMidiInterface;
+
+    SerialMock serial;
+    Transport transport(serial);
+    SysExMidiInterface midi((Transport&)transport);
+
+    Buffer buffer;
+    byte sysExBuffer[4];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.setSysExBuffer(sysExBuffer, sizeof(sysExBuffer));
+
+    static const unsigned rxSize = 7;
+    static const byte rxData[rxSize] = { 0xf0, 1, 2, 0xf8, 3, 4, 0xf7 };
+    serial.mRxBuffer.write(rxData, rxSize);
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    buffer.clear();
+    buffer.resize(7);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 7);
+    serial.mTxBuffer.read(&buffer[0], 7);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0xf8, 0xf0, 1, 2, 3, 4, 0xf7
+    }));
+}
+
 END_UNNAMED_NAMESPACE
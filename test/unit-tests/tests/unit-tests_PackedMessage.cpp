@@ -0,0 +1,138 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef midi::Message Message;
+typedef midi::PackedMessage PackedMessage;
+typedef std::vector<uint8_t> Buffer;
+
+TEST(PackedMessage, layout)
+{
+    EXPECT_EQ(sizeof(PackedMessage), 4u);
+    EXPECT_TRUE(std::is_trivially_copyable<PackedMessage>::value);
+    EXPECT_TRUE(std::is_trivially_copyable<Message>::value);
+}
+
+TEST(PackedMessage, conversions)
+{
+    Message message;
+    message.type    = midi::ControlChange;
+    message.channel = 11;
+    message.data1   = 7;
+    message.data2   = 100;
+    message.length  = 3;
+    message.valid   = true;
+    message.timestamp = 1234;
+
+    const PackedMessage packed(message);
+    EXPECT_EQ(packed.status, 0xba);
+    EXPECT_EQ(packed.data1,  7);
+    EXPECT_EQ(packed.data2,  100);
+    EXPECT_EQ(packed.length, 3);
+    EXPECT_EQ(packed.getType(),    midi::ControlChange);
+    EXPECT_EQ(packed.getChannel(), 11);
+    EXPECT_TRUE(packed.isValid());
+
+    const Message unpacked(packed);
+    EXPECT_EQ(unpacked.type,      midi::ControlChange);
+    EXPECT_EQ(unpacked.channel,   11);
+    EXPECT_EQ(unpacked.data1,     7);
+    EXPECT_EQ(unpacked.data2,     100);
+    EXPECT_EQ(unpacked.length,    3);
+    EXPECT_EQ(unpacked.valid,     true);
+    EXPECT_EQ(unpacked.timestamp, 0u);
+
+    // System messages have no channel
+    const PackedMessage songSelect(midi::SongSelect, 12, 0, 2);
+    EXPECT_EQ(songSelect.getType(),    midi::SongSelect);
+    EXPECT_EQ(songSelect.getChannel(), 0);
+    EXPECT_EQ(Message(songSelect).channel, 0);
+    EXPECT_EQ(PackedMessage(Message(songSelect)).status, midi::SongSelect);
+
+    // SysEx chunks keep their size in the data bytes, and a length of 1
+    Message sysEx;
+    sysEx.type  = midi::SystemExclusive;
+    sysEx.data1 = 0x2c;
+    sysEx.data2 = 0x01;
+    sysEx.valid = true;
+    const PackedMessage packedSysEx(sysEx);
+    EXPECT_EQ(packedSysEx.status, midi::SystemExclusive);
+    EXPECT_EQ(packedSysEx.length, 1);
+    EXPECT_TRUE(packedSysEx.isValid());
+    EXPECT_EQ(Message(packedSysEx).type,   midi::SystemExclusive);
+    EXPECT_EQ(Message(packedSysEx).data1,  0x2c);
+    EXPECT_EQ(Message(packedSysEx).data2,  0x01);
+    EXPECT_EQ(Message(packedSysEx).length, 0);
+    EXPECT_EQ(Message(packedSysEx).valid,  true);
+
+    // Invalid messages have a null length
+    EXPECT_FALSE(PackedMessage(Message()).isValid());
+    EXPECT_FALSE(Message(PackedMessage(0x90, 60, 100, 0)).valid);
+}
+
+TEST(PackedMessage, readBatch)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const unsigned rxSize = 8;
+    static const byte rxData[rxSize] = {
+        0x9b, 12, 34,
+        56, 78,         // Running status
+        0xf8,
+        0xc0, 42,
+    };
+    PackedMessage messages[8];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    serial.mRxBuffer.write(rxData, rxSize);
+    EXPECT_EQ(midi.readBatch(messages, 8), 4u);
+    EXPECT_EQ(messages[0].status, 0x9b);
+    EXPECT_EQ(messages[0].data1,  12);
+    EXPECT_EQ(messages[0].data2,  34);
+    EXPECT_EQ(messages[0].length, 3);
+    EXPECT_EQ(messages[1].status, 0x9b);
+    EXPECT_EQ(messages[1].data1,  56);
+    EXPECT_EQ(messages[2].status, midi::Clock);
+    EXPECT_EQ(messages[2].length, 1);
+    EXPECT_EQ(messages[3].status, 0xc0);
+    EXPECT_EQ(messages[3].data1,  42);
+    EXPECT_EQ(messages[3].length, 2);
+}
+
+TEST(PackedMessage, send)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    Buffer buffer;
+
+    midi.begin();
+    midi.send(PackedMessage(0x93, 60, 100, 3));
+    midi.send(PackedMessage(0xc1, 5, 0, 2));
+    midi.send(PackedMessage(midi::Clock, 0, 0, 1));
+    midi.send(PackedMessage(0x90, 1, 2, 0));        // Invalid
+    midi.send(PackedMessage(midi::SystemExclusive, 4, 0, 1)); // No content
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 6);
+    buffer.resize(6);
+    serial.mTxBuffer.read(&buffer[0], 6);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0x93, 60, 100, 0xc1, 5, 0xf8 }));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,195 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_PosixTransport.h>
+
+#if MIDI_POSIX_PLATFORM
+
+#include <sys/socket.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef std::vector<byte> Buffer;
+
+struct SmallBufferSettings : public midi::DefaultPosixSettings
+{
+    static const unsigned BufferSize = 8;
+};
+
+typedef midi::PosixMIDI<> Transport;
+typedef midi::PosixMIDI<SmallBufferSettings> SmallTransport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+
+// Both ends of a local stream socket, standing for a device.
+struct Device
+{
+    Device()
+    {
+        EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, mFds), 0);
+    }
+
+    ~Device()
+    {
+        if (mFds[0] >= 0)
+            close(mFds[0]);
+        closePeer();
+    }
+
+    void send(const Buffer& inData)
+    {
+        EXPECT_EQ(::write(mFds[1], &inData[0], inData.size()), ssize_t(inData.size()));
+    }
+
+    Buffer receive()
+    {
+        byte data[512];
+        const ssize_t count = recv(mFds[1], data, sizeof(data), MSG_DONTWAIT);
+        return count > 0 ? Buffer(data, data + count) : Buffer();
+    }
+
+    void closePeer()
+    {
+        if (mFds[1] >= 0)
+            close(mFds[1]);
+        mFds[1] = -1;
+    }
+
+    int mFds[2];
+};
+
+TEST(PosixTransport, monotonicClock)
+{
+    const unsigned long micros = midi::DefaultPlatform::nowMicros();
+    const unsigned long millis = midi::DefaultPlatform::now();
+    usleep(2000);
+    EXPECT_GE(midi::DefaultPlatform::nowMicros() - micros, 2000ul);
+    EXPECT_GE(midi::DefaultPlatform::now() - millis, 1ul);
+    EXPECT_LT(midi::DefaultPlatform::now() - millis, 1000ul);
+}
+
+TEST(PosixTransport, readsInBatches)
+{
+    Device device;
+    Transport transport;
+    transport.attach(device.mFds[0]);
+    MidiInterface midi(transport);
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    EXPECT_TRUE(transport.isOpen());
+    EXPECT_EQ(transport.available(), 0u); // Does not block
+    EXPECT_FALSE(transport.waitForInput(0));
+
+    static const byte rxData[] = { 0x90, 60, 100, 0xf8, 0x80, 60, 0 };
+    device.send(Buffer(rxData, rxData + sizeof(rxData)));
+    EXPECT_TRUE(transport.waitForInput(100));
+
+    midi::Message messages[4];
+    EXPECT_EQ(midi.readBatch(messages, 4), 3u);
+    EXPECT_EQ(messages[0].type, midi::NoteOn);
+    EXPECT_EQ(messages[1].type, midi::Clock);
+    EXPECT_EQ(messages[2].type, midi::NoteOff);
+
+    // One read(2) per buffer: the rest waits in the device.
+    SmallTransport small;
+    small.attach(device.mFds[0]);
+    device.send(Buffer(20, 0x42));
+    EXPECT_EQ(small.available(), 8u);
+    EXPECT_EQ(small.pump(), 0u); // Buffer not consumed yet
+    for (unsigned i = 0; i < 8; ++i)
+        EXPECT_EQ(small.read(), 0x42);
+    EXPECT_EQ(small.available(), 8u);
+}
+
+TEST(PosixTransport, writesOnePerMessage)
+{
+    Device device;
+    Transport transport;
+    transport.attach(device.mFds[0]);
+    MidiInterface midi(transport);
+    midi.begin();
+
+    midi.sendNoteOn(60, 100, 1);
+    static const byte noteOn[] = { 0x90, 60, 100 };
+    EXPECT_EQ(device.receive(), Buffer(noteOn, noteOn + 3));
+
+    // Long SysEx goes past the transmit buffer.
+    SmallTransport small;
+    small.attach(device.mFds[0]);
+    midi::MidiInterface<SmallTransport> smallMidi(small);
+    smallMidi.begin();
+    const Buffer sysEx(30, 0x11);
+    smallMidi.sendSysEx(unsigned(sysEx.size()), &sysEx[0]);
+    const Buffer sent = device.receive();
+    ASSERT_EQ(sent.size(), 32u);
+    EXPECT_EQ(sent.front(), 0xf0);
+    EXPECT_EQ(sent[1], 0x11);
+    EXPECT_EQ(sent.back(), 0xf7);
+    EXPECT_EQ(small.getDroppedBytes(), 0u);
+}
+
+TEST(PosixTransport, closesOnEndOfFile)
+{
+    Device device;
+    Transport transport;
+    transport.attach(device.mFds[0]);
+
+    device.send(Buffer(1, 0xf8));
+    device.closePeer();
+    EXPECT_EQ(transport.available(), 1u);
+    EXPECT_EQ(transport.read(), 0xf8);
+    EXPECT_EQ(transport.available(), 0u);
+    EXPECT_FALSE(transport.isOpen());
+    EXPECT_FALSE(transport.beginTransmission(midi::Clock));
+    EXPECT_FALSE(transport.waitForInput(0));
+
+    // Attached descriptors are left to the application.
+    EXPECT_GE(fcntl(device.mFds[0], F_GETFD), 0);
+    EXPECT_FALSE(transport.open("/nonexistent/midi"));
+}
+
+#if defined(__linux__)
+
+TEST(PosixTransport, epollHandsPortsOnce)
+{
+    Device devices[2];
+    Transport transports[2];
+    midi::EpollPortSet ports;
+    ASSERT_TRUE(ports.begin());
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        transports[i].attach(devices[i].mFds[0]);
+        EXPECT_TRUE(ports.add(transports[i].getFd(), &transports[i]));
+    }
+    EXPECT_EQ(ports.wait(0), nullptr);
+
+    devices[1].send(Buffer(3, 0xf8));
+    EXPECT_EQ(ports.wait(100), &transports[1]);
+
+    // Not handed again until rearmed, even with input left.
+    EXPECT_EQ(ports.wait(0), nullptr);
+    EXPECT_TRUE(ports.rearm(transports[1].getFd(), &transports[1]));
+    EXPECT_EQ(ports.wait(0), &transports[1]);
+
+    // Drained: rearming does not wake the set.
+    EXPECT_EQ(transports[1].available(), 3u);
+    EXPECT_TRUE(ports.rearm(transports[1].getFd(), &transports[1]));
+    EXPECT_EQ(ports.wait(0), nullptr);
+
+    devices[0].send(Buffer(1, 0xfe));
+    EXPECT_EQ(ports.wait(100), &transports[0]);
+    EXPECT_TRUE(ports.remove(transports[0].getFd()));
+}
+
+#endif
+
+END_UNNAMED_NAMESPACE
+
+#endif
@@ -0,0 +1,138 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_RingTransport.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <thread>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<32> SerialMock;
+typedef midi::RingSerialMIDI<SerialMock, 8> Transport;
+typedef midi::MidiInterface<Transport> MidiInterface;
+typedef std::vector<byte> Buffer;
+
+TEST(RingTransport, ringWrapsAround)
+{
+    midi::SpscByteRing<4> ring;
+    EXPECT_EQ(ring.available(), unsigned(0));
+
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(ring.push(byte(i)),     true);
+        EXPECT_EQ(ring.push(byte(i + 1)), true);
+        EXPECT_EQ(ring.available(), unsigned(2));
+        EXPECT_EQ(ring.pop(), byte(i));
+        EXPECT_EQ(ring.pop(), byte(i + 1));
+    }
+    EXPECT_EQ(ring.available(), unsigned(0));
+}
+
+TEST(RingTransport, ringFull)
+{
+    midi::SpscByteRing<4> ring;
+    for (unsigned i = 0; i < 4; ++i)
+        EXPECT_EQ(ring.push(byte(i)), true);
+    EXPECT_EQ(ring.push(42), false);
+    EXPECT_EQ(ring.available(), unsigned(4));
+    EXPECT_EQ(ring.pop(), 0);
+    EXPECT_EQ(ring.push(42), true);
+
+    ring.clear();
+    EXPECT_EQ(ring.available(), unsigned(0));
+}
+
+TEST(RingTransport, pushThenParse)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+
+    static const byte rxData[] = { 0x9b, 12, 34, 0xf8 };
+    for (unsigned i = 0; i < sizeof(rxData); ++i)
+        EXPECT_EQ(transport.push(rxData[i]), true);
+
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),    midi::NoteOn);
+    EXPECT_EQ(midi.getChannel(), 12);
+    EXPECT_EQ(midi.getData1(),   12);
+    EXPECT_EQ(midi.getData2(),   34);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),    midi::Clock);
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(transport.getHighWaterMark(), unsigned(4));
+}
+
+TEST(RingTransport, pumpAndCounters)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+
+    static const byte rxData[] = {
+        0xc0, 1, 0xc0, 2, 0xc0, 3, 0xc0, 4, 0xc0, 5
+    };
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(transport.pump(), unsigned(sizeof(rxData)));
+    EXPECT_EQ(serial.mRxBuffer.getLength(), 0);
+    EXPECT_EQ(transport.getOverflowCount(), unsigned(2));
+
+    unsigned count = 0;
+    while (transport.available() > 0)
+        count += midi.read() ? 1 : 0;
+    EXPECT_EQ(count, unsigned(4));
+    EXPECT_EQ(transport.getHighWaterMark(), unsigned(8));
+
+    transport.resetHighWaterMark();
+    EXPECT_EQ(transport.getHighWaterMark(), unsigned(0));
+
+    // Transmission goes to the serial port
+    midi.sendProgramChange(42, 3);
+    Buffer buffer(2);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 2);
+    serial.mTxBuffer.read(&buffer[0], 2);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0xc2, 42 }));
+}
+
+TEST(RingTransport, crossThread)
+{
+    static const unsigned numBytes = 100000;
+    midi::SpscByteRing<16> ring;
+
+    std::thread producer([&ring]() {
+        for (unsigned i = 0; i < numBytes; ++i)
+        {
+            while (!ring.push(byte(i)))
+                std::this_thread::yield();
+        }
+    });
+
+    bool inOrder = true;
+    for (unsigned i = 0; i < numBytes; ++i)
+    {
+        while (ring.available() == 0)
+            std::this_thread::yield();
+        inOrder = inOrder && ring.pop() == byte(i);
+    }
+    producer.join();
+    EXPECT_EQ(inOrder, true);
+    EXPECT_EQ(ring.available(), unsigned(0));
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,314 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_RtpTransport.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef std::vector<byte> Buffer;
+
+// Sent datagrams are kept, received ones are queued.
+class SocketMock
+{
+public:
+    SocketMock()
+        : mBusy(false)
+    {
+    }
+
+    void begin()
+    {
+    }
+
+    bool send(const byte* inPacket, unsigned inSize)
+    {
+        if (mBusy)
+            return false;
+        mSent.push_back(Buffer(inPacket, inPacket + inSize));
+        return true;
+    }
+
+    const byte* receive(unsigned& outSize)
+    {
+        if (mReceived.empty())
+            return nullptr;
+        mCurrent = mReceived.front();
+        mReceived.erase(mReceived.begin());
+        outSize = unsigned(mCurrent.size());
+        return &mCurrent[0];
+    }
+
+    bool mBusy;
+    std::vector<Buffer> mSent;
+    std::vector<Buffer> mReceived;
+    Buffer mCurrent;
+};
+
+struct RtpTestPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros; }
+    static unsigned long sMicros;
+};
+unsigned long RtpTestPlatform::sMicros = 0;
+
+struct ImmediateSettings : public midi::DefaultRtpSettings
+{
+    static const unsigned long FlushLatency = 0;
+};
+
+struct SmallSettings : public midi::DefaultRtpSettings
+{
+    static const unsigned PacketSize = 32;
+    static const unsigned long FlushLatency = 1000000;
+};
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+    static const bool Use1ByteParsing = false;
+};
+
+typedef midi::RtpMIDI<SocketMock, midi::DefaultRtpSettings, RtpTestPlatform> Transport;
+typedef midi::RtpMIDI<SocketMock, ImmediateSettings, RtpTestPlatform> ImmediateTransport;
+typedef midi::RtpMIDI<SocketMock, SmallSettings, RtpTestPlatform> SmallTransport;
+
+static Buffer getList(const Buffer& inPacket)
+{
+    return Buffer(inPacket.begin() + 14, inPacket.end());
+}
+
+TEST(RtpTransport, packsCommands)
+{
+    SocketMock socket;
+    Transport transport(socket, 0x12345678);
+    midi::MidiInterface<Transport> midi(transport);
+
+    RtpTestPlatform::sMicros = 1000;
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    RtpTestPlatform::sMicros = 1200;
+    midi.sendNoteOn(62, 100, 1);
+    midi.sendControlChange(7, 100, 1);
+    midi.sendClock();
+    midi.sendNoteOn(64, 100, 1);
+
+    RtpTestPlatform::sMicros = 1999;
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(socket.mSent.size(), 0u);
+
+    RtpTestPlatform::sMicros = 2000;
+    EXPECT_EQ(midi.read(), false);
+    ASSERT_EQ(socket.mSent.size(), 1u);
+
+    const Buffer& packet = socket.mSent[0];
+    EXPECT_THAT(Buffer(packet.begin(), packet.begin() + 14),
+                ElementsAreArray({ 0x80, 0xe1, 0, 0,        // V2, M, PT 97, sequence 0
+                                   0, 0, 0, 10,             // 1000 us / 100
+                                   0x12, 0x34, 0x56, 0x78,  // SSRC
+                                   0x80, 16 }));            // Long header
+    EXPECT_THAT(getList(packet), ElementsAreArray({ 0x90, 60, 100,
+                                                    2, 62, 100,
+                                                    0, 0xb0, 7, 100,
+                                                    0, 0xf8,
+                                                    0, 0x90, 64, 100 }));
+
+    // Send-only loops send through flush().
+    midi.sendNoteOn(60, 100, 1);
+    midi.flush();
+    EXPECT_EQ(socket.mSent.size(), 1u);
+    RtpTestPlatform::sMicros = 3000;
+    midi.flush();
+    ASSERT_EQ(socket.mSent.size(), 2u);
+    EXPECT_THAT(getList(socket.mSent[1]), ElementsAreArray({ 0x90, 60, 100 }));
+}
+
+TEST(RtpTransport, deltaTimes)
+{
+    SocketMock socket;
+    ImmediateTransport transport(socket);
+    midi::MidiInterface<ImmediateTransport> midi(transport);
+
+    RtpTestPlatform::sMicros = 0;
+    midi.begin();
+    transport.beginTransmission(midi::Clock);
+    transport.write(0xf8);
+    RtpTestPlatform::sMicros = 100 * 200;
+    transport.write(0xf8);
+    RtpTestPlatform::sMicros += 100 * 20000;
+    transport.write(0xf8);
+    transport.endTransmission();
+
+    ASSERT_EQ(socket.mSent.size(), 1u);
+    EXPECT_THAT(getList(socket.mSent[0]), ElementsAreArray({ 0xf8,
+                                                             0x81, 0x48, 0xf8,
+                                                             0x81, 0x9c, 0x20, 0xf8 }));
+}
+
+TEST(RtpTransport, flushesFullPackets)
+{
+    SocketMock socket;
+    SmallTransport transport(socket);
+    midi::MidiInterface<SmallTransport> midi(transport);
+
+    midi.begin();
+    for (byte i = 0; i < 10; ++i)
+        midi.sendNoteOn(i, 100, 1);
+
+    ASSERT_EQ(socket.mSent.size(), 2u);
+    EXPECT_EQ(socket.mSent[0].size(), 26u);
+    EXPECT_EQ(socket.mSent[1][3], 1); // Sequence number
+    EXPECT_THAT(getList(socket.mSent[1]), ElementsAreArray({ 0x90, 4, 100,
+                                                             0, 5, 100,
+                                                             0, 6, 100,
+                                                             0, 7, 100 }));
+    EXPECT_EQ(transport.flush(), true);
+    ASSERT_EQ(socket.mSent.size(), 3u);
+    EXPECT_EQ(socket.mSent[2].size(), 20u);
+}
+
+TEST(RtpTransport, busySocket)
+{
+    SocketMock socket;
+    SmallTransport transport(socket);
+    midi::MidiInterface<SmallTransport> midi(transport);
+
+    midi.begin();
+    socket.mBusy = true;
+    for (byte i = 0; i < 6; ++i)
+        midi.sendNoteOn(i, 100, 1);
+    EXPECT_EQ(transport.getDroppedCommands(), 2u);
+    EXPECT_EQ(transport.flush(), false);
+
+    socket.mBusy = false;
+    EXPECT_EQ(transport.flush(), true);
+    ASSERT_EQ(socket.mSent.size(), 1u);
+    EXPECT_EQ(socket.mSent[0].size(), 26u);
+}
+
+TEST(RtpTransport, sysExSegments)
+{
+    SocketMock socket;
+    SmallTransport sender(socket);
+    midi::MidiInterface<SmallTransport> output(sender);
+
+    SocketMock peer;
+    SmallTransport receiver(peer);
+    midi::MidiInterface<SmallTransport, SysExSettings> input(receiver);
+    byte sysEx[64];
+
+    Buffer data;
+    for (byte i = 0; i < 40; ++i)
+        data.push_back(i);
+
+    output.begin();
+    output.sendSysEx(unsigned(data.size()), &data[0]);
+    output.sendNoteOn(60, 100, 2);
+    sender.flush();
+    ASSERT_EQ(socket.mSent.size(), 3u);
+    EXPECT_EQ(socket.mSent[0][14], 0xf0);
+    EXPECT_EQ(socket.mSent[0].back(), 0xf0);
+    EXPECT_EQ(socket.mSent[1][14], 0xf7);
+    EXPECT_EQ(socket.mSent[1].back(), 0xf0);
+    EXPECT_EQ(socket.mSent[2][14], 0xf7);
+
+    peer.mReceived = socket.mSent;
+    input.setSysExBuffer(sysEx, sizeof(sysEx));
+    input.begin(MIDI_CHANNEL_OMNI);
+    EXPECT_EQ(input.read(), true);
+    EXPECT_EQ(input.getType(), midi::SystemExclusive);
+
+    Buffer expected(1, 0xf0);
+    expected.insert(expected.end(), data.begin(), data.end());
+    expected.push_back(0xf7);
+    EXPECT_THAT(Buffer(input.getSysExArray(), input.getSysExArray() + input.getSysExArrayLength()),
+                ElementsAreArray(expected));
+
+    EXPECT_EQ(input.read(), true);
+    EXPECT_EQ(input.getType(),      midi::NoteOn);
+    EXPECT_EQ(input.getChannel(),   2);
+    EXPECT_EQ(input.getData1(),     60);
+    EXPECT_EQ(input.read(), false);
+}
+
+TEST(RtpTransport, listView)
+{
+    static const byte packet[] = {
+        0x80, 0xe1, 0x01, 0x02,
+        0, 0, 0x10, 0,
+        0, 0, 0, 1,
+        0x2b,                   // Short header, Z, 11 bytes
+        0x05, 0x90, 60, 100,    // Delta 5, NoteOn
+        0x81, 0x00, 62, 0,      // Delta 128, running status
+        0x00, 0xfe,             // Active Sensing
+        0x00, 0xc1,             // ProgramChange, cut by LEN
+        0xff, 0xff,             // Journal, ignored
+    };
+
+    midi::RtpMidiList list;
+    ASSERT_EQ(list.open(packet, sizeof(packet)), true);
+    EXPECT_EQ(list.getSequenceNumber(), 0x0102);
+    EXPECT_EQ(list.getTimestamp(), 0x1000ul);
+
+    unsigned long delta = 0;
+    const byte* data = nullptr;
+    unsigned length = 0;
+    ASSERT_EQ(list.next(delta, data, length), true);
+    EXPECT_EQ(delta, 5ul);
+    EXPECT_EQ(data, packet + 14);
+    EXPECT_EQ(length, 3u);
+    ASSERT_EQ(list.next(delta, data, length), true);
+    EXPECT_EQ(delta, 128ul);
+    EXPECT_EQ(data, packet + 19);
+    EXPECT_EQ(length, 2u);
+    ASSERT_EQ(list.next(delta, data, length), true);
+    EXPECT_EQ(delta, 0ul);
+    EXPECT_EQ(data[0], 0xfe);
+    EXPECT_EQ(length, 1u);
+    EXPECT_EQ(list.next(delta, data, length), false);
+
+    ASSERT_EQ(list.open(packet, 12), false);
+    Buffer notRtp(packet, packet + sizeof(packet));
+    notRtp[0] = 0x40;
+    EXPECT_EQ(list.open(&notRtp[0], unsigned(notRtp.size())), false);
+}
+
+TEST(RtpTransport, readsDatagrams)
+{
+    SocketMock socket;
+    Transport transport(socket);
+    midi::MidiInterface<Transport, SysExSettings> midi(transport);
+
+    static const byte packet[] = {
+        0x80, 0xe1, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,
+        0x08,                   // Short header, 8 bytes
+        0x92, 60, 100,
+        0x00, 61, 100,          // Running status
+        0x00, 0xf8,
+    };
+    socket.mReceived.push_back(Buffer(packet, packet + 12)); // Truncated, skipped
+    socket.mReceived.push_back(Buffer(packet, packet + sizeof(packet)));
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getChannel(),    3);
+    EXPECT_EQ(midi.getData1(),      60);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getData1(),      61);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::Clock);
+    EXPECT_EQ(midi.read(), false);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,401 @@
+#include "unit-tests.h"
+#include <src/MIDILite.h>
+#include <src/midi_Smf.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+
+typedef std::vector<byte> Buffer;
+
+struct SmallWindowSettings : public midi::DefaultSmfSettings
+{
+    static const unsigned MaxTracks  = 4;
+    static const unsigned WindowSize = 3;
+};
+
+// Counts the reads, to check that the file is streamed.
+class FileMock
+{
+public:
+    explicit FileMock(const Buffer& inData)
+        : mData(inData)
+        , mNumReads(0)
+        , mBytesRead(0)
+    {
+    }
+
+    unsigned read(unsigned long inOffset, byte* outData, unsigned inSize)
+    {
+        mNumReads++;
+        if (inOffset >= mData.size())
+            return 0;
+        const unsigned count = std::min<unsigned>(inSize, unsigned(mData.size() - inOffset));
+        memcpy(outData, &mData[inOffset], count);
+        mBytesRead += count;
+        return count;
+    }
+
+    bool write(const byte* inData, unsigned inSize)
+    {
+        mData.insert(mData.end(), inData, inData + inSize);
+        return true;
+    }
+
+    bool writeAt(unsigned long inOffset, const byte* inData, unsigned inSize)
+    {
+        if (inOffset + inSize > mData.size())
+            return false;
+        memcpy(&mData[inOffset], inData, inSize);
+        return true;
+    }
+
+    Buffer mData;
+    unsigned mNumReads;
+    unsigned mBytesRead;
+};
+
+Buffer makeHeader(uint16_t inFormat, uint16_t inNumTracks, uint16_t inDivision)
+{
+    const byte header[14] = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6,
+        byte(inFormat >> 8), byte(inFormat),
+        byte(inNumTracks >> 8), byte(inNumTracks),
+        byte(inDivision >> 8), byte(inDivision),
+    };
+    return Buffer(header, header + 14);
+}
+
+void appendChunk(Buffer& ioFile, const char* inType, const Buffer& inData)
+{
+    ioFile.insert(ioFile.end(), inType, inType + 4);
+    const unsigned long length = inData.size();
+    ioFile.push_back(byte(length >> 24));
+    ioFile.push_back(byte(length >> 16));
+    ioFile.push_back(byte(length >> 8));
+    ioFile.push_back(byte(length));
+    ioFile.insert(ioFile.end(), inData.begin(), inData.end());
+}
+
+// -----------------------------------------------------------------------------
+
+TEST(Smf, variableLength)
+{
+    struct Case { unsigned long value; byte length; byte data[4]; };
+    static const Case cases[] = {
+        { 0x00,       1, { 0x00 } },
+        { 0x40,       1, { 0x40 } },
+        { 0x7f,       1, { 0x7f } },
+        { 0x80,       2, { 0x81, 0x00 } },
+        { 0x2000,     2, { 0xc0, 0x00 } },
+        { 0x3fff,     2, { 0xff, 0x7f } },
+        { 0x4000,     3, { 0x81, 0x80, 0x00 } },
+        { 0x0fffffff, 4, { 0xff, 0xff, 0xff, 0x7f } },
+    };
+    for (const Case& c : cases)
+    {
+        byte data[4] = { 0 };
+        EXPECT_EQ(midi::encodeVariableLength(c.value, data), c.length);
+        EXPECT_EQ(Buffer(data, data + c.length), Buffer(c.data, c.data + c.length));
+    }
+}
+
+TEST(Smf, readFormat0)
+{
+    static const byte events[] = {
+        0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20,       // Tempo 500000
+        0x00, 0x90, 60, 100,
+        0x60, 62, 100,                                  // Running status
+        0x81, 0x00, 0xc2, 5,                            // Delta 128
+        0x00, 0xf0, 0x04, 0x7e, 0x09, 0x01, 0xf7,       // SysEx
+        0x10, 0x80, 60, 0,
+        0x00, 0xff, 0x2f, 0x00,
+    };
+    Buffer file = makeHeader(0, 1, 96);
+    appendChunk(file, "MTrk", Buffer(events, events + sizeof(events)));
+    FileMock mock(file);
+
+    midi::SmfReader<FileMock, SmallWindowSettings> reader(mock);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.getFormat(),    0);
+    EXPECT_EQ(reader.getNumTracks(), 1);
+    EXPECT_EQ(reader.getDivision(),  96);
+
+    midi::SmfEvent event;
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_TRUE(event.isMeta(midi::SmfEvent::Tempo));
+    EXPECT_EQ(event.getTempo(), 500000ul);
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.tick,            0ul);
+    EXPECT_EQ(event.status,          0x90);
+    EXPECT_EQ(event.message.type,    midi::NoteOn);
+    EXPECT_EQ(event.message.channel, 1);
+    EXPECT_EQ(event.message.data1,   60);
+    EXPECT_EQ(event.message.data2,   100);
+    EXPECT_EQ(event.message.length,  3);
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.tick,            96ul);
+    EXPECT_EQ(event.message.type,    midi::NoteOn);
+    EXPECT_EQ(event.message.data1,   62);
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.tick,            224ul);
+    EXPECT_EQ(event.message.type,    midi::ProgramChange);
+    EXPECT_EQ(event.message.channel, 3);
+    EXPECT_EQ(event.message.data1,   5);
+    EXPECT_EQ(event.message.length,  2);
+
+    byte data[16];
+    reader.setDataBuffer(data, sizeof(data));
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.status,          0xf0);
+    EXPECT_EQ(event.message.type,    midi::SystemExclusive);
+    EXPECT_EQ(event.length,          4ul);
+    EXPECT_EQ(event.dataLength,      4u);
+    EXPECT_EQ(Buffer(event.data, event.data + 4), Buffer(events + 21, events + 25));
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.tick,            240ul);
+    EXPECT_EQ(event.message.type,    midi::NoteOff);
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_TRUE(event.isMeta(midi::SmfEvent::EndOfTrack));
+    EXPECT_FALSE(reader.readEvent(event));
+    EXPECT_TRUE(reader.isTrackOver(0));
+    EXPECT_EQ(reader.getErrorCount(), 0ul);
+
+    // Each byte is read once, 3 at a time.
+    EXPECT_EQ(mock.mBytesRead, 14 + 8 + sizeof(events));
+}
+
+TEST(Smf, mergeTracks)
+{
+    // Delta times of 3 tracks, each event is a NoteOn on the track's channel.
+    static const byte deltas[3][4] = {
+        { 0, 10, 10, 10 },  // 0, 10, 20, 30
+        { 5, 5, 20, 0 },    // 5, 10, 30, 30
+        { 30, 0, 0, 1 },    // 30, 30, 30, 31
+    };
+    Buffer file = makeHeader(1, 3, 480);
+    appendChunk(file, "XFIH", Buffer(3, 0)); // Unknown chunks are skipped
+    for (byte track = 0; track < 3; ++track)
+    {
+        Buffer events;
+        for (byte i = 0; i < 4; ++i)
+        {
+            const byte event[4] = { deltas[track][i], byte(0x90 | track), byte(i), 64 };
+            events.insert(events.end(), event, event + 4);
+        }
+        appendChunk(file, "MTrk", events); // No End Of Track
+    }
+    FileMock mock(file);
+
+    midi::SmfReader<FileMock, SmallWindowSettings> reader(mock);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.getNumTracks(), 3);
+
+    static const byte expected[12][3] = { // tick, track, note
+        { 0, 0, 0 }, { 5, 1, 0 }, { 10, 0, 1 }, { 10, 1, 1 },
+        { 20, 0, 2 }, { 30, 0, 3 }, { 30, 1, 2 }, { 30, 1, 3 },
+        { 30, 2, 0 }, { 30, 2, 1 }, { 30, 2, 2 }, { 31, 2, 3 },
+    };
+    midi::SmfEvent event;
+    for (unsigned i = 0; i < 12; ++i)
+    {
+        ASSERT_TRUE(reader.readEvent(event)) << i;
+        EXPECT_EQ(event.tick,            expected[i][0]) << i;
+        EXPECT_EQ(event.track,           expected[i][1]) << i;
+        EXPECT_EQ(event.message.channel, expected[i][1] + 1) << i;
+        EXPECT_EQ(event.message.data1,   expected[i][2]) << i;
+    }
+    EXPECT_FALSE(reader.readEvent(event));
+    EXPECT_EQ(reader.getErrorCount(), 0ul);
+
+    // Track by track
+    ASSERT_TRUE(reader.open());
+    ASSERT_TRUE(reader.readTrackEvent(2, event));
+    EXPECT_EQ(event.tick, 30ul);
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.track, 0);
+    EXPECT_EQ(event.tick,  0ul);
+}
+
+TEST(Smf, tooManyTracks)
+{
+    Buffer file = makeHeader(1, 6, 96);
+    static const byte endOfTrack[4] = { 0, 0xff, 0x2f, 0 };
+    for (unsigned i = 0; i < 6; ++i)
+        appendChunk(file, "MTrk", Buffer(endOfTrack, endOfTrack + 4));
+
+    midi::SmfMemoryFile memory(&file[0], file.size());
+    midi::SmfReader<midi::SmfMemoryFile, SmallWindowSettings> reader(memory);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.getNumTracks(), 4);
+    EXPECT_EQ(reader.getErrorCount(), 2ul);
+
+    midi::SmfEvent event;
+    for (unsigned i = 0; i < 4; ++i)
+        EXPECT_TRUE(reader.readEvent(event));
+    EXPECT_FALSE(reader.readEvent(event));
+}
+
+TEST(Smf, largePayloadsAreSkipped)
+{
+    Buffer events(1, 0x00);
+    events.push_back(0xff);
+    events.push_back(0x01);             // Text
+    events.push_back(0x81);
+    events.push_back(0x00);             // 128 bytes
+    for (byte i = 0; i < 128; ++i)
+        events.push_back(i);
+    static const byte note[4] = { 0x00, 0x91, 60, 100 };
+    events.insert(events.end(), note, note + 4);
+
+    Buffer file = makeHeader(0, 1, 96);
+    appendChunk(file, "MTrk", events);
+    FileMock mock(file);
+
+    midi::SmfReader<FileMock> reader(mock);
+    ASSERT_TRUE(reader.open());
+
+    midi::SmfEvent event;
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_TRUE(event.isMeta(0x01));
+    EXPECT_EQ(event.length,     128ul);
+    EXPECT_EQ(event.dataLength, 4u);
+    EXPECT_EQ(event.data[3],    3);
+
+    ASSERT_TRUE(reader.readEvent(event));
+    EXPECT_EQ(event.message.type,    midi::NoteOn);
+    EXPECT_EQ(event.message.channel, 2);
+    EXPECT_FALSE(reader.readEvent(event));
+    EXPECT_LT(mock.mBytesRead, unsigned(file.size()));
+}
+
+TEST(Smf, malformedTracks)
+{
+    static const byte noStatus[] = { 0x00, 60, 100 };       // Data without running status
+    static const byte truncated[] = { 0x00, 0x90, 60 };     // Chunk ends in the event
+    static const byte systemCommon[] = { 0x00, 0xf2, 0, 0 };
+
+    Buffer file = makeHeader(1, 3, 96);
+    appendChunk(file, "MTrk", Buffer(noStatus, noStatus + sizeof(noStatus)));
+    appendChunk(file, "MTrk", Buffer(truncated, truncated + sizeof(truncated)));
+    appendChunk(file, "MTrk", Buffer(systemCommon, systemCommon + sizeof(systemCommon)));
+    FileMock mock(file);
+
+    midi::SmfReader<FileMock, SmallWindowSettings> reader(mock);
+    ASSERT_TRUE(reader.open());
+    midi::SmfEvent event;
+    EXPECT_FALSE(reader.readEvent(event));
+    EXPECT_EQ(reader.getErrorCount(), 3ul);
+
+    static const byte notAFile[] = "RIFF....WAVEfmt ";
+    midi::SmfMemoryFile memory(notAFile, sizeof(notAFile));
+    midi::SmfReader<midi::SmfMemoryFile> other(memory);
+    EXPECT_FALSE(other.open());
+}
+
+TEST(Smf, writeWithRunningStatus)
+{
+    FileMock mock((Buffer()));
+    midi::SmfWriter<FileMock> writer(mock);
+
+    midi::Message noteOn;
+    noteOn.type    = midi::NoteOn;
+    noteOn.channel = 2;
+    noteOn.data1   = 60;
+    noteOn.data2   = 100;
+    noteOn.valid   = true;
+
+    midi::Message clock;
+    clock.type  = midi::Clock;
+    clock.valid = true;
+
+    static const byte sysEx[] = { 0xf0, 0x7e, 0x7f, 0x09, 0x01, 0xf7 };
+
+    EXPECT_TRUE(writer.begin(0, 96));
+    EXPECT_TRUE(writer.beginTrack());
+    EXPECT_TRUE(writer.writeTempo(0, 500000));
+    EXPECT_TRUE(writer.write(noteOn, 0));
+    noteOn.data1 = 62;
+    EXPECT_TRUE(writer.write(noteOn, 200));
+    EXPECT_FALSE(writer.write(clock, 0));
+    EXPECT_TRUE(writer.writeSysEx(0, sizeof(sysEx), sysEx, true));
+    EXPECT_TRUE(writer.write(noteOn, 4));
+    EXPECT_EQ(writer.getTick(), 204ul);
+    EXPECT_TRUE(writer.end());
+    EXPECT_FALSE(writer.hasError());
+    EXPECT_EQ(writer.getNumTracks(), 1);
+
+    static const byte expected[] = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+        'M', 'T', 'r', 'k', 0, 0, 0, 31,
+        0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20,
+        0x00, 0x91, 60, 100,
+        0x81, 0x48, 62, 100,
+        0x00, 0xf0, 0x05, 0x7e, 0x7f, 0x09, 0x01, 0xf7,
+        0x04, 0x91, 62, 100,                            // SysEx cancelled running status
+        0x00, 0xff, 0x2f, 0x00,
+    };
+    EXPECT_EQ(mock.mData, Buffer(expected, expected + sizeof(expected)));
+}
+
+TEST(Smf, roundTrip)
+{
+    byte buffer[512];
+    midi::SmfMemoryFile memory(buffer, sizeof(buffer), 0);
+    midi::SmfWriter<midi::SmfMemoryFile> writer(memory);
+
+    EXPECT_TRUE(writer.begin(1, 480));
+    for (byte track = 0; track < 3; ++track)
+    {
+        EXPECT_TRUE(writer.beginTrack());
+        for (byte i = 0; i < 10; ++i)
+        {
+            midi::Message message;
+            message.type    = i & 1 ? midi::ControlChange : midi::PitchBend;
+            message.channel = byte(track + 1);
+            message.data1   = byte(i * 10 + track);
+            message.data2   = 0x40;
+            message.valid   = true;
+            EXPECT_TRUE(writer.write(message, 7 * (track + 1)));
+        }
+    }
+    EXPECT_TRUE(writer.end());
+    EXPECT_EQ(writer.getNumTracks(), 3);
+
+    midi::SmfMemoryFile file(buffer, memory.getSize());
+    midi::SmfReader<midi::SmfMemoryFile> reader(file);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.getNumTracks(), 3);
+    EXPECT_EQ(reader.getDivision(),  480);
+
+    unsigned numEvents = 0;
+    unsigned long lastTick = 0;
+    midi::SmfEvent event;
+    while (reader.readEvent(event))
+    {
+        EXPECT_GE(event.tick, lastTick);
+        lastTick = event.tick;
+        if (event.status == 0xff)
+            continue;
+        const unsigned i = event.message.data1 / 10;
+        EXPECT_EQ(event.tick, 7ul * (event.track + 1) * (i + 1));
+        EXPECT_EQ(event.message.channel, event.track + 1);
+        EXPECT_EQ(event.message.type, i & 1 ? midi::ControlChange : midi::PitchBend);
+        numEvents++;
+    }
+    EXPECT_EQ(numEvents, 30u);
+    EXPECT_EQ(reader.getErrorCount(), 0ul);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,214 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef std::vector<byte> Buffer;
+typedef std::vector<unsigned> Values;
+
+struct TrackerSettings : public midi::DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+    static const bool UseReceiverActiveSensing = true;
+    static const bool UseStateTracker = true;
+    static const unsigned TrackedControllers = 2;
+};
+
+const bool TrackerSettings::UseRunningStatus;
+const bool TrackerSettings::UseReceiverActiveSensing;
+const bool TrackerSettings::UseStateTracker;
+const unsigned TrackerSettings::TrackedControllers;
+
+struct ManualPlatform
+{
+    static unsigned long now() { return sMillis; }
+    static unsigned long sMillis;
+};
+
+unsigned long ManualPlatform::sMillis = 0;
+
+typedef midi::MidiInterface<Transport, TrackerSettings, ManualPlatform> MidiInterface;
+
+template<class Tracker>
+Values heldNotes(const Tracker& inTracker)
+{
+    Values notes;
+    inTracker.forEachHeldNote([&notes](midi::Channel inChannel, midi::DataByte inNote) {
+        notes.push_back(inChannel * 1000 + inNote);
+    });
+    return notes;
+}
+
+TEST(StateTracker, heldNotes)
+{
+    midi::StateTracker<true, 0> tracker;
+    EXPECT_EQ(tracker.hasHeldNotes(), false);
+
+    tracker.process(midi::NoteOn, 1, 0,   100);
+    tracker.process(midi::NoteOn, 1, 127, 100);
+    tracker.process(midi::NoteOn, 16, 64, 100);
+    tracker.process(midi::NoteOn, 3, 33,  100);
+    tracker.process(midi::NoteOn, 3, 34,  0);   // Null velocity, not held
+    EXPECT_EQ(tracker.isNoteOn(1, 127), true);
+    EXPECT_EQ(tracker.isNoteOn(3, 34),  false);
+    EXPECT_THAT(heldNotes(tracker), ElementsAreArray({
+        1000, 1127, 3033, 16064
+    }));
+
+    tracker.process(midi::NoteOff, 1, 0, 0);
+    tracker.process(midi::NoteOn,  3, 33, 0);
+    tracker.process(midi::ControlChange, 16, midi::AllNotesOff, 0);
+    EXPECT_THAT(heldNotes(tracker), ElementsAreArray({ 1127 }));
+
+    // Mode messages imply All Notes Off
+    static const midi::DataByte modes[] = {
+        midi::OmniModeOff, midi::OmniModeOn, midi::MonoModeOn, midi::PolyModeOn
+    };
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        tracker.process(midi::NoteOn, 5, 60, 100);
+        tracker.process(midi::ControlChange, 5, modes[i], 0);
+        EXPECT_EQ(tracker.isNoteOn(5, 60), false);
+    }
+    EXPECT_THAT(heldNotes(tracker), ElementsAreArray({ 1127 }));
+
+    tracker.process(midi::SystemReset, 0, 0, 0);
+    EXPECT_EQ(tracker.hasHeldNotes(), false);
+}
+
+TEST(StateTracker, sparseControllers)
+{
+    midi::StateTracker<true, 2> tracker;
+    midi::DataByte value = 0;
+
+    tracker.process(midi::ControlChange, 1, 7, 100);
+    tracker.process(midi::ControlChange, 2, 7, 50);
+    tracker.process(midi::ControlChange, 1, 7, 101);
+    tracker.process(midi::ControlChange, 1, 10, 64); // No room left
+    EXPECT_EQ(tracker.getController(1, 7, value), true);
+    EXPECT_EQ(value, 101);
+    EXPECT_EQ(tracker.getController(2, 7, value), true);
+    EXPECT_EQ(value, 50);
+    EXPECT_EQ(tracker.getController(1, 10, value), false);
+
+    Values values;
+    tracker.forEachController([&values](midi::Channel inChannel,
+                                        midi::DataByte inNumber,
+                                        midi::DataByte inValue) {
+        values.push_back(inChannel * 100000 + inNumber * 1000 + inValue);
+    });
+    EXPECT_THAT(values, ElementsAreArray({ 107101, 207050 }));
+}
+
+TEST(StateTracker, denseControllers)
+{
+    midi::StateTracker<true, midi::DenseControllerSlots> tracker;
+    midi::DataByte value = 0;
+
+    for (unsigned channel = 1; channel <= 16; ++channel)
+        for (unsigned number = 0; number < 120; ++number)
+            tracker.process(midi::ControlChange, channel, number, (channel + number) & 0x7f);
+
+    EXPECT_EQ(tracker.getController(16, 119, value), true);
+    EXPECT_EQ(value, 7);
+    EXPECT_EQ(tracker.getController(16, 120, value), false);
+
+    unsigned count = 0;
+    tracker.forEachController([&count](midi::Channel, midi::DataByte, midi::DataByte) {
+        count++;
+    });
+    EXPECT_EQ(count, 16u * 120u);
+}
+
+TEST(StateTracker, disabledByDefault)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    midi::MidiInterface<Transport> midi(transport);
+
+    static const byte rxData[] = { 0x90, 12, 34 };
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    EXPECT_EQ(midi.getStateTracker().isNoteOn(1, 12), false);
+    midi.panic();
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 0);
+}
+
+TEST(StateTracker, panicSendsHeldNotesOnly)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = {
+        0x90, 60, 100, 64, 100, 67, 100,
+        60, 0,
+        0x95, 12, 34,
+        0xb0, 7, 99,
+    };
+    midi::Message messages[8];
+
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 8), 6u);
+    EXPECT_EQ(midi.getStateTracker().isNoteOn(1, 64), true);
+
+    midi.panic();
+    Buffer buffer(8);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 8);
+    serial.mTxBuffer.read(&buffer[0], 8);
+    EXPECT_THAT(buffer, ElementsAreArray({
+        0x80, 64, 0, 67, 0, 0x85, 12, 0
+    }));
+    EXPECT_EQ(midi.getStateTracker().hasHeldNotes(), false);
+
+    // Controllers are kept
+    midi::DataByte value = 0;
+    EXPECT_EQ(midi.getStateTracker().getController(1, 7, value), true);
+    EXPECT_EQ(value, 99);
+}
+
+TEST(StateTracker, panicOnActiveSensingTimeout)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+
+    static const byte rxData[] = { 0xfe, 0x92, 42, 100 };
+    midi::Message messages[4];
+
+    ManualPlatform::sMillis = 0;
+    midi.begin(MIDI_CHANNEL_OMNI);
+    midi.turnThruOff();
+    serial.mRxBuffer.write(rxData, sizeof(rxData));
+    EXPECT_EQ(midi.readBatch(messages, 4), 2u);
+
+    ManualPlatform::sMillis = 500;
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(midi.getLastError() & (1 << midi::ErrorActiveSensingTimeout),
+              1 << midi::ErrorActiveSensingTimeout);
+
+    Buffer buffer(3);
+    EXPECT_EQ(serial.mTxBuffer.getLength(), 3);
+    serial.mTxBuffer.read(&buffer[0], 3);
+    EXPECT_THAT(buffer, ElementsAreArray({ 0x82, 42, 0 }));
+}
+
+END_UNNAMED_NAMESPACE
@@ -1,5 +1,5 @@
 #include "unit-tests.h"
-#include <src/MIDI.h>
+#include <src/MIDILite.h>
 
 BEGIN_MIDI_NAMESPACE
 
@@ -10,6 +10,7 @@ END_MIDI_NAMESPACE
 BEGIN_UNNAMED_NAMESPACE
 
 using namespace testing;
+typedef std::vector<uint8_t> Buffer;
 
 TEST(SysExCodec, EncoderAscii)
 {
@@ -178,4 +179,81 @@ TEST(SysExCodec, CodecNonAsciiFlipHeader)
     EXPECT_THAT(buffer2, ContainerEq(input));
 }
 
+// -----------------------------------------------------------------------------
+
+TEST(SysExCodec, EncoderSlices)
+{
+    byte input[64];
+    for (unsigned i = 0; i < sizeof(input); ++i)
+        input[i] = byte(i * 37 + 11);
+
+    for (unsigned flip = 0; flip < 2; ++flip)
+    {
+        byte expected[80];
+        const unsigned expectedSize = midi::encodeSysEx(input, expected, 64, flip);
+        EXPECT_EQ(expectedSize, unsigned(74));
+
+        for (unsigned sliceSize = 1; sliceSize < 16; ++sliceSize)
+        {
+            midi::SysExEncoder encoder(flip);
+            byte buffer[80];
+            unsigned encodedSize = 0;
+            for (unsigned i = 0; i < sizeof(input); i += sliceSize)
+            {
+                const unsigned size = i + sliceSize > 64 ? 64 - i : sliceSize;
+                encodedSize += encoder.encode(input + i, size, buffer + encodedSize);
+            }
+            encodedSize += encoder.finish(buffer + encodedSize);
+            EXPECT_EQ(encodedSize, expectedSize);
+            EXPECT_THAT(Buffer(buffer, buffer + encodedSize),
+                        ElementsAreArray(expected, expectedSize));
+        }
+    }
+}
+
+TEST(SysExCodec, DecoderSlices)
+{
+    byte input[64];
+    for (unsigned i = 0; i < sizeof(input); ++i)
+        input[i] = byte(i * 37 + 11);
+
+    for (unsigned flip = 0; flip < 2; ++flip)
+    {
+        byte encoded[80];
+        const unsigned encodedSize = midi::encodeSysEx(input, encoded, 64, flip);
+
+        for (unsigned sliceSize = 1; sliceSize < 20; ++sliceSize)
+        {
+            midi::SysExDecoder decoder(flip);
+            byte buffer[80];
+            unsigned decodedSize = 0;
+            for (unsigned i = 0; i < encodedSize; i += sliceSize)
+            {
+                const unsigned size = i + sliceSize > encodedSize ? encodedSize - i : sliceSize;
+                decodedSize += decoder.decode(encoded + i, size, buffer + decodedSize);
+            }
+            EXPECT_EQ(decodedSize, unsigned(64));
+            EXPECT_THAT(Buffer(buffer, buffer + decodedSize), ElementsAreArray(input));
+        }
+    }
+}
+
+TEST(SysExCodec, CodecAllLengths)
+{
+    byte input[32];
+    for (unsigned i = 0; i < sizeof(input); ++i)
+        input[i] = byte(0xff - i * 13);
+
+    for (unsigned length = 0; length <= sizeof(input); ++length)
+    {
+        byte encoded[40];
+        byte decoded[32];
+        const unsigned encodedSize = midi::encodeSysEx(input, encoded, length);
+        EXPECT_EQ(encodedSize, length + (length + 6) / 7);
+        EXPECT_THAT(Buffer(encoded, encoded + encodedSize), Each(Le(0x7f)));
+        EXPECT_EQ(midi::decodeSysEx(encoded, decoded, encodedSize), length);
+        EXPECT_THAT(Buffer(decoded, decoded + length), ElementsAreArray(input, length));
+    }
+}
+
 END_UNNAMED_NAMESPACE
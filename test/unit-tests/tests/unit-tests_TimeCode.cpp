@@ -0,0 +1,232 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <test/mocks/test-mocks_SerialMock.h>
+#include <type_traits>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+typedef test_mocks::SerialMock<64> SerialMock;
+typedef midi::SerialMIDI<SerialMock> Transport;
+typedef midi::TimeCodeDecoder<true> Decoder;
+typedef midi::TimeCodeRate Rate;
+
+struct TimeCodeSettings : public midi::DefaultSettings
+{
+    static const bool UseTimeCodeDecoder = true;
+    static const bool UseSysExInput = true;
+};
+
+struct ClockPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros; }
+    static unsigned long sMicros;
+};
+
+unsigned long ClockPlatform::sMicros = 0;
+
+typedef midi::MidiInterface<Transport, TimeCodeSettings, ClockPlatform> MidiInterface;
+
+// 25 fps: 10 ms per quarter frame.
+static const unsigned long sQuarter = 10000;
+
+midi::TimeCode makeTimeCode(byte inHours, byte inMinutes, byte inSeconds, byte inFrames,
+                            Rate::Type inRate)
+{
+    const midi::TimeCode timeCode = { inHours, inMinutes, inSeconds, inFrames, inRate };
+    return timeCode;
+}
+
+byte quarterFrame(const midi::TimeCode& inTimeCode, byte inPiece)
+{
+    static const byte shifts[8] = { 0, 4, 0, 4, 0, 4, 0, 4 };
+    byte value = 0;
+    switch (inPiece >> 1)
+    {
+        case 0: value = inTimeCode.frames;  break;
+        case 1: value = inTimeCode.seconds; break;
+        case 2: value = inTimeCode.minutes; break;
+        default: value = byte(inTimeCode.hours | inTimeCode.rate << 5); break;
+    }
+    return byte(inPiece << 4 | ((value >> shifts[inPiece]) & 0x0f));
+}
+
+// Sends the 8 pieces of each time code from inFrames on, 2 frames apart,
+// like a master playing forward (or in reverse).
+void play(Decoder& ioDecoder, unsigned long& ioTime, unsigned long inFrames,
+          unsigned inCycles, Rate::Type inRate, bool inReverse = false,
+          unsigned long inQuarter = sQuarter)
+{
+    for (unsigned cycle = 0; cycle < inCycles; ++cycle)
+    {
+        const unsigned long frames = inReverse ? inFrames - 2 * cycle : inFrames + 2 * cycle;
+        const midi::TimeCode timeCode = midi::framesToTimeCode(frames, inRate);
+        for (byte i = 0; i < 8; ++i)
+        {
+            ioTime += inQuarter;
+            ioDecoder.process(midi::TimeCodeQuarterFrame,
+                              quarterFrame(timeCode, inReverse ? 7 - i : i), ioTime);
+        }
+    }
+}
+
+TEST(TimeCode, frameConversions)
+{
+    const midi::TimeCode timeCode = makeTimeCode(1, 2, 3, 4, Rate::Fps25);
+    EXPECT_EQ(midi::timeCodeToFrames(timeCode), ((60ul + 2) * 60 + 3) * 25 + 4);
+
+    // Drop-frame: 00:01:00;02 follows 00:00:59;29.
+    EXPECT_EQ(midi::timeCodeToFrames(makeTimeCode(0, 1, 0, 2, Rate::Fps30Drop)), 1800ul);
+    EXPECT_EQ(midi::timeCodeToFrames(makeTimeCode(0, 10, 0, 0, Rate::Fps30Drop)), 17982ul);
+    EXPECT_EQ(midi::timeCodeToFrames(makeTimeCode(1, 0, 0, 0, Rate::Fps30Drop)), 107892ul);
+
+    for (unsigned long frames = 0; frames < 40000; frames += 7)
+    {
+        for (byte rate = 0; rate < 4; ++rate)
+        {
+            const midi::TimeCode decoded = midi::framesToTimeCode(frames, Rate::Type(rate));
+            EXPECT_EQ(midi::timeCodeToFrames(decoded), frames);
+            if (rate == Rate::Fps30Drop && decoded.seconds == 0 && decoded.minutes % 10 != 0)
+            {
+                EXPECT_GE(decoded.frames, 2);
+            }
+        }
+    }
+}
+
+TEST(TimeCode, disabledTakesNoSpace)
+{
+    EXPECT_TRUE((std::is_empty<midi::TimeCodeDecoder<false> >::value));
+    EXPECT_TRUE((std::is_empty<midi::MidiInterface<Transport>::MidiTimeCodeDecoder>::value));
+}
+
+TEST(TimeCode, locksAfterEightPieces)
+{
+    Decoder decoder;
+    unsigned long time = 0;
+    const unsigned long start = midi::timeCodeToFrames(makeTimeCode(1, 2, 3, 4, Rate::Fps25));
+
+    // Starting mid-cycle: the first complete cycle locks.
+    for (byte i = 4; i < 8; ++i)
+    {
+        time += sQuarter;
+        decoder.process(midi::TimeCodeQuarterFrame,
+                        quarterFrame(midi::framesToTimeCode(start - 2, Rate::Fps25), i), time);
+    }
+    play(decoder, time, start, 1, Rate::Fps25);
+    EXPECT_TRUE(decoder.isLocked());
+    EXPECT_FALSE(decoder.isReverse());
+    EXPECT_EQ(decoder.getRate(), Rate::Fps25);
+    EXPECT_EQ(decoder.getTimeCode().hours,   1);
+    EXPECT_EQ(decoder.getTimeCode().minutes, 2);
+    EXPECT_EQ(decoder.getTimeCode().seconds, 3);
+    EXPECT_EQ(decoder.getTimeCode().frames,  5); // Piece 7 comes 1.75 frame later
+    EXPECT_EQ(decoder.getPosition(time), (start * 4 + 7) << 6);
+
+    // Each piece then moves the position by a quarter frame.
+    play(decoder, time, start + 2, 1, Rate::Fps25);
+    EXPECT_EQ(decoder.getPosition(time), (start * 4 + 15) << 6);
+    EXPECT_EQ(decoder.getDrift(), 0);
+    EXPECT_TRUE(decoder.isRunning(time));
+    EXPECT_TRUE(decoder.isRunning(time + sQuarter * 3));
+    EXPECT_FALSE(decoder.isRunning(time + sQuarter * 5));
+}
+
+TEST(TimeCode, interpolatedPosition)
+{
+    Decoder decoder;
+    unsigned long time = 0;
+    play(decoder, time, 1000, 2, Rate::Fps25);
+    const unsigned long position = (1002 * 4 + 7) << 6;
+    EXPECT_EQ(decoder.getPosition(time), position);
+    EXPECT_EQ(decoder.getPosition(time + sQuarter / 2), position + 32);
+    EXPECT_EQ(decoder.getPosition(time + sQuarter * 3), position + 63);
+}
+
+TEST(TimeCode, reverse)
+{
+    Decoder decoder;
+    unsigned long time = 0;
+    play(decoder, time, 2000, 2, Rate::Fps30, true, 8333);
+    EXPECT_TRUE(decoder.isLocked());
+    EXPECT_TRUE(decoder.isReverse());
+    EXPECT_EQ(decoder.getPosition(time), (1998ul * 4) << 6);
+    EXPECT_EQ(decoder.getPosition(time + 4166), ((1998ul * 4) << 6) - 31);
+
+    play(decoder, time, 1996, 1, Rate::Fps30, true, 8333);
+    EXPECT_EQ(decoder.getPosition(time), (1996ul * 4) << 6);
+    EXPECT_EQ(decoder.getDrift(), -5); // 1/3 us early per quarter frame
+
+    // Back to forward: relocks after 8 pieces.
+    play(decoder, time, 1996, 2, Rate::Fps30, false, 8333);
+    EXPECT_FALSE(decoder.isReverse());
+    EXPECT_EQ(decoder.getPosition(time), (1998ul * 4 + 7) << 6);
+}
+
+TEST(TimeCode, drift)
+{
+    Decoder decoder;
+    unsigned long time = 0;
+    play(decoder, time, 0, 1, Rate::Fps25);
+
+    // Each quarter frame 10 us late.
+    play(decoder, time, 2, 4, Rate::Fps25, false, sQuarter + 10);
+    EXPECT_EQ(decoder.getDrift(), 320);
+
+    play(decoder, time, 10, 2, Rate::Fps25, false, sQuarter - 20);
+    EXPECT_EQ(decoder.getDrift(), 0);
+
+    // Jumps relock and restart the measure.
+    play(decoder, time, 5000, 2, Rate::Fps25, false, sQuarter + 10);
+    EXPECT_EQ(decoder.getPosition(time), (5002ul * 4 + 7) << 6);
+    EXPECT_EQ(decoder.getDrift(), 80);
+}
+
+TEST(TimeCode, fedByRead)
+{
+    SerialMock serial;
+    Transport transport(serial);
+    MidiInterface midi(transport);
+    static byte sysEx[16];
+    midi.setSysExBuffer(sysEx, sizeof(sysEx));
+    midi.begin(MIDI_CHANNEL_OMNI);
+
+    // Full Frame 01:02:03:04 at 30 fps
+    static const byte fullFrame[] = { 0xf0, 0x7f, 0x7f, 0x01, 0x01, 0x61, 2, 3, 4, 0xf7 };
+    serial.mRxBuffer.write(fullFrame, sizeof(fullFrame));
+    while (serial.mRxBuffer.getLength() > 0)
+        midi.read();
+
+    const midi::TimeCode located = midi.getTimeCodeDecoder().getTimeCode();
+    EXPECT_TRUE(midi.getTimeCodeDecoder().isLocked());
+    EXPECT_EQ(located.hours,   1);
+    EXPECT_EQ(located.minutes, 2);
+    EXPECT_EQ(located.seconds, 3);
+    EXPECT_EQ(located.frames,  4);
+    EXPECT_EQ(located.rate,    Rate::Fps30);
+    EXPECT_FALSE(midi.getTimeCodeDecoder().isRunning(ClockPlatform::sMicros));
+
+    // Then plays from there.
+    const unsigned long start = midi::timeCodeToFrames(located);
+    for (byte i = 0; i < 8; ++i)
+    {
+        ClockPlatform::sMicros += 8333;
+        serial.mRxBuffer.write(midi::TimeCodeQuarterFrame);
+        serial.mRxBuffer.write(quarterFrame(located, i));
+        while (serial.mRxBuffer.getLength() > 0)
+            midi.read();
+    }
+    EXPECT_TRUE(midi.getTimeCodeDecoder().isRunning(ClockPlatform::sMicros));
+    EXPECT_EQ(midi.getTimeCodeDecoder().getPosition(ClockPlatform::sMicros), (start * 4 + 7) << 6);
+}
+
+END_UNNAMED_NAMESPACE
@@ -0,0 +1,251 @@
+#include "unit-tests.h"
+#include "unit-tests_Settings.h"
+#include <src/MIDILite.h>
+#include <src/midi_UsbTransport.h>
+
+BEGIN_MIDI_NAMESPACE
+
+END_MIDI_NAMESPACE
+
+// -----------------------------------------------------------------------------
+
+BEGIN_UNNAMED_NAMESPACE
+
+using namespace testing;
+USING_NAMESPACE_UNIT_TESTS
+
+typedef std::vector<byte> Buffer;
+
+// Bulk endpoints: submitted frames are kept, frames to receive are queued.
+class UsbDeviceMock
+{
+public:
+    UsbDeviceMock()
+        : mBusy(false)
+    {
+    }
+
+    void begin()
+    {
+    }
+
+    bool writeFrame(const byte* inFrame, unsigned inSize)
+    {
+        if (mBusy)
+            return false;
+        mSent.push_back(Buffer(inFrame, inFrame + inSize));
+        return true;
+    }
+
+    unsigned readFrame(byte* outFrame, unsigned inMaxSize)
+    {
+        if (mReceived.empty())
+            return 0;
+        const Buffer frame = mReceived.front();
+        mReceived.erase(mReceived.begin());
+        const unsigned size = std::min(unsigned(frame.size()), inMaxSize);
+        std::copy(frame.begin(), frame.begin() + size, outFrame);
+        return size;
+    }
+
+    bool mBusy;
+    std::vector<Buffer> mSent;
+    std::vector<Buffer> mReceived;
+};
+
+struct UsbTestPlatform
+{
+    static unsigned long now()          { return sMicros / 1000; }
+    static unsigned long nowMicros()    { return sMicros; }
+    static unsigned long sMicros;
+};
+unsigned long UsbTestPlatform::sMicros = 0;
+
+struct ImmediateSettings : public midi::DefaultUsbSettings
+{
+    static const unsigned long FlushPeriod = 0;
+};
+
+struct CableSettings : public ImmediateSettings
+{
+    static const byte Cable = 3;
+};
+
+struct SysExSettings : public midi::DefaultSettings
+{
+    static const bool UseSysExInput = true;
+    static const bool Use1ByteParsing = false;
+};
+
+struct RunningStatusSettings : public midi::DefaultSettings
+{
+    static const bool UseRunningStatus = true;
+};
+
+typedef midi::UsbMIDI<UsbDeviceMock, midi::DefaultUsbSettings, UsbTestPlatform> Transport;
+typedef midi::UsbMIDI<UsbDeviceMock, ImmediateSettings, UsbTestPlatform> ImmediateTransport;
+typedef midi::UsbMIDI<UsbDeviceMock, CableSettings, UsbTestPlatform> CableTransport;
+
+TEST(UsbTransport, codeIndexNumbers)
+{
+    EXPECT_EQ(Transport::getCodeIndex(0x80, 3), 0x8);
+    EXPECT_EQ(Transport::getCodeIndex(0x9f, 3), 0x9);
+    EXPECT_EQ(Transport::getCodeIndex(0xc0, 2), 0xc);
+    EXPECT_EQ(Transport::getCodeIndex(0xe5, 3), 0xe);
+    EXPECT_EQ(Transport::getCodeIndex(0xf1, 2), 0x2);
+    EXPECT_EQ(Transport::getCodeIndex(0xf2, 3), 0x3);
+    EXPECT_EQ(Transport::getCodeIndex(0xf6, 1), 0x5);
+
+    EXPECT_EQ(Transport::getPacketLength(0x0), 0);
+    EXPECT_EQ(Transport::getPacketLength(0x4), 3);
+    EXPECT_EQ(Transport::getPacketLength(0x6), 2);
+    EXPECT_EQ(Transport::getPacketLength(0xc), 2);
+    EXPECT_EQ(Transport::getPacketLength(0xf), 1);
+}
+
+TEST(UsbTransport, packsMessages)
+{
+    UsbDeviceMock device;
+    ImmediateTransport transport(device);
+    midi::MidiInterface<ImmediateTransport> midi(transport);
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendProgramChange(12, 3);
+    midi.sendClock();
+    midi.sendSongPosition(0x1234);
+    ASSERT_EQ(device.mSent.size(), 4u);
+    EXPECT_THAT(device.mSent[0], ElementsAreArray({ 0x09, 0x90, 60, 100 }));
+    EXPECT_THAT(device.mSent[1], ElementsAreArray({ 0x0c, 0xc2, 12, 0 }));
+    EXPECT_THAT(device.mSent[2], ElementsAreArray({ 0x0f, 0xf8, 0, 0 }));
+    EXPECT_THAT(device.mSent[3], ElementsAreArray({ 0x03, 0xf2, 0x34, 0x24 }));
+}
+
+TEST(UsbTransport, packsSysEx)
+{
+    UsbDeviceMock device;
+    ImmediateTransport transport(device);
+    midi::MidiInterface<ImmediateTransport> midi(transport);
+
+    static const byte sysEx[5] = { 1, 2, 3, 4, 5 };
+    midi.begin();
+    midi.sendSysEx(5, sysEx);
+    ASSERT_EQ(device.mSent.size(), 1u);
+    EXPECT_THAT(device.mSent[0], ElementsAreArray({ 0x04, 0xf0, 1, 2,
+                                                    0x04, 3, 4, 5,
+                                                    0x05, 0xf7, 0, 0 }));
+
+    midi.sendSysEx(4, sysEx);
+    EXPECT_THAT(device.mSent[1], ElementsAreArray({ 0x04, 0xf0, 1, 2,
+                                                    0x07, 3, 4, 0xf7 }));
+}
+
+TEST(UsbTransport, expandsRunningStatus)
+{
+    UsbDeviceMock device;
+    CableTransport transport(device);
+    midi::MidiInterface<CableTransport, RunningStatusSettings> midi(transport);
+
+    midi.begin();
+    midi.sendNoteOn(60, 100, 1);
+    midi.sendNoteOn(62, 100, 1);
+    ASSERT_EQ(device.mSent.size(), 2u);
+    EXPECT_THAT(device.mSent[0], ElementsAreArray({ 0x39, 0x90, 60, 100 }));
+    EXPECT_THAT(device.mSent[1], ElementsAreArray({ 0x39, 0x90, 62, 100 }));
+}
+
+TEST(UsbTransport, batchesFrames)
+{
+    UsbDeviceMock device;
+    Transport transport(device);
+    midi::MidiInterface<Transport> midi(transport);
+
+    UsbTestPlatform::sMicros = 0;
+    midi.begin();
+    for (byte i = 0; i < 20; ++i)
+        midi.sendNoteOn(i, 100, 1);
+
+    // The first 16 packets fill a frame
+    ASSERT_EQ(device.mSent.size(), 1u);
+    EXPECT_EQ(device.mSent[0].size(), 64u);
+    EXPECT_EQ(transport.availableForWrite(), (16 - 4) * 3);
+
+    UsbTestPlatform::sMicros = 999;
+    EXPECT_EQ(midi.read(), false);
+    EXPECT_EQ(device.mSent.size(), 1u);
+
+    UsbTestPlatform::sMicros = 1000;
+    EXPECT_EQ(midi.read(), false);
+    ASSERT_EQ(device.mSent.size(), 2u);
+    EXPECT_EQ(device.mSent[1].size(), 16u);
+    EXPECT_THAT(Buffer(device.mSent[1].begin(), device.mSent[1].begin() + 4),
+                ElementsAreArray({ 0x09, 0x90, 16, 100 }));
+
+    // Send-only loops submit through flush().
+    midi.sendNoteOn(60, 100, 1);
+    midi.flush();
+    EXPECT_EQ(device.mSent.size(), 2u);
+    UsbTestPlatform::sMicros = 2000;
+    midi.flush();
+    ASSERT_EQ(device.mSent.size(), 3u);
+    EXPECT_THAT(device.mSent[2], ElementsAreArray({ 0x09, 0x90, 60, 100 }));
+}
+
+TEST(UsbTransport, busyEndpoint)
+{
+    UsbDeviceMock device;
+    Transport transport(device);
+    midi::MidiInterface<Transport> midi(transport);
+
+    midi.begin();
+    device.mBusy = true;
+    for (byte i = 0; i < 18; ++i)
+        midi.sendControlChange(i, 1, 1);
+    EXPECT_EQ(transport.getDroppedPackets(), 2u);
+    EXPECT_EQ(transport.flush(), false);
+
+    device.mBusy = false;
+    EXPECT_EQ(transport.flush(), true);
+    ASSERT_EQ(device.mSent.size(), 1u);
+    EXPECT_EQ(device.mSent[0].size(), 64u);
+}
+
+TEST(UsbTransport, unpacksFrames)
+{
+    UsbDeviceMock device;
+    CableTransport transport(device);
+    midi::MidiInterface<CableTransport, SysExSettings> midi(transport);
+    byte sysEx[8];
+
+    static const byte frame[] = {
+        0x39, 0x91, 60, 100,    // NoteOn
+        0x29, 0x92, 61, 100,    // NoteOn on another cable, ignored
+        0x3f, 0xf8, 0, 0,       // Clock
+        0x34, 0xf0, 1, 2,       // SysEx start
+        0x36, 3, 0xf7, 0,       // SysEx end
+        0x3c, 0xc0, 5, 0,       // ProgramChange
+    };
+    device.mReceived.push_back(Buffer(frame, frame + sizeof(frame)));
+
+    midi.setSysExBuffer(sysEx, sizeof(sysEx));
+    midi.begin(MIDI_CHANNEL_OMNI);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::NoteOn);
+    EXPECT_EQ(midi.getChannel(),    2);
+    EXPECT_EQ(midi.getData1(),      60);
+    EXPECT_EQ(device.mReceived.size(), 0u);
+    EXPECT_EQ(transport.available(), 8u);
+
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::Clock);
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::SystemExclusive);
+    EXPECT_THAT(Buffer(midi.getSysExArray(), midi.getSysExArray() + midi.getSysExArrayLength()),
+                ElementsAreArray({ 0xf0, 1, 2, 3, 0xf7 }));
+    EXPECT_EQ(midi.read(), true);
+    EXPECT_EQ(midi.getType(),       midi::ProgramChange);
+    EXPECT_EQ(midi.getData1(),      5);
+    EXPECT_EQ(midi.read(), false);
+}
+
+END_UNNAMED_NAMESPACE